@@ -0,0 +1,226 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <map>
+#include <cstdio>
+#include <cstring>
+#include <cstddef>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+using namespace std;
+
+#include "General.h"
+#include "Alignment_Cache.h"
+#include "Run_Statistics.h"
+
+extern bool DEBUG;
+extern RunStatistics runStatistics;
+
+static const char cacheMagic[8] = {'B', 'F', 'Y', 'A', 'L', 'N', '0', '3'};
+
+static bool getSourceStatus (string const& fileName, unsigned long long & size, long long & time) {
+    struct stat status;
+    if (stat(fileName.c_str(), &status) != 0) {
+        return false;
+    }
+    size = status.st_size;
+    time = (long long)status.st_mtim.tv_sec * 1000000000LL + status.st_mtim.tv_nsec;
+    return true;
+}
+
+static int getPatternBytes (long long const& numPatterns) {
+    if (numPatterns <= 0xFFLL) {
+        return 1;
+    } else if (numPatterns <= 0xFFFFLL) {
+        return 2;
+    } else if (numPatterns <= 0xFFFFFFFFLL) {
+        return 4;
+    }
+    return 8;
+}
+
+string getAlignmentCacheName (string const& alignmentFileName) {
+    return alignmentFileName + ".bcache";
+}
+
+unsigned long long hashFileContents (string const& fileName) {
+    unsigned long long hash = 14695981039346656037ULL;
+    ifstream input(fileName.c_str(), ios::in | ios::binary);
+    runStatistics.countOpen();
+    vector <char> buffer(1 << 20);
+    while (input.good()) {
+        input.read(&buffer[0], buffer.size());
+        streamsize numRead = input.gcount();
+        runStatistics.countRead(numRead);
+        for (streamsize i = 0; i < numRead; i++) {
+            hash = (hash ^ (unsigned char)buffer[i]) * 1099511628211ULL;
+        }
+    }
+    return hash;
+}
+
+bool readAlignmentCache (string const& alignmentFileName, vector < vector <string> > & taxaAlignment,
+    long long & numTaxa, long long & numChar, bool & interleavedData, vector <long long> & sitePatterns,
+    long long & numPatterns)
+{
+// false (and nothing changed) if there is no usable cache for the file as it is now
+    ScopedTimer timer("parse.cache");
+    unsigned long long sourceSize = 0;
+    long long sourceTime = 0;
+    if (!getSourceStatus(alignmentFileName, sourceSize, sourceTime)) {
+        return false;
+    }
+    string cacheFileName = getAlignmentCacheName(alignmentFileName);
+    int cacheDescriptor = open(cacheFileName.c_str(), O_RDONLY);
+    runStatistics.countOpen();
+    if (cacheDescriptor < 0) {
+        return false;
+    }
+    struct stat cacheStatus;
+    if (fstat(cacheDescriptor, &cacheStatus) != 0 || cacheStatus.st_size < (off_t)sizeof(AlignmentCacheHeader)) {
+        close(cacheDescriptor);
+        return false;
+    }
+    size_t cacheSize = cacheStatus.st_size;
+    void * mapped = mmap(NULL, cacheSize, PROT_READ, MAP_PRIVATE, cacheDescriptor, 0);
+    close(cacheDescriptor);
+    if (mapped == MAP_FAILED) {
+        return false;
+    }
+    char const* cache = (char const*)mapped;
+    AlignmentCacheHeader header;
+    memcpy(&header, cache, sizeof(header));
+    
+    bool valid = (memcmp(header.magic, cacheMagic, sizeof(cacheMagic)) == 0 && header.fileSize == cacheSize
+        && header.numTaxa > 0 && header.numChar > 0 && header.namesOffset == sizeof(header)
+        && header.sequencesOffset <= cacheSize
+        && header.patternsOffset == header.sequencesOffset + header.numTaxa * header.numChar
+        && header.numPatterns > 0 && header.patternBytes == getPatternBytes(header.numPatterns)
+        && header.patternsOffset + header.numChar * header.patternBytes == cacheSize);
+    if (valid && (header.sourceSize != sourceSize || header.sourceTime != sourceTime)) {
+        valid = (header.sourceSize == sourceSize && header.sourceHash == hashFileContents(alignmentFileName));
+        if (DEBUG) {cout << "Alignment cache '" << cacheFileName << "' is " << (valid ? "older than" : "stale for")
+            << " '" << alignmentFileName << "' (contents " << (valid ? "unchanged" : "changed") << ")" << endl;}
+        if (valid) {
+// same contents, new time (e.g. copied or touched): record the time so the next run skips the hash
+            int updateDescriptor = open(cacheFileName.c_str(), O_WRONLY);
+            if (updateDescriptor >= 0) {
+                if (pwrite(updateDescriptor, &sourceTime, sizeof(sourceTime), offsetof(AlignmentCacheHeader, sourceTime)) < 0) {
+                    if (DEBUG) {cout << "Unable to update '" << cacheFileName << "'" << endl;}
+                }
+                close(updateDescriptor);
+            }
+        }
+    }
+    if (!valid) {
+        munmap(mapped, cacheSize);
+        return false;
+    }
+    
+    taxaAlignment.assign(header.numTaxa, vector <string>(2));
+    char const* name = cache + header.namesOffset;
+    char const* namesEnd = cache + header.sequencesOffset;
+    for (long long i = 0; i < header.numTaxa; i++) {
+        size_t length = strnlen(name, namesEnd - name);
+        taxaAlignment[i][0].assign(name, length);
+        name += length + 1;
+        taxaAlignment[i][1].assign(cache + header.sequencesOffset + i * header.numChar, header.numChar);
+    }
+    sitePatterns.resize(header.numChar);
+    char const* pattern = cache + header.patternsOffset;
+    for (long long i = 0; i < header.numChar; i++, pattern += header.patternBytes) {
+        if (header.patternBytes == 1) {
+            sitePatterns[i] = (unsigned char)*pattern;
+        } else if (header.patternBytes == 2) {
+            unsigned short index;
+            memcpy(&index, pattern, sizeof(index));
+            sitePatterns[i] = index;
+        } else if (header.patternBytes == 4) {
+            unsigned int index;
+            memcpy(&index, pattern, sizeof(index));
+            sitePatterns[i] = index;
+        } else {
+            memcpy(&sitePatterns[i], pattern, sizeof(long long));
+        }
+    }
+    munmap(mapped, cacheSize);
+    runStatistics.countRead(cacheSize);
+    
+    numTaxa = header.numTaxa;
+    numChar = header.numChar;
+    numPatterns = header.numPatterns;
+    interleavedData = (header.interleavedData != 0);
+    if (DEBUG) {cout << "Read " << numTaxa << " taxa of " << numChar << " characters from '" << cacheFileName << "'" << endl;}
+    return true;
+}
+
+bool writeAlignmentCache (string const& alignmentFileName, vector < vector <string> > const& taxaAlignment,
+    long long const& numTaxa, long long const& numChar, bool const& interleavedData,
+    vector <long long> const& sitePatterns, long long const& numPatterns)
+{
+// written under a temporary name and renamed, so a concurrent run never maps a partial file
+    ScopedTimer timer("parse.cache");
+    AlignmentCacheHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, cacheMagic, sizeof(cacheMagic));
+    if (!getSourceStatus(alignmentFileName, header.sourceSize, header.sourceTime)) {
+        return false;
+    }
+    header.sourceHash = hashFileContents(alignmentFileName);
+    header.numTaxa = numTaxa;
+    header.numChar = numChar;
+    header.numPatterns = numPatterns;
+    header.interleavedData = interleavedData;
+    header.patternBytes = getPatternBytes(numPatterns);
+    header.namesOffset = sizeof(header);
+    header.sequencesOffset = header.namesOffset;
+    for (int i = 0; i < numTaxa; i++) {
+        header.sequencesOffset += taxaAlignment[i][0].size() + 1;
+    }
+    header.patternsOffset = header.sequencesOffset + (unsigned long long)numTaxa * numChar;
+    header.fileSize = header.patternsOffset + (unsigned long long)numChar * header.patternBytes;
+    
+    string cacheFileName = getAlignmentCacheName(alignmentFileName);
+    string temporaryFileName = cacheFileName + ".tmp" + convertIntToString(getpid());
+    ofstream cacheOutput(temporaryFileName.c_str(), ios::out | ios::binary);
+    runStatistics.countOpen();
+    if (!cacheOutput.is_open()) {
+        return false;
+    }
+    cacheOutput.write((char const*)&header, sizeof(header));
+    for (int i = 0; i < numTaxa; i++) {
+        cacheOutput.write(taxaAlignment[i][0].c_str(), taxaAlignment[i][0].size() + 1);
+    }
+    for (int i = 0; i < numTaxa; i++) {
+        cacheOutput.write(taxaAlignment[i][1].data(), numChar);
+    }
+    vector <char> patterns(numChar * header.patternBytes);
+    for (long long i = 0; i < numChar; i++) {
+        char * pattern = &patterns[i * header.patternBytes];
+        if (header.patternBytes == 1) {
+            *pattern = (char)sitePatterns[i];
+        } else if (header.patternBytes == 2) {
+            unsigned short index = sitePatterns[i];
+            memcpy(pattern, &index, sizeof(index));
+        } else if (header.patternBytes == 4) {
+            unsigned int index = sitePatterns[i];
+            memcpy(pattern, &index, sizeof(index));
+        } else {
+            memcpy(pattern, &sitePatterns[i], sizeof(long long));
+        }
+    }
+    cacheOutput.write(&patterns[0], patterns.size());
+    cacheOutput.close();
+    runStatistics.countWrite(header.fileSize);
+    if (cacheOutput.fail() || rename(temporaryFileName.c_str(), cacheFileName.c_str()) != 0) {
+        remove(temporaryFileName.c_str());
+        return false;
+    }
+    if (DEBUG) {cout << "Wrote alignment cache '" << cacheFileName << "' (" << header.fileSize << " bytes)" << endl;}
+    return true;
+}
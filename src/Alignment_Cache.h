@@ -0,0 +1,42 @@
+#ifndef _ALIGNMENT_CACHE_H_
+#define _ALIGNMENT_CACHE_H_
+
+// Binary sidecar ('<alignment>.bcache') holding a parsed alignment, so that later runs skip
+// parsing the text and hashing its columns. It is not a packed format: sequences are stored one
+// byte per state, as in memory, and loading still copies them into the alignment. Layout, in
+// native byte order, with offsets from the start of the file:
+//     AlignmentCacheHeader
+//     names       numTaxa NUL-terminated taxon names, each stored once
+//     sequences   numTaxa x numChar states, taxon by taxon
+//     patterns    numChar site-pattern indices (see SimData::buildSitePatterns), each
+//                 patternBytes wide: the fewest of 1, 2, 4 or 8 bytes that hold numPatterns
+// The header records the size, modification time and 64-bit FNV-1a content hash of the text
+// file. A cache is used when size and time match, or failing that when the content hash does;
+// otherwise the text file is read and the cache rewritten.
+
+struct AlignmentCacheHeader {
+    char magic[8];                      // 'BFYALN' + format version
+    unsigned long long sourceSize;
+    long long sourceTime;               // modification time, ns
+    unsigned long long sourceHash;
+    long long numTaxa;
+    long long numChar;
+    long long numPatterns;
+    long long interleavedData;
+    long long patternBytes;
+    unsigned long long namesOffset;
+    unsigned long long sequencesOffset;
+    unsigned long long patternsOffset;
+    unsigned long long fileSize;
+};
+
+string getAlignmentCacheName (string const& alignmentFileName);
+unsigned long long hashFileContents (string const& fileName);
+bool readAlignmentCache (string const& alignmentFileName, vector < vector <string> > & taxaAlignment,
+    long long & numTaxa, long long & numChar, bool & interleavedData, vector <long long> & sitePatterns,
+    long long & numPatterns);
+bool writeAlignmentCache (string const& alignmentFileName, vector < vector <string> > const& taxaAlignment,
+    long long const& numTaxa, long long const& numChar, bool const& interleavedData,
+    vector <long long> const& sitePatterns, long long const& numPatterns);
+
+#endif /* _ALIGNMENT_CACHE_H_ */
@@ -0,0 +1,189 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <map>
+#include <algorithm>
+#include <cstring>
+#include <fcntl.h>
+#include <fnmatch.h>
+#include <regex.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+
+using namespace std;
+
+#include "General.h"
+#include "Alignment_Discovery.h"
+#include "Run_Statistics.h"
+#include "Run_Trace.h"
+
+extern bool DEBUG;
+
+// record layout returned by getdents64
+struct DirectoryEntry {
+    unsigned long long inode;
+    long long nextOffset;
+    unsigned short recordLength;
+    unsigned char type;
+    char name[1];
+};
+
+struct DiscoveredFile {
+    string path;
+    long long size;
+};
+
+struct DirectoryListing {
+    vector <DiscoveredFile> files;
+    vector <string> subdirectories;
+    bool readable;
+};
+
+static bool compareDiscoveredFiles (DiscoveredFile const& first, DiscoveredFile const& second) {
+// largest first; equal sizes in path order, so the order does not depend on the walk
+    if (first.size != second.size) {
+        return first.size > second.size;
+    }
+    return first.path < second.path;
+}
+
+static string joinPath (string const& directory, string const& name) {
+    return (directory == ".") ? name : directory + "/" + name;
+}
+
+static void listDirectory (string const& directory, vector <string> const& globPatterns,
+    regex_t const* pathExpression, DirectoryListing & listing)
+{
+    TraceScope scope("discovery.directory");
+    listing.readable = false;
+    int descriptor = open(directory.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (descriptor < 0) {
+        return;
+    }
+    listing.readable = true;
+    vector <char> buffer(1 << 16);
+    long numRead = 0;
+    while ((numRead = syscall(SYS_getdents64, descriptor, &buffer[0], buffer.size())) > 0) {
+        for (long position = 0; position < numRead; ) {
+            DirectoryEntry const* entry = (DirectoryEntry const*)&buffer[position];
+            position += entry->recordLength;
+            if (entry->name[0] == '.') {
+                continue; // '.', '..' and hidden entries
+            }
+            string path = joinPath(directory, entry->name);
+            unsigned char type = entry->type;
+            struct stat status;
+            bool statusRead = false;
+            if (type == DT_UNKNOWN || type == DT_LNK) {
+                if (fstatat(descriptor, entry->name, &status, 0) != 0) {
+                    continue;
+                }
+                statusRead = true;
+                if (S_ISDIR(status.st_mode)) {
+                    type = (type == DT_LNK) ? DT_LNK : DT_DIR; // never descend through a link
+                } else {
+                    type = S_ISREG(status.st_mode) ? DT_REG : DT_UNKNOWN;
+                }
+            }
+            if (type == DT_DIR) {
+                listing.subdirectories.push_back(path);
+                continue;
+            }
+            if (type != DT_REG) {
+                continue;
+            }
+            bool nameMatches = false;
+            for (int i = 0; i < (int)globPatterns.size() && !nameMatches; i++) {
+                nameMatches = (fnmatch(globPatterns[i].c_str(), entry->name, FNM_CASEFOLD) == 0);
+            }
+            if (!nameMatches || (pathExpression != NULL && regexec(pathExpression, path.c_str(), 0, NULL, 0) != 0)) {
+                continue;
+            }
+            if (!statusRead && fstatat(descriptor, entry->name, &status, 0) != 0) {
+                continue;
+            }
+            DiscoveredFile file = {path, (long long)status.st_size};
+            listing.files.push_back(file);
+        }
+    }
+    close(descriptor);
+}
+
+vector <string> getDefaultAlignmentGlobs () {
+    vector <string> globPatterns;
+    globPatterns.push_back("*.nex");
+    globPatterns.push_back("*.nexus");
+    globPatterns.push_back("*.fasta");
+    globPatterns.push_back("*.fas");
+    globPatterns.push_back("*.fa");
+    return globPatterns;
+}
+
+vector <string> discoverAlignmentFiles (vector <string> const& directories, vector <string> const& globPatterns,
+    string const& pathExpression)
+{
+    ScopedTimer timer("discovery");
+    regex_t compiledExpression;
+    if (!pathExpression.empty()) {
+        int status = regcomp(&compiledExpression, pathExpression.c_str(), REG_EXTENDED | REG_NOSUB);
+        if (status != 0) {
+            char message[256];
+            regerror(status, &compiledExpression, message, sizeof(message));
+            throw BEASTifierError("option", "invalid regular expression '" + pathExpression + "' (" + message + ")");
+        }
+    }
+    regex_t const* expression = pathExpression.empty() ? NULL : &compiledExpression;
+    
+    vector <DiscoveredFile> files;
+    vector <string> level;
+    for (int i = 0; i < (int)directories.size(); i++) {
+        string directory = directories[i];
+        while (directory.size() > 1 && directory[directory.size() - 1] == '/') {
+            directory.erase(directory.size() - 1);
+        }
+        level.push_back(directory);
+    }
+    int numDirectories = 0;
+    for (int depth = 0; !level.empty(); depth++) {
+        vector <DirectoryListing> listings(level.size());
+#ifdef _OPENMP
+        #pragma omp parallel for schedule(dynamic)
+#endif
+        for (int i = 0; i < (int)level.size(); i++) {
+            listDirectory(level[i], globPatterns, expression, listings[i]);
+        }
+        vector <string> nextLevel;
+        for (int i = 0; i < (int)level.size(); i++) {
+            if (!listings[i].readable) {
+                if (depth == 0) {
+                    if (expression != NULL) {
+                        regfree(&compiledExpression);
+                    }
+                    throw BEASTifierError("input", "unable to read directory '" + level[i] + "'");
+                }
+                cout << "Warning: unable to read directory '" << level[i] << "'; skipping it." << endl;
+                continue;
+            }
+            files.insert(files.end(), listings[i].files.begin(), listings[i].files.end());
+            nextLevel.insert(nextLevel.end(), listings[i].subdirectories.begin(), listings[i].subdirectories.end());
+        }
+        numDirectories += level.size();
+        level.swap(nextLevel);
+    }
+    if (expression != NULL) {
+        regfree(&compiledExpression);
+    }
+    
+    sort(files.begin(), files.end(), compareDiscoveredFiles);
+    vector <string> alignments(files.size());
+    for (int i = 0; i < (int)files.size(); i++) {
+        alignments[i] = files[i].path;
+    }
+    cout << "Found " << alignments.size() << " alignments in " << numDirectories << " directories." << endl;
+    if (DEBUG && !files.empty()) {cout << "Largest '" << files[0].path << "' (" << files[0].size << " bytes)" << endl;}
+    return alignments;
+}
+
@@ -0,0 +1,17 @@
+#ifndef _ALIGNMENT_DISCOVERY_H_
+#define _ALIGNMENT_DISCOVERY_H_
+
+// Finds the alignments under one or more directories ('-adir'), as an alternative to listing them
+// in a file ('-alist'). Each tree is walked a level at a time with getdents64; the directories of
+// a level are read in parallel when built with OpenMP. Entry types come from the listing itself,
+// so only files that are kept are stat'ed (for their size). A file is kept when its name matches
+// one of the glob patterns (case-insensitive; by default the NEXUS and FASTA suffixes) and, if
+// given, its path matches the extended regular expression. Hidden entries are skipped and
+// symbolic links to directories are not followed. Files are returned largest first, so that the
+// longest jobs of a batch start first.
+
+vector <string> getDefaultAlignmentGlobs ();
+vector <string> discoverAlignmentFiles (vector <string> const& directories, vector <string> const& globPatterns,
+    string const& pathExpression);
+
+#endif /* _ALIGNMENT_DISCOVERY_H_ */
@@ -0,0 +1,747 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <map>
+#include <cstdlib>
+#include <cctype>
+#include <climits>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/sendfile.h>
+
+using namespace std;
+
+#include "General.h"
+#include "Alignment_Reader.h"
+#include "Run_Statistics.h"
+
+extern bool DEBUG;
+extern RunStatistics runStatistics;
+
+static const size_t readChunkSize = 1 << 20;
+
+AlignmentReader::AlignmentReader (string const& alignmentFileName)
+: bufferPosition(0), bufferSize(0), bufferOffset(0), lineNumber(1), alignment(NULL), sequenceRanges(NULL),
+    dimensionsOnly(false)
+{
+    fileName = alignmentFileName;
+    input.open(fileName.c_str(), ios::in | ios::binary);
+    runStatistics.countOpen();
+    buffer.resize(readChunkSize);
+}
+
+AlignmentReader::AlignmentReader (string const& alignmentFileName, size_t const& chunkSize)
+: bufferPosition(0), bufferSize(0), bufferOffset(0), lineNumber(1), alignment(NULL), sequenceRanges(NULL),
+    dimensionsOnly(false)
+{
+// a smaller chunk for reading many headers ('-plan')
+    fileName = alignmentFileName;
+    input.open(fileName.c_str(), ios::in | ios::binary);
+    runStatistics.countOpen();
+    buffer.resize(chunkSize);
+}
+
+bool AlignmentReader::fillBuffer () {
+    if (bufferPosition < bufferSize) {
+        return true;
+    }
+    if (!input.good()) {
+        return false;
+    }
+    bufferOffset += bufferSize;
+    input.read(&buffer[0], buffer.size());
+    bufferSize = input.gcount();
+    runStatistics.countRead(bufferSize);
+    bufferPosition = 0;
+    return (bufferSize > 0);
+}
+
+int AlignmentReader::peekChar () {
+    if (!fillBuffer()) {
+        return EOF;
+    }
+    return (unsigned char)buffer[bufferPosition];
+}
+
+int AlignmentReader::getChar () {
+    if (!fillBuffer()) {
+        return EOF;
+    }
+    int character = (unsigned char)buffer[bufferPosition++];
+    if (character == '\n') {
+        lineNumber++;
+    }
+    return character;
+}
+
+void AlignmentReader::skipComment () {
+// NEXUS comments nest: '[a [b] c]'
+    int depth = 0;
+    int character;
+    while ((character = getChar()) != EOF) {
+        if (character == '[') {
+            depth++;
+        } else if (character == ']' && --depth == 0) {
+            return;
+        }
+    }
+}
+
+void AlignmentReader::skipWhiteSpace (bool const& stopAtNewline) {
+    int character;
+    while ((character = peekChar()) != EOF) {
+        if (character == '[' && format == "nexus") {
+            skipComment();
+        } else if (isspace(character) && !(stopAtNewline && character == '\n')) {
+            getChar();
+        } else {
+            return;
+        }
+    }
+}
+
+void AlignmentReader::skipLine () {
+    int character;
+    while ((character = getChar()) != EOF && character != '\n') {
+    }
+}
+
+string AlignmentReader::readNexusToken () {
+// A word, a quoted name ('' inside quotes is a literal quote), or one of ';' and '='
+    skipWhiteSpace(false);
+    string token;
+    int character = peekChar();
+    if (character == EOF) {
+        return token;
+    }
+    if (character == ';' || character == '=') {
+        token += (char)getChar();
+        return token;
+    }
+    if (character == '\'') {
+        getChar();
+        while ((character = getChar()) != EOF) {
+            if (character == '\'') {
+                if (peekChar() != '\'') {
+                    break;
+                }
+                getChar();
+            }
+            token += (char)character;
+        }
+        return token;
+    }
+    while ((character = peekChar()) != EOF && !isspace(character) && character != ';' && character != '='
+        && character != '[')
+    {
+        token += (char)getChar();
+    }
+    return token;
+}
+
+string AlignmentReader::readWord () {
+    skipWhiteSpace(false);
+    string word;
+    int character;
+    while ((character = peekChar()) != EOF && !isspace(character)) {
+        word += (char)getChar();
+    }
+    return word;
+}
+
+void AlignmentReader::startSequence (string const& name, long long const& expectedLength) {
+    if (DEBUG) {cout << "Reading in taxon '" << name << "'..." << endl;}
+    alignment->push_back(vector <string>(2));
+    alignment->back()[0] = name;
+    if (sequenceRanges != NULL) {
+        sequenceRanges->push_back(vector <SequenceRange>());
+        sequenceLengths.push_back(0);
+    } else if (expectedLength > 0) {
+        alignment->back()[1].reserve(expectedLength);
+    }
+}
+
+long long AlignmentReader::getSequenceLength (int const& taxon) {
+    return (sequenceRanges != NULL) ? sequenceLengths[taxon] : (long long)(*alignment)[taxon][1].size();
+}
+
+int AlignmentReader::readSequence (int const& taxon, long long const& maxLength, bool const& stopAtNewline) {
+// Adds sequence characters to the taxon until it holds maxLength of them (if maxLength > 0), a
+// line ends (if stopAtNewline), or the format's terminator (';' NEXUS, '>' FASTA) or the end of
+// the file is reached. Whitespace and NEXUS [comments] are skipped; everything else is a state.
+// Runs of states are appended from the read buffer in one go, or only their file offsets are
+// recorded when reading ranges. Returns what stopped the read: 0 for maxLength, '\n', the
+// (unread) terminator or EOF.
+    int terminator = (format == "nexus") ? ';' : ((format == "fasta") ? '>' : EOF);
+    bool nexusComments = (format == "nexus");
+    while (true) {
+        long long length = getSequenceLength(taxon);
+        if (maxLength > 0 && length >= maxLength) {
+            return 0;
+        }
+        if (!fillBuffer()) {
+            return EOF;
+        }
+        char const* chunk = &buffer[bufferPosition];
+        size_t available = bufferSize - bufferPosition;
+        if (maxLength > 0 && available > (size_t)(maxLength - length)) {
+            available = maxLength - length;
+        }
+        size_t runLength = 0;
+        while (runLength < available && !isspace((unsigned char)chunk[runLength])
+            && (unsigned char)chunk[runLength] != terminator && !(nexusComments && chunk[runLength] == '['))
+        {
+            runLength++;
+        }
+        if (runLength > 0 && sequenceRanges == NULL) {
+            (*alignment)[taxon][1].append(chunk, runLength);
+        } else if (runLength > 0) {
+            vector <SequenceRange> & ranges = (*sequenceRanges)[taxon];
+            long long offset = bufferOffset + bufferPosition;
+            if (!ranges.empty() && ranges.back().offset + ranges.back().length == offset) {
+                ranges.back().length += runLength; // run split by the chunk boundary
+            } else {
+                SequenceRange range = {offset, (long long)runLength};
+                ranges.push_back(range);
+            }
+            sequenceLengths[taxon] += runLength;
+        }
+        if (runLength > 0) {
+            bufferPosition += runLength;
+            continue;
+        }
+        int character = peekChar();
+        if (character == terminator) {
+            return character;
+        } else if (nexusComments && character == '[') {
+            skipComment();
+        } else if (character == '\n' && stopAtNewline) {
+            getChar();
+            return '\n';
+        } else {
+            getChar();
+        }
+    }
+}
+
+string AlignmentReader::composeError (string const& message) {
+    return format + " file '" + fileName + "', line " + convertIntToString(lineNumber) + ": " + message;
+}
+
+string const& AlignmentReader::getFormat () const {
+    return format;
+}
+
+bool AlignmentReader::readAlignmentRanges (vector < vector <string> > & taxaAlignment,
+    vector < vector <SequenceRange> > & ranges, long long & numTaxa, long long & numChar, bool & interleavedData,
+    string & errorMessage)
+{
+// Names only: each sequence becomes the file ranges holding its states, and its text a marker
+// (composeSequenceMarker) to be replaced by those states when the xml is written.
+    ranges.clear();
+    sequenceRanges = &ranges;
+    if (!readAlignment(taxaAlignment, numTaxa, numChar, interleavedData, errorMessage)) {
+        return false;
+    }
+    for (int i = 0; i < numTaxa; i++) {
+        taxaAlignment[i][1] = composeSequenceMarker(i);
+    }
+    return true;
+}
+
+bool AlignmentReader::detectFormat (string & errorMessage) {
+    if (!input.is_open()) {
+        errorMessage = "unable to open '" + fileName + "'";
+        return false;
+    }
+    skipWhiteSpace(false);
+    int firstCharacter = peekChar();
+    if (firstCharacter == '#') {
+        format = "nexus";
+    } else if (firstCharacter == '>') {
+        format = "fasta";
+    } else if (firstCharacter != EOF && isdigit(firstCharacter)) {
+        format = "phylip";
+    } else {
+        errorMessage = "'" + fileName + "' is not a NEXUS, FASTA or PHYLIP alignment";
+        return false;
+    }
+    if (DEBUG) {cout << "Reading '" << fileName << "' as " << format << endl;}
+    return true;
+}
+
+bool AlignmentReader::readDimensions (long long & numTaxa, long long & numChar, string & errorMessage) {
+// Only as much of the file as gives ntax and nchar: a NEXUS file up to its 'matrix', the first
+// line of a PHYLIP file. FASTA has no header, so its first sequence is read (for nchar) and the
+// '>' starting the other lines counted.
+    vector < vector <string> > firstSequence;
+    alignment = &firstSequence;
+    numTaxa = 0;
+    numChar = 0;
+    bool interleavedData = false;
+    dimensionsOnly = true;
+    if (!detectFormat(errorMessage)) {
+        return false;
+    }
+    if (format == "nexus") {
+        return readNexus(firstSequence, numTaxa, numChar, interleavedData, errorMessage);
+    } else if (format == "phylip") {
+        return readPhylip(firstSequence, numTaxa, numChar, interleavedData, errorMessage);
+    }
+    return readFasta(firstSequence, numTaxa, numChar, errorMessage);
+}
+
+long long AlignmentReader::countFastaRecords () {
+// '>' at the start of a line, from the read position to the end of the file
+    long long numRecords = 0;
+    char previous = '\n';
+    while (fillBuffer()) {
+        char const* chunk = &buffer[bufferPosition];
+        size_t available = bufferSize - bufferPosition;
+        for (size_t i = 0; i < available; i++) {
+            if (chunk[i] == '>' && previous == '\n') {
+                numRecords++;
+            }
+            previous = chunk[i];
+        }
+        bufferPosition = bufferSize;
+    }
+    return numRecords;
+}
+
+bool AlignmentReader::readAlignment (vector < vector <string> > & taxaAlignment, long long & numTaxa, long long & numChar,
+    bool & interleavedData, string & errorMessage)
+{
+    taxaAlignment.clear();
+    alignment = &taxaAlignment;
+    numTaxa = 0;
+    numChar = 0;
+    interleavedData = false;
+    if (!detectFormat(errorMessage)) {
+        return false;
+    }
+    
+    bool success = false;
+    if (format == "nexus") {
+        success = readNexus(taxaAlignment, numTaxa, numChar, interleavedData, errorMessage);
+    } else if (format == "phylip") {
+        success = readPhylip(taxaAlignment, numTaxa, numChar, interleavedData, errorMessage);
+    } else {
+        success = readFasta(taxaAlignment, numTaxa, numChar, errorMessage);
+    }
+    if (!success) {
+        return false;
+    }
+    for (int i = 0; i < (int)taxaAlignment.size(); i++) {
+        if (getSequenceLength(i) != numChar) {
+            errorMessage = format + " file '" + fileName + "': taxon '" + taxaAlignment[i][0] + "' has "
+                + convertIntToString(getSequenceLength(i)) + " characters, not " + convertIntToString(numChar);
+            return false;
+        }
+    }
+    if (DEBUG) {cout << "Read " << numTaxa << " taxa of " << numChar << " characters. Woo-hoo!" << endl;}
+    return true;
+}
+
+bool AlignmentReader::readNexus (vector < vector <string> > & taxaAlignment, long long & numTaxa, long long & numChar,
+    bool & interleavedData, string & errorMessage)
+{
+// Statements are read token by token, so 'dimensions' and 'format' may span lines and put
+// spaces around '='. Only the first 'matrix' is read; all other statements are skipped.
+    string token = readNexusToken();
+    for (string::size_type i = 0; i < token.size(); i++) {
+        token[i] = tolower(token[i]);
+    }
+    if (token != "#nexus") {
+        errorMessage = composeError("expected '#NEXUS', found '" + token + "'");
+        return false;
+    }
+    while (true) {
+        token = readNexusToken();
+        if (token.empty()) {
+            errorMessage = composeError("no 'matrix' found");
+            return false;
+        }
+        string keyword = token;
+        for (string::size_type i = 0; i < keyword.size(); i++) {
+            keyword[i] = tolower(keyword[i]);
+        }
+        if (keyword == "matrix") {
+            return readNexusMatrix(taxaAlignment, numTaxa, numChar, interleavedData, errorMessage);
+        }
+        string lastKey;
+        while (!token.empty() && token != ";") {
+            token = readNexusToken();
+            string key = token;
+            for (string::size_type i = 0; i < key.size(); i++) {
+                key[i] = tolower(key[i]);
+            }
+            if (keyword == "dimensions" && token == "=" && (lastKey == "ntax" || lastKey == "nchar")) {
+                string value = readNexusToken();
+                long long & dimension = (lastKey == "ntax") ? numTaxa : numChar;
+                if (value.find_first_not_of("0123456789") != string::npos || !parseCount(value, dimension)
+                    || (lastKey == "ntax" && dimension > INT_MAX))
+                {
+                    errorMessage = composeError("invalid " + lastKey + " '" + value + "'");
+                    return false;
+                }
+                if (DEBUG) {cout << (lastKey == "ntax" ? "NTax = " : "NChar = ") << value << endl;}
+            } else if (keyword == "format" && key == "interleave") {
+                interleavedData = true;
+                skipWhiteSpace(false);
+                if (peekChar() == '=') {
+                    readNexusToken();
+                    string value = readNexusToken();
+                    for (string::size_type i = 0; i < value.size(); i++) {
+                        value[i] = tolower(value[i]);
+                    }
+                    interleavedData = (value != "no");
+                }
+                if (!dimensionsOnly) {
+                    cout << (interleavedData ? "Data are in interleaved format." : "Data are not in interleaved format.") << endl;
+                }
+            }
+            lastKey = key;
+        }
+    }
+}
+
+bool AlignmentReader::readNexusMatrix (vector < vector <string> > & taxaAlignment, long long const& numTaxa,
+    long long const& numChar, bool const& interleavedData, string & errorMessage)
+{
+// Sequential: each name is followed by numChar states, over as many lines as needed.
+// Interleaved: blocks of one line per taxon, in the same order in every block.
+    if (numTaxa <= 0 || numChar <= 0) {
+        errorMessage = composeError("'matrix' before a 'dimensions' statement giving ntax and nchar");
+        return false;
+    }
+    if (dimensionsOnly) {
+        return true;
+    }
+    taxaAlignment.reserve(numTaxa);
+    int stop = 0;
+    for (int block = 0; stop != ';'; block++) {
+        for (int taxonIter = 0; taxonIter < numTaxa; taxonIter++) {
+            string name = readNexusToken();
+            if (name == ";" && taxonIter == 0 && block > 0) {
+                stop = ';';
+                break;
+            }
+            if (name.empty() || name == ";") {
+                errorMessage = composeError("matrix ends after " + convertIntToString(taxonIter) + " of "
+                    + convertIntToString(numTaxa) + " taxa");
+                return false;
+            }
+            if (block == 0) {
+                startSequence(name, numChar);
+            } else if (name != taxaAlignment[taxonIter][0]) {
+                errorMessage = composeError("expected taxon '" + taxaAlignment[taxonIter][0] + "' in interleaved block "
+                    + convertIntToString(block + 1) + ", found '" + name + "'");
+                return false;
+            }
+            stop = readSequence(taxonIter, interleavedData ? 0 : numChar, interleavedData);
+            if (stop == EOF || (stop == ';' && taxonIter < numTaxa - 1)) {
+                errorMessage = composeError("matrix ends within taxon '" + name + "'");
+                return false;
+            }
+        }
+        if (!interleavedData && stop != ';') {
+            string token = readNexusToken();
+            if (token != ";") {
+                errorMessage = composeError("expected ';' after " + convertIntToString(numTaxa) + " taxa of "
+                    + convertIntToString(numChar) + " characters, found '" + token + "'");
+                return false;
+            }
+            stop = ';';
+        }
+    }
+    return true;
+}
+
+bool AlignmentReader::readPhylip (vector < vector <string> > & taxaAlignment, long long & numTaxa, long long & numChar,
+    bool & interleavedData, string & errorMessage)
+{
+// Relaxed PHYLIP: 'ntax nchar' on the first line, then names of any length separated from the
+// states by whitespace. When the first sequence is shorter than nchar on its line, the file is
+// either sequential with wrapped sequences or interleaved (later blocks carry states only, one
+// line per taxon in the same order). It is taken as sequential if the following lines complete
+// the first sequence exactly at the end of a line; in an interleaved file those lines begin with
+// the next names, so the count overshoots within a line (or the file ends) and the reader goes
+// back to the second line.
+    string numTaxaString = readWord();
+    string numCharString = readWord();
+    if (numTaxaString.find_first_not_of("0123456789") != string::npos
+        || numCharString.empty() || numCharString.find_first_not_of("0123456789") != string::npos)
+    {
+        errorMessage = composeError("expected 'ntax nchar', found '" + numTaxaString + " " + numCharString + "'");
+        return false;
+    }
+    if (!parseCount(numTaxaString, numTaxa) || !parseCount(numCharString, numChar) || numTaxa > INT_MAX) {
+        errorMessage = composeError("ntax or nchar out of range ('" + numTaxaString + " " + numCharString + "')");
+        return false;
+    }
+    if (numTaxa <= 0 || numChar <= 0) {
+        errorMessage = composeError("ntax and nchar must be positive");
+        return false;
+    }
+    if (dimensionsOnly) {
+        return true;
+    }
+    skipLine();
+    
+    taxaAlignment.reserve(numTaxa);
+    interleavedData = false;
+    for (int taxonIter = 0; taxonIter < numTaxa; taxonIter++) {
+        string name = readWord();
+        if (name.empty()) {
+            errorMessage = composeError("file ends after " + convertIntToString(taxonIter) + " of "
+                + convertIntToString(numTaxa) + " taxa");
+            return false;
+        }
+        startSequence(name, numChar);
+        readSequence(taxonIter, numChar, true);
+        if (taxonIter == 0 && getSequenceLength(0) < numChar && numTaxa > 1) {
+            interleavedData = !checkWrappedSequence(numChar);
+            if (interleavedData) {
+                cout << "Data are in interleaved format." << endl;
+            }
+        }
+        if (!interleavedData && getSequenceLength(taxonIter) < numChar) {
+            readSequence(taxonIter, numChar, false);
+        }
+    }
+    
+    while (interleavedData && getSequenceLength((int)numTaxa - 1) < numChar) {
+        for (int taxonIter = 0; taxonIter < numTaxa; taxonIter++) {
+            skipWhiteSpace(false);
+            if (readSequence(taxonIter, numChar, true) == EOF && getSequenceLength(taxonIter) < numChar)
+            {
+                errorMessage = composeError("file ends within taxon '" + taxaAlignment[taxonIter][0] + "'");
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+bool AlignmentReader::checkWrappedSequence (long long const& numChar) {
+// Reads on with the first taxon from the end of its first line. True (and the taxon complete) if
+// its states reach nchar exactly at the end of a line; otherwise the taxon is cut back to its
+// first line and reading resumes at the start of the second.
+    long long firstLineLength = getSequenceLength(0);
+    long long lineOffset = bufferOffset + bufferPosition;
+    int line = lineNumber;
+    while (getSequenceLength(0) < numChar && readSequence(0, numChar, true) != EOF) {
+    }
+    if (getSequenceLength(0) == numChar) {
+        skipWhiteSpace(true);
+        int character = peekChar();
+        if (character == '\n' || character == EOF) {
+            return true;
+        }
+    }
+    truncateSequence(0, firstLineLength);
+    input.clear();
+    input.seekg(lineOffset);
+    bufferOffset = lineOffset;
+    bufferPosition = 0;
+    bufferSize = 0;
+    lineNumber = line;
+    return false;
+}
+
+void AlignmentReader::truncateSequence (int const& taxon, long long const& length) {
+    if (sequenceRanges == NULL) {
+        (*alignment)[taxon][1].resize(length);
+        return;
+    }
+    vector <SequenceRange> & ranges = (*sequenceRanges)[taxon];
+    long long kept = 0;
+    int numRanges = 0;
+    while (numRanges < (int)ranges.size() && kept < length) {
+        if (kept + ranges[numRanges].length > length) {
+            ranges[numRanges].length = length - kept;
+        }
+        kept += ranges[numRanges].length;
+        numRanges++;
+    }
+    ranges.resize(numRanges);
+    sequenceLengths[taxon] = kept;
+}
+
+bool AlignmentReader::readFasta (vector < vector <string> > & taxaAlignment, long long & numTaxa, long long & numChar,
+    string & errorMessage)
+{
+// '>name [description]' then the sequence over any number of lines. All sequences must have the
+// length of the first, which sets nchar.
+    while (getChar() == '>') {
+        string name = readWord();
+        if (name.empty()) {
+            errorMessage = composeError("sequence without a name");
+            return false;
+        }
+        skipLine();
+        startSequence(name, numChar);
+        readSequence(taxaAlignment.size() - 1, 0, false);
+        if (taxaAlignment.size() == 1) {
+            numChar = getSequenceLength(0);
+            if (dimensionsOnly) {
+                numTaxa = 1 + countFastaRecords();
+                return true;
+            }
+        }
+    }
+    numTaxa = taxaAlignment.size();
+    return true;
+}
+
+string composeSequenceMarker (int const& taxon) {
+// control characters cannot occur in xml text, so the marker cannot clash with real content
+    return "\x01" + convertIntToString(taxon) + "\x01";
+}
+
+long long readSequenceRanges (int const& sourceDescriptor, vector <SequenceRange> const& ranges,
+    long long const& from, long long const& maxLength, string & states)
+{
+// States from..from+maxLength-1 of one taxon into 'states'; returns how many were read
+    states.clear();
+    long long skip = from;
+    for (int i = 0; i < (int)ranges.size() && (long long)states.size() < maxLength; i++) {
+        if (skip >= ranges[i].length) {
+            skip -= ranges[i].length;
+            continue;
+        }
+        long long length = ranges[i].length - skip;
+        if (length > maxLength - (long long)states.size()) {
+            length = maxLength - states.size();
+        }
+        size_t start = states.size();
+        states.resize(start + length);
+        ssize_t numRead = pread(sourceDescriptor, &states[start], length, ranges[i].offset + skip);
+        runStatistics.countRead((numRead > 0) ? numRead : 0);
+        if (numRead != length) {
+            states.resize(start + (numRead > 0 ? numRead : 0));
+            break;
+        }
+        skip = 0;
+    }
+    return states.size();
+}
+
+static bool writeAll (int const& outputDescriptor, char const* data, size_t length) {
+    while (length > 0) {
+        ssize_t numWritten = write(outputDescriptor, data, length);
+        runStatistics.countWrite((numWritten > 0) ? numWritten : 0);
+        if (numWritten < 0 && errno == EINTR) {
+            continue;
+        }
+        if (numWritten <= 0) {
+            return false;
+        }
+        data += numWritten;
+        length -= numWritten;
+    }
+    return true;
+}
+
+static bool copyRange (int const& sourceDescriptor, SequenceRange const& range, int const& outputDescriptor,
+    string & pending)
+{
+// Short ranges (lines of interleaved or wrapped files) are gathered into 'pending' and written in
+// large blocks. Long ones are copied inside the kernel: copy_file_range where the filesystems
+// allow, else sendfile, else plain reads and writes.
+    size_t inKernelMinimum = 1 << 16;
+    size_t pendingMaximum = 1 << 20;
+    if ((size_t)range.length < inKernelMinimum) {
+        size_t start = pending.size();
+        pending.resize(start + range.length);
+        ssize_t numRead = pread(sourceDescriptor, &pending[start], range.length, range.offset);
+        runStatistics.countRead((numRead > 0) ? numRead : 0);
+        if (numRead != range.length) {
+            return false;
+        }
+        if (pending.size() >= pendingMaximum) {
+            bool written = writeAll(outputDescriptor, pending.data(), pending.size());
+            pending.clear();
+            return written;
+        }
+        return true;
+    }
+    if (!writeAll(outputDescriptor, pending.data(), pending.size())) {
+        return false;
+    }
+    pending.clear();
+    
+    loff_t sourceOffset = range.offset;
+    long long remaining = range.length;
+    while (remaining > 0) {
+        ssize_t numCopied = copy_file_range(sourceDescriptor, &sourceOffset, outputDescriptor, NULL, remaining, 0);
+        runStatistics.countWrite((numCopied > 0) ? numCopied : 0);
+        if (numCopied <= 0) {
+            break;
+        }
+        remaining -= numCopied;
+    }
+    while (remaining > 0) {
+        off_t offset = sourceOffset;
+        ssize_t numCopied = sendfile(outputDescriptor, sourceDescriptor, &offset, remaining);
+        runStatistics.countWrite((numCopied > 0) ? numCopied : 0);
+        if (numCopied <= 0) {
+            break;
+        }
+        sourceOffset = offset;
+        remaining -= numCopied;
+    }
+    vector <char> buffer(1 << 20);
+    while (remaining > 0) {
+        ssize_t numRead = pread(sourceDescriptor, &buffer[0], (remaining < (long long)buffer.size()) ? remaining : buffer.size(), sourceOffset);
+        runStatistics.countRead((numRead > 0) ? numRead : 0);
+        if (numRead <= 0 || !writeAll(outputDescriptor, &buffer[0], numRead)) {
+            return false;
+        }
+        sourceOffset += numRead;
+        remaining -= numRead;
+    }
+    return true;
+}
+
+bool writeWithSequenceRanges (string const& text, string const& sourceFileName,
+    vector < vector <SequenceRange> > const& sequenceRanges, string const& outputFileName)
+{
+// Writes 'text' with every sequence marker replaced by that taxon's states from the source file
+    int sourceDescriptor = open(sourceFileName.c_str(), O_RDONLY);
+    runStatistics.countOpen();
+    if (sourceDescriptor < 0) {
+        return false;
+    }
+    int outputDescriptor = open(outputFileName.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    runStatistics.countOpen();
+    if (outputDescriptor < 0) {
+        close(sourceDescriptor);
+        return false;
+    }
+    bool success = true;
+    string pending;
+    string::size_type position = 0;
+    while (success && position < text.size()) {
+        string::size_type markerStart = text.find('\x01', position);
+        string::size_type markerEnd = (markerStart == string::npos) ? string::npos : text.find('\x01', markerStart + 1);
+        if (markerEnd == string::npos) {
+            pending.append(text, position, string::npos);
+            break;
+        }
+        pending.append(text, position, markerStart - position);
+        int taxon = atoi(text.substr(markerStart + 1, markerEnd - markerStart - 1).c_str());
+        vector <SequenceRange> const& ranges = sequenceRanges[taxon];
+        for (int i = 0; success && i < (int)ranges.size(); i++) {
+            success = copyRange(sourceDescriptor, ranges[i], outputDescriptor, pending);
+        }
+        position = markerEnd + 1;
+    }
+    success = success && writeAll(outputDescriptor, pending.data(), pending.size());
+    close(sourceDescriptor);
+    success = (close(outputDescriptor) == 0) && success;
+    return success;
+}
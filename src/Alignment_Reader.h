@@ -0,0 +1,80 @@
+#ifndef _ALIGNMENT_READER_H_
+#define _ALIGNMENT_READER_H_
+
+// Streaming reader for DNA alignments in NEXUS, FASTA or relaxed PHYLIP format, detected from the
+// first non-blank character ('#' NEXUS, '>' FASTA, a digit PHYLIP). The file is read in fixed-size
+// chunks and runs of sequence characters are appended straight from the chunk into the caller's
+// alignment, so the data are never held twice. NEXUS statements may span lines and [comments]
+// are skipped anywhere; NEXUS and PHYLIP may be sequential or interleaved.
+//
+// For alignments too large to hold, readAlignmentRanges keeps only the names and, per taxon, the
+// byte ranges of the file holding its states (one per line or block when wrapped or interleaved).
+// Those are read back with readSequenceRanges and copied into the xml by writeWithSequenceRanges.
+// readDimensions stops as soon as ntax and nchar are known (for planning a batch with '-plan').
+
+struct SequenceRange {
+    long long offset;
+    long long length;
+};
+
+string composeSequenceMarker (int const& taxon);
+long long readSequenceRanges (int const& sourceDescriptor, vector <SequenceRange> const& ranges,
+    long long const& from, long long const& maxLength, string & states);
+bool writeWithSequenceRanges (string const& text, string const& sourceFileName,
+    vector < vector <SequenceRange> > const& sequenceRanges, string const& outputFileName);
+
+class AlignmentReader {
+    
+    ifstream input;
+    vector <char> buffer;
+    size_t bufferPosition, bufferSize;
+    long long bufferOffset;             // file offset of buffer[0]
+    int lineNumber;
+    string fileName, format;
+    vector < vector <string> > * alignment;
+    vector < vector <SequenceRange> > * sequenceRanges; // NULL unless reading ranges
+    vector <long long> sequenceLengths;
+    bool dimensionsOnly;                // readDimensions: stop once ntax and nchar are known
+    
+    bool fillBuffer ();
+    int peekChar ();
+    int getChar ();
+    void skipComment ();
+    void skipWhiteSpace (bool const& stopAtNewline);
+    void skipLine ();
+    string readNexusToken ();
+    string readWord ();
+    void startSequence (string const& name, long long const& expectedLength);
+    long long getSequenceLength (int const& taxon);
+    int readSequence (int const& taxon, long long const& maxLength, bool const& stopAtNewline);
+    bool checkWrappedSequence (long long const& numChar);
+    void truncateSequence (int const& taxon, long long const& length);
+    string composeError (string const& message);
+    bool detectFormat (string & errorMessage);
+    long long countFastaRecords ();
+    
+    bool readNexus (vector < vector <string> > & taxaAlignment, long long & numTaxa, long long & numChar,
+        bool & interleavedData, string & errorMessage);
+    bool readNexusMatrix (vector < vector <string> > & taxaAlignment, long long const& numTaxa, long long const& numChar,
+        bool const& interleavedData, string & errorMessage);
+    bool readPhylip (vector < vector <string> > & taxaAlignment, long long & numTaxa, long long & numChar,
+        bool & interleavedData, string & errorMessage);
+    bool readFasta (vector < vector <string> > & taxaAlignment, long long & numTaxa, long long & numChar,
+        string & errorMessage);
+    
+public:
+    
+    string const& getFormat () const;
+    bool readAlignment (vector < vector <string> > & taxaAlignment, long long & numTaxa, long long & numChar,
+        bool & interleavedData, string & errorMessage);
+    bool readDimensions (long long & numTaxa, long long & numChar, string & errorMessage);
+    bool readAlignmentRanges (vector < vector <string> > & taxaAlignment,
+        vector < vector <SequenceRange> > & ranges, long long & numTaxa, long long & numChar, bool & interleavedData,
+        string & errorMessage);
+    
+    AlignmentReader (string const& alignmentFileName);
+    AlignmentReader (string const& alignmentFileName, size_t const& chunkSize);
+    ~AlignmentReader () {};
+};
+
+#endif /* _ALIGNMENT_READER_H_ */
@@ -1,19 +1,30 @@
 #include <iostream>
 #include <sstream>
 #include <vector>
+#include <map>
 #include <fstream>
 #include <cstdlib>
+#include <climits>
 
 using namespace std;
 
 #include "General.h"
+#include "Log_Analysis.h"
+#include "File_Name_Pattern.h"
 #include "Analysis_Settings.h"
+#include "Substitution_Models.h"
+#include "Partitions.h"
 
 
 AnalysisSettings::AnalysisSettings ()
 :
     treePrior("bd"), manipulateTreeTopology(true), logPhylograms(false), overwrite(false),
-    mcmcLength(20000000), screenSampling(500), parameterSampling(1000), treeSampling(5000)
+    triageRuns(false), estimateMarginalLikelihood(false), fixFrequencies(false), useAmbiguities(false),
+    useAlignmentCache(false), streamSequences(false), mcmcLength(20000000), screenSampling(500),
+    parameterSampling(1000), treeSampling(5000), mleChainLength(1000000), targetSamples(0), mleSteps(100),
+    maxThreads(8), triageESS(200.0), burninFraction(0.1), outputByteBudget(0.0),
+    ultrametricTolerance(0.0), namePattern("b_{b}_d_{d}_a_{a}_n_{n}_sim_{model}_rep_{rep}.{ext}"),
+    treePattern("b_{b}_d_{d}_a_{a}_n_{n}_rep_{rep}.phy"), outputPattern("{root}"), planRun(false)
 {
     intializeDefaults();
 }
@@ -33,26 +44,307 @@ vector <string> AnalysisSettings::readListFromFile(string const& fileName) {
     return (listElements);
 }
 
+bool AnalysisSettings::applyOption (vector <string> tokens) {
+// One configuration line (e.g. '-mcmc 5e7'); false if it is not a setting. Flags take an
+// optional 'on'/'off' so that they can be varied in a settings grid (see Settings_Grid.h).
+    if (tokens[0] == "-namepattern") {
+        setNamePattern(tokens[1]);
+        return true;
+    } else if (tokens[0] == "-treepattern") {
+        setTreePattern(tokens[1]);
+        return true;
+    } else if (tokens[0] == "-outpattern") {
+        setOutputPattern(tokens[1]);
+        return true;
+    } else if (tokens[0] == "-cache") {
+        useAlignmentCache = checkFlagValue(tokens);
+        return true;
+    } else if (tokens[0] == "-stream") {
+        streamSequences = checkFlagValue(tokens);
+        return true;
+    } else if (tokens[0] == "-plan") {
+        setPlanRun((tokens.size() > 1) ? tokens[1] : "");
+        return true;
+    } else if (tokens[0] == "-mods") {
+        tokens.erase(tokens.begin());
+        setSubModels(tokens);
+        return true;
+    } else if (tokens[0] == "-mcmc") {
+        setMcmcLength(tokens[1]);
+        return true;
+    } else if (tokens[0] == "-tsamp") {
+        setTreeSampling(tokens[1]);
+        return true;
+    } else if (tokens[0] == "-psamp") {
+        setParameterSampling(tokens[1]);
+        return true;
+    } else if (tokens[0] == "-ssamp") {
+        setScreenSampling(tokens[1]);
+        return true;
+    } else if (tokens[0] == "-samples") {
+        setTargetSamples(tokens[1]);
+        return true;
+    } else if (tokens[0] == "-iobudget") {
+        setOutputByteBudget(tokens[1]);
+        return true;
+    } else if (tokens[0] == "-manifest") {
+        setManifestFileName(tokens[1]);
+        return true;
+    } else if (tokens[0] == "-maxthreads") {
+        setMaxThreads(tokens[1]);
+        return true;
+    } else if (tokens[0] == "-runscript") {
+        setRunScriptFileName(tokens[1]);
+        return true;
+    } else if (tokens[0] == "-format") {
+        tokens.erase(tokens.begin());
+        setOutputFormats(tokens);
+        return true;
+    } else if (tokens[0] == "-ambiguities") {
+        useAmbiguities = checkFlagValue(tokens);
+        return true;
+    } else if (tokens[0] == "-ultrametric") {
+        setUltrametricTolerance(tokens[1]);
+        return true;
+    } else if (tokens[0] == "-partition") {
+        setPartitionScheme(tokens[1]);
+        return true;
+    } else if (tokens[0] == "-templates") {
+        setTemplateDirectory(tokens[1]);
+        return true;
+    } else if (tokens[0] == "-logphy") {
+        logPhylograms = checkFlagValue(tokens);
+        return true;
+    } else if (tokens[0] == "-tprior") {
+        tokens.erase(tokens.begin());
+        setTreePriors(tokens);
+        return true;
+    } else if (tokens[0] == "-fixtree") {
+        manipulateTreeTopology = !checkFlagValue(tokens);
+        return true;
+    } else if (tokens[0] == "-tuneops") {
+        setOperatorTuning(tokens[1]);
+        return true;
+    } else if (tokens[0] == "-fixfreqs") {
+        fixFrequencies = checkFlagValue(tokens);
+        return true;
+    } else if (tokens[0] == "-clock") {
+        tokens.erase(tokens.begin());
+        setClockFlavours(tokens);
+        return true;
+    } else if (tokens[0] == "-rprior") {
+        tokens.erase(tokens.begin());
+        setRootPrior(tokens);
+        return true;
+    } else if (tokens[0] == "-overwrite") {
+        overwrite = checkFlagValue(tokens);
+        return true;
+    } else if (tokens[0] == "-mle") {
+        tokens.erase(tokens.begin());
+        setMarginalLikelihood(tokens);
+        return true;
+    } else if (tokens[0] == "-triage") {
+        setTriage(tokens[1]);
+        return true;
+    } else if (tokens[0] == "-burnin") {
+        setBurnin(tokens[1]);
+        return true;
+    }
+    return false;
+}
+
+bool AnalysisSettings::checkFlagValue (vector <string> const& tokens) {
+    if (tokens.size() < 2 || tokens[1] == "on" || tokens[1] == "yes" || tokens[1] == "true") {
+        return true;
+    } else if (tokens[1] == "off" || tokens[1] == "no" || tokens[1] == "false") {
+        return false;
+    }
+    throw BEASTifierError("option", "flag " + tokens[0] + " expects 'on' or 'off', found '" + tokens[1] + "'");
+}
+
+void AnalysisSettings::setGridLabel (string const& label) {
+    gridLabel = label;
+}
+
+string AnalysisSettings::getGridLabel () {
+    return gridLabel;
+}
+
 void AnalysisSettings::setMcmcLength (string val) {
-    mcmcLength = convertStringtoInt(val);
+    mcmcLength = convertStringtoCount(val, "chain length (-mcmc)", LLONG_MAX);
 }
 
 void AnalysisSettings::setScreenSampling (string val) {
-    screenSampling = convertStringtoInt(val);
+    screenSampling = convertStringtoCount(val, "screen sampling interval (-ssamp)", LLONG_MAX);
 }
 
 void AnalysisSettings::setParameterSampling (string val) {
-    parameterSampling = convertStringtoInt(val);
+    parameterSampling = convertStringtoCount(val, "parameter sampling interval (-psamp)", LLONG_MAX);
 }
 
 void AnalysisSettings::setTreeSampling (string val) {
-    treeSampling = convertStringtoInt(val);
+    treeSampling = convertStringtoCount(val, "tree sampling interval (-tsamp)", LLONG_MAX);
+}
+
+void AnalysisSettings::setTargetSamples (string val) {
+    targetSamples = convertStringtoCount(val, "number of samples (-samples)", LLONG_MAX);
+}
+
+void AnalysisSettings::setOutputByteBudget (string val) {
+// accepts plain bytes or a K/M/G suffix (e.g. '500M')
+    double multiplier = 1.0;
+    char suffix = toupper(val[val.size() - 1]);
+    if (suffix == 'K' || suffix == 'M' || suffix == 'G') {
+        multiplier = (suffix == 'K') ? 1024.0 : (suffix == 'M') ? 1048576.0 : 1073741824.0;
+        val = val.substr(0, val.size() - 1);
+    }
+    checkValidFloat(val);
+    outputByteBudget = atof(val.c_str()) * multiplier;
+}
+
+void AnalysisSettings::setManifestFileName (string val) {
+    manifestFileName = val;
+}
+
+string AnalysisSettings::getManifestFileName () {
+    return manifestFileName;
+}
+
+void AnalysisSettings::setMaxThreads (string val) {
+    maxThreads = (int)convertStringtoCount(val, "thread count (-maxthreads)", INT_MAX);
+    if (maxThreads < 1) {
+        maxThreads = 1;
+    }
+}
+
+void AnalysisSettings::setRunScriptFileName (string val) {
+    runScriptFileName = val;
+}
+
+string AnalysisSettings::getRunScriptFileName () {
+    return runScriptFileName;
+}
+
+void AnalysisSettings::setOutputFormats (vector <string> const& formatVals) {
+    outputFormats = formatVals;
+    for (int i = 0; i < (int)outputFormats.size(); i++) {
+        checkOutputFormat(outputFormats[i]);
+    }
+}
+
+bool AnalysisSettings::checkOutputFormat (string const& formatString) {
+    bool cool = true;
+    if (formatString != "beast1" && formatString != "beast2") {
+        cool = false;
+        throw BEASTifierError("option", "output format '" + formatString + "' not recognized ('beast1' or 'beast2')");
+    }
+    return cool;
+}
+
+void AnalysisSettings::setUseAmbiguitiesTrue () {
+    useAmbiguities = true;
+}
+
+void AnalysisSettings::setUseAlignmentCacheTrue () {
+    useAlignmentCache = true;
+}
+
+bool AnalysisSettings::getUseAlignmentCache () {
+    return useAlignmentCache;
+}
+
+void AnalysisSettings::setStreamSequencesTrue () {
+    streamSequences = true;
+}
+
+bool AnalysisSettings::getStreamSequences () {
+    return streamSequences;
+}
+
+void AnalysisSettings::setNamePattern (string val) {
+    namePattern.compile(val);
+}
+
+void AnalysisSettings::setTreePattern (string val) {
+    treePattern.compile(val);
+}
+
+void AnalysisSettings::setOutputPattern (string val) {
+    outputPattern.compile(val);
+}
+
+void AnalysisSettings::checkFileNamePatterns () {
+// the tree and output patterns can only use fields that the name pattern sets
+    string undefinedField;
+    if (!treePattern.checkFieldsDefined(namePattern, undefinedField)
+        || !outputPattern.checkFieldsDefined(namePattern, undefinedField))
+    {
+        throw BEASTifierError("option", "file name field '{" + undefinedField + "}' is not in the name pattern '"
+            + namePattern.getPattern() + "'");
+    }
+}
+
+FileNamePattern const& AnalysisSettings::getNamePattern () {
+    return namePattern;
+}
+
+FileNamePattern const& AnalysisSettings::getTreePattern () {
+    return treePattern;
+}
+
+FileNamePattern const& AnalysisSettings::getOutputPattern () {
+    return outputPattern;
+}
+
+void AnalysisSettings::setPlanRun (string val) {
+// val: the file for the table of planned xml files (none if empty)
+    planRun = true;
+    planFileName = val;
+}
+
+bool AnalysisSettings::getPlanRun () {
+    return planRun;
+}
+
+string AnalysisSettings::getPlanFileName () {
+    return planFileName;
+}
+
+void AnalysisSettings::setTemplateDirectory (string val) {
+    templateDirectory = val;
+}
+
+string AnalysisSettings::getTemplateDirectory () {
+    return templateDirectory;
 }
 
 void AnalysisSettings::setTreeManipulationFalse () {
     manipulateTreeTopology = false;
 }
 
+void AnalysisSettings::setFixFrequenciesTrue () {
+    fixFrequencies = true;
+}
+
+void AnalysisSettings::setOperatorTuning (string const& listFileName) {
+// operator analysis tables of previous runs; each file is matched to new files by run size
+    checkValidInputFile(listFileName);
+    vector <string> opsFileNames = readListFromFile(listFileName);
+    for (int i = 0; i < (int)opsFileNames.size(); i++) {
+        OperatorAnalysis analysis;
+        if (!readOperatorAnalysis(opsFileNames[i], analysis)) {
+            cout << "Warning: no operator analysis found in '" << opsFileNames[i] << "'; ignored." << endl;
+            continue;
+        }
+        if (analysis.numTaxa == 0) {
+            cout << "Warning: size of the run behind '" << opsFileNames[i] << "' is unknown (no matching xml); ignored." << endl;
+            continue;
+        }
+        operatorAnalyses.push_back(analysis);
+    }
+    cout << "Read operator analyses of " << operatorAnalyses.size() << " previous runs." << endl;
+}
+
 void AnalysisSettings::setLogPhylogramsTrue () {
     logPhylograms = true;
 }
@@ -72,10 +364,30 @@ void AnalysisSettings::intializeDefaults () {
     
     clockFlavours = defaultClock;
     treePriors = defaultTreePr;
+    outputFormats.push_back("beast1");
 }
 
 void AnalysisSettings::setSubModels (vector <string> const& subModels) {
     models = subModels;
+    for (int i = 0; i < (int)models.size(); i++) {
+        checkSubModel(models[i]);
+    }
+}
+
+bool AnalysisSettings::checkSubModel (string const& modelString) {
+// substitution model must be in the model table; site model (after '+') must be I, G or IG
+    bool cool = true;
+    string subModelName = getStringElement(modelString, '+', 1);
+    string siteModelName = removeStringPrefix(modelString, '+');
+    if (siteModelName == subModelName) {
+        siteModelName = "none";
+    }
+    if (findSubstitutionModel(subModelName) == 0 || (siteModelName != "none" && siteModelName != "I"
+        && siteModelName != "G" && siteModelName != "IG")) {
+        cool = false;
+        throw BEASTifierError("option", "substitution model '" + modelString + "' not recognized");
+    }
+    return cool;
 }
 
 int AnalysisSettings::getNumSubModels () {
@@ -97,13 +409,7 @@ bool AnalysisSettings::checkClockFlavour (string const& clockString) {
     bool cool = true;
     if (clockString != "strict" && clockString != "ucln" && clockString != "uced" && clockString != "randlocal") {
         cool = false;
-        ofstream errorReport("Error.BEASTifier.txt");
-        errorReport << "BEASTifier  failed." << endl << "Error: clock flavour '";
-        errorReport << clockString << "' not recognized." << endl;
-        errorReport.close();
-        cerr << endl << "BEASTifier failed." << endl << "Error: clock flavour '";
-        cerr << clockString << "' not recognized. You fucked up, yo. Exiting." << endl << endl;
-        exit(1);
+        throw BEASTifierError("option", "clock flavour '" + clockString + "' not recognized");
     }
     return cool;
 }
@@ -128,13 +434,7 @@ bool AnalysisSettings::checkTreePrior (string const& treePriorString) {
     if (treePriorString != "bd" && treePriorString != "yule" && treePriorString != "concoal"
         && treePriorString != "expcoal" && treePriorString != "logcoal") {
         cool = false;
-        ofstream errorReport("Error.BEASTifier.txt");
-        errorReport << "BEASTifier  failed." << endl << "Error: tree prior flavour '";
-        errorReport << treePriorString << "' not recognized." << endl;
-        errorReport.close();
-        cerr << endl << "BEASTifier failed." << endl << "Error: tree prior flavour '";
-        cerr << treePriorString << "' not recognized. You fucked up, yo. Exiting." << endl << endl;
-        exit(1);
+        throw BEASTifierError("option", "tree prior flavour '" + treePriorString + "' not recognized");
     }
     return cool;
 }
@@ -150,19 +450,8 @@ int AnalysisSettings::getNumTreePriors () {
 void AnalysisSettings::setRootPrior (vector <string> const& rootPriorVals) {
     rootPrior = rootPriorVals;
     if (rootPrior.size() != 3) {
-        ofstream errorReport("Error.BEASTifier.txt");
-        errorReport << "BEASTifier  failed." << endl;
-        errorReport << "Error: Root prior must have three elements:" << endl;
-        errorReport << "   '-rprior unif min_value max_value'" << endl;
-        errorReport << "or" << endl;
-        errorReport << "   '-rprior norm mean_value stdev_value'" << endl;
-        errorReport.close();
-        cerr << "BEASTifier  failed." << endl;
-        cerr << "Error: Root prior must have three elements:" << endl;
-        cerr << "   '-rprior unif min_value max_value'" << endl;
-        cerr << "or" << endl;
-        cerr << "   '-rprior norm mean_value stdev_value'" << endl << endl;
-        exit(1);
+        throw BEASTifierError("option", "root prior must have three elements",
+            vector <string>(1, "'-rprior unif min_value max_value' or '-rprior norm mean_value stdev_value'"));
     }
     
     checkPriorFlavour(rootPrior[0]); // flavour; unif or norm
@@ -174,13 +463,7 @@ bool AnalysisSettings::checkPriorFlavour (string & priorString) {
     bool cool = true;
     if (priorString != "unif" && priorString != "norm") {
         cool = false;
-        ofstream errorReport("Error.BEASTifier.txt");
-        errorReport << "BEASTifier  failed." << endl << "Error: prior flavour '";
-        errorReport << priorString << "' not recognized." << endl;
-        errorReport.close();
-        cerr << endl << "BEASTifier failed." << endl << "Error: prior flavour '";
-        cerr << priorString << "' not recognized. You fucked up, yo. Exiting." << endl << endl;
-        exit(1);
+        throw BEASTifierError("option", "prior flavour '" + priorString + "' not recognized");
     }
     return cool;
 }
@@ -188,3 +471,54 @@ bool AnalysisSettings::checkPriorFlavour (string & priorString) {
 void AnalysisSettings::setOverwriteTrue () {
     overwrite = true;
 }
+
+void AnalysisSettings::setTriage (string val) {
+    checkValidFloat(val);
+    triageESS = atof(val.c_str());
+    triageRuns = true;
+}
+
+void AnalysisSettings::setBurnin (string val) {
+    checkValidFloat(val);
+    burninFraction = atof(val.c_str());
+    if (burninFraction < 0.0 || burninFraction >= 1.0) {
+        throw BEASTifierError("option", "burnin fraction '" + val + "' must be in [0, 1)");
+    }
+}
+
+void AnalysisSettings::setPartitionScheme (string val) {
+    if (!checkPartitionScheme(val)) {
+        throw BEASTifierError("option", "partition scheme '" + val + "' is not supported ('codon', 'codon12+3' or 'charsets')");
+    }
+    partitionScheme = val;
+}
+
+string AnalysisSettings::getPartitionScheme () {
+    return partitionScheme;
+}
+
+void AnalysisSettings::setUltrametricTolerance (string val) {
+    checkValidFloat(val);
+    ultrametricTolerance = atof(val.c_str());
+    if (ultrametricTolerance <= 0.0) {
+        throw BEASTifierError("option", "ultrametric tolerance '" + val + "' must be positive");
+    }
+}
+
+double AnalysisSettings::getUltrametricTolerance () {
+    return ultrametricTolerance;
+}
+
+void AnalysisSettings::setMarginalLikelihood (vector <string> const& mleVals) {
+    long long steps = 0;
+    long long chainLength = 0;
+    if (mleVals.size() != 2 || !parseCount(mleVals[0], steps) || !parseCount(mleVals[1], chainLength)
+        || steps < 1 || steps > INT_MAX || chainLength < 1)
+    {
+        throw BEASTifierError("option", "marginal likelihood estimation expects two positive integers",
+            vector <string>(1, "'-mle path_steps chain_length_per_step'"));
+    }
+    mleSteps = (int)steps;
+    mleChainLength = chainLength;
+    estimateMarginalLikelihood = true;
+}
@@ -4,14 +4,29 @@
 class AnalysisSettings {
     
     string treePrior;
-    bool manipulateTreeTopology, logPhylograms, overwrite;
-    int mcmcLength, screenSampling, parameterSampling, treeSampling;
-    vector <string> rootPrior, models, clockFlavours, treePriors;
+    bool manipulateTreeTopology, logPhylograms, overwrite, triageRuns, estimateMarginalLikelihood,
+        fixFrequencies, useAmbiguities, useAlignmentCache, streamSequences;
+    long long mcmcLength, screenSampling, parameterSampling, treeSampling, mleChainLength, targetSamples;
+    int mleSteps, maxThreads;
+    double triageESS, burninFraction, outputByteBudget, ultrametricTolerance;
+    string manifestFileName, templateDirectory, partitionScheme, runScriptFileName;
+    vector <string> rootPrior, models, clockFlavours, treePriors, outputFormats;
+    vector <OperatorAnalysis> operatorAnalyses;
+    FileNamePattern namePattern, treePattern, outputPattern;
+    string gridLabel;
+    bool planRun;
+    string planFileName;
         
 public:
     
     vector <string> readListFromFile(string const& fileName);
     void intializeDefaults ();
+    bool applyOption (vector <string> tokens);
+    bool checkFlagValue (vector <string> const& tokens);
+    
+// settings grid: the combination an xml file belongs to (appended to its name)
+    void setGridLabel (string const& label);
+    string getGridLabel ();
     
 // mcmc parameters
     void setMcmcLength (string val);
@@ -19,7 +34,59 @@ public:
     void setParameterSampling (string val);
     void setTreeSampling (string val);
     
+// per-file sampling interval planning
+    void setTargetSamples (string val);
+    void setOutputByteBudget (string val);
+    void setManifestFileName (string val);
+    string getManifestFileName ();
+    
+// BEAGLE settings and launch commands
+    void setMaxThreads (string val);
+    void setRunScriptFileName (string val);
+    string getRunScriptFileName ();
+    
+// output formats (BEAST 1 and/or BEAST 2 xml)
+    void setOutputFormats (vector <string> const& formatVals);
+    bool checkOutputFormat (string const& formatString);
+    void setUseAmbiguitiesTrue ();
+    
+// binary alignment cache (skips re-parsing unchanged alignments)
+    void setUseAlignmentCacheTrue ();
+    bool getUseAlignmentCache ();
+    
+// sequences copied from the alignment file at write time (alignments larger than memory)
+    void setStreamSequencesTrue ();
+    bool getStreamSequences ();
+    
+// alignment file names: fields, starting tree file and output root
+    void setNamePattern (string val);
+    void setTreePattern (string val);
+    void setOutputPattern (string val);
+    void checkFileNamePatterns ();
+    FileNamePattern const& getNamePattern ();
+    FileNamePattern const& getTreePattern ();
+    FileNamePattern const& getOutputPattern ();
+    
+// dry run: estimates of what would be written ('-plan')
+    void setPlanRun (string val);
+    bool getPlanRun ();
+    string getPlanFileName ();
+    
+// user overrides of the built-in xml templates
+    void setTemplateDirectory (string val);
+    string getTemplateDirectory ();
+    
+// data partitions (codon positions or charsets)
+    void setPartitionScheme (string val);
+    string getPartitionScheme ();
+    
+// starting tree checks
+    void setUltrametricTolerance (string val);
+    double getUltrametricTolerance ();
+    
     void setTreeManipulationFalse ();
+    void setFixFrequenciesTrue ();
+    void setOperatorTuning (string const& listFileName);
     void setLogPhylogramsTrue ();
     
     void setRootPrior (vector <string> const& rootPriorVals);
@@ -27,8 +94,16 @@ public:
     
     void setOverwriteTrue ();
     
+// convergence triage of previous runs
+    void setTriage (string val);
+    void setBurnin (string val);
+    
+// marginal likelihood estimation (path sampling / stepping-stone)
+    void setMarginalLikelihood (vector <string> const& mleVals);
+    
 // values to loop over
     void setSubModels (vector <string> const& subModels);
+    bool checkSubModel (string const& modelString);
     int getNumSubModels ();
     string getSubModel (int const& modelIndex);
     
@@ -0,0 +1,638 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <map>
+#include <cstdlib>
+
+using namespace std;
+
+#include "General.h"
+#include "Log_Analysis.h"
+#include "File_Name_Pattern.h"
+#include "Analysis_Settings.h"
+#include "Newick_Tree.h"
+#include "Partitions.h"
+#include "Alignment_Reader.h"
+#include "SimData.h"
+#include "Substitution_Models.h"
+#include "BEAST_XML.h"
+#include "BEAST2_XML.h"
+#include "XML_Templates.h"
+#include "Run_Statistics.h"
+
+extern bool DEBUG;
+extern double version;
+extern string month;
+extern int year;
+
+// functions for writing BEAST 2 xml files
+
+BEAST2XML::BEAST2XML (BEASTXML & source)
+:
+    analysis(source)
+{
+}
+
+bool BEAST2XML::checkTreePriorSupported (string const& treePrior) {
+// BEAST 2 has no logistic-growth coalescent
+    return (treePrior != "logcoal");
+}
+
+void BEAST2XML::writeFile (ostream & BEAST_xml_code, string const& serializedAlignment) {
+    writeXMLHeader (BEAST_xml_code);
+    BEAST_xml_code << serializedAlignment;
+    writePartitionInformation (BEAST_xml_code);
+    
+    BEAST_xml_code
+    << "<!-- *** MCMC PARAMETERS *** -->" << endl
+    << "    <run id=\"mcmc\" spec=\"MCMC\" chainLength=\"" << analysis.mcmcLength << "\">" << endl;
+    writeState (BEAST_xml_code);
+    writeStartingTree (BEAST_xml_code);
+    
+    BEAST_xml_code
+    << "        <distribution id=\"posterior\" spec=\"CompoundDistribution\">" << endl;
+    writePriors (BEAST_xml_code);
+    writeTreeLikelihoods (BEAST_xml_code);
+    BEAST_xml_code
+    << "        </distribution>" << endl << endl;
+    
+    writeOperators (BEAST_xml_code);
+    writeLoggers (BEAST_xml_code);
+    BEAST_xml_code
+    << "    </run>" << endl;
+    renderXMLTemplate(BEAST_xml_code, "beast2.tail");
+}
+
+void BEAST2XML::writeXMLHeader (ostream & BEAST_xml_code) {
+    ScopedTimer timer("emit.beast2.header");
+    ostringstream versionString;
+    versionString << version;
+    ostringstream yearString;
+    yearString << year;
+    
+    map <string, string> values;
+    values["version"] = versionString.str();
+    values["month"] = month;
+    values["year"] = yearString.str();
+    renderXMLTemplate(BEAST_xml_code, "beast2.header", values);
+    analysis.writeLaunchComment(BEAST_xml_code);
+    
+    if (analysis.estimateMarginalLikelihood) {
+        BEAST_xml_code
+        << "<!-- Marginal likelihood estimation ('-mle') is only written to BEAST 1 files. -->" << endl << endl;
+    }
+}
+
+void BEAST2XML::writeAlignment (ostream & BEAST_xml_code, long long const& numTaxa, long long const& numChar,
+    vector < vector <string> > const& taxaAlignment)
+{
+    ScopedTimer timer("emit.beast2.alignment");
+    BEAST_xml_code
+    << "<!-- *** NUCLEOTIDE ALIGNMENT *** -->" << endl
+    << "    <!-- numTaxa = " << numTaxa << " numChar = " << numChar << " -->" << endl
+    << "    <data id=\"alignment\" spec=\"Alignment\" dataType=\"nucleotide\">" << endl;
+    
+    for (int taxonIter = 0; taxonIter < numTaxa; taxonIter++) {
+        BEAST_xml_code
+        << "        <sequence id=\"seq_" << taxaAlignment[taxonIter][0] << "\" spec=\"Sequence\" taxon=\""
+        << taxaAlignment[taxonIter][0] << "\" totalcount=\"4\" value=\"" << taxaAlignment[taxonIter][1] << "\"/>" << endl;
+    }
+    BEAST_xml_code
+    << "    </data>" << endl << endl;
+}
+
+string BEAST2XML::getPartitionFilter (Partition const& partition) {
+// FilteredAlignment takes comma-separated '1-300' ranges and '1:300:3' strides, so a partition
+// of several charset ranges is a single filter
+    ostringstream filter;
+    for (int i = 0; i < (int)partition.ranges.size(); i++) {
+        CharacterRange const& range = partition.ranges[i];
+        long long to = (range.to == 0) ? analysis.numChar : range.to;
+        filter << (i ? "," : "") << range.from;
+        if (range.every > 1) {
+            filter << ":" << to << ":" << range.every;
+        } else if (to > range.from) {
+            filter << "-" << to;
+        }
+    }
+    return filter.str();
+}
+
+void BEAST2XML::writePartitionInformation (ostream & BEAST_xml_code) {
+    ScopedTimer timer("emit.beast2.partitions");
+    if (analysis.partitions.empty()) {
+        return;
+    }
+    BEAST_xml_code
+    << "<!-- *** DEFINE PARTITIONS *** -->" << endl;
+    for (int i = 0; i < (int)analysis.partitions.size(); i++) {
+        BEAST_xml_code
+        << "    <!-- " << analysis.partitions[i].name << ": " << analysis.partitionNumSites[i] << " sites -->" << endl
+        << "    <data id=\"" << analysis.partitionPrefixes[i] << "patterns\" spec=\"FilteredAlignment\" data=\"@alignment\" filter=\""
+        << getPartitionFilter(analysis.partitions[i]) << "\"/>" << endl;
+    }
+    BEAST_xml_code << endl;
+}
+
+void BEAST2XML::writeStateParameter (ostream & BEAST_xml_code, string const& id, string const& value,
+    string const& lower, string const& upper)
+{
+    BEAST_xml_code
+    << "            <parameter id=\"" << id << "\" name=\"stateNode\"";
+    if (!lower.empty()) {
+        BEAST_xml_code << " lower=\"" << lower << "\"";
+    }
+    if (!upper.empty()) {
+        BEAST_xml_code << " upper=\"" << upper << "\"";
+    }
+    BEAST_xml_code << ">" << value << "</parameter>" << endl;
+}
+
+void BEAST2XML::writeState (ostream & BEAST_xml_code) {
+    ScopedTimer timer("emit.beast2.state");
+// the tree and every estimated parameter; fixed parameters are defined where they are used
+    string numBranches = convertIntToString((2 * analysis.numTaxa) - 2);
+    string clockRate = analysis.getStartingClockRate(analysis.clockFlavour);
+    
+    BEAST_xml_code
+    << "        <state id=\"state\">" << endl
+    << "            <tree id=\"Tree\" spec=\"beast.evolution.tree.Tree\" name=\"stateNode\">" << endl
+    << "                <taxonset id=\"taxa\" spec=\"TaxonSet\" alignment=\"@alignment\"/>" << endl
+    << "            </tree>" << endl;
+    
+    if (analysis.treePrior == "bd") {
+        writeStateParameter(BEAST_xml_code, "birthDeath.BminusDRate", "1.0", "0.0", "");
+        writeStateParameter(BEAST_xml_code, "birthDeath.DoverB", "0.5", "0.0", "1.0");
+    } else if (analysis.treePrior == "yule") {
+        writeStateParameter(BEAST_xml_code, "yule.birthRate", "1.0", "0.0", "");
+    } else if (analysis.treePrior == "concoal") {
+        writeStateParameter(BEAST_xml_code, "constant.popSize", "0.3", "0.0", "");
+    } else if (analysis.treePrior == "expcoal") {
+        writeStateParameter(BEAST_xml_code, "exponential.popSize", "0.3", "0.0", "");
+        writeStateParameter(BEAST_xml_code, "exponential.growthRate", "3.0E-4", "", "");
+    }
+    
+    if (analysis.clockFlavour == "ucln") {
+        writeStateParameter(BEAST_xml_code, "ucld.mean", clockRate, "0.0", "10.0");
+        writeStateParameter(BEAST_xml_code, "ucld.stdev", "0.1", "0.0", "10.0");
+    } else if (analysis.clockFlavour == "uced") {
+        writeStateParameter(BEAST_xml_code, "uced.mean", clockRate, "0.0", "1000000.0");
+    } else if (analysis.clockFlavour == "randlocal") {
+        writeStateParameter(BEAST_xml_code, "clock.rate", clockRate, "0.0", "");
+        BEAST_xml_code
+        << "            <parameter id=\"localClock.relativeRates\" name=\"stateNode\" dimension=\"" << numBranches << "\" lower=\"0.0\">1.0</parameter>" << endl
+        << "            <stateNode id=\"localClock.changes\" spec=\"parameter.BooleanParameter\" dimension=\"" << numBranches << "\">false</stateNode>" << endl;
+    }
+    if (analysis.clockFlavour == "ucln" || analysis.clockFlavour == "uced") {
+        BEAST_xml_code
+        << "            <stateNode id=\"branchRates.categories\" spec=\"parameter.IntegerParameter\" dimension=\"" << numBranches << "\">1</stateNode>" << endl;
+    }
+    
+    for (int p = 0; p < (int)analysis.partitionSubstitutionModels.size(); p++) {
+        SubstitutionModel const& subModel = *findSubstitutionModel(analysis.partitionSubstitutionModels[p]);
+        string const& prefix = analysis.partitionPrefixes[p];
+        for (int i = 0; i < subModel.numParameters; i++) {
+            ModelParameter const& parameter = subModel.parameters[i];
+            if (!parameter.reference && checkEstimatedParameter(parameter)) {
+                writeStateParameter(BEAST_xml_code, prefix + subModel.id + "." + parameter.name, "1.0", "1.0E-8", "100.0");
+            }
+        }
+        if (subModel.frequencyWeight && !analysis.fixFrequencies) {
+            BEAST_xml_code
+            << "            <parameter id=\"" << prefix << subModel.id << ".frequencies\" name=\"stateNode\" dimension=\"4\" lower=\"0.0\" upper=\"1.0\">"
+            << analysis.getFrequencyValues(subModel, analysis.partitionFrequencies[p]) << "</parameter>" << endl;
+        }
+        if (analysis.partitionSiteModels[p] == "IG" || analysis.partitionSiteModels[p] == "G") {
+            writeStateParameter(BEAST_xml_code, prefix + "alpha", "0.5", "0.0", "1000.0");
+        }
+        if (analysis.partitionSiteModels[p] == "IG" || analysis.partitionSiteModels[p] == "I") {
+            writeStateParameter(BEAST_xml_code, prefix + "pInv", "0.25", "0.0", "1.0");
+        }
+        if (analysis.partitionPrefixes.size() > 1) {
+            writeStateParameter(BEAST_xml_code, prefix + "mu", "1.0", "0.0", "");
+        }
+    }
+    BEAST_xml_code
+    << "        </state>" << endl << endl;
+}
+
+void BEAST2XML::writeStartingTree (ostream & BEAST_xml_code) {
+    ScopedTimer timer("emit.beast2.startingTree");
+    if (analysis.starterTreePresent) {
+        BEAST_xml_code
+        << "<!-- *** STARTING TREE - MUST BE COMPATIBLE WITH MONOPHYLY/TEMPORAL CONSTRAINTS OR OR INITIAL STATE OF MODEL WILL HAVE ZERO PROBABILITY *** -->" << endl
+        << "        <init id=\"startingTree\" spec=\"beast.util.TreeParser\" initial=\"@Tree\" taxa=\"@alignment\""
+        << " IsLabelledNewick=\"true\" adjustTipHeights=\"false\" newick=\"" << analysis.starterTree << "\"/>" << endl << endl;
+        return;
+    }
+    BEAST_xml_code
+    << "    <!-- Generate a random starting tree under the coalescent process -->" << endl
+    << "        <init id=\"startingTree\" spec=\"beast.evolution.tree.RandomTree\" initial=\"@Tree\" taxa=\"@alignment\" rootHeight=\""
+    << analysis.startingRootHeight << "\">" << endl
+    << "            <populationModel id=\"initialDemo\" spec=\"ConstantPopulation\">" << endl
+    << "                <parameter id=\"initialDemo.popSize\" name=\"popSize\">100.0</parameter>" << endl
+    << "            </populationModel>" << endl
+    << "        </init>" << endl << endl;
+}
+
+void BEAST2XML::writePrior (ostream & BEAST_xml_code, string const& parameter, string const& distribution) {
+    BEAST_xml_code
+    << "                <distribution id=\"" << parameter << ".prior\" spec=\"Prior\" x=\"@" << parameter << "\">" << endl
+    << "                    <distr " << distribution << "/>" << endl
+    << "                </distribution>" << endl;
+}
+
+void BEAST2XML::writePriors (ostream & BEAST_xml_code) {
+    ScopedTimer timer("emit.beast2.priors");
+// same priors as the BEAST 1 files (improper uniform priors on the tree prior rates)
+    BEAST_xml_code
+    << "            <distribution id=\"prior\" spec=\"CompoundDistribution\">" << endl;
+    renderXMLTemplate(BEAST_xml_code, "beast2.treePrior." + analysis.treePrior);
+    
+    if (analysis.treePrior == "bd") {
+        writePrior(BEAST_xml_code, "birthDeath.BminusDRate", "spec=\"beast.math.distributions.Uniform\" lower=\"0.0\" upper=\"100000.0\"");
+        writePrior(BEAST_xml_code, "birthDeath.DoverB", "spec=\"beast.math.distributions.Uniform\" lower=\"0.0\" upper=\"1.0\"");
+    } else if (analysis.treePrior == "yule") {
+        writePrior(BEAST_xml_code, "yule.birthRate", "spec=\"beast.math.distributions.Uniform\" lower=\"0.0\" upper=\"1.0E100\"");
+    } else if (analysis.treePrior == "concoal") {
+        writePrior(BEAST_xml_code, "constant.popSize", "spec=\"OneOnX\"");
+    } else if (analysis.treePrior == "expcoal") {
+        writePrior(BEAST_xml_code, "exponential.popSize", "spec=\"OneOnX\"");
+        writePrior(BEAST_xml_code, "exponential.growthRate", "spec=\"LaplaceDistribution\" mu=\"0.0\" scale=\"30.701134573253945\"");
+    }
+    
+    if (analysis.clockFlavour == "ucln") {
+        writePrior(BEAST_xml_code, "ucld.stdev", "spec=\"Exponential\" mean=\"0.3333333333333333\"");
+    } else if (analysis.clockFlavour == "randlocal") {
+        BEAST_xml_code
+        << "                <distribution id=\"rateChanges.prior\" spec=\"Prior\">" << endl
+        << "                    <x id=\"rateChanges\" spec=\"Sum\" arg=\"@localClock.changes\"/>" << endl
+        << "                    <distr spec=\"Poisson\" lambda=\"0.6931471805599453\"/>" << endl
+        << "                </distribution>" << endl;
+        writePrior(BEAST_xml_code, "localClock.relativeRates", "spec=\"Gamma\" alpha=\"0.5\" beta=\"2.0\"");
+    }
+    
+// the root prior is on the age of the most recent common ancestor of all taxa
+    vector <string> const& rootPrior = analysis.rootPrior;
+    if (!rootPrior.empty()) {
+        BEAST_xml_code
+        << "                <distribution id=\"treeModel.rootHeight.prior\" spec=\"MRCAPrior\" tree=\"@Tree\" taxonset=\"@taxa\" monophyletic=\"false\">" << endl;
+        if (rootPrior[0] == "unif") {
+            BEAST_xml_code
+            << "                    <distr spec=\"beast.math.distributions.Uniform\" lower=\"" << rootPrior[1] << "\" upper=\"" << rootPrior[2] << "\"/>" << endl;
+        } else {
+            BEAST_xml_code
+            << "                    <distr spec=\"Normal\" mean=\"" << rootPrior[1] << "\" sigma=\"" << rootPrior[2] << "\"/>" << endl;
+        }
+        BEAST_xml_code
+        << "                </distribution>" << endl;
+    }
+    
+    for (int p = 0; p < (int)analysis.partitionSubstitutionModels.size(); p++) {
+        SubstitutionModel const& subModel = *findSubstitutionModel(analysis.partitionSubstitutionModels[p]);
+        for (int i = 0; i < subModel.numParameters; i++) {
+            ModelParameter const& parameter = subModel.parameters[i];
+            if (!checkEstimatedParameter(parameter)) {
+                continue;
+            }
+            string parameterName = analysis.partitionPrefixes[p] + subModel.id + "." + parameter.name;
+            if (parameter.prior == logNormalKappaPrior) {
+                writePrior(BEAST_xml_code, parameterName, "spec=\"LogNormalDistributionModel\" M=\"1.0\" S=\"1.25\" meanInRealSpace=\"false\"");
+            } else if (parameter.prior == gammaRatePrior) {
+                writePrior(BEAST_xml_code, parameterName, "spec=\"Gamma\" alpha=\"0.05\" beta=\"10.0\"");
+            }
+        }
+    }
+    BEAST_xml_code
+    << "            </distribution>" << endl;
+}
+
+void BEAST2XML::writeSubstitutionModel (ostream & BEAST_xml_code, SubstitutionModel const& subModel,
+    string const& prefix, vector <double> const& frequencies)
+{
+// 'hkyModel' entries map to BEAST 2's HKY, 'gtrModel' entries to GTR (whose rateCT is fixed at 1,
+// as in BEAST 1). Estimated and linked rates refer to the state; fixed rates are defined in place.
+    string modelId = prefix + subModel.id;
+    string spec = (string(subModel.element) == "hkyModel") ? "HKY" : "GTR";
+    
+    BEAST_xml_code
+    << "                        <!-- " << subModel.description << " -->" << endl
+    << "                        <substModel id=\"" << modelId << "\" spec=\"" << spec << "\"";
+    for (int i = 0; i < subModel.numParameters; i++) {
+        ModelParameter const& parameter = subModel.parameters[i];
+        if (parameter.reference || checkEstimatedParameter(parameter)) {
+            BEAST_xml_code << " " << parameter.element << "=\"@" << modelId << "." << parameter.name << "\"";
+        }
+    }
+    BEAST_xml_code << ">" << endl;
+    for (int i = 0; i < subModel.numParameters; i++) {
+        ModelParameter const& parameter = subModel.parameters[i];
+        if (!parameter.reference && !checkEstimatedParameter(parameter)) {
+            BEAST_xml_code
+            << "                            <parameter id=\"" << modelId << "." << parameter.name << "\" name=\"" << parameter.element
+            << "\" estimate=\"false\">1.0</parameter>" << endl;
+        }
+    }
+    if (subModel.frequencyWeight && !analysis.fixFrequencies) {
+        BEAST_xml_code
+        << "                            <frequencies id=\"" << modelId << ".freqs\" spec=\"Frequencies\" frequencies=\"@" << modelId << ".frequencies\"/>" << endl;
+    } else {
+        BEAST_xml_code
+        << "                            <frequencies id=\"" << modelId << ".freqs\" spec=\"Frequencies\">" << endl
+        << "                                <parameter id=\"" << modelId << ".frequencies\" name=\"frequencies\" estimate=\"false\">"
+        << analysis.getFrequencyValues(subModel, frequencies) << "</parameter>" << endl
+        << "                            </frequencies>" << endl;
+    }
+    BEAST_xml_code
+    << "                        </substModel>" << endl;
+}
+
+void BEAST2XML::writeSiteModel (ostream & BEAST_xml_code, SubstitutionModel const& subModel,
+    string const& partitionSiteModel, string const& prefix, vector <double> const& frequencies)
+{
+    BEAST_xml_code
+    << "                    <siteModel id=\"" << prefix << "siteModel\" spec=\"SiteModel\"";
+    if (partitionSiteModel == "IG" || partitionSiteModel == "G") {
+        BEAST_xml_code << " gammaCategoryCount=\"4\" shape=\"@" << prefix << "alpha\"";
+    }
+    if (partitionSiteModel == "IG" || partitionSiteModel == "I") {
+        BEAST_xml_code << " proportionInvariant=\"@" << prefix << "pInv\"";
+    }
+// partitions evolve at different relative rates (weighted mean fixed at 1 by their operator)
+    if (analysis.partitionPrefixes.size() > 1) {
+        BEAST_xml_code << " mutationRate=\"@" << prefix << "mu\"";
+    }
+    BEAST_xml_code << ">" << endl;
+    writeSubstitutionModel(BEAST_xml_code, subModel, prefix, frequencies);
+    BEAST_xml_code
+    << "                    </siteModel>" << endl;
+}
+
+void BEAST2XML::writeTreeLikelihoods (ostream & BEAST_xml_code) {
+    ScopedTimer timer("emit.beast2.treeLikelihoods");
+// Partition likelihoods are computed in parallel, and each splits its patterns across as many
+// threads as the BEAST 1 file has BEAGLE instances. The clock model is defined in the first
+// likelihood and referred to by the others.
+    BEAST_xml_code
+    << "            <distribution id=\"likelihood\" spec=\"CompoundDistribution\"";
+    if (analysis.partitionPrefixes.size() > 1) {
+        BEAST_xml_code << " useThreads=\"true\"";
+    }
+    BEAST_xml_code << ">" << endl;
+    
+    map <string, string> values;
+    values["clockRate"] = analysis.getStartingClockRate(analysis.clockFlavour);
+    for (int p = 0; p < (int)analysis.partitionPrefixes.size(); p++) {
+        string const& prefix = analysis.partitionPrefixes[p];
+        string data = analysis.partitions.empty() ? "alignment" : prefix + "patterns";
+        BEAST_xml_code
+        << "                <distribution id=\"" << prefix << "treeLikelihood\" spec=\"ThreadedTreeLikelihood\" data=\"@" << data
+        << "\" tree=\"@Tree\" threads=\"" << analysis.partitionInstanceCounts[p]
+        << "\" useAmbiguities=\"" << (analysis.useAmbiguities ? "true" : "false") << "\">" << endl;
+        writeSiteModel(BEAST_xml_code, *findSubstitutionModel(analysis.partitionSubstitutionModels[p]),
+            analysis.partitionSiteModels[p], prefix, analysis.partitionFrequencies[p]);
+        if (p == 0) {
+            renderXMLTemplate(BEAST_xml_code, "beast2.clockModel." + analysis.clockFlavour, values);
+        } else {
+            BEAST_xml_code
+            << "                    <branchRateModel idref=\"branchRates\"/>" << endl;
+        }
+        BEAST_xml_code
+        << "                </distribution>" << endl;
+    }
+    BEAST_xml_code
+    << "            </distribution>" << endl;
+}
+
+void BEAST2XML::writeScaleOperator (ostream & BEAST_xml_code, string const& parameter, string const& defaultWeight) {
+// tuned from previous BEAST 1 runs where available; the operators and parameters are the same
+    BEAST_xml_code
+    << "        <operator spec=\"ScaleOperator\" parameter=\"@" << parameter << "\" scaleFactor=\""
+    << analysis.getOperatorTuning("scale", parameter, "0.75") << "\" weight=\""
+    << analysis.getOperatorWeight("scale", parameter, defaultWeight) << "\"/>" << endl;
+}
+
+void BEAST2XML::writeUpDownOperator (ostream & BEAST_xml_code, string const& parameter) {
+    BEAST_xml_code
+    << "        <operator spec=\"UpDownOperator\" scaleFactor=\"" << analysis.getOperatorTuning("up:", parameter, "0.75")
+    << "\" weight=\"" << analysis.getOperatorWeight("up:", parameter, "5") << "\">" << endl
+    << "            <up idref=\"" << parameter << "\"/>" << endl
+    << "            <down idref=\"Tree\"/>" << endl
+    << "        </operator>" << endl;
+}
+
+void BEAST2XML::writeOperators (ostream & BEAST_xml_code) {
+    ScopedTimer timer("emit.beast2.operators");
+    BEAST_xml_code
+    << "<!-- *** DEFINE OPERATORS *** -->" << endl;
+    for (int p = 0; p < (int)analysis.partitionSubstitutionModels.size(); p++) {
+        SubstitutionModel const& subModel = *findSubstitutionModel(analysis.partitionSubstitutionModels[p]);
+        string const& prefix = analysis.partitionPrefixes[p];
+        for (int i = 0; i < subModel.numParameters; i++) {
+            if (!subModel.parameters[i].reference && checkEstimatedParameter(subModel.parameters[i])) {
+                writeScaleOperator(BEAST_xml_code, prefix + subModel.id + "." + subModel.parameters[i].name, "0.1");
+            }
+        }
+        if (subModel.frequencyWeight && !analysis.fixFrequencies) {
+            string parameterName = prefix + subModel.id + ".frequencies";
+            BEAST_xml_code
+            << "        <operator spec=\"DeltaExchangeOperator\" parameter=\"@" << parameterName << "\" delta=\""
+            << analysis.getOperatorTuning("deltaexchange", parameterName, "0.01") << "\" weight=\""
+            << analysis.getOperatorWeight("deltaexchange", parameterName, subModel.frequencyWeight) << "\"/>" << endl;
+        }
+        if (analysis.partitionSiteModels[p] == "IG" || analysis.partitionSiteModels[p] == "G") {
+            writeScaleOperator(BEAST_xml_code, prefix + "alpha", "0.1");
+        }
+        if (analysis.partitionSiteModels[p] == "IG" || analysis.partitionSiteModels[p] == "I") {
+            writeScaleOperator(BEAST_xml_code, prefix + "pInv", "0.1");
+        }
+    }
+// relative rates of partitions move together, keeping their mean (weighted by number of sites) at 1
+    if (analysis.partitionPrefixes.size() > 1) {
+        BEAST_xml_code
+        << "        <operator id=\"allMus\" spec=\"DeltaExchangeOperator\" delta=\"" << analysis.getOperatorTuning("deltaexchange", "allMus", "0.75")
+        << "\" weight=\"" << analysis.getOperatorWeight("deltaexchange", "allMus", "3") << "\">" << endl;
+        for (int p = 0; p < (int)analysis.partitionPrefixes.size(); p++) {
+            BEAST_xml_code
+            << "            <parameter idref=\"" << analysis.partitionPrefixes[p] << "mu\"/>" << endl;
+        }
+        BEAST_xml_code
+        << "            <weightvector spec=\"parameter.IntegerParameter\" dimension=\"" << analysis.partitionNumSites.size()
+        << "\" estimate=\"false\">";
+        for (int p = 0; p < (int)analysis.partitionNumSites.size(); p++) {
+            BEAST_xml_code << (p ? " " : "") << analysis.partitionNumSites[p];
+        }
+        BEAST_xml_code << "</weightvector>" << endl
+        << "        </operator>" << endl;
+    }
+    BEAST_xml_code << endl;
+    
+    BEAST_xml_code
+    << "<!-- *** CLOCK OPERATORS *** -->" << endl;
+    string clockFlavour = analysis.clockFlavour;
+    if (clockFlavour == "ucln" || clockFlavour == "uced") {
+        string meanParameter = (clockFlavour == "ucln") ? "ucld.mean" : "uced.mean";
+        writeScaleOperator(BEAST_xml_code, meanParameter, "5");
+        if (clockFlavour == "ucln") {
+            writeScaleOperator(BEAST_xml_code, "ucld.stdev", "5");
+        }
+        BEAST_xml_code
+        << "        <operator spec=\"SwapOperator\" intparameter=\"@branchRates.categories\" howMany=\"1\" weight=\""
+        << analysis.getOperatorWeight("swap", "branchRates.categories", convertIntToString(analysis.numTaxa)) << "\"/>" << endl
+        << "        <operator spec=\"UniformOperator\" parameter=\"@branchRates.categories\" weight=\""
+        << analysis.getOperatorWeight("uniforminteger", "branchRates.categories", "10") << "\"/>" << endl;
+        writeUpDownOperator(BEAST_xml_code, meanParameter);
+    } else if (clockFlavour == "randlocal") {
+        writeScaleOperator(BEAST_xml_code, "clock.rate", "5");
+        writeScaleOperator(BEAST_xml_code, "localClock.relativeRates", "15");
+        BEAST_xml_code
+        << "        <operator spec=\"BitFlipOperator\" parameter=\"@localClock.changes\" weight=\""
+        << analysis.getOperatorWeight("bitflip", "localClock.changes", "15") << "\"/>" << endl;
+        writeUpDownOperator(BEAST_xml_code, "clock.rate");
+    }
+    BEAST_xml_code << endl;
+    
+    if (analysis.treePrior == "bd") {
+        writeScaleOperator(BEAST_xml_code, "birthDeath.BminusDRate", "3");
+        writeScaleOperator(BEAST_xml_code, "birthDeath.DoverB", "3");
+    } else if (analysis.treePrior == "yule") {
+        writeScaleOperator(BEAST_xml_code, "yule.birthRate", "3");
+    } else if (analysis.treePrior == "concoal") {
+        writeScaleOperator(BEAST_xml_code, "constant.popSize", "3");
+    } else if (analysis.treePrior == "expcoal") {
+        writeScaleOperator(BEAST_xml_code, "exponential.popSize", "3");
+        BEAST_xml_code
+        << "        <operator spec=\"RealRandomWalkOperator\" parameter=\"@exponential.growthRate\" windowSize=\""
+        << analysis.getOperatorTuning("randomwalk", "exponential.growthRate", "1.0") << "\" weight=\""
+        << analysis.getOperatorWeight("randomwalk", "exponential.growthRate", "3") << "\"/>" << endl;
+    }
+    
+    BEAST_xml_code
+    << "        <operator spec=\"ScaleOperator\" tree=\"@Tree\" rootOnly=\"true\" scaleFactor=\""
+    << analysis.getOperatorTuning("scale", "treeModel.rootHeight", "0.75") << "\" weight=\""
+    << analysis.getOperatorWeight("scale", "treeModel.rootHeight", "5") << "\"/>" << endl
+    << "        <operator spec=\"beast.evolution.operators.Uniform\" tree=\"@Tree\" weight=\""
+    << analysis.getOperatorWeight("uniform", "treeModel.internalNodeHeights", "30") << "\"/>" << endl << endl;
+    
+    if (analysis.manipulateTreeTopology) {
+        BEAST_xml_code
+        << "<!-- *** TOPOLOGY MANIPULATION OPERATORS *** -->" << endl
+        << "        <operator spec=\"SubtreeSlide\" tree=\"@Tree\" size=\"" << analysis.getOperatorTuning("subtreeslide", "treeModel", "0.02")
+        << "\" gaussian=\"true\" weight=\"" << analysis.getOperatorWeight("subtreeslide", "treeModel", "15") << "\"/>" << endl
+        << "        <operator spec=\"Exchange\" tree=\"@Tree\" isNarrow=\"true\" weight=\""
+        << analysis.getOperatorWeight("narrow", "treeModel", "15") << "\"/>" << endl
+        << "        <operator spec=\"Exchange\" tree=\"@Tree\" isNarrow=\"false\" weight=\""
+        << analysis.getOperatorWeight("wide", "treeModel", "3") << "\"/>" << endl
+        << "        <operator spec=\"WilsonBalding\" tree=\"@Tree\" weight=\""
+        << analysis.getOperatorWeight("wilson", "treeModel", "3") << "\"/>" << endl << endl;
+    }
+}
+
+void BEAST2XML::writeLoggers (ostream & BEAST_xml_code) {
+    ScopedTimer timer("emit.beast2.loggers");
+// same columns and file names as the BEAST 1 logs, so triage reads either
+    string prunedFileName = getRootName(analysis.XMLOutFileName);
+    string const& treePrior = analysis.treePrior;
+    string const& clockFlavour = analysis.clockFlavour;
+    
+    BEAST_xml_code
+    << "<!-- *** PRINT PARAMETERS TO SCREEN *** -->" << endl
+    << "        <logger id=\"screenLog\" logEvery=\"" << analysis.screenSampling << "\">" << endl
+    << "            <log idref=\"posterior\"/>" << endl
+    << "            <log idref=\"prior\"/>" << endl
+    << "            <log idref=\"likelihood\"/>" << endl
+    << "        </logger>" << endl << endl
+    
+    << "<!-- *** PRINT PARAMETERS TO FILE *** -->" << endl
+    << "        <logger id=\"fileLog\" logEvery=\"" << analysis.parameterSampling << "\" fileName=\"" << prunedFileName << ".log\" model=\"@posterior\">" << endl
+    << "            <log idref=\"posterior\"/>" << endl
+    << "            <log idref=\"prior\"/>" << endl
+    << "            <log idref=\"likelihood\"/>" << endl
+    << "            <log id=\"treeModel.rootHeight\" spec=\"TreeHeightLogger\" tree=\"@Tree\"/>" << endl;
+    
+    if (treePrior == "bd") {
+        BEAST_xml_code
+        << "            <log idref=\"birthDeath.BminusDRate\"/>" << endl
+        << "            <log idref=\"birthDeath.DoverB\"/>" << endl;
+    } else if (treePrior == "yule") {
+        BEAST_xml_code
+        << "            <log idref=\"yule.birthRate\"/>" << endl;
+    } else if (treePrior == "concoal") {
+        BEAST_xml_code
+        << "            <log idref=\"constant.popSize\"/>" << endl;
+    } else if (treePrior == "expcoal") {
+        BEAST_xml_code
+        << "            <log idref=\"exponential.popSize\"/>" << endl
+        << "            <log idref=\"exponential.growthRate\"/>" << endl;
+    }
+    
+    for (int p = 0; p < (int)analysis.partitionSubstitutionModels.size(); p++) {
+        SubstitutionModel const& subModel = *findSubstitutionModel(analysis.partitionSubstitutionModels[p]);
+        string const& prefix = analysis.partitionPrefixes[p];
+        for (int i = 0; i < subModel.numParameters; i++) {
+            if (!subModel.parameters[i].reference && checkEstimatedParameter(subModel.parameters[i])) {
+                BEAST_xml_code
+                << "            <log idref=\"" << prefix << subModel.id << "." << subModel.parameters[i].name << "\"/>" << endl;
+            }
+        }
+        if (subModel.logFrequencies) {
+            BEAST_xml_code
+            << "            <log idref=\"" << prefix << subModel.id << ".frequencies\"/>" << endl;
+        }
+        if (analysis.partitionSiteModels[p] == "IG" || analysis.partitionSiteModels[p] == "G") {
+            BEAST_xml_code
+            << "            <log idref=\"" << prefix << "alpha\"/>" << endl;
+        }
+        if (analysis.partitionSiteModels[p] == "IG" || analysis.partitionSiteModels[p] == "I") {
+            BEAST_xml_code
+            << "            <log idref=\"" << prefix << "pInv\"/>" << endl;
+        }
+        if (analysis.partitionPrefixes.size() > 1) {
+            BEAST_xml_code
+            << "            <log idref=\"" << prefix << "mu\"/>" << endl;
+        }
+    }
+    
+    if (clockFlavour == "ucln") {
+        BEAST_xml_code
+        << "            <log idref=\"ucld.mean\"/>" << endl
+        << "            <log idref=\"ucld.stdev\"/>" << endl;
+    } else if (clockFlavour == "uced") {
+        BEAST_xml_code
+        << "            <log idref=\"uced.mean\"/>" << endl;
+    } else {
+        BEAST_xml_code
+        << "            <log idref=\"clock.rate\"/>" << endl;
+    }
+    if (clockFlavour == "randlocal") {
+        BEAST_xml_code
+        << "            <log idref=\"rateChanges\"/>" << endl;
+    }
+    if (clockFlavour != "strict") {
+        BEAST_xml_code
+        << "            <log id=\"rateStatistic\" spec=\"beast.evolution.branchratemodel.RateStatistic\" branchratemodel=\"@branchRates\" tree=\"@Tree\"/>" << endl;
+    }
+    
+    for (int p = 0; p < (int)analysis.partitionPrefixes.size(); p++) {
+        BEAST_xml_code
+        << "            <log idref=\"" << analysis.partitionPrefixes[p] << "treeLikelihood\"/>" << endl;
+    }
+    if (treePrior == "bd" || treePrior == "yule") {
+        BEAST_xml_code
+        << "            <log idref=\"speciation\"/>" << endl;
+    } else {
+        BEAST_xml_code
+        << "            <log idref=\"coalescent\"/>" << endl;
+    }
+    BEAST_xml_code
+    << "        </logger>" << endl << endl;
+    
+    map <string, string> values;
+    values["treeSampling"] = convertIntToString(analysis.treeSampling);
+    values["fileRoot"] = prunedFileName;
+    renderXMLTemplate(BEAST_xml_code, "beast2.treeLog", values);
+    if (analysis.logPhylograms) {
+        renderXMLTemplate(BEAST_xml_code, "beast2.phylogramLog", values);
+    }
+}
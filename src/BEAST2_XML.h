@@ -0,0 +1,46 @@
+#ifndef _BEAST2_XML_H_
+#define _BEAST2_XML_H_
+
+// Writes one analysis as BEAST 2 (2.6) xml. Everything about the analysis (models, partitions,
+// starting values, sampling intervals, BEAGLE instances, operator tuning) is taken from the
+// BEASTXML object driving the file, so the two formats describe the same run. Parameter ids
+// follow the BEAST 1 files (e.g. 'GTR.ac', 'ucld.mean') so their logs can be compared column
+// by column.
+
+class BEAST2XML {
+    
+    BEASTXML & analysis;
+    
+public:
+    
+    static bool checkTreePriorSupported (string const& treePrior);
+    static void writeAlignment (ostream & BEAST_xml_code, long long const& numTaxa, long long const& numChar,
+        vector < vector <string> > const& taxaAlignment);
+    
+    void writeFile (ostream & BEAST_xml_code, string const& serializedAlignment);
+    
+    // Writing functions
+    void writeXMLHeader (ostream & BEAST_xml_code);
+    string getPartitionFilter (Partition const& partition);
+    void writePartitionInformation (ostream & BEAST_xml_code);
+    void writeStateParameter (ostream & BEAST_xml_code, string const& id, string const& value,
+        string const& lower, string const& upper);
+    void writeState (ostream & BEAST_xml_code);
+    void writeStartingTree (ostream & BEAST_xml_code);
+    void writePrior (ostream & BEAST_xml_code, string const& parameter, string const& distribution);
+    void writePriors (ostream & BEAST_xml_code);
+    void writeSubstitutionModel (ostream & BEAST_xml_code, SubstitutionModel const& subModel,
+        string const& prefix, vector <double> const& frequencies);
+    void writeSiteModel (ostream & BEAST_xml_code, SubstitutionModel const& subModel,
+        string const& partitionSiteModel, string const& prefix, vector <double> const& frequencies);
+    void writeTreeLikelihoods (ostream & BEAST_xml_code);
+    void writeScaleOperator (ostream & BEAST_xml_code, string const& parameter, string const& defaultWeight);
+    void writeUpDownOperator (ostream & BEAST_xml_code, string const& parameter);
+    void writeOperators (ostream & BEAST_xml_code);
+    void writeLoggers (ostream & BEAST_xml_code);
+    
+    BEAST2XML (BEASTXML & source);
+    ~BEAST2XML () {};
+};
+
+#endif /* _BEAST2_XML_H_ */
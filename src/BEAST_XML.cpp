@@ -1,39 +1,134 @@
 #include <iostream>
 #include <fstream>
 #include <sstream>
+#include <iomanip>
 #include <vector>
+#include <map>
+#include <algorithm>
 #include <math.h>
 #include <cstdlib>
+#include <cstdio>
 
 using namespace std;
 
 #include "General.h"
+#include "Log_Analysis.h"
+#include "File_Name_Pattern.h"
 #include "Analysis_Settings.h"
+#include "Newick_Tree.h"
+#include "Partitions.h"
+#include "Alignment_Reader.h"
 #include "SimData.h"
+#include "Substitution_Models.h"
 #include "BEAST_XML.h"
+#include "BEAST2_XML.h"
+#include "XML_Templates.h"
+#include "Run_Statistics.h"
 
 extern bool DEBUG;
 extern double version;
 extern string month;
 extern int year;
+extern RunStatistics runStatistics;
 
 // functions for writing BEAST xml files
 
-// functions marked as "not used at the moment" were taken from code for partitioned model analyses
-
 BEASTXML::BEASTXML (SimData & data, int const& modelIndex, int const& clockIndex, int const& treePriorIndex, AnalysisSettings ASet)
 {
+    ScopedTimer timer("xml");
 // extract information from SimData object
     root = data.root;
+    alignmentFileName = data.seqFileName;
     numTaxa = data.numTaxa;
     numChar = data.numChar;
-    taxaAlignment = data.taxaAlignment;
     starterTree = data.starterTree;
     starterTreePresent = data.starterTreePresent;
+    empiricalFrequencies = data.empiricalFrequencies;
+    vector <string> const& nameFieldNames = ASet.getNamePattern().getFieldNames();
+    for (int i = 0; i < (int)nameFieldNames.size(); i++) {
+        nameFieldValues.push_back(data.nameFields[nameFieldNames[i]]);
+    }
     
+    setAnalysisSettings(modelIndex, clockIndex, treePriorIndex, ASet);
+    setPartitions(data, ASet.partitionScheme);
+    
+    setStartingValues(data);
+    poolOperatorAnalyses(ASet.operatorAnalyses);
+    setBeagleSettings();
+    
+// every format writes the same analysis; triage and sampling plans may differ per format,
+// so each starts from the settings as given
+    long long givenMcmcLength = mcmcLength;
+    long long givenTreeSampling = treeSampling;
+    long long givenParameterSampling = parameterSampling;
+    bool givenOverwrite = overwrite;
+    
+    fileWritten = false;
+    for (int i = 0; i < (int)outputFormats.size(); i++) {
+        outputFormat = outputFormats[i];
+        if (outputFormat == "beast2" && !BEAST2XML::checkTreePriorSupported(treePrior)) {
+            cout << "    - no BEAST 2 file for tree prior '" << treePrior << "' (not available in BEAST 2)." << endl;
+            continue;
+        }
+        mcmcLength = givenMcmcLength;
+        treeSampling = givenTreeSampling;
+        parameterSampling = givenParameterSampling;
+        overwrite = givenOverwrite;
+        if (writeFiles(data)) {
+            fileWritten = true;
+        }
+    }
+}
+
+BEASTXML::BEASTXML (string const& fileName, string const& fileRoot, long long const& fileNumTaxa,
+    long long const& fileNumChar, int const& modelIndex, int const& clockIndex, int const& treePriorIndex,
+    AnalysisSettings & ASet)
+{
+// '-plan': the files the constructor above would write for an alignment of this size, with their
+// estimated sizes and cost, without reading the alignment or touching any output file
+    root = fileRoot;
+    alignmentFileName = fileName;
+    numTaxa = fileNumTaxa;
+    numChar = fileNumChar;
+    starterTreePresent = false;
+    plannedXMLBytes = 0.0;
+    plannedOutputBytes = 0.0;
+    plannedCPUHours = 0.0;
+    
+    setAnalysisSettings(modelIndex, clockIndex, treePriorIndex, ASet);
+    planPartitions(ASet.partitionScheme);
+    
+    long long givenMcmcLength = mcmcLength;
+    long long givenTreeSampling = treeSampling;
+    long long givenParameterSampling = parameterSampling;
+    
+    fileWritten = false;
+    for (int i = 0; i < (int)outputFormats.size(); i++) {
+        outputFormat = outputFormats[i];
+        if (outputFormat == "beast2" && !BEAST2XML::checkTreePriorSupported(treePrior)) {
+            continue;
+        }
+        mcmcLength = givenMcmcLength;
+        treeSampling = givenTreeSampling;
+        parameterSampling = givenParameterSampling;
+        if (targetSamples > 0 || outputByteBudget > 0.0) {
+            planSamplingIntervals();
+        }
+        XMLOutFileName = composeXMLOutFileName();
+        plannedXMLBytes += estimateXMLBytes();
+        plannedOutputBytes += estimateOutputBytes();
+        plannedCPUHours += estimateCPUHours();
+        planEntries.push_back(composePlanEntry());
+    }
+}
+
+void BEASTXML::setAnalysisSettings (int const& modelIndex, int const& clockIndex, int const& treePriorIndex,
+    AnalysisSettings & ASet)
+{
 // analysis parameters. others will include e.g. mcmc parameters
     analyzeModel = ASet.getSubModel(modelIndex);
     setDNASubModel(analyzeModel, partitionSubstitutionModel, partitionSiteModel);
+    subModel = findSubstitutionModel(partitionSubstitutionModel);
     clockFlavour = ASet.getClockFlavour(clockIndex);
     treePrior = ASet.getTreePrior(treePriorIndex);
     
@@ -45,61 +140,135 @@ BEASTXML::BEASTXML (SimData & data, int const& modelIndex, int const& clockIndex
     logPhylograms = ASet.logPhylograms;
     overwrite = ASet.overwrite;
     manipulateTreeTopology = ASet.manipulateTreeTopology;
-        
-    XMLOutFileName = setXMLOutFileName(overwrite);
-    BEAST_xml_code.open(XMLOutFileName.c_str());
+    fixFrequencies = ASet.fixFrequencies;
+    triageRuns = ASet.triageRuns;
+    triageESS = ASet.triageESS;
+    burninFraction = ASet.burninFraction;
+    estimateMarginalLikelihood = ASet.estimateMarginalLikelihood;
+    mleSteps = ASet.mleSteps;
+    mleChainLength = ASet.mleChainLength;
+    targetSamples = ASet.targetSamples;
+    maxThreads = ASet.maxThreads;
+    outputByteBudget = ASet.outputByteBudget;
+    outputFormats = ASet.outputFormats;
+    useAmbiguities = ASet.useAmbiguities;
+    gridLabel = ASet.gridLabel;
+}
+
+bool BEASTXML::writeFiles (SimData & data) {
+// in triage mode, only (re)generate files whose previous run has not converged
+    if (triageRuns) {
+        XMLOutFileName = composeXMLOutFileName();
+        if (!triageRun()) {
+            return false;
+        }
+    }
     
-    writeFile();
+    if (targetSamples > 0 || outputByteBudget > 0.0) {
+        planSamplingIntervals();
+    }
+    
+    string const& serializedAlignment = getSerializedAlignment(data, outputFormat);
+    
+    XMLOutFileName = setXMLOutFileName(overwrite);
+    writeFile(data, serializedAlignment);
+    writtenFileNames.push_back(XMLOutFileName);
+    manifestEntries.push_back(composeManifestEntry());
+    return true;
+}
+
+string const& BEASTXML::getSerializedAlignment (SimData & data, string const& format) {
+// The taxa and alignment are the same in every file written from one alignment, so each format
+// serializes them once per SimData object; later files copy the cached text.
+    map <string, string>::iterator cached = data.serializedAlignments.find(format);
+    if (cached == data.serializedAlignments.end()) {
+        ScopedTimer timer("emit");
+        ostringstream alignmentXML;
+        if (format == "beast2") {
+            BEAST2XML::writeAlignment(alignmentXML, numTaxa, numChar, data.taxaAlignment);
+        } else {
+            writeTaxonList(alignmentXML, numTaxa, data.taxaAlignment);
+            writeAlignment(alignmentXML, numTaxa, numChar, data.taxaAlignment);
+        }
+        cached = data.serializedAlignments.insert(make_pair(format, alignmentXML.str())).first;
+    }
+    return cached->second;
+}
+
+void BEASTXML::writeFile (SimData & data, string const& serializedAlignment) {
+    string xmlText;
+    {
+        ScopedTimer timer("emit");
+        if (outputFormat == "beast2") {
+            BEAST2XML BEAST2Writer(*this);
+            BEAST2Writer.writeFile(BEAST_xml_code, serializedAlignment);
+        } else {
+            writeSections(serializedAlignment);
+        }
+        
+// the file is assembled in memory and handed to the OS in a single write
+        xmlText = BEAST_xml_code.str();
+        BEAST_xml_code.str("");
+    }
+    ScopedTimer timer("output");
+    runStatistics.countFileWritten();
+    
+// streamed sequences are copied from the alignment file into the xml as it is written
+    if (data.streamSequences) {
+        if (!writeWithSequenceRanges(xmlText, data.seqFileName, data.sequenceRanges, XMLOutFileName)) {
+            remove(XMLOutFileName.c_str());
+            throw BEASTifierError("output", "unable to write '" + XMLOutFileName + "' with sequences from '"
+                + data.seqFileName + "'");
+        }
+        return;
+    }
     
-    BEAST_xml_code.close();
+    ofstream xmlOutput(XMLOutFileName.c_str(), ios::out | ios::binary);
+    runStatistics.countOpen();
+    xmlOutput.write(xmlText.data(), xmlText.size());
+    runStatistics.countWrite(xmlText.size());
+    xmlOutput.close();
+    if (xmlOutput.fail()) {
+        remove(XMLOutFileName.c_str());
+        throw BEASTifierError("output", "unable to write '" + XMLOutFileName + "'");
+    }
 }
 
-void BEASTXML::writeFile () {
+void BEASTXML::writeSections (string const& serializedAlignment) {
     writeXMLHeader ();
-    writeTaxonList (BEAST_xml_code, numTaxa, taxaAlignment);
-    writeAlignment (BEAST_xml_code, numTaxa, numChar, taxaAlignment);
+    BEAST_xml_code << serializedAlignment;
     writePartitionInformation (BEAST_xml_code);
     writeTreePrior (BEAST_xml_code, treePrior, starterTreePresent, starterTree);
     writeTreeModel (BEAST_xml_code, treePrior);
     writeClockModel (BEAST_xml_code, numTaxa, clockFlavour);
     
-    writeSubstitutionModel (BEAST_xml_code, partitionSubstitutionModel);
-    
-//    writeSubstitutionModels (BEAST_xml_code, partitionSubstitutionModels);
+    writeSubstitutionModels (BEAST_xml_code, partitionSubstitutionModels);
     
-    writeSiteModel (BEAST_xml_code, partitionSubstitutionModel,    partitionSiteModel);
-    
-//    writeSiteModels (BEAST_xml_code, partitionSubstitutionModels, partitionSiteModels);
+    writeSiteModels (BEAST_xml_code, partitionSubstitutionModels, partitionSiteModels);
     
     writeTreeLikelihoods (BEAST_xml_code, clockFlavour);
     
     writeOperators (BEAST_xml_code, treePrior, manipulateTreeTopology,
-        partitionSubstitutionModel, partitionSiteModel, clockFlavour, numTaxa);
-    
-//     writeOperators (BEAST_xml_code, treePrior, manipulateTreeTopology,
-//         partitionSubstitutionModels, partitionSiteModels, clockFlavour, numTaxa);
+        partitionSubstitutionModels, partitionSiteModels, clockFlavour, numTaxa);
     
     writeMCMCParameters (BEAST_xml_code, mcmcLength, clockFlavour,
-        partitionSubstitutionModel, rootPrior, treePrior);
-    
-//     writeMCMCParameters (BEAST_xml_code, mcmcLength, clockFlavour,
-//         partitionSubstitutionModels, rootPrior, treePrior);
+        partitionSubstitutionModels, rootPrior, treePrior);
     
     writeScreenLog (BEAST_xml_code, screenSampling, clockFlavour);
     
     writeParameterLog (BEAST_xml_code, parameterSampling, treePrior, clockFlavour,
-        partitionSubstitutionModel, partitionSiteModel);
-    
-//     writeParameterLog (BEAST_xml_code, parameterSampling, treePrior, clockFlavour,
-//         partitionSubstitutionModels, partitionSiteModels);
-    
+        partitionSubstitutionModels, partitionSiteModels);
     
     writeTreeLogs (BEAST_xml_code, clockFlavour, logPhylograms,
         treeSampling);
+    
+    if (estimateMarginalLikelihood) {
+        writeMarginalLikelihoodEstimator (BEAST_xml_code, mleSteps, mleChainLength);
+    }
     writeXMLTail();
 }
 
-string BEASTXML::setXMLOutFileName (bool const& overwrite) {
+string BEASTXML::composeXMLOutFileName () {
     XMLOutFileName = root + "_analyze-" + analyzeModel;
     if (manipulateTreeTopology) {
         XMLOutFileName = XMLOutFileName + "_est-top";
@@ -107,15 +276,33 @@ string BEASTXML::setXMLOutFileName (bool const& overwrite) {
         XMLOutFileName = XMLOutFileName + "_fix-top";
     }
     
+    if (fixFrequencies && subModel->frequencyWeight) {
+        XMLOutFileName = XMLOutFileName + "_fix-freq";
+    }
+    
+    if (!partitions.empty()) {
+        XMLOutFileName = XMLOutFileName + "_" + partitionScheme + "-part";
+    }
+    
     XMLOutFileName = XMLOutFileName + "_" + treePrior + "-prior";
     
     if (!rootPrior.empty()) {
         XMLOutFileName = XMLOutFileName + "_" + rootPrior[0] + "-root";
     }
     
-    XMLOutFileName = XMLOutFileName + '_' + clockFlavour + "-clock";
+    XMLOutFileName = XMLOutFileName + '_' + clockFlavour + "-clock" + gridLabel;
+    
+    if (outputFormat == "beast2") {
+        XMLOutFileName = XMLOutFileName + "_beast2";
+    }
     XMLOutFileName = XMLOutFileName + ".xml";
     
+    return XMLOutFileName;
+}
+
+string BEASTXML::setXMLOutFileName (bool const& overwrite) {
+    XMLOutFileName = composeXMLOutFileName();
+    
 // Check if file exists/is writable
     bool validFileName = false;
     while (!validFileName) {
@@ -128,6 +315,354 @@ string BEASTXML::getXMLOutFileName () {
     return XMLOutFileName;
 }
 
+bool BEASTXML::getFileWritten () {
+    return fileWritten;
+}
+
+int BEASTXML::getNumFilesWritten () {
+    return writtenFileNames.size();
+}
+
+double BEASTXML::estimateTreeSampleBytes () {
+// Rough size of one sample in a nexus '.trees' file (taxa are written as translate-table indices):
+// per branch ~ index/parentheses + ':' + 17-digit length; relaxed/local clocks add a '[&rate=...]'.
+    long long numBranches = (2 * numTaxa) - 2;
+    int indexDigits = convertIntToString(numTaxa).size();
+    double bytesPerBranch = 22.0 + indexDigits;
+    if (clockFlavour != "strict") {
+        bytesPerBranch += 26.0;
+    }
+    return 60.0 + numBranches * bytesPerBranch;
+}
+
+double BEASTXML::estimateLogSampleBytes () {
+// One row of the parameter log; ~20 columns of ~20 characters covers every model combination here,
+// and each further partition adds up to ~10 columns
+    return 400.0 + 200.0 * (partitionPrefixes.size() - 1);
+}
+
+double BEASTXML::estimateOutputBytes () {
+    double numTreeFiles = logPhylograms ? 2.0 : 1.0;
+    double treeBytes = numTreeFiles * ((double)mcmcLength / treeSampling) * estimateTreeSampleBytes();
+    double logBytes = ((double)mcmcLength / parameterSampling) * estimateLogSampleBytes();
+    return treeBytes + logBytes;
+}
+
+double BEASTXML::estimateXMLBytes () {
+// Rough size of one xml file, calibrated on files written here: ~9 kB of fixed blocks, then per
+// taxon its states and ~100 bytes of taxon, sequence and starting tree entries; a relaxed or
+// local clock, each further partition and a marginal likelihood ladder add a few kB.
+    double bytes = 9000.0 + numTaxa * (100.0 + numChar) + 3000.0 * (partitionPrefixes.size() - 1);
+    if (clockFlavour != "strict") {
+        bytes += 2500.0;
+    }
+    if (estimateMarginalLikelihood && outputFormat == "beast1") {
+        bytes += 3000.0;
+    }
+    return bytes;
+}
+
+double BEASTXML::estimateCPUHours () {
+// Each step recomputes partial likelihoods along part of the tree, at a cost growing with site
+// patterns x rate categories x nodes; ~2e-10 s per pattern, category and node per step (BEAGLE,
+// SSE, 4 states) is the rough figure used.
+    double secondsPerPatternNodeStep = 2e-10;
+    double work = 0.0;
+    for (int i = 0; i < (int)partitionNumPatterns.size(); i++) {
+        work += (double)partitionNumPatterns[i] * getRateCategoryCount(partitionSiteModels[i]);
+    }
+    double numSteps = (double)mcmcLength;
+    if (estimateMarginalLikelihood && outputFormat == "beast1") {
+        numSteps += (double)mleSteps * mleChainLength;
+    }
+    return numSteps * work * (numTaxa - 1) * secondsPerPatternNodeStep / 3600.0;
+}
+
+void BEASTXML::planSamplingIntervals () {
+// Choose per-file tree/parameter sampling intervals: first from the target number of samples,
+// then, if the estimated log + tree output is over the budget, only the tree interval is
+// coarsened. Parameter lines are small and are what ESS (and so '-triage') is computed from, so
+// the parameter log keeps its samples and trees get the budget it leaves. If the parameter log
+// alone is over the budget, trees are cut as far as the whole output is over it, and the budget
+// is not met.
+    if (targetSamples > 0) {
+        treeSampling = (mcmcLength + targetSamples - 1) / targetSamples;
+        parameterSampling = treeSampling;
+        if (treeSampling < 1) {
+            treeSampling = parameterSampling = 1;
+        }
+    }
+    if (outputByteBudget > 0.0) {
+        double estimatedBytes = estimateOutputBytes();
+        if (estimatedBytes > outputByteBudget) {
+            double logBytes = ((double)mcmcLength / parameterSampling) * estimateLogSampleBytes();
+            double treeBytes = estimatedBytes - logBytes;
+            double treeBudget = outputByteBudget - logBytes;
+            if (treeBudget > 0.0) {
+                treeSampling = (long long)ceil(treeSampling * treeBytes / treeBudget);
+            } else {
+                treeSampling = (long long)ceil(treeSampling * estimatedBytes / outputByteBudget);
+                cout << "    - the parameter log alone exceeds the output budget (-iobudget); keeping its sampling"
+                    << " interval of " << parameterSampling << "." << endl;
+            }
+        }
+    }
+    if (DEBUG) {cout << "treeSampling = " << treeSampling << ", parameterSampling = " << parameterSampling
+        << ", estimated output = " << estimateOutputBytes() << " bytes" << endl;}
+}
+
+string BEASTXML::composeManifestEntry () {
+// one tab-delimited line per xml file, composed when the file is written (formats may differ in
+// chain length and sampling), ending with the fields of the alignment's name; header is written in main
+    ostringstream entry;
+    entry << XMLOutFileName << "\t" << alignmentFileName << "\t" << analyzeModel
+        << "\t" << clockFlavour << "\t" << treePrior << "\t" << numTaxa << "\t" << numChar
+        << "\t" << mcmcLength << "\t" << treeSampling << "\t" << parameterSampling
+        << "\t" << screenSampling << "\t" << (long long)estimateOutputBytes();
+    for (int i = 0; i < (int)nameFieldValues.size(); i++) {
+        entry << "\t" << nameFieldValues[i];
+    }
+    return entry.str();
+}
+
+string BEASTXML::composePlanEntry () {
+// one line of the '-plan' table; header is written by BatchPlan
+    ostringstream entry;
+    entry << XMLOutFileName << "\t" << alignmentFileName << "\t" << analyzeModel
+        << "\t" << clockFlavour << "\t" << treePrior << "\t" << numTaxa << "\t" << numChar
+        << "\t" << mcmcLength << "\t" << treeSampling << "\t" << parameterSampling
+        << "\t" << (long long)estimateXMLBytes() << "\t" << (long long)estimateOutputBytes()
+        << "\t" << fixed << setprecision(4) << estimateCPUHours();
+    return entry.str();
+}
+
+void BEASTXML::writePlanEntries (ostream & planTable) {
+    for (int i = 0; i < (int)planEntries.size(); i++) {
+        planTable << planEntries[i] << endl;
+    }
+}
+
+int BEASTXML::getNumPlannedFiles () {
+    return planEntries.size();
+}
+
+double BEASTXML::getPlannedXMLBytes () {
+    return plannedXMLBytes;
+}
+
+double BEASTXML::getPlannedOutputBytes () {
+    return plannedOutputBytes;
+}
+
+double BEASTXML::getPlannedCPUHours () {
+    return plannedCPUHours;
+}
+
+void BEASTXML::writeManifestEntries (ofstream & manifest) {
+    for (int i = 0; i < (int)manifestEntries.size(); i++) {
+        manifest << manifestEntries[i] << endl;
+    }
+}
+
+int BEASTXML::getRateCategoryCount (string const& siteModel) {
+// gamma categories, plus one (rate zero) for invariant sites
+    if (siteModel == "IG") {
+        return 5;
+    } else if (siteModel == "G") {
+        return 4;
+    } else if (siteModel == "I") {
+        return 2;
+    }
+    return 1;
+}
+
+void BEASTXML::setBeagleSettings () {
+// BEAGLE work per likelihood evaluation grows with patterns x rate categories (x 4^2 states).
+// A partition with more than 'workPerInstance' is split across BEAGLE instances, and each
+// instance gets a thread, capped at maxThreads: small data sets run on one thread instead of
+// waiting on idle ones, and large ones get a thread per slice. SSE pays off except on tiny
+// partitions; with many taxa, rescaling at every step avoids underflow restarts.
+    double workPerInstance = 20000.0;
+    double minSSEWork = 1000.0;
+    int alwaysScaleTaxa = 1000;
+    
+    partitionInstanceCounts.clear();
+    int totalInstances = 0;
+    double totalWork = 0.0;
+    for (int i = 0; i < (int)partitionNumPatterns.size(); i++) {
+        double work = (double)partitionNumPatterns[i] * getRateCategoryCount(partitionSiteModels[i]);
+        int instances = (int)(work / workPerInstance);
+        if (instances < 1) {
+            instances = 1;
+        } else if (instances > maxThreads) {
+            instances = maxThreads;
+        }
+        partitionInstanceCounts.push_back(instances);
+        totalInstances += instances;
+        totalWork += work;
+    }
+    beagleThreads = (totalInstances < maxThreads) ? totalInstances : maxThreads;
+    beagleResource = (totalWork < minSSEWork) ? "CPU" : "SSE";
+    beagleScaling = (numTaxa >= alwaysScaleTaxa) ? "always" : "dynamic";
+    if (DEBUG) {cout << "BEAGLE: " << totalInstances << " instances, " << beagleThreads << " threads, "
+        << beagleResource << ", " << beagleScaling << " scaling" << endl;}
+}
+
+string BEASTXML::getLaunchCommand (string const& fileName) {
+// instance counts are in the xml, so '-beagle_instances' (which would override them) is left out
+    return "beast -beagle -beagle_" + beagleResource + " -beagle_scaling " + beagleScaling
+        + " -threads " + convertIntToString(beagleThreads) + " " + fileName;
+}
+
+void BEASTXML::writeLaunchCommands (ofstream & runScript) {
+    for (int i = 0; i < (int)writtenFileNames.size(); i++) {
+        runScript << getLaunchCommand(writtenFileNames[i]) << endl;
+    }
+}
+
+void BEASTXML::writeLaunchComment (ostream & BEAST_xml_code) {
+    long long numPatterns = 0;
+    for (int i = 0; i < (int)partitionNumPatterns.size(); i++) {
+        numPatterns += partitionNumPatterns[i];
+    }
+    BEAST_xml_code
+    << "<!-- " << numPatterns << (sitePatternsCounted ? " site patterns in " : " sites (patterns not counted) in ") << partitionNumPatterns.size() << " tree likelihood(s); suggested run: -->" << endl
+    << "<!--     " << getLaunchCommand(XMLOutFileName) << " -->" << endl << endl;
+}
+
+void BEASTXML::setStartingValues (SimData & data) {
+// Root height comes from the starting tree, else the root prior (midpoint/mean), else the data.
+// The substitution depth of the root is taken as half the mean pairwise distance, and the clock
+// rate is chosen so that rate * root height matches it; only estimated rates start there (see
+// getStartingClockRate). A starting tree is rescaled to the root prior only when its root lies
+// outside it (outside the bounds, or beyond three standard deviations of a normal prior);
+// otherwise it is written as given.
+    double defaultRootHeight = 0.3;
+    double substitutionDepth = data.meanPairwiseDistance / 2.0;
+    double treeHeight = starterTreePresent ? data.starterTreeStructure.getTreeHeight() : 0.0;
+    
+    double priorRootHeight = 0.0;
+    bool treeInsidePrior = true;
+    if (!rootPrior.empty()) {
+        double first = atof(rootPrior[1].c_str());
+        double second = atof(rootPrior[2].c_str());
+        if (rootPrior[0] == "unif") {
+            priorRootHeight = (first + second) / 2.0;
+            treeInsidePrior = (treeHeight >= first && treeHeight <= second);
+        } else if (rootPrior[0] == "norm") {
+            priorRootHeight = first;
+            treeInsidePrior = (fabs(treeHeight - first) <= 3.0 * second);
+        }
+    }
+    
+    startingRootHeight = 0.0;
+    if (treeHeight > 0.0 && treeInsidePrior) {
+        startingRootHeight = treeHeight;
+    } else if (priorRootHeight > 0.0) {
+        startingRootHeight = priorRootHeight;
+    } else if (treeHeight > 0.0) {
+        startingRootHeight = treeHeight;
+    } else {
+        startingRootHeight = substitutionDepth;
+    }
+    if (startingRootHeight <= 0.0) {
+        startingRootHeight = defaultRootHeight;
+    }
+    
+    startingClockRate = (substitutionDepth > 0.0) ? substitutionDepth / startingRootHeight : 1.0;
+    
+    if (starterTreePresent && treeHeight > 0.0 && !treeInsidePrior) {
+        NewickTree scaledTree = data.starterTreeStructure;
+        scaledTree.scaleToHeight(startingRootHeight);
+        starterTree = scaledTree.writeNewick();
+    }
+    if (DEBUG) {cout << "Starting root height = " << startingRootHeight << ", clock rate = " << startingClockRate << endl;}
+}
+
+string BEASTXML::getStartingClockRate (string const& clockFlavour) {
+// the starting value of an estimated rate (ucld.mean, uced.mean, randlocal clock.rate), kept
+// inside the bounds of ucld.mean; the strict clock's rate is fixed at 1.0 and not set from here
+    double maxRelaxedClockMean = 10.0;
+    ostringstream clockRate;
+    if (clockFlavour == "ucln" && startingClockRate > maxRelaxedClockMean) {
+        clockRate << maxRelaxedClockMean;
+    } else {
+        clockRate << startingClockRate;
+    }
+    return clockRate.str();
+}
+
+bool BEASTXML::triageRun () {
+// Decide whether this combination needs (re)generating, based on the parameter log of a previous run.
+//     - no log and no xml: new combination; write as usual.
+//     - no log but xml exists: run is pending; leave it alone.
+//     - log with fewer than a few samples (header only, or just started): run is in progress; leave it alone.
+//     - log short of the chain length the xml was written with: still running (or stopped); leave it alone.
+//     - min ESS >= threshold: converged; leave it alone.
+//     - otherwise: overwrite with a chain extended in proportion to the ESS shortfall, never shorter
+//       than the configured chain length.
+    ScopedTimer timer("triage");
+    int minTriageSamples = 10;
+    string logFileName = getRootName(XMLOutFileName) + ".log";
+    
+    ifstream logTest(logFileName.c_str());
+    if (logTest.fail()) {
+        ifstream xmlTest(XMLOutFileName.c_str());
+        if (xmlTest.fail()) {
+            return true;
+        }
+        cout << "    - no log found for '" << XMLOutFileName << "'; assuming run is pending." << endl;
+        return false;
+    }
+    logTest.close();
+    
+    string worstParameter;
+    long long lastState = 0;
+    int numSamples = 0;
+    double minESS = calculateMinESS(logFileName, burninFraction, worstParameter, lastState, numSamples);
+    
+    if (numSamples < minTriageSamples || lastState <= 0) {
+        cout << "    - only " << numSamples << " samples in '" << logFileName << "'; assuming run is in progress." << endl;
+        return false;
+    }
+// the last sample is within one sampling interval of the end of a finished chain
+    long long writtenChainLength = readXMLChainLength(XMLOutFileName);
+    if (writtenChainLength <= 0) {
+        writtenChainLength = mcmcLength;
+    }
+    long long samplingInterval = lastState / (numSamples - 1);
+    if (lastState + samplingInterval <= writtenChainLength) {
+        cout << "    - run '" << logFileName << "' has reached state " << lastState << " of " << writtenChainLength
+            << "; assuming run is in progress." << endl;
+        return false;
+    }
+    if (minESS >= triageESS) {
+        cout << "    - run '" << logFileName << "' converged (min ESS = " << minESS
+            << " for '" << worstParameter << "'); leaving alone." << endl;
+        return false;
+    }
+    
+// ESS grows roughly linearly with chain length; clamp so a nearly-stuck chain doesn't explode
+    double extension = 10.0;
+    if (minESS > 0.0) {
+        extension = triageESS / minESS;
+    }
+    if (extension < 1.5) {
+        extension = 1.5;
+    } else if (extension > 10.0) {
+        extension = 10.0;
+    }
+    long long extendedLength = (long long)(lastState * extension);
+    if (extendedLength > mcmcLength) {
+        mcmcLength = extendedLength;
+    }
+    overwrite = true;
+    
+    cout << "    - run '" << logFileName << "' not converged (min ESS = " << minESS
+        << " for '" << worstParameter << "'); extending chain to " << mcmcLength << "." << endl;
+    return true;
+}
+
 void BEASTXML::setDNASubModel (string const& analyzeModel, string & partitionSubstitutionModel,
     string & partitionSiteModel)
 {
@@ -161,35 +696,79 @@ void BEASTXML::setDNAModel (string const& analyzeModel, vector <string> & partit
     if (DEBUG) {cout << "hetModel = " << hetModel << endl;}
 }
 
+void BEASTXML::setPartitions (SimData & data, string const& scheme) {
+// One entry per partition in the partition vectors. Partitions share the model being analysed
+// but not its parameters: ids are prefixed with the partition name ('pos1.GTR.ac'). An
+// unpartitioned analysis is a single partition with unprefixed ids.
+    partitions = data.partitions;
+    partitionNumSites = data.partitionNumSites;
+    partitionNumPatterns = data.partitionNumPatterns;
+    sitePatternsCounted = !data.streamSequences;
+    partitionScheme = scheme;
+    partitionSubstitutionModels.clear();
+    partitionSiteModels.clear();
+    partitionPrefixes.clear();
+    partitionFrequencies.clear();
+    
+    if (partitions.empty()) {
+        setDNAModel(analyzeModel, partitionSubstitutionModels, partitionSiteModels);
+        partitionPrefixes.push_back("");
+        partitionFrequencies.push_back(empiricalFrequencies);
+        partitionNumPatterns.assign(1, data.numPatterns);
+        return;
+    }
+    for (int i = 0; i < (int)partitions.size(); i++) {
+        setDNAModel(analyzeModel, partitionSubstitutionModels, partitionSiteModels);
+        partitionPrefixes.push_back(partitions[i].name + ".");
+        partitionFrequencies.push_back(data.partitionFrequencies[i]);
+    }
+}
+
+void BEASTXML::planPartitions (string const& scheme) {
+// setPartitions without the data: codon positions split the sites evenly, and the sites stand in
+// for the site patterns (of which there are at most as many). Charsets are only known once the
+// alignment is read, so they are planned as a single partition.
+    partitionScheme = scheme;
+    partitions.clear();
+    if (!makeCodonPartitions(scheme, partitions) && !scheme.empty()) {
+        partitions.assign(1, Partition());
+    }
+    int numPartitions = (partitions.size() > 1) ? partitions.size() : 1;
+    partitionSubstitutionModels.clear();
+    partitionSiteModels.clear();
+    partitionPrefixes.clear();
+    partitionNumPatterns.clear();
+    for (int i = 0; i < numPartitions; i++) {
+        setDNAModel(analyzeModel, partitionSubstitutionModels, partitionSiteModels);
+        partitionPrefixes.push_back((numPartitions > 1) ? partitions[i].name + "." : "");
+        partitionNumPatterns.push_back(numChar / numPartitions);
+    }
+}
+
 void BEASTXML::writeXMLHeader () {
-    BEAST_xml_code 
-    << "<?xml version=\"1.0\" standalone=\"yes\"?>" << endl
-    << endl
-    << " <!-- Generated by BEASTifier version " << version << " -->" << endl
-    << " <!--           Joseph W. Brown           -->" << endl
-    << " <!--        University of Michigan       -->" << endl
-    << " <!--          josephwb@umich.edu         -->" << endl
-    << " <!--            " << month <<", " << year << "            -->" <<  endl
-    << endl
-    << "<beast>" << endl << endl;
+    ScopedTimer timer("emit.header");
+    ostringstream versionString;
+    versionString << version;
+    ostringstream yearString;
+    yearString << year;
+    
+    map <string, string> values;
+    values["version"] = versionString.str();
+    values["month"] = month;
+    values["year"] = yearString.str();
+    renderXMLTemplate(BEAST_xml_code, "header", values);
+    writeLaunchComment(BEAST_xml_code);
 }
 
 void BEASTXML::writeXMLTail () {
-    BEAST_xml_code << endl
-    << "    <report>" << endl
-    << "        <property name=\"timer\">" << endl
-    << "            <object idref=\"mcmc\"/>" << endl
-    << "        </property>" << endl
-    << "    </report>" << endl
-    << endl
-    << "</beast>" << endl;
-    
-    BEAST_xml_code.close();
+    ScopedTimer timer("emit.tail");
+    renderXMLTemplate(BEAST_xml_code, "tail");
 }
 
-void BEASTXML::writeAlignment (ofstream & BEAST_xml_code, int const& numTaxa, int const& numChar,
+void BEASTXML::writeAlignment (ostream & BEAST_xml_code, long long const& numTaxa, long long const& numChar,
     vector < vector <string> > const& taxaAlignment)
 {
+    ScopedTimer timer("emit.alignment");
     BEAST_xml_code
     << "<!-- *** NUCLEOTIDE ALIGNMENT (refers to taxa above) *** -->" << endl
     << "    <!-- numTaxa = " << numTaxa << " numChar = " << numChar << " -->" << endl
@@ -206,7 +785,8 @@ void BEASTXML::writeAlignment (ofstream & BEAST_xml_code, int const& numTaxa, in
     << "    </alignment>" << endl << endl;
 }
 
-void BEASTXML::writeTaxonList (ofstream & BEAST_xml_code, int const& numTaxa, vector < vector <string> > const& taxaAlignment) {
+void BEASTXML::writeTaxonList (ostream & BEAST_xml_code, long long const& numTaxa, vector < vector <string> > const& taxaAlignment) {
+    ScopedTimer timer("emit.taxa");
     BEAST_xml_code
     << "<!-- *** TAXON LIST *** -->" << endl
     << "    <!-- numTaxa = " << numTaxa << " -->" << endl
@@ -220,1406 +800,405 @@ void BEASTXML::writeTaxonList (ofstream & BEAST_xml_code, int const& numTaxa, ve
     << "    </taxa>" << endl << endl;
 }
 
-void BEASTXML::writeTreePrior (ofstream & BEAST_xml_code, string const& treePrior,
+void BEASTXML::writeTreePrior (ostream & BEAST_xml_code, string const& treePrior,
     bool const& starterTreePresent, string const& starterTree)
 {
-    if (treePrior == "bd") {
-        BEAST_xml_code
-        << "<!-- *** PRIOR ON NODE AGES *** -->" << endl
-        << "    <!-- A prior on the distribution node heights defined given a birth-death speciation process -->" << endl
-        << "    <birthDeathModel id=\"birthDeath\" units=\"substitutions\">" << endl
-        << "        <birthMinusDeathRate>" << endl
-        << "            <parameter id=\"birthDeath.BminusDRate\" value=\"1.0\" lower=\"0.0\" upper=\"Infinity\"/>" << endl
-        << "        </birthMinusDeathRate>" << endl
-        << "        <relativeDeathRate>" << endl
-        << "            <parameter id=\"birthDeath.DoverB\" value=\"0.5\" lower=\"0.0\" upper=\"1.0\"/>" << endl
-        << "        </relativeDeathRate>" << endl
-        << "    </birthDeathModel>" << endl << endl << endl;
-        
-        if (!starterTreePresent) {
-            BEAST_xml_code
-            << "    <!-- This is a simple constant population size coalescent model  -->" << endl
-            << "    <!-- that is used to generate an initial tree for the chain. -->" << endl
-            << "    <constantSize id=\"initialDemo\" units=\"substitutions\">" << endl
-            << "        <populationSize>" << endl
-            << "            <parameter id=\"initialDemo.popSize\" value=\"100.0\"/>" << endl
-            << "        </populationSize>" << endl
-            << "    </constantSize>" << endl << endl
-            << "    <!-- Generate a random starting tree under the coalescent process -->" << endl
-            << "    <coalescentTree id=\"startingTree\" rootHeight=\"0.3\">" << endl
-            << "        <taxa idref=\"taxa\"/>" << endl
-            << "        <constantSize idref=\"initialDemo\"/>" << endl
-            << "    </coalescentTree>" << endl << endl << endl;
-        }
-    } else if (treePrior == "yule") { // yule
-        BEAST_xml_code
-        << "<!-- *** PRIOR ON NODE AGES *** -->" << endl
-        << "    <!-- A prior on the distribution node heights defined given a Yule speciation process (a pure birth process) -->" << endl
-        << "    <yuleModel id=\"yule\" units=\"substitutions\">" << endl
-        << "        <birthRate>" << endl
-        << "            <parameter id=\"yule.birthRate\" value=\"1.0\" lower=\"0.0\" upper=\"Infinity\"/>" << endl
-        << "        </birthRate>" << endl
-        << "    </yuleModel>" << endl << endl << endl;
+    ScopedTimer timer("emit.treePrior");
+    renderXMLTemplate(BEAST_xml_code, "treePrior." + treePrior);
+    
+    if (starterTreePresent) {
+        map <string, string> values;
+        values["starterTree"] = starterTree;
+        renderXMLTemplate(BEAST_xml_code, "startingTree.newick", values);
+    } else {
+        ostringstream rootHeight;
+        rootHeight << startingRootHeight;
         
-        if (!starterTreePresent) {
-            BEAST_xml_code
-            << "    <!-- This is a simple constant population size coalescent model  -->" << endl
-            << "    <!-- that is used to generate an initial tree for the chain. -->" << endl
-            << "    <constantSize id=\"initialDemo\" units=\"substitutions\">" << endl
-            << "        <populationSize>" << endl
-            << "            <parameter id=\"initialDemo.popSize\" value=\"100.0\"/>" << endl
-            << "        </populationSize>" << endl
-            << "    </constantSize>" << endl << endl
-            << "    <!-- Generate a random starting tree under the coalescent process -->" << endl
-            << "    <coalescentTree id=\"startingTree\" rootHeight=\"0.3\">" << endl
-            << "        <taxa idref=\"taxa\"/>" << endl
-            << "        <constantSize idref=\"initialDemo\"/>" << endl
-            << "    </coalescentTree>" << endl << endl << endl;
-        }
-    } else if (treePrior == "concoal") {
+        map <string, string> values;
+        values["rootHeight"] = rootHeight.str();
+        renderXMLTemplate(BEAST_xml_code, "startingTree." + treePrior, values);
+    }
+}
+
+void BEASTXML::writePartitionInformation (ostream & BEAST_xml_code) {
+    ScopedTimer timer("emit.partitions");
+    if (partitions.empty()) {
+        renderXMLTemplate(BEAST_xml_code, "partitions");
+        return;
+    }
+// one 'patterns' element per partition; a partition of several ranges merges their patterns
+    BEAST_xml_code << endl
+    << "<!-- *** DEFINE PARTITIONS *** -->" << endl;
+    for (int i = 0; i < (int)partitions.size(); i++) {
+        vector <CharacterRange> const& ranges = partitions[i].ranges;
         BEAST_xml_code
-        << "<!-- *** PRIOR ON NODE AGES *** -->" << endl
-        << "    <!-- A prior on the distribution node heights defined given a constant-size coalescent process -->" << endl
-        << "    <constantSize id=\"constant\" units=\"substitutions\">" << endl
-        << "    <populationSize>" << endl
-        << "        <parameter id=\"constant.popSize\" value=\"0.3\" lower=\"0.0\" upper=\"Infinity\"/>" << endl
-        << "    </populationSize>" << endl
-        << "    </constantSize>" << endl << endl << endl;
-        
-        if (!starterTreePresent) {
+        << "    <!-- " << partitions[i].name << ": " << partitionNumSites[i] << " sites -->" << endl;
+        string indent = "    ";
+        if (ranges.size() > 1) {
             BEAST_xml_code
-            << "    <!-- Generate a random starting tree under the coalescent process            -->" << endl
-            << "    <coalescentTree id=\"startingTree\" rootHeight=\"0.3\">" << endl
-            << "        <taxa idref=\"taxa\"/>" << endl
-            << "        <constantSize idref=\"constant\"/>" << endl
-            << "    </coalescentTree>" << endl << endl << endl;
+            << "    <mergePatterns id=\"" << partitionPrefixes[i] << "patterns\">" << endl;
+            indent = "        ";
         }
-    } else if (treePrior == "expcoal") {
-        BEAST_xml_code
-        << "<!-- *** PRIOR ON NODE AGES *** -->" << endl
-        << "    <!-- A prior on the distribution node heights defined given a exponential-growth coalescent process -->" << endl
-        << "    <exponentialGrowth id=\"exponential\" units=\"substitutions\">" << endl
-        << "    <populationSize>" << endl
-        << "        <parameter id=\"exponential.popSize\" value=\"0.3\" lower=\"0.0\" upper=\"Infinity\"/>" << endl
-        << "    </populationSize>" << endl
-        << "    <growthRate>" << endl
-        << "        <parameter id=\"exponential.growthRate\" value=\"3.0E-4\" lower=\"-Infinity\" upper=\"Infinity\"/>" << endl
-        << "    </growthRate>" << endl
-        << "    </exponentialGrowth>" << endl << endl << endl;
-        
-        if (!starterTreePresent) {
-            BEAST_xml_code
-            << "    <!-- Generate a random starting tree under the coalescent process            -->" << endl
-            << "    <coalescentTree id=\"startingTree\" rootHeight=\"0.3\">" << endl
-            << "        <taxa idref=\"taxa\"/>" << endl
-            << "        <constantSize idref=\"exponential\"/>" << endl
-            << "    </coalescentTree>" << endl << endl << endl;
+        for (int j = 0; j < (int)ranges.size(); j++) {
+            BEAST_xml_code << indent << "<patterns";
+            if (ranges.size() == 1) {
+                BEAST_xml_code << " id=\"" << partitionPrefixes[i] << "patterns\"";
+            }
+            BEAST_xml_code << " from=\"" << ranges[j].from << "\"";
+            if (ranges[j].to > 0) {
+                BEAST_xml_code << " to=\"" << ranges[j].to << "\"";
+            }
+            if (ranges[j].every > 1) {
+                BEAST_xml_code << " every=\"" << ranges[j].every << "\"";
+            }
+            BEAST_xml_code << ">" << endl
+            << indent << "    <alignment idref=\"alignment\"/>" << endl
+            << indent << "</patterns>" << endl;
         }
-    } else if (treePrior == "logcoal") {
-        BEAST_xml_code
-        << "<!-- *** PRIOR ON NODE AGES *** -->" << endl
-        << "    <!-- A prior on the distribution node heights defined given a logistic-growth coalescent process -->" << endl
-        << "    <logisticGrowth id=\"logistic\" units=\"substitutions\">" << endl
-        << "    <populationSize>" << endl
-        << "        <parameter id=\"logistic.popSize\" value=\"0.3\" lower=\"0.0\" upper=\"Infinity\"/>" << endl
-        << "    </populationSize>" << endl
-        << "    <growthRate>" << endl
-        << "        <parameter id=\"logistic.growthRate\" value=\"3.0E-4\" lower=\"-Infinity\" upper=\"Infinity\"/>" << endl
-        << "    </growthRate>" << endl
-        << "    <t50>" << endl
-        << "        <parameter id=\"logistic.t50\" value=\"1.0\" lower=\"0.0\" upper=\"Infinity\"/>" << endl
-        << "    </t50>" << endl
-        << "    </logisticGrowth>" << endl << endl << endl;
-        
-        if (!starterTreePresent) {
+        if (ranges.size() > 1) {
             BEAST_xml_code
-            << "    <constantSize id=\"initialDemo\" units=\"substitutions\">" << endl
-            << "    <populationSize>" << endl
-            << "        <parameter idref=\"logistic.popSize\"/>" << endl
-            << "    </populationSize>" << endl
-            << "    </constantSize>" << endl << endl
-            << "    <!-- Generate a random starting tree under the coalescent process -->" << endl
-            << "    <coalescentTree id=\"startingTree\" rootHeight=\"0.3\">" << endl
-            << "        <taxa idref=\"taxa\"/>" << endl
-            << "        <constantSize idref=\"initialDemo\"/>" << endl
-            << "    </coalescentTree>" << endl << endl << endl;
+            << "    </mergePatterns>" << endl;
         }
     }
-        
-    if (starterTreePresent) {
-        BEAST_xml_code
-        << "<!-- *** STARTING TREE - MUST BE COMPATIBLE WITH MONOPHYLY/TEMPORAL CONSTRAINTS OR OR INITIAL STATE OF MODEL WILL HAVE ZERO PROBABILITY *** -->" << endl
-        << "<newick id=\"startingTree\" units=\"years\">" << endl
-        << starterTree << endl
-        << "</newick>" << endl << endl;
-    }
+    BEAST_xml_code << endl;
 }
 
-void BEASTXML::writePartitionInformation (ofstream & BEAST_xml_code) {
-    BEAST_xml_code << endl
-    << "<!-- *** DEFINE PARTITIONS *** -->" << endl
-    << "    <patterns id=\"patterns\" from=\"1\">" << endl
-    << "        <alignment idref=\"alignment\"/>" << endl
-    << "    </patterns>" << endl << endl;
+void BEASTXML::writeTreeModel (ostream & BEAST_xml_code, string const& treePrior) {
+    ScopedTimer timer("emit.treeModel");
+    renderXMLTemplate(BEAST_xml_code, "treeModel");
+    renderXMLTemplate(BEAST_xml_code, "treeModel." + treePrior);
 }
 
-void BEASTXML::writeTreeModel (ofstream & BEAST_xml_code, string const& treePrior) {
-    BEAST_xml_code
-    << "<!-- *** CONSTRUCT TREE MODEL *** -->" << endl
-    << "    <treeModel id=\"treeModel\">" << endl
-    << "        <tree idref=\"startingTree\"/>" << endl
-    << "        <rootHeight>" << endl
-    << "            <parameter id=\"treeModel.rootHeight\"/>" << endl
-    << "        </rootHeight>" << endl
-    << "        <nodeHeights internalNodes=\"true\">" << endl
-    << "            <parameter id=\"treeModel.internalNodeHeights\"/>" << endl
-    << "        </nodeHeights>" << endl
-    << "        <nodeHeights internalNodes=\"true\" rootNode=\"true\">" << endl
-    << "            <parameter id=\"treeModel.allInternalNodeHeights\"/>" << endl
-    << "        </nodeHeights>" << endl
-    << "    </treeModel>" << endl << endl;
+
+void BEASTXML::writeClockModel (ostream & BEAST_xml_code, long long const& numTaxa, string const& clockFlavour) {
+    ScopedTimer timer("emit.clockModel");
+    ostringstream numBranches;
+    numBranches << (2 * numTaxa) - 2;
+    
+    map <string, string> values;
+    values["numBranches"] = numBranches.str();
+    values["clockRate"] = getStartingClockRate(clockFlavour);
+    renderXMLTemplate(BEAST_xml_code, "clockModel." + clockFlavour, values);
+}
+
+
+void BEASTXML::poolOperatorAnalyses (vector <OperatorAnalysis> const& operatorAnalyses) {
+// Operator statistics of previous runs within a factor of two in number of taxa, pooled per
+// operator name (count-weighted means of tuning, time per operation and acceptance).
+    map <string, OperatorStatistics> pooled;
+    int numRuns = 0;
+    
+    tunedOperators.clear();
+    medianTimePerOperation = 0.0;
+    for (int i = 0; i < (int)operatorAnalyses.size(); i++) {
+        long long runTaxa = operatorAnalyses[i].numTaxa;
+        if (2 * runTaxa < numTaxa || runTaxa > 2 * numTaxa) {
+            continue;
+        }
+        numRuns++;
+        for (int j = 0; j < (int)operatorAnalyses[i].operators.size(); j++) {
+            OperatorStatistics const& stats = operatorAnalyses[i].operators[j];
+            if (stats.count <= 0.0) {
+                continue;
+            }
+            map <string, OperatorStatistics>::iterator found = pooled.find(stats.name);
+            if (found == pooled.end()) {
+                pooled[stats.name] = stats;
+                continue;
+            }
+            OperatorStatistics & total = found->second;
+            double sumCount = total.count + stats.count;
+            total.tuning = (total.tuning < 0.0 || stats.tuning < 0.0) ? -1.0
+                : (total.tuning * total.count + stats.tuning * stats.count) / sumCount;
+            total.timePerOperation = (total.timePerOperation * total.count + stats.timePerOperation * stats.count) / sumCount;
+            total.acceptance = (total.acceptance * total.count + stats.acceptance * stats.count) / sumCount;
+            total.count = sumCount;
+        }
+    }
+    if (pooled.empty()) {
+        return;
+    }
     
-    if (treePrior == "bd") {
-        BEAST_xml_code
-        << "    <speciationLikelihood id=\"speciation\">" << endl
-        << "        <model>" << endl
-        << "            <birthDeathModel idref=\"birthDeath\"/>" << endl
-        << "        </model>" << endl
-        << "        <speciesTree>" << endl
-        << "            <treeModel idref=\"treeModel\"/>" << endl
-        << "        </speciesTree>" << endl
-        << "    </speciationLikelihood>" << endl << endl << endl;
-    } else if (treePrior == "yule") {
-        BEAST_xml_code
-        << "    <speciationLikelihood id=\"speciation\">" << endl
-        << "        <model>" << endl
-        << "            <yuleModel idref=\"yule\"/>" << endl
-        << "        </model>" << endl
-        << "        <speciesTree>" << endl
-        << "            <treeModel idref=\"treeModel\"/>" << endl
-        << "        </speciesTree>" << endl
-        << "    </speciationLikelihood>" << endl << endl << endl;
-    } else if (treePrior == "concoal") {
-        BEAST_xml_code
-        << "    <!-- Generate a coalescent likelihood -->" << endl
-        << "    <coalescentLikelihood id=\"coalescent\">" << endl
-        << "        <model>" << endl
-        << "            <constantSize idref=\"constant\"/>" << endl
-        << "        </model>" << endl
-        << "        <populationTree>" << endl
-        << "            <treeModel idref=\"treeModel\"/>" << endl
-        << "        </populationTree>" << endl
-        << "    </coalescentLikelihood>" << endl << endl << endl;
-    } else if (treePrior == "expcoal") {
-        BEAST_xml_code
-        << "    <!-- Generate a coalescent likelihood -->" << endl
-        << "    <coalescentLikelihood id=\"coalescent\">" << endl
-        << "        <model>" << endl
-        << "            <exponentialGrowth idref=\"exponential\"/>" << endl
-        << "        </model>" << endl
-        << "        <populationTree>" << endl
-        << "            <treeModel idref=\"treeModel\"/>" << endl
-        << "        </populationTree>" << endl
-        << "    </coalescentLikelihood>" << endl << endl << endl;
-    } else if (treePrior == "logcoal") {
-        BEAST_xml_code
-        << "    <!-- Generate a coalescent likelihood -->" << endl
-        << "    <coalescentLikelihood id=\"coalescent\">" << endl
-        << "        <model>" << endl
-        << "            <logisticGrowth idref=\"logistic\"/>" << endl
-        << "        </model>" << endl
-        << "        <populationTree>" << endl
-        << "            <treeModel idref=\"treeModel\"/>" << endl
-        << "        </populationTree>" << endl
-        << "    </coalescentLikelihood>" << endl << endl << endl;
+    vector <double> times;
+    for (map <string, OperatorStatistics>::const_iterator iter = pooled.begin(); iter != pooled.end(); iter++) {
+        tunedOperators.push_back(iter->second);
+        times.push_back(iter->second.timePerOperation);
     }
+    sort(times.begin(), times.end());
+    medianTimePerOperation = times[times.size() / 2];
+    if (DEBUG) {cout << "Tuning operators from " << numRuns << " previous runs." << endl;}
 }
 
+OperatorStatistics const* BEASTXML::findOperatorStatistics (string const& operatorKeyword, string const& parameter) {
+// BEAST names operators 'scale(ucld.mean)', 'Narrow Exchange(treeModel)' or 'up:ucld.mean down:...'.
+// The operator must start with the keyword (ignoring case and spaces) and act on exactly this
+// parameter, so e.g. 'hky.kappa' never picks up 'pos1.hky.kappa' from a partitioned run
+    string keyword = operatorKeyword;
+    string parameterName = parameter;
+    transform(keyword.begin(), keyword.end(), keyword.begin(), ::tolower);
+    transform(parameterName.begin(), parameterName.end(), parameterName.begin(), ::tolower);
+    
+    for (int i = 0; i < (int)tunedOperators.size(); i++) {
+        string name = tunedOperators[i].name;
+        transform(name.begin(), name.end(), name.begin(), ::tolower);
+        string operatorName;
+        string operatorParameter;
+        if (name.compare(0, 3, "up:") == 0) {
+            operatorName = "up:";
+            operatorParameter = name.substr(3, name.find(' ') - 3);
+        } else {
+            string::size_type open = name.find('(');
+            if (open == string::npos || name[name.size() - 1] != ')') {
+                continue;
+            }
+            for (string::size_type j = 0; j < open; j++) {
+                if (name[j] != ' ') {
+                    operatorName += name[j];
+                }
+            }
+            operatorParameter = name.substr(open + 1, name.size() - open - 2);
+        }
+        if (operatorName.compare(0, keyword.size(), keyword) == 0 && operatorParameter == parameterName) {
+            return &tunedOperators[i];
+        }
+    }
+    return 0;
+}
 
-void BEASTXML::writeClockModel (ofstream & BEAST_xml_code, int const& numTaxa, string const& clockFlavour) {
-    BEAST_xml_code << "<!-- *** DEFINE CLOCK MODEL *** -->" << endl;
+string BEASTXML::getOperatorWeight (string const& operatorKeyword, string const& parameter, string const& defaultWeight) {
+// Operators that are rarely accepted waste proposals, and slow ones cost CPU time: scale the
+// default weight down for acceptance < 0.05 (by half below 0.01), and by sqrt(median time / time),
+// bounded to [0.5, 2].
+    OperatorStatistics const* stats = findOperatorStatistics(operatorKeyword, parameter);
+    if (stats == 0) {
+        return defaultWeight;
+    }
+    double factor = 1.0;
+    if (stats->acceptance < 0.01) {
+        factor = 0.5;
+    } else if (stats->acceptance < 0.05) {
+        factor = 0.75;
+    }
+    if (stats->timePerOperation > 0.0 && medianTimePerOperation > 0.0) {
+        double timeFactor = sqrt(medianTimePerOperation / stats->timePerOperation);
+        timeFactor = (timeFactor < 0.5) ? 0.5 : (timeFactor > 2.0) ? 2.0 : timeFactor;
+        factor *= timeFactor;
+    }
+    ostringstream weight;
+    weight << setprecision(3) << atof(defaultWeight.c_str()) * factor;
+    return weight.str();
+}
 
-    if (clockFlavour == "ucln") {
-        BEAST_xml_code
-        << "    <!-- The uncorrelated relaxed clock (Drummond, Ho, Phillips & Rambaut, 2006) -->" << endl
-        << "    <discretizedBranchRates id=\"branchRates\">" << endl
-        << "        <treeModel idref=\"treeModel\"/>" << endl
-        << "        <distribution>" << endl
-        << "            <logNormalDistributionModel meanInRealSpace=\"true\">" << endl
-        << "                <mean>" << endl
-        << "                    <parameter id=\"ucld.mean\" value=\"0.001\" lower=\"0.0\" upper=\"10.0\"/>" << endl
-        << "                </mean>" << endl
-        << "                <stdev>" << endl
-        << "                    <parameter id=\"ucld.stdev\" value=\"0.1\" lower=\"0.0\" upper=\"10.0\"/>" << endl
-        << "                </stdev>" << endl
-        << "            </logNormalDistributionModel>" << endl
-        << "        </distribution>" << endl
-        << "        <rateCategories>" << endl
-        << "            <parameter id=\"branchRates.categories\" dimension=\"" << (2 * numTaxa) - 2 << "\"/>" << endl
-        << "        </rateCategories>" << endl
-        << "    </discretizedBranchRates>" << endl
-        << endl
-        << "    <rateStatistic id=\"meanRate\" name=\"meanRate\" mode=\"mean\" internal=\"true\" external=\"true\">" << endl
-        << "        <treeModel idref=\"treeModel\"/>" << endl
-        << "        <discretizedBranchRates idref=\"branchRates\"/>" << endl
-        << "    </rateStatistic>" << endl
-        << endl
-        << "    <rateStatistic id=\"coefficientOfVariation\" name=\"coefficientOfVariation\" mode=\"coefficientOfVariation\" internal=\"true\" external=\"true\">" << endl
-        << "        <treeModel idref=\"treeModel\"/>" << endl
-        << "        <discretizedBranchRates idref=\"branchRates\"/>" << endl
-        << "    </rateStatistic>" << endl
-        << endl
-        << "    <rateCovarianceStatistic id=\"covariance\" name=\"covariance\">" << endl
-        << "        <treeModel idref=\"treeModel\"/>" << endl
-        << "        <discretizedBranchRates idref=\"branchRates\"/>" << endl
-        << "    </rateCovarianceStatistic>" << endl << endl;
-    } else if (clockFlavour == "uced") {
-        BEAST_xml_code
-        << "    <!-- The uncorrelated relaxed clock (Drummond, Ho, Phillips & Rambaut, 2006) -->" << endl
-        << "    <discretizedBranchRates id=\"branchRates\">" << endl
-        << "        <treeModel idref=\"treeModel\"/>" << endl
-        << "        <distribution>" << endl
-        << "            <exponentialDistributionModel>" << endl
-        << "                <mean>" << endl
-        << "                    <parameter id=\"uced.mean\" value=\"1.0\" lower=\"0.0\" upper=\"1000000.0\"/>" << endl
-        << "                </mean>" << endl
-        << "            </exponentialDistributionModel>" << endl
-        << "        </distribution>" << endl
-        << "        <rateCategories>" << endl
-        << "            <parameter id=\"branchRates.categories\" dimension=\"" << (2 * numTaxa) - 2 << "\"/>" << endl
-        << "        </rateCategories>" << endl
-        << "    </discretizedBranchRates>" << endl
-        << "    <rateStatistic id=\"meanRate\" name=\"meanRate\" mode=\"mean\" internal=\"true\" external=\"true\">" << endl
-        << "        <treeModel idref=\"treeModel\"/>" << endl
-        << "        <discretizedBranchRates idref=\"branchRates\"/>" << endl
-        << "    </rateStatistic>" << endl
-        << "    <rateStatistic id=\"coefficientOfVariation\" name=\"coefficientOfVariation\" mode=\"coefficientOfVariation\" internal=\"true\" external=\"true\">" << endl
-        << "        <treeModel idref=\"treeModel\"/>" << endl
-        << "        <discretizedBranchRates idref=\"branchRates\"/>" << endl
-        << "    </rateStatistic>" << endl
-        << "    <rateCovarianceStatistic id=\"covariance\" name=\"covariance\">" << endl
-        << "        <treeModel idref=\"treeModel\"/>" << endl
-        << "        <discretizedBranchRates idref=\"branchRates\"/>" << endl
-        << "    </rateCovarianceStatistic>" << endl << endl;
-    } else if (clockFlavour == "strict") {
-        BEAST_xml_code
-        << "    <!-- The strict clock (Uniform rates across branches) -->" << endl
-        << "        <strictClockBranchRates id=\"branchRates\">" << endl
-        << "            <rate>" << endl
-        << "                <parameter id=\"clock.rate\" value=\"1.0\"/>" << endl
-        << "            </rate>" << endl
-        << "        </strictClockBranchRates>" << endl << endl;
-    } else if (clockFlavour == "randlocal") {
-        BEAST_xml_code
-        << "    <!-- The random local clock model (Drummond & Suchard, 2010) -->" << endl
-        << "    <randomLocalClockModel id=\"branchRates\" ratesAreMultipliers=\"false\">" << endl
-        << "        <treeModel idref=\"treeModel\"/>" << endl
-        << "        <rates>" << endl
-        << "            <parameter id=\"localClock.relativeRates\"/>" << endl
-        << "        </rates>" << endl
-        << "        <rateIndicator>" << endl
-        << "            <parameter id=\"localClock.changes\"/>" << endl
-        << "        </rateIndicator>" << endl
-        << "        <clockRate>" << endl
-        << "            <parameter id=\"clock.rate\" value=\"1.0\" lower=\"0.0\"/>" << endl
-        << "        </clockRate>" << endl
-        << "    </randomLocalClockModel>" << endl
-        << "    <sumStatistic id=\"rateChanges\" name=\"rateChangeCount\" elementwise=\"true\">" << endl
-        << "        <parameter idref=\"localClock.changes\"/>" << endl
-        << "    </sumStatistic>" << endl
-        << "    <rateStatistic id=\"meanRate\" name=\"meanRate\" mode=\"mean\" internal=\"true\" external=\"true\">" << endl
-        << "        <treeModel idref=\"treeModel\"/>" << endl
-        << "        <randomLocalClockModel idref=\"branchRates\"/>" << endl
-        << "    </rateStatistic>" << endl
-        << "    <rateStatistic id=\"coefficientOfVariation\" name=\"coefficientOfVariation\" mode=\"coefficientOfVariation\" internal=\"true\" external=\"true\">" << endl
-        << "        <treeModel idref=\"treeModel\"/>" << endl
-        << "        <randomLocalClockModel idref=\"branchRates\"/>" << endl
-        << "    </rateStatistic>" << endl
-        << "    <rateCovarianceStatistic id=\"covariance\" name=\"covariance\">" << endl
-        << "        <treeModel idref=\"treeModel\"/>" << endl
-        << "        <randomLocalClockModel idref=\"branchRates\"/>" << endl
-        << "    </rateCovarianceStatistic>" << endl << endl;
+string BEASTXML::getOperatorTuning (string const& operatorKeyword, string const& parameter, string const& defaultTuning) {
+// start from the value BEAST's auto-optimization settled on in previous runs
+    OperatorStatistics const* stats = findOperatorStatistics(operatorKeyword, parameter);
+    if (stats == 0 || stats->tuning <= 0.0) {
+        return defaultTuning;
     }
+    ostringstream tuning;
+    tuning << setprecision(4) << stats->tuning;
+    return tuning.str();
 }
 
+string BEASTXML::getFrequencyValues (SubstitutionModel const& subModel, vector <double> const& frequencies) {
+// Equal-frequency models keep 0.25s; others start at (or are fixed to) the empirical values,
+// rounded to 6 decimals with T taking up the remainder so the four sum to exactly 1.
+    if (!subModel.frequencyWeight) {
+        return "0.25 0.25 0.25 0.25";
+    }
+    ostringstream values;
+    values << fixed << setprecision(6);
+    double sum = 0.0;
+    for (int i = 0; i < 3; i++) {
+        double rounded = floor(frequencies[i] * 1000000.0 + 0.5) / 1000000.0;
+        sum += rounded;
+        values << rounded << " ";
+    }
+    values << 1.0 - sum;
+    return values.str();
+}
 
-void BEASTXML::writeSubstitutionModel (ofstream & BEAST_xml_code,
-    string const& partitionSubstitutionModel)
+void BEASTXML::writeSubstitutionModel (ostream & BEAST_xml_code, SubstitutionModel const& subModel,
+    string const& prefix, vector <double> const& frequencies)
 {
-    BEAST_xml_code << endl
-    << "<!-- *** DEFINE SUBSTITUTION MODEL -->"<< endl;
-    if (partitionSubstitutionModel == "JC") {
-        BEAST_xml_code
-        << "    <!-- The JC69 substitution model (Jukes & Cantor, 1969) -->" << endl
-        << "    <gtrModel id=\"JC69\">" << endl
-        << "        <frequencies>" << endl
-        << "            <frequencyModel dataType=\"nucleotide\">" << endl
-        << "                <frequencies>" << endl
-        << "                    <parameter id=\"JC69.frequencies\" value=\"0.25 0.25 0.25 0.25\"/>" << endl
-        << "                </frequencies>" << endl
-        << "            </frequencyModel>" << endl
-        << "        </frequencies>" << endl
-        << "        <rateAC>" << endl
-        << "            <parameter id=\"JC69.ac\" value=\"1.0\"/>" << endl
-        << "        </rateAC>" << endl
-        << "        <rateAG>" << endl
-        << "            <parameter id=\"JC69.ag\" value=\"1.0\"/>" << endl
-        << "        </rateAG>" << endl
-        << "        <rateAT>" << endl
-        << "            <parameter id=\"JC69.at\" value=\"1.0\"/>" << endl
-        << "        </rateAT>" << endl
-        << "        <rateCG>" << endl
-        << "            <parameter id=\"JC69.cg\" value=\"1.0\"/>" << endl
-        << "        </rateCG>" << endl
-        << "        <rateGT>" << endl
-        << "            <parameter id=\"JC69.gt\" value=\"1.0\"/>" << endl
-        << "        </rateGT>" << endl
-        << "    </gtrModel>" << endl << endl;
-    } else if (partitionSubstitutionModel == "K80") {
-        BEAST_xml_code
-        << "    <!-- The K80 substitution model (Hasegawa, Kishino & Yano, 1985) -->" << endl
-        << "    <hkyModel id=\"K80\">" << endl
-        << "        <frequencies>" << endl
-        << "            <frequencyModel dataType=\"nucleotide\">" << endl
-        << "                <frequencies>" << endl
-        << "                    <parameter id=\"K80.frequencies\" value=\"0.25 0.25 0.25 0.25\"/>" << endl
-        << "                </frequencies>" << endl
-        << "            </frequencyModel>" << endl
-        << "        </frequencies>" << endl
-        << "        <kappa>" << endl
-        << "            <parameter id=\"K80.kappa\" value=\"1.0\" lower=\"1.0E-8\" upper=\"100.0\"/>" << endl
-        << "        </kappa>" << endl
-        << "    </hkyModel>" << endl << endl;
-    } else if (partitionSubstitutionModel == "HKY") {
-        BEAST_xml_code
-        << "    <!-- The HKY substitution model (Hasegawa, Kishino & Yano, 1985) -->" << endl
-        << "    <hkyModel id=\"HKY\">" << endl
-        << "        <frequencies>" << endl
-        << "            <frequencyModel dataType=\"nucleotide\">" << endl
-        << "                <frequencies>" << endl
-        << "                    <parameter id=\"HKY.frequencies\" value=\"0.25 0.25 0.25 0.25\"/>" << endl
-        << "                </frequencies>" << endl
-        << "            </frequencyModel>" << endl
-        << "        </frequencies>" << endl
-        << "        <kappa>" << endl
-        << "            <parameter id=\"HKY.kappa\" value=\"1.0\" lower=\"1.0E-8\" upper=\"100.0\"/>" << endl
-        << "        </kappa>" << endl
-        << "    </hkyModel>" << endl << endl;
-    } else if (partitionSubstitutionModel == "TrNef") {
-        BEAST_xml_code            
-        << "    <!-- The Tamura-Nei 1993 (TrNef) substitution model  -->" << endl
-        << "    <gtrModel id=\"TrNef\">" << endl
-        << "        <frequencies>" << endl
-        << "            <frequencyModel dataType=\"nucleotide\">" << endl
-        << "                <frequencies>" << endl
-        << "                    <parameter id=\"TrNef.frequencies\" value=\"0.25 0.25 0.25 0.25\"/>" << endl
-        << "                </frequencies>" << endl
-        << "            </frequencyModel>" << endl
-        << "        </frequencies>" << endl
-        << "        <rateAC>" << endl
-        << "            <parameter id=\"TrNef.transversion\" value=\"1.0\" lower=\"1.0E-8\" upper=\"100.0\"/>" << endl
-        << "        </rateAC>" << endl
-        << "        <rateAG>" << endl
-        << "            <parameter id=\"TrNef.ag\" value=\"1.0\" lower=\"1.0E-8\" upper=\"100.0\"/>" << endl
-        << "        </rateAG>" << endl
-        << "        <rateAT>" << endl
-        << "            <parameter idref=\"TrNef.transversion\"/>" << endl
-        << "        </rateAT>" << endl
-        << "        <rateCG>" << endl
-        << "            <parameter idref=\"TrNef.transversion\"/>" << endl
-        << "        </rateCG>" << endl
-        << "        <rateGT>" << endl
-        << "            <parameter idref=\"TrNef.transversion\"/>" << endl
-        << "        </rateGT>" << endl
-        << "    </gtrModel>" << endl << endl;
-    } else if (partitionSubstitutionModel == "TrN") {
-        BEAST_xml_code            
-        << "    <!-- The Tamura-Nei 1993 (TrN) substitution model  -->" << endl
-        << "    <gtrModel id=\"TrN\">" << endl
-        << "        <frequencies>" << endl
-        << "            <frequencyModel dataType=\"nucleotide\">" << endl
-        << "                <frequencies>" << endl
-        << "                    <parameter id=\"TrN.frequencies\" value=\"0.25 0.25 0.25 0.25\"/>" << endl
-        << "                </frequencies>" << endl
-        << "            </frequencyModel>" << endl
-        << "        </frequencies>" << endl
-        << "        <rateAC>" << endl
-        << "            <parameter id=\"TrN.transversion\" value=\"1.0\" lower=\"1.0E-8\" upper=\"100.0\"/>" << endl
-        << "        </rateAC>" << endl
-        << "        <rateAG>" << endl
-        << "            <parameter id=\"TrN.ag\" value=\"1.0\" lower=\"1.0E-8\" upper=\"100.0\"/>" << endl
-        << "        </rateAG>" << endl
-        << "        <rateAT>" << endl
-        << "            <parameter idref=\"TrN.transversion\"/>" << endl
-        << "        </rateAT>" << endl
-        << "        <rateCG>" << endl
-        << "            <parameter idref=\"TrN.transversion\"/>" << endl
-        << "        </rateCG>" << endl
-        << "        <rateGT>" << endl
-        << "            <parameter idref=\"TrN.transversion\"/>" << endl
-        << "        </rateGT>" << endl
-        << "    </gtrModel>" << endl << endl;
-    } else if (partitionSubstitutionModel == "K3P") {
-        BEAST_xml_code
-        << "    <!-- The Kimura 1981 3-parameter (K3P) substitution model -->" << endl
-        << "    <gtrModel id=\"K3P\">" << endl
-        << "        <frequencies>" << endl
-        << "            <frequencyModel dataType=\"nucleotide\">" << endl
-        << "                <frequencies>" << endl
-        << "                    <parameter id=\"K3P.frequencies\" value=\"0.25 0.25 0.25 0.25\"/>" << endl
-        << "                </frequencies>" << endl
-        << "            </frequencyModel>" << endl
-        << "        </frequencies>" << endl
-        << "        <rateAC>" << endl
-        << "            <parameter id=\"K3P.purine2pyrimidine\" value=\"1.0\" lower=\"1.0E-8\" upper=\"100.0\"/>" << endl
-        << "        </rateAC>" << endl
-        << "        <rateAG>" << endl
-        << "            <parameter id=\"K3P.ag\" value=\"1.0\"/>" << endl
-        << "        </rateAG>" << endl
-        << "        <rateAT>" << endl
-        << "            <parameter id=\"K3P.pyrimidine2purine\" value=\"1.0\" lower=\"1.0E-8\" upper=\"100.0\"/>" << endl
-        << "        </rateAT>" << endl
-        << "        <rateCG>" << endl
-        << "            <parameter idref=\"K3P.pyrimidine2purine\"/>" << endl
-        << "        </rateCG>" << endl
-        << "        <rateGT>" << endl
-        << "            <parameter idref=\"K3P.purine2pyrimidine\"/>" << endl
-        << "        </rateGT>" << endl
-        << "    </gtrModel>" << endl << endl;
-    } else if (partitionSubstitutionModel == "K3Puf") {
-        BEAST_xml_code
-        << "    <!-- The Kimura 1981 3-parameter (K3Puf) substitution model -->" << endl
-        << "    <gtrModel id=\"K3Puf\">" << endl
-        << "        <frequencies>" << endl
-        << "            <frequencyModel dataType=\"nucleotide\">" << endl
-        << "                <frequencies>" << endl
-        << "                    <parameter id=\"K3Puf.frequencies\" value=\"0.25 0.25 0.25 0.25\"/>" << endl
-        << "                </frequencies>" << endl
-        << "            </frequencyModel>" << endl
-        << "        </frequencies>" << endl
-        << "        <rateAC>" << endl
-        << "            <parameter id=\"K3Puf.purine2pyrimidine\" value=\"1.0\" lower=\"1.0E-8\" upper=\"100.0\"/>" << endl
-        << "        </rateAC>" << endl
-        << "        <rateAG>" << endl
-        << "            <parameter id=\"K3Puf.ag\" value=\"1.0\"/>" << endl
-        << "        </rateAG>" << endl
-        << "        <rateAT>" << endl
-        << "            <parameter id=\"K3Puf.pyrimidine2purine\" value=\"1.0\" lower=\"1.0E-8\" upper=\"100.0\"/>" << endl
-        << "        </rateAT>" << endl
-        << "        <rateCG>" << endl
-        << "            <parameter idref=\"K3Puf.pyrimidine2purine\"/>" << endl
-        << "        </rateCG>" << endl
-        << "        <rateGT>" << endl
-        << "            <parameter idref=\"K3Puf.purine2pyrimidine\"/>" << endl
-        << "        </rateGT>" << endl
-        << "    </gtrModel>" << endl << endl;
-    } else if (partitionSubstitutionModel == "TIMef") {
-        BEAST_xml_code
-        << "    <!-- The transitional (TIMef) substitution model -->" << endl
-        << "    <gtrModel id=\"TIMef\">" << endl
-        << "        <frequencies>" << endl
-        << "            <frequencyModel dataType=\"nucleotide\">" << endl
-        << "                <frequencies>" << endl
-        << "                    <parameter id=\"TIMef.frequencies\" value=\"0.25 0.25 0.25 0.25\"/>" << endl
-        << "                </frequencies>" << endl
-        << "            </frequencyModel>" << endl
-        << "        </frequencies>" << endl
-        << "        <rateAC>" << endl
-        << "            <parameter id=\"TIMef.purine2pyrimidine\" value=\"1.0\" lower=\"1.0E-8\" upper=\"100.0\"/>" << endl
-        << "        </rateAC>" << endl
-        << "        <rateAG>" << endl
-        << "            <parameter id=\"TIMef.ag\" value=\"1.0\" lower=\"1.0E-8\" upper=\"100.0\"/>" << endl
-        << "        </rateAG>" << endl
-        << "        <rateAT>" << endl
-        << "            <parameter id=\"TIMef.pyrimidine2purine\" value=\"1.0\" lower=\"1.0E-8\" upper=\"100.0\"/>" << endl
-        << "        </rateAT>" << endl
-        << "        <rateCG>" << endl
-        << "            <parameter idref=\"TIMef.pyrimidine2purine\"/>" << endl
-        << "        </rateCG>" << endl
-        << "        <rateGT>" << endl
-        << "            <parameter idref=\"TIMef.purine2pyrimidine\"/>" << endl
-        << "        </rateGT>" << endl
-        << "    </gtrModel>" << endl << endl;
-    } else if (partitionSubstitutionModel == "TIM") {
-        BEAST_xml_code
-        << "    <!-- The transitional (TIM) substitution model -->" << endl
-        << "    <gtrModel id=\"TIM\">" << endl
-        << "        <frequencies>" << endl
-        << "            <frequencyModel dataType=\"nucleotide\">" << endl
-        << "                <frequencies>" << endl
-        << "                    <parameter id=\"TIM.frequencies\" value=\"0.25 0.25 0.25 0.25\"/>" << endl
-        << "                </frequencies>" << endl
-        << "            </frequencyModel>" << endl
-        << "        </frequencies>" << endl
-        << "        <rateAC>" << endl
-        << "            <parameter id=\"TIM.purine2pyrimidine\" value=\"1.0\" lower=\"1.0E-8\" upper=\"100.0\"/>" << endl
-        << "        </rateAC>" << endl
-        << "        <rateAG>" << endl
-        << "            <parameter id=\"TIM.ag\" value=\"1.0\" lower=\"1.0E-8\" upper=\"100.0\"/>" << endl
-        << "        </rateAG>" << endl
-        << "        <rateAT>" << endl
-        << "            <parameter id=\"TIM.pyrimidine2purine\" value=\"1.0\" lower=\"1.0E-8\" upper=\"100.0\"/>" << endl
-        << "        </rateAT>" << endl
-        << "        <rateCG>" << endl
-        << "            <parameter idref=\"TIM.pyrimidine2purine\"/>" << endl
-        << "        </rateCG>" << endl
-        << "        <rateGT>" << endl
-        << "            <parameter idref=\"TIM.purine2pyrimidine\"/>" << endl
-        << "        </rateGT>" << endl
-        << "    </gtrModel>" << endl << endl;
-    } else if (partitionSubstitutionModel == "TVMef") {
-        BEAST_xml_code
-        << "    <!-- The transversional (TVMef) substitution model -->" << endl
-        << "    <gtrModel id=\"TVMef\">" << endl
-        << "        <frequencies>" << endl
-        << "            <frequencyModel dataType=\"nucleotide\">" << endl
-        << "                <frequencies>" << endl
-        << "                    <parameter id=\"TVMef.frequencies\" value=\"0.25 0.25 0.25 0.25\"/>" << endl
-        << "                </frequencies>" << endl
-        << "            </frequencyModel>" << endl
-        << "        </frequencies>" << endl
-        << "        <rateAC>" << endl
-        << "            <parameter id=\"TVMef.ac\" value=\"1.0\" lower=\"1.0E-8\" upper=\"100.0\"/>" << endl
-        << "        </rateAC>" << endl
-        << "        <rateAG>" << endl
-        << "            <parameter id=\"TVMef.ag\" value=\"1.0\"/>" << endl
-        << "        </rateAG>" << endl
-        << "        <rateAT>" << endl
-        << "            <parameter id=\"TVMef.at\" value=\"1.0\" lower=\"1.0E-8\" upper=\"100.0\"/>" << endl
-        << "        </rateAT>" << endl
-        << "        <rateCG>" << endl
-        << "            <parameter id=\"TVMef.cg\" value=\"1.0\" lower=\"1.0E-8\" upper=\"100.0\"/>" << endl
-        << "        </rateCG>" << endl
-        << "        <rateGT>" << endl
-        << "            <parameter id=\"TVMef.gt\" value=\"1.0\" lower=\"1.0E-8\" upper=\"100.0\"/>" << endl
-        << "        </rateGT>" << endl
-        << "    </gtrModel>" << endl << endl;
-    } else if (partitionSubstitutionModel == "TVM") {
-        BEAST_xml_code
-        << "    <!-- The transversional (TVM) substitution model  -->" << endl
-        << "    <gtrModel id=\"TVM\">" << endl
-        << "        <frequencies>" << endl
-        << "            <frequencyModel dataType=\"nucleotide\">" << endl
-        << "                <frequencies>" << endl
-        << "                    <parameter id=\"TVM.frequencies\" value=\"0.25 0.25 0.25 0.25\"/>" << endl
-        << "                </frequencies>" << endl
-        << "            </frequencyModel>" << endl
-        << "        </frequencies>" << endl
-        << "        <rateAC>" << endl
-        << "            <parameter id=\"TVM.ac\" value=\"1.0\" lower=\"1.0E-8\" upper=\"100.0\"/>" << endl
-        << "        </rateAC>" << endl
-        << "        <rateAG>" << endl
-        << "            <parameter id=\"TVM.ag\" value=\"1.0\"/>" << endl
-        << "        </rateAG>" << endl
-        << "        <rateAT>" << endl
-        << "            <parameter id=\"TVM.at\" value=\"1.0\" lower=\"1.0E-8\" upper=\"100.0\"/>" << endl
-        << "        </rateAT>" << endl
-        << "        <rateCG>" << endl
-        << "            <parameter id=\"TVM.cg\" value=\"1.0\" lower=\"1.0E-8\" upper=\"100.0\"/>" << endl
-        << "        </rateCG>" << endl
-        << "        <rateGT>" << endl
-        << "            <parameter id=\"TVM.gt\" value=\"1.0\" lower=\"1.0E-8\" upper=\"100.0\"/>" << endl
-        << "        </rateGT>" << endl
-        << "    </gtrModel>" << endl << endl;
-    } else if (partitionSubstitutionModel == "SYM") {
-        BEAST_xml_code
-        << "    <!-- The symmetric (SYM) substitution model -->" << endl
-        << "    <gtrModel id=\"SYM\">" << endl
-        << "        <frequencies>" << endl
-        << "            <frequencyModel dataType=\"nucleotide\">" << endl
-        << "                <frequencies>" << endl
-        << "                    <parameter id=\"SYM.frequencies\" value=\"0.25 0.25 0.25 0.25\"/>" << endl
-        << "                </frequencies>" << endl
-        << "            </frequencyModel>" << endl
-        << "        </frequencies>" << endl
-        << "        <rateAC>" << endl
-        << "            <parameter id=\"SYM.ac\" value=\"1.0\" lower=\"1.0E-8\" upper=\"100.0\"/>" << endl
-        << "        </rateAC>" << endl
-        << "        <rateAG>" << endl
-        << "            <parameter id=\"SYM.ag\" value=\"1.0\" lower=\"1.0E-8\" upper=\"100.0\"/>" << endl
-        << "        </rateAG>" << endl
-        << "        <rateAT>" << endl
-        << "            <parameter id=\"SYM.at\" value=\"1.0\" lower=\"1.0E-8\" upper=\"100.0\"/>" << endl
-        << "        </rateAT>" << endl
-        << "        <rateCG>" << endl
-        << "            <parameter id=\"SYM.cg\" value=\"1.0\" lower=\"1.0E-8\" upper=\"100.0\"/>" << endl
-        << "        </rateCG>" << endl
-        << "        <rateGT>" << endl
-        << "            <parameter id=\"SYM.gt\" value=\"1.0\" lower=\"1.0E-8\" upper=\"100.0\"/>" << endl
-        << "        </rateGT>" << endl
-        << "    </gtrModel>" << endl << endl;
-    } else if (partitionSubstitutionModel == "GTR") {
+    string modelId = prefix + subModel.id;
+    BEAST_xml_code
+    << "    <!-- " << subModel.description << " -->" << endl
+    << "    <" << subModel.element << " id=\"" << modelId << "\">" << endl
+    << "        <frequencies>" << endl
+    << "            <frequencyModel dataType=\"nucleotide\">" << endl
+    << "                <frequencies>" << endl
+    << "                    <parameter id=\"" << modelId << ".frequencies\" value=\"" << getFrequencyValues(subModel, frequencies) << "\"/>" << endl
+    << "                </frequencies>" << endl
+    << "            </frequencyModel>" << endl
+    << "        </frequencies>" << endl;
+    
+    for (int i = 0; i < subModel.numParameters; i++) {
+        ModelParameter const& parameter = subModel.parameters[i];
+        BEAST_xml_code
+        << "        <" << parameter.element << ">" << endl;
+        if (parameter.reference) {
+            BEAST_xml_code
+            << "            <parameter idref=\"" << modelId << "." << parameter.name << "\"/>" << endl;
+        } else if (checkEstimatedParameter(parameter)) {
+            BEAST_xml_code
+            << "            <parameter id=\"" << modelId << "." << parameter.name << "\" value=\"1.0\" lower=\"1.0E-8\" upper=\"100.0\"/>" << endl;
+        } else {
+            BEAST_xml_code
+            << "            <parameter id=\"" << modelId << "." << parameter.name << "\" value=\"1.0\"/>" << endl;
+        }
         BEAST_xml_code
-        << "    <!-- The general time reversible (GTR) substitution model -->" << endl
-        << "    <gtrModel id=\"GTR\">" << endl
-        << "        <frequencies>" << endl
-        << "            <frequencyModel dataType=\"nucleotide\">" << endl
-        << "                <frequencies>" << endl
-        << "                    <parameter id=\"GTR.frequencies\" value=\"0.25 0.25 0.25 0.25\"/>" << endl
-        << "                </frequencies>" << endl
-        << "            </frequencyModel>" << endl
-        << "        </frequencies>" << endl
-        << "        <rateAC>" << endl
-        << "            <parameter id=\"GTR.ac\" value=\"1.0\" lower=\"1.0E-8\" upper=\"100.0\"/>" << endl
-        << "        </rateAC>" << endl
-        << "        <rateAG>" << endl
-        << "            <parameter id=\"GTR.ag\" value=\"1.0\" lower=\"1.0E-8\" upper=\"100.0\"/>" << endl
-        << "        </rateAG>" << endl
-        << "        <rateAT>" << endl
-        << "            <parameter id=\"GTR.at\" value=\"1.0\" lower=\"1.0E-8\" upper=\"100.0\"/>" << endl
-        << "        </rateAT>" << endl
-        << "        <rateCG>" << endl
-        << "            <parameter id=\"GTR.cg\" value=\"1.0\" lower=\"1.0E-8\" upper=\"100.0\"/>" << endl
-        << "        </rateCG>" << endl
-        << "        <rateGT>" << endl
-        << "            <parameter id=\"GTR.gt\" value=\"1.0\" lower=\"1.0E-8\" upper=\"100.0\"/>" << endl
-        << "        </rateGT>" << endl
-        << "    </gtrModel>" << endl << endl;
+        << "        </" << parameter.element << ">" << endl;
     }
-    BEAST_xml_code << endl;
+    BEAST_xml_code
+    << "    </" << subModel.element << ">" << endl << endl;
 }
 
-// not used at the moment
-/*
-void BEASTXML::writeSubstitutionModels (ofstream & BEAST_xml_code,
+void BEASTXML::writeSubstitutionModels (ostream & BEAST_xml_code,
     vector <string> const& partitionSubstitutionModels)
 {
+    ScopedTimer timer("emit.substitutionModels");
     BEAST_xml_code << endl
     << "<!-- *** DEFINE SUBSTITUTION MODEL -->"<< endl;
-    int counter = 0;
-    for (vector <string>::const_iterator iter = partitionSubstitutionModels.begin(); iter != partitionSubstitutionModels.end(); iter++) {
-        if (partitionSubstitutionModels[counter] == "JC") {
-            BEAST_xml_code
-            << "    <!-- The JC69 substitution model (Jukes & Cantor, 1969) -->" << endl
-            << "    <gtrModel id=\"JC69\">" << endl
-            << "        <frequencies>" << endl
-            << "            <frequencyModel dataType=\"nucleotide\">" << endl
-            << "                <frequencies>" << endl
-            << "                    <parameter id=\"JC69.frequencies\" value=\"0.25 0.25 0.25 0.25\"/>" << endl
-            << "                </frequencies>" << endl
-            << "            </frequencyModel>" << endl
-            << "        </frequencies>" << endl
-            << "        <rateAC>" << endl
-            << "            <parameter id=\"JC69.ac\" value=\"1.0\"/>" << endl
-            << "        </rateAC>" << endl
-            << "        <rateAG>" << endl
-            << "            <parameter id=\"JC69.ag\" value=\"1.0\"/>" << endl
-            << "        </rateAG>" << endl
-            << "        <rateAT>" << endl
-            << "            <parameter id=\"JC69.at\" value=\"1.0\"/>" << endl
-            << "        </rateAT>" << endl
-            << "        <rateCG>" << endl
-            << "            <parameter id=\"JC69.cg\" value=\"1.0\"/>" << endl
-            << "        </rateCG>" << endl
-            << "        <rateGT>" << endl
-            << "            <parameter id=\"JC69.gt\" value=\"1.0\"/>" << endl
-            << "        </rateGT>" << endl
-            << "    </gtrModel>" << endl << endl;
-        } else if (partitionSubstitutionModels[counter] == "K80") {
-            BEAST_xml_code
-            << "    <!-- The K80 substitution model (Hasegawa, Kishino & Yano, 1985) -->" << endl
-            << "    <hkyModel id=\"K80\">" << endl
-            << "        <frequencies>" << endl
-            << "            <frequencyModel dataType=\"nucleotide\">" << endl
-            << "                <frequencies>" << endl
-            << "                    <parameter id=\"K80.frequencies\" value=\"0.25 0.25 0.25 0.25\"/>" << endl
-            << "                </frequencies>" << endl
-            << "            </frequencyModel>" << endl
-            << "        </frequencies>" << endl
-            << "        <kappa>" << endl
-            << "            <parameter id=\"K80.kappa\" value=\"1.0\" lower=\"1.0E-8\" upper=\"100.0\"/>" << endl
-            << "        </kappa>" << endl
-            << "    </hkyModel>" << endl << endl;
-        } else if (partitionSubstitutionModels[counter] == "HKY") {
-            BEAST_xml_code
-            << "    <!-- The HKY substitution model (Hasegawa, Kishino & Yano, 1985) -->" << endl
-            << "    <hkyModel id=\"HKY\">" << endl
-            << "        <frequencies>" << endl
-            << "            <frequencyModel dataType=\"nucleotide\">" << endl
-            << "                <frequencies>" << endl
-            << "                    <parameter id=\"HKY.frequencies\" value=\"0.25 0.25 0.25 0.25\"/>" << endl
-            << "                </frequencies>" << endl
-            << "            </frequencyModel>" << endl
-            << "        </frequencies>" << endl
-            << "        <kappa>" << endl
-            << "            <parameter id=\"HKY.kappa\" value=\"1.0\" lower=\"1.0E-8\" upper=\"100.0\"/>" << endl
-            << "        </kappa>" << endl
-            << "    </hkyModel>" << endl << endl;
-        } else if (partitionSubstitutionModels[counter] == "TrNef") {
-            BEAST_xml_code            
-            << "    <!-- The Tamura-Nei 1993 (TrNef) substitution model  -->" << endl
-            << "    <gtrModel id=\"TrNef\">" << endl
-            << "        <frequencies>" << endl
-            << "            <frequencyModel dataType=\"nucleotide\">" << endl
-            << "                <frequencies>" << endl
-            << "                    <parameter id=\"TrNef.frequencies\" value=\"0.25 0.25 0.25 0.25\"/>" << endl
-            << "                </frequencies>" << endl
-            << "            </frequencyModel>" << endl
-            << "        </frequencies>" << endl
-            << "        <rateAC>" << endl
-            << "            <parameter id=\"TrNef.transversion\" value=\"1.0\" lower=\"1.0E-8\" upper=\"100.0\"/>" << endl
-            << "        </rateAC>" << endl
-            << "        <rateAG>" << endl
-            << "            <parameter id=\"TrNef.ag\" value=\"1.0\" lower=\"1.0E-8\" upper=\"100.0\"/>" << endl
-            << "        </rateAG>" << endl
-            << "        <rateAT>" << endl
-            << "            <parameter idref=\"TrNef.transversion\"/>" << endl
-            << "        </rateAT>" << endl
-            << "        <rateCG>" << endl
-            << "            <parameter idref=\"TrNef.transversion\"/>" << endl
-            << "        </rateCG>" << endl
-            << "        <rateGT>" << endl
-            << "            <parameter idref=\"TrNef.transversion\"/>" << endl
-            << "        </rateGT>" << endl
-            << "    </gtrModel>" << endl << endl;
-        } else if (partitionSubstitutionModels[counter] == "TrN") {
-            BEAST_xml_code            
-            << "    <!-- The Tamura-Nei 1993 (TrN) substitution model  -->" << endl
-            << "    <gtrModel id=\"TrN\">" << endl
-            << "        <frequencies>" << endl
-            << "            <frequencyModel dataType=\"nucleotide\">" << endl
-            << "                <frequencies>" << endl
-            << "                    <parameter id=\"TrN.frequencies\" value=\"0.25 0.25 0.25 0.25\"/>" << endl
-            << "                </frequencies>" << endl
-            << "            </frequencyModel>" << endl
-            << "        </frequencies>" << endl
-            << "        <rateAC>" << endl
-            << "            <parameter id=\"TrN.transversion\" value=\"1.0\" lower=\"1.0E-8\" upper=\"100.0\"/>" << endl
-            << "        </rateAC>" << endl
-            << "        <rateAG>" << endl
-            << "            <parameter id=\"TrN.ag\" value=\"1.0\" lower=\"1.0E-8\" upper=\"100.0\"/>" << endl
-            << "        </rateAG>" << endl
-            << "        <rateAT>" << endl
-            << "            <parameter idref=\"TrN.transversion\"/>" << endl
-            << "        </rateAT>" << endl
-            << "        <rateCG>" << endl
-            << "            <parameter idref=\"TrN.transversion\"/>" << endl
-            << "        </rateCG>" << endl
-            << "        <rateGT>" << endl
-            << "            <parameter idref=\"TrN.transversion\"/>" << endl
-            << "        </rateGT>" << endl
-            << "    </gtrModel>" << endl << endl;
-        } else if (partitionSubstitutionModels[counter] == "K3P") {
-            BEAST_xml_code
-            << "    <!-- The Kimura 1981 3-parameter (K3P) substitution model -->" << endl
-            << "    <gtrModel id=\"K3P\">" << endl
-            << "        <frequencies>" << endl
-            << "            <frequencyModel dataType=\"nucleotide\">" << endl
-            << "                <frequencies>" << endl
-            << "                    <parameter id=\"K3P.frequencies\" value=\"0.25 0.25 0.25 0.25\"/>" << endl
-            << "                </frequencies>" << endl
-            << "            </frequencyModel>" << endl
-            << "        </frequencies>" << endl
-            << "        <rateAC>" << endl
-            << "            <parameter id=\"K3P.purine2pyrimidine\" value=\"1.0\" lower=\"1.0E-8\" upper=\"100.0\"/>" << endl
-            << "        </rateAC>" << endl
-            << "        <rateAG>" << endl
-            << "            <parameter id=\"K3P.ag\" value=\"1.0\"/>" << endl
-            << "        </rateAG>" << endl
-            << "        <rateAT>" << endl
-            << "            <parameter id=\"K3P.pyrimidine2purine\" value=\"1.0\" lower=\"1.0E-8\" upper=\"100.0\"/>" << endl
-            << "        </rateAT>" << endl
-            << "        <rateCG>" << endl
-            << "            <parameter idref=\"K3P.pyrimidine2purine\"/>" << endl
-            << "        </rateCG>" << endl
-            << "        <rateGT>" << endl
-            << "            <parameter idref=\"K3P.purine2pyrimidine\"/>" << endl
-            << "        </rateGT>" << endl
-            << "    </gtrModel>" << endl << endl;
-        } else if (partitionSubstitutionModels[counter] == "K3Puf") {
-            BEAST_xml_code
-            << "    <!-- The Kimura 1981 3-parameter (K3Puf) substitution model -->" << endl
-            << "    <gtrModel id=\"K3Puf\">" << endl
-            << "        <frequencies>" << endl
-            << "            <frequencyModel dataType=\"nucleotide\">" << endl
-            << "                <frequencies>" << endl
-            << "                    <parameter id=\"K3Puf.frequencies\" value=\"0.25 0.25 0.25 0.25\"/>" << endl
-            << "                </frequencies>" << endl
-            << "            </frequencyModel>" << endl
-            << "        </frequencies>" << endl
-            << "        <rateAC>" << endl
-            << "            <parameter id=\"K3Puf.purine2pyrimidine\" value=\"1.0\" lower=\"1.0E-8\" upper=\"100.0\"/>" << endl
-            << "        </rateAC>" << endl
-            << "        <rateAG>" << endl
-            << "            <parameter id=\"K3Puf.ag\" value=\"1.0\"/>" << endl
-            << "        </rateAG>" << endl
-            << "        <rateAT>" << endl
-            << "            <parameter id=\"K3Puf.pyrimidine2purine\" value=\"1.0\" lower=\"1.0E-8\" upper=\"100.0\"/>" << endl
-            << "        </rateAT>" << endl
-            << "        <rateCG>" << endl
-            << "            <parameter idref=\"K3Puf.pyrimidine2purine\"/>" << endl
-            << "        </rateCG>" << endl
-            << "        <rateGT>" << endl
-            << "            <parameter idref=\"K3Puf.purine2pyrimidine\"/>" << endl
-            << "        </rateGT>" << endl
-            << "    </gtrModel>" << endl << endl;
-        } else if (partitionSubstitutionModels[counter] == "TIMef") {
-            BEAST_xml_code
-            << "    <!-- The transitional (TIMef) substitution model -->" << endl
-            << "    <gtrModel id=\"TIMef\">" << endl
-            << "        <frequencies>" << endl
-            << "            <frequencyModel dataType=\"nucleotide\">" << endl
-            << "                <frequencies>" << endl
-            << "                    <parameter id=\"TIMef.frequencies\" value=\"0.25 0.25 0.25 0.25\"/>" << endl
-            << "                </frequencies>" << endl
-            << "            </frequencyModel>" << endl
-            << "        </frequencies>" << endl
-            << "        <rateAC>" << endl
-            << "            <parameter id=\"TIMef.purine2pyrimidine\" value=\"1.0\" lower=\"1.0E-8\" upper=\"100.0\"/>" << endl
-            << "        </rateAC>" << endl
-            << "        <rateAG>" << endl
-            << "            <parameter id=\"TIMef.ag\" value=\"1.0\" lower=\"1.0E-8\" upper=\"100.0\"/>" << endl
-            << "        </rateAG>" << endl
-            << "        <rateAT>" << endl
-            << "            <parameter id=\"TIMef.pyrimidine2purine\" value=\"1.0\" lower=\"1.0E-8\" upper=\"100.0\"/>" << endl
-            << "        </rateAT>" << endl
-            << "        <rateCG>" << endl
-            << "            <parameter idref=\"TIMef.pyrimidine2purine\"/>" << endl
-            << "        </rateCG>" << endl
-            << "        <rateGT>" << endl
-            << "            <parameter idref=\"TIMef.purine2pyrimidine\"/>" << endl
-            << "        </rateGT>" << endl
-            << "    </gtrModel>" << endl << endl;
-        } else if (partitionSubstitutionModels[counter] == "TIM") {
-            BEAST_xml_code
-            << "    <!-- The transitional (TIM) substitution model -->" << endl
-            << "    <gtrModel id=\"TIM\">" << endl
-            << "        <frequencies>" << endl
-            << "            <frequencyModel dataType=\"nucleotide\">" << endl
-            << "                <frequencies>" << endl
-            << "                    <parameter id=\"TIM.frequencies\" value=\"0.25 0.25 0.25 0.25\"/>" << endl
-            << "                </frequencies>" << endl
-            << "            </frequencyModel>" << endl
-            << "        </frequencies>" << endl
-            << "        <rateAC>" << endl
-            << "            <parameter id=\"TIM.purine2pyrimidine\" value=\"1.0\" lower=\"1.0E-8\" upper=\"100.0\"/>" << endl
-            << "        </rateAC>" << endl
-            << "        <rateAG>" << endl
-            << "            <parameter id=\"TIM.ag\" value=\"1.0\" lower=\"1.0E-8\" upper=\"100.0\"/>" << endl
-            << "        </rateAG>" << endl
-            << "        <rateAT>" << endl
-            << "            <parameter id=\"TIM.pyrimidine2purine\" value=\"1.0\" lower=\"1.0E-8\" upper=\"100.0\"/>" << endl
-            << "        </rateAT>" << endl
-            << "        <rateCG>" << endl
-            << "            <parameter idref=\"TIM.pyrimidine2purine\"/>" << endl
-            << "        </rateCG>" << endl
-            << "        <rateGT>" << endl
-            << "            <parameter idref=\"TIM.purine2pyrimidine\"/>" << endl
-            << "        </rateGT>" << endl
-            << "    </gtrModel>" << endl << endl;
-        } else if (partitionSubstitutionModels[counter] == "TVMef") {
-            BEAST_xml_code
-            << "    <!-- The transversional (TVMef) substitution model -->" << endl
-            << "    <gtrModel id=\"TVMef\">" << endl
-            << "        <frequencies>" << endl
-            << "            <frequencyModel dataType=\"nucleotide\">" << endl
-            << "                <frequencies>" << endl
-            << "                    <parameter id=\"TVMef.frequencies\" value=\"0.25 0.25 0.25 0.25\"/>" << endl
-            << "                </frequencies>" << endl
-            << "            </frequencyModel>" << endl
-            << "        </frequencies>" << endl
-            << "        <rateAC>" << endl
-            << "            <parameter id=\"TVMef.ac\" value=\"1.0\" lower=\"1.0E-8\" upper=\"100.0\"/>" << endl
-            << "        </rateAC>" << endl
-            << "        <rateAG>" << endl
-            << "            <parameter id=\"TVMef.ag\" value=\"1.0\"/>" << endl
-            << "        </rateAG>" << endl
-            << "        <rateAT>" << endl
-            << "            <parameter id=\"TVMef.at\" value=\"1.0\" lower=\"1.0E-8\" upper=\"100.0\"/>" << endl
-            << "        </rateAT>" << endl
-            << "        <rateCG>" << endl
-            << "            <parameter id=\"TVMef.cg\" value=\"1.0\" lower=\"1.0E-8\" upper=\"100.0\"/>" << endl
-            << "        </rateCG>" << endl
-            << "        <rateGT>" << endl
-            << "            <parameter id=\"TVMef.gt\" value=\"1.0\" lower=\"1.0E-8\" upper=\"100.0\"/>" << endl
-            << "        </rateGT>" << endl
-            << "    </gtrModel>" << endl << endl;
-        } else if (partitionSubstitutionModels[counter] == "TVM") {
-            BEAST_xml_code
-            << "    <!-- The transversional (TVM) substitution model  -->" << endl
-            << "    <gtrModel id=\"TVM\">" << endl
-            << "        <frequencies>" << endl
-            << "            <frequencyModel dataType=\"nucleotide\">" << endl
-            << "                <frequencies>" << endl
-            << "                    <parameter id=\"TVM.frequencies\" value=\"0.25 0.25 0.25 0.25\"/>" << endl
-            << "                </frequencies>" << endl
-            << "            </frequencyModel>" << endl
-            << "        </frequencies>" << endl
-            << "        <rateAC>" << endl
-            << "            <parameter id=\"TVM.ac\" value=\"1.0\" lower=\"1.0E-8\" upper=\"100.0\"/>" << endl
-            << "        </rateAC>" << endl
-            << "        <rateAG>" << endl
-            << "            <parameter id=\"TVM.ag\" value=\"1.0\"/>" << endl
-            << "        </rateAG>" << endl
-            << "        <rateAT>" << endl
-            << "            <parameter id=\"TVM.at\" value=\"1.0\" lower=\"1.0E-8\" upper=\"100.0\"/>" << endl
-            << "        </rateAT>" << endl
-            << "        <rateCG>" << endl
-            << "            <parameter id=\"TVM.cg\" value=\"1.0\" lower=\"1.0E-8\" upper=\"100.0\"/>" << endl
-            << "        </rateCG>" << endl
-            << "        <rateGT>" << endl
-            << "            <parameter id=\"TVM.gt\" value=\"1.0\" lower=\"1.0E-8\" upper=\"100.0\"/>" << endl
-            << "        </rateGT>" << endl
-            << "    </gtrModel>" << endl << endl;
-        } else if (partitionSubstitutionModels[counter] == "SYM") {
-            BEAST_xml_code
-            << "    <!-- The symmetric (SYM) substitution model -->" << endl
-            << "    <gtrModel id=\"SYM\">" << endl
-            << "        <frequencies>" << endl
-            << "            <frequencyModel dataType=\"nucleotide\">" << endl
-            << "                <frequencies>" << endl
-            << "                    <parameter id=\"SYM.frequencies\" value=\"0.25 0.25 0.25 0.25\"/>" << endl
-            << "                </frequencies>" << endl
-            << "            </frequencyModel>" << endl
-            << "        </frequencies>" << endl
-            << "        <rateAC>" << endl
-            << "            <parameter id=\"SYM.ac\" value=\"1.0\" lower=\"1.0E-8\" upper=\"100.0\"/>" << endl
-            << "        </rateAC>" << endl
-            << "        <rateAG>" << endl
-            << "            <parameter id=\"SYM.ag\" value=\"1.0\" lower=\"1.0E-8\" upper=\"100.0\"/>" << endl
-            << "        </rateAG>" << endl
-            << "        <rateAT>" << endl
-            << "            <parameter id=\"SYM.at\" value=\"1.0\" lower=\"1.0E-8\" upper=\"100.0\"/>" << endl
-            << "        </rateAT>" << endl
-            << "        <rateCG>" << endl
-            << "            <parameter id=\"SYM.cg\" value=\"1.0\" lower=\"1.0E-8\" upper=\"100.0\"/>" << endl
-            << "        </rateCG>" << endl
-            << "        <rateGT>" << endl
-            << "            <parameter id=\"SYM.gt\" value=\"1.0\" lower=\"1.0E-8\" upper=\"100.0\"/>" << endl
-            << "        </rateGT>" << endl
-            << "    </gtrModel>" << endl << endl;
-        } else if (partitionSubstitutionModels[counter] == "GTR") {
-            BEAST_xml_code
-            << "    <!-- The general time reversible (GTR) substitution model -->" << endl
-            << "    <gtrModel id=\"GTR\">" << endl
-            << "        <frequencies>" << endl
-            << "            <frequencyModel dataType=\"nucleotide\">" << endl
-            << "                <frequencies>" << endl
-            << "                    <parameter id=\"GTR.frequencies\" value=\"0.25 0.25 0.25 0.25\"/>" << endl
-            << "                </frequencies>" << endl
-            << "            </frequencyModel>" << endl
-            << "        </frequencies>" << endl
-            << "        <rateAC>" << endl
-            << "            <parameter id=\"GTR.ac\" value=\"1.0\" lower=\"1.0E-8\" upper=\"100.0\"/>" << endl
-            << "        </rateAC>" << endl
-            << "        <rateAG>" << endl
-            << "            <parameter id=\"GTR.ag\" value=\"1.0\" lower=\"1.0E-8\" upper=\"100.0\"/>" << endl
-            << "        </rateAG>" << endl
-            << "        <rateAT>" << endl
-            << "            <parameter id=\"GTR.at\" value=\"1.0\" lower=\"1.0E-8\" upper=\"100.0\"/>" << endl
-            << "        </rateAT>" << endl
-            << "        <rateCG>" << endl
-            << "            <parameter id=\"GTR.cg\" value=\"1.0\" lower=\"1.0E-8\" upper=\"100.0\"/>" << endl
-            << "        </rateCG>" << endl
-            << "        <rateGT>" << endl
-            << "            <parameter id=\"GTR.gt\" value=\"1.0\" lower=\"1.0E-8\" upper=\"100.0\"/>" << endl
-            << "        </rateGT>" << endl
-            << "    </gtrModel>" << endl << endl;
-        }
-        counter++;
+    for (int i = 0; i < (int)partitionSubstitutionModels.size(); i++) {
+        writeSubstitutionModel(BEAST_xml_code, *findSubstitutionModel(partitionSubstitutionModels[i]),
+            partitionPrefixes[i], partitionFrequencies[i]);
     }
     BEAST_xml_code << endl;
 }
-*/
 
-void BEASTXML::writeSiteModel (ofstream & BEAST_xml_code, string const& partitionSubstitutionModel,
-    string const& partitionSiteModel)
+void BEASTXML::writeSiteModel (ostream & BEAST_xml_code, SubstitutionModel const& subModel,
+    string const& partitionSiteModel, string const& prefix)
 {
     BEAST_xml_code
-    << "<!-- *** DEFINE AMONG-SITE HETEROGENEITY (SITE MODEL) *** -->" << endl;
-    if (partitionSubstitutionModel == "JC") {
-        BEAST_xml_code
-        << "    <siteModel id=\"siteModel\">" << endl
-        << "        <substitutionModel>" << endl
-        << "            <gtrModel idref=\"JC69\"/>" << endl
-        << "        </substitutionModel>" << endl;
-    } else if (partitionSubstitutionModel == "K80") {
-        BEAST_xml_code
-        << "    <siteModel id=\"siteModel\">" << endl
-        << "        <substitutionModel>" << endl
-        << "            <hkyModel idref=\"K80\"/>" << endl
-        << "        </substitutionModel>" << endl;
-    } else if (partitionSubstitutionModel == "HKY") {
-        BEAST_xml_code
-        << "    <siteModel id=\"siteModel\">" << endl
-        << "        <substitutionModel>" << endl
-        << "            <hkyModel idref=\"HKY\"/>" << endl
-        << "        </substitutionModel>" << endl;
-    } else if (partitionSubstitutionModel == "TrNef") {
-        BEAST_xml_code
-        << "    <siteModel id=\"siteModel\">" << endl
-        << "        <substitutionModel>" << endl
-        << "            <gtrModel idref=\"TrNef\"/>" << endl
-        << "        </substitutionModel>" << endl;
-    } else if (partitionSubstitutionModel == "TrN") {
-        BEAST_xml_code
-        << "    <siteModel id=\"siteModel\">" << endl
-        << "        <substitutionModel>" << endl
-        << "            <gtrModel idref=\"TrN\"/>" << endl
-        << "        </substitutionModel>" << endl;
-    } else if (partitionSubstitutionModel == "K3P") {
-        BEAST_xml_code
-        << "    <siteModel id=\"siteModel\">" << endl
-        << "        <substitutionModel>" << endl
-        << "            <gtrModel idref=\"K3P\"/>" << endl
-        << "        </substitutionModel>" << endl;
-    } else if (partitionSubstitutionModel == "K3Puf") {
-        BEAST_xml_code
-        << "    <siteModel id=\"siteModel\">" << endl
-        << "        <substitutionModel>" << endl
-        << "            <gtrModel idref=\"K3Puf\"/>" << endl
-        << "        </substitutionModel>" << endl;
-    } else if (partitionSubstitutionModel == "TIMef") {
-        BEAST_xml_code
-        << "    <siteModel id=\"siteModel\">" << endl
-        << "        <substitutionModel>" << endl
-        << "            <gtrModel idref=\"TIMef\"/>" << endl
-        << "        </substitutionModel>" << endl;
-    } else if (partitionSubstitutionModel == "TIM") {
-        BEAST_xml_code
-        << "    <siteModel id=\"siteModel\">" << endl
-        << "        <substitutionModel>" << endl
-        << "            <gtrModel idref=\"TIM\"/>" << endl
-        << "        </substitutionModel>" << endl;
-    } else if (partitionSubstitutionModel == "TVMef") {
-        BEAST_xml_code
-        << "    <siteModel id=\"siteModel\">" << endl
-        << "        <substitutionModel>" << endl
-        << "            <gtrModel idref=\"TVMef\"/>" << endl
-        << "        </substitutionModel>" << endl;
-    } else if (partitionSubstitutionModel == "TVM") {
-        BEAST_xml_code
-        << "    <siteModel id=\"siteModel\">" << endl
-        << "        <substitutionModel>" << endl
-        << "            <gtrModel idref=\"TVM\"/>" << endl
-        << "        </substitutionModel>" << endl;
-    } else if (partitionSubstitutionModel == "SYM") {
-        BEAST_xml_code
-        << "    <siteModel id=\"siteModel\">" << endl
-        << "        <substitutionModel>" << endl
-        << "            <gtrModel idref=\"SYM\"/>" << endl
-        << "        </substitutionModel>" << endl;
-    } else if (partitionSubstitutionModel == "GTR") {
+    << "    <siteModel id=\"" << prefix << "siteModel\">" << endl
+    << "        <substitutionModel>" << endl
+    << "            <" << subModel.element << " idref=\"" << prefix << subModel.id << "\"/>" << endl
+    << "        </substitutionModel>" << endl;
+    
+// partitions evolve at different relative rates (weighted mean fixed at 1 by their operator)
+    if (partitionPrefixes.size() > 1) {
         BEAST_xml_code
-        << "    <siteModel id=\"siteModel\">" << endl
-        << "        <substitutionModel>" << endl
-        << "            <gtrModel idref=\"GTR\"/>" << endl
-        << "        </substitutionModel>" << endl;
+        << "        <relativeRate>" << endl
+        << "            <parameter id=\"" << prefix << "mu\" value=\"1.0\" lower=\"0.0\"/>" << endl
+        << "        </relativeRate>" << endl;
     }
-    
     if (partitionSiteModel == "IG" || partitionSiteModel == "G")
     {
         BEAST_xml_code
         << "        <gammaShape gammaCategories=\"4\">" << endl
-        << "            <parameter id=\"alpha\" value=\"0.5\" lower=\"0.0\" upper=\"1000.0\"/>" << endl
+        << "            <parameter id=\"" << prefix << "alpha\" value=\"0.5\" lower=\"0.0\" upper=\"1000.0\"/>" << endl
         << "        </gammaShape>" << endl;
     }
     if (partitionSiteModel == "IG" || partitionSiteModel == "I")
     {
         BEAST_xml_code
         << "        <proportionInvariant>" << endl
-        << "            <parameter id=\"pInv\" value=\"0.25\" lower=\"0.0\" upper=\"1.0\"/>" << endl
+        << "            <parameter id=\"" << prefix << "pInv\" value=\"0.25\" lower=\"0.0\" upper=\"1.0\"/>" << endl
         << "        </proportionInvariant>" << endl;
     }
     BEAST_xml_code
     << "    </siteModel>" << endl << endl;
 }
 
-// not used at the moment
-/*
-void BEASTXML::writeSiteModels (ofstream & BEAST_xml_code, vector <string> const& partitionSubstitutionModels,
+void BEASTXML::writeSiteModels (ostream & BEAST_xml_code, vector <string> const& partitionSubstitutionModels,
     vector <string> const& partitionSiteModels)
 {
-    int counter = 0;
+    ScopedTimer timer("emit.siteModels");
     BEAST_xml_code
     << "<!-- *** DEFINE AMONG-SITE HETEROGENEITY (SITE MODEL) *** -->" << endl;
-    for (vector<string>::const_iterator iter = partitionSubstitutionModels.begin(); iter != partitionSubstitutionModels.end(); iter++) {
-        if (partitionSubstitutionModels[counter] == "JC") {
-            BEAST_xml_code
-            << "    <siteModel id=\"siteModel\">" << endl
-            << "        <substitutionModel>" << endl
-            << "            <gtrModel idref=\"JC69\"/>" << endl
-            << "        </substitutionModel>" << endl;
-        } else if (partitionSubstitutionModels[counter] == "K80") {
-            BEAST_xml_code
-            << "    <siteModel id=\"siteModel\">" << endl
-            << "        <substitutionModel>" << endl
-            << "            <hkyModel idref=\"K80\"/>" << endl
-            << "        </substitutionModel>" << endl;
-        } else if (partitionSubstitutionModels[counter] == "HKY") {
-            BEAST_xml_code
-            << "    <siteModel id=\"siteModel\">" << endl
-            << "        <substitutionModel>" << endl
-            << "            <hkyModel idref=\"HKY\"/>" << endl
-            << "        </substitutionModel>" << endl;
-        } else if (partitionSubstitutionModels[counter] == "TrNef") {
-            BEAST_xml_code
-            << "    <siteModel id=\"siteModel\">" << endl
-            << "        <substitutionModel>" << endl
-            << "            <gtrModel idref=\"TrNef\"/>" << endl
-            << "        </substitutionModel>" << endl;
-        } else if (partitionSubstitutionModels[counter] == "TrN") {
-            BEAST_xml_code
-            << "    <siteModel id=\"siteModel\">" << endl
-            << "        <substitutionModel>" << endl
-            << "            <gtrModel idref=\"TrN\"/>" << endl
-            << "        </substitutionModel>" << endl;
-        } else if (partitionSubstitutionModels[counter] == "K3P") {
-            BEAST_xml_code
-            << "    <siteModel id=\"siteModel\">" << endl
-            << "        <substitutionModel>" << endl
-            << "            <gtrModel idref=\"K3P\"/>" << endl
-            << "        </substitutionModel>" << endl;
-        } else if (partitionSubstitutionModels[counter] == "K3Puf") {
-            BEAST_xml_code
-            << "    <siteModel id=\"siteModel\">" << endl
-            << "        <substitutionModel>" << endl
-            << "            <gtrModel idref=\"K3Puf\"/>" << endl
-            << "        </substitutionModel>" << endl;
-        } else if (partitionSubstitutionModels[counter] == "TIMef") {
-            BEAST_xml_code
-            << "    <siteModel id=\"siteModel\">" << endl
-            << "        <substitutionModel>" << endl
-            << "            <gtrModel idref=\"TIMef\"/>" << endl
-            << "        </substitutionModel>" << endl;
-        } else if (partitionSubstitutionModels[counter] == "TIM") {
-            BEAST_xml_code
-            << "    <siteModel id=\"siteModel\">" << endl
-            << "        <substitutionModel>" << endl
-            << "            <gtrModel idref=\"TIM\"/>" << endl
-            << "        </substitutionModel>" << endl;
-        } else if (partitionSubstitutionModels[counter] == "TVMef") {
-            BEAST_xml_code
-            << "    <siteModel id=\"siteModel\">" << endl
-            << "        <substitutionModel>" << endl
-            << "            <gtrModel idref=\"TVMef\"/>" << endl
-            << "        </substitutionModel>" << endl;
-        } else if (partitionSubstitutionModels[counter] == "TVM") {
-            BEAST_xml_code
-            << "    <siteModel id=\"siteModel\">" << endl
-            << "        <substitutionModel>" << endl
-            << "            <gtrModel idref=\"TVM\"/>" << endl
-            << "        </substitutionModel>" << endl;
-        } else if (partitionSubstitutionModels[counter] == "SYM") {
-            BEAST_xml_code
-            << "    <siteModel id=\"siteModel\">" << endl
-            << "        <substitutionModel>" << endl
-            << "            <gtrModel idref=\"SYM\"/>" << endl
-            << "        </substitutionModel>" << endl;
-        } else if (partitionSubstitutionModels[counter] == "GTR") {
-            BEAST_xml_code
-            << "    <siteModel id=\"siteModel\">" << endl
-            << "        <substitutionModel>" << endl
-            << "            <gtrModel idref=\"GTR\"/>" << endl
-            << "        </substitutionModel>" << endl;
-        }
-        
-        if (partitionSiteModels[counter] == "IG" || partitionSiteModels[counter] == "G")
-        {
-            BEAST_xml_code
-            << "        <gammaShape gammaCategories=\"4\">" << endl
-            << "            <parameter id=\"alpha\" value=\"0.5\" lower=\"0.0\" upper=\"1000.0\"/>" << endl
-            << "        </gammaShape>" << endl;
-        }
-        if (partitionSiteModels[counter] == "IG" || partitionSiteModels[counter] == "I")
-        {
-            BEAST_xml_code
-            << "        <proportionInvariant>" << endl
-            << "            <parameter id=\"pInv\" value=\"0.25\" lower=\"0.0\" upper=\"1.0\"/>" << endl
-            << "        </proportionInvariant>" << endl;
-        }
-        BEAST_xml_code
-        << "    </siteModel>" << endl << endl;
-        counter++;
+    for (int i = 0; i < (int)partitionSubstitutionModels.size(); i++) {
+        writeSiteModel(BEAST_xml_code, *findSubstitutionModel(partitionSubstitutionModels[i]),
+            partitionSiteModels[i], partitionPrefixes[i]);
     }
 }
-*/
 
-void BEASTXML::writeTreeLikelihoods (ofstream & BEAST_xml_code, string const& clockFlavour) {
-    BEAST_xml_code << endl
-    << "<!-- *** DEFINE TREE LIKELIHOOD *** -->" << endl
-    << "    <treeLikelihood id=\"treeLikelihood\">" << endl
-    << "        <patterns idref=\"patterns\"/>" << endl
-    << "        <treeModel idref=\"treeModel\"/>" << endl
-    << "        <siteModel idref=\"siteModel\"/>" << endl;
-    if (clockFlavour == "ucln" || clockFlavour == "uced") {
-        BEAST_xml_code
-        << "        <discretizedBranchRates idref=\"branchRates\"/>" << endl;
-    } else if (clockFlavour == "strict") {
-        BEAST_xml_code
-        << "        <strictClockBranchRates idref=\"branchRates\"/>" << endl;
+string BEASTXML::getBranchRatesElement (string const& clockFlavour) {
+// element name of the clock model, as referred to by the likelihood and tree logs
+    if (clockFlavour == "strict") {
+        return "strictClockBranchRates";
     } else if (clockFlavour == "randlocal") {
-        BEAST_xml_code
-        << "        <randomLocalClockModel idref=\"branchRates\"/>" << endl;
+        return "randomLocalClockModel";
+    }
+    return "discretizedBranchRates";
+}
+
+void BEASTXML::writeTreeLikelihoods (ostream & BEAST_xml_code, string const& clockFlavour) {
+    ScopedTimer timer("emit.treeLikelihoods");
+// one likelihood per partition, so BEAST can compute them independently (e.g. one BEAGLE instance each)
+    map <string, string> values;
+    values["branchRatesElement"] = getBranchRatesElement(clockFlavour);
+    values["scalingScheme"] = beagleScaling;
+    for (int i = 0; i < (int)partitionPrefixes.size(); i++) {
+        values["idPrefix"] = partitionPrefixes[i];
+        values["instanceCount"] = convertIntToString(partitionInstanceCounts[i]);
+        values["patternsElement"] = (!partitions.empty() && partitions[i].ranges.size() > 1) ? "mergePatterns" : "patterns";
+        renderXMLTemplate(BEAST_xml_code, "treeLikelihood", values);
     }
-    BEAST_xml_code
-    << "    </treeLikelihood>" << endl << endl;
 }
 
-void BEASTXML::writeOperators (ofstream & BEAST_xml_code, string const& treePrior, bool const& manipulateTreeTopology,
-    string const& partitionSubstitutionModel, string const& partitionSiteModel, string const& clockFlavour, int const& numTaxa)
+void BEASTXML::writeOperators (ostream & BEAST_xml_code, string const& treePrior, bool const& manipulateTreeTopology,
+    vector <string> const& partitionSubstitutionModels, vector <string> const& partitionSiteModels,
+    string const& clockFlavour, long long const& numTaxa)
 {
+    ScopedTimer timer("emit.operators");
     BEAST_xml_code << endl
     << "<!-- *** DEFINE OPERATORS *** -->" << endl
     <<     "    <operators id=\"operators\">" << endl;
-    if (partitionSubstitutionModel == "K80") {
-        BEAST_xml_code    
-        << "        <scaleOperator scaleFactor=\"0.75\" weight=\"0.1\">" << endl
-        << "            <parameter idref=\"K80.kappa\"/>" << endl
-        << "        </scaleOperator>" << endl;
-    } else if (partitionSubstitutionModel == "HKY") {
-        BEAST_xml_code    
-        << "        <scaleOperator scaleFactor=\"0.75\" weight=\"0.1\">" << endl
-        << "            <parameter idref=\"HKY.kappa\"/>" << endl
-        << "        </scaleOperator>" << endl
-        << "        <deltaExchange delta=\"0.01\" weight=\"0.1\">" << endl
-        << "            <parameter idref=\"HKY.frequencies\"/>" << endl
-        << "        </deltaExchange>" << endl;
-    } else if (partitionSubstitutionModel == "TrNef") {
-        BEAST_xml_code
-        << "        <scaleOperator scaleFactor=\"0.75\" weight=\"0.1\">" << endl
-        << "            <parameter idref=\"TrNef.transversion\"/>" << endl
-        << "        </scaleOperator>" << endl
-        << "        <scaleOperator scaleFactor=\"0.75\" weight=\"0.1\">" << endl
-        << "            <parameter idref=\"TrNef.ag\"/>" << endl
-        << "        </scaleOperator>" << endl;
-    } else if (partitionSubstitutionModel == "TrN") {
-        BEAST_xml_code
-        << "        <scaleOperator scaleFactor=\"0.75\" weight=\"0.1\">" << endl
-        << "            <parameter idref=\"TrN.transversion\"/>" << endl
-        << "        </scaleOperator>" << endl
-        << "        <scaleOperator scaleFactor=\"0.75\" weight=\"0.1\">" << endl
-        << "            <parameter idref=\"TrN.ag\"/>" << endl
-        << "        </scaleOperator>" << endl
-        << "        <deltaExchange delta=\"0.01\" weight=\"1\">" << endl
-        << "            <parameter idref=\"TrN.frequencies\"/>" << endl
-        << "        </deltaExchange>" << endl;
-    } else if (partitionSubstitutionModel == "K3P") {
-        BEAST_xml_code
-        << "        <scaleOperator scaleFactor=\"0.75\" weight=\"0.1\">" << endl
-        << "            <parameter idref=\"K3P.purine2pyrimidine\"/>" << endl
-        << "        </scaleOperator>" << endl
-        << "        <scaleOperator scaleFactor=\"0.75\" weight=\"0.1\">" << endl
-        << "            <parameter idref=\"K3P.pyrimidine2purine\"/>" << endl
-        << "        </scaleOperator>" << endl;
-    } else if (partitionSubstitutionModel == "K3Puf") {
-        BEAST_xml_code
-        << "        <scaleOperator scaleFactor=\"0.75\" weight=\"0.1\">" << endl
-        << "            <parameter idref=\"K3Puf.purine2pyrimidine\"/>" << endl
-        << "        </scaleOperator>" << endl
-        << "        <scaleOperator scaleFactor=\"0.75\" weight=\"0.1\">" << endl
-        << "            <parameter idref=\"K3Puf.pyrimidine2purine\"/>" << endl
-        << "        </scaleOperator>" << endl
-        << "        <deltaExchange delta=\"0.01\" weight=\"0.1\">" << endl
-        << "            <parameter idref=\"K3Puf.frequencies\"/>" << endl
-        << "        </deltaExchange>" << endl;
-    } else if (partitionSubstitutionModel == "TIMef") {
-        BEAST_xml_code
-        << "        <scaleOperator scaleFactor=\"0.75\" weight=\"0.1\">" << endl
-        << "            <parameter idref=\"TIMef.purine2pyrimidine\"/>" << endl
-        << "        </scaleOperator>" << endl
-        << "        <scaleOperator scaleFactor=\"0.75\" weight=\"0.1\">" << endl
-        << "            <parameter idref=\"TIMef.ag\"/>" << endl
-        << "        </scaleOperator>" << endl
-        << "        <scaleOperator scaleFactor=\"0.75\" weight=\"0.1\">" << endl
-        << "            <parameter idref=\"TIMef.pyrimidine2purine\"/>" << endl
-        << "        </scaleOperator>" << endl;
-    } else if (partitionSubstitutionModel == "TIM") {
-        BEAST_xml_code
-        << "        <scaleOperator scaleFactor=\"0.75\" weight=\"0.1\">" << endl
-        << "            <parameter idref=\"TIM.purine2pyrimidine\"/>" << endl
-        << "        </scaleOperator>" << endl
-        << "        <scaleOperator scaleFactor=\"0.75\" weight=\"0.1\">" << endl
-        << "            <parameter idref=\"TIM.ag\"/>" << endl
-        << "        </scaleOperator>" << endl
-        << "        <scaleOperator scaleFactor=\"0.75\" weight=\"0.1\">" << endl
-        << "            <parameter idref=\"TIM.pyrimidine2purine\"/>" << endl
-        << "        </scaleOperator>" << endl
-        << "        <deltaExchange delta=\"0.01\" weight=\"0.1\">" << endl
-        << "            <parameter idref=\"TIM.frequencies\"/>" << endl
-        << "        </deltaExchange>" << endl;
-    } else if (partitionSubstitutionModel == "TVMef") {
-        BEAST_xml_code
-        << "        <scaleOperator scaleFactor=\"0.75\" weight=\"0.1\">" << endl
-        << "            <parameter idref=\"TVMef.ac\"/>" << endl
-        << "        </scaleOperator>" << endl
-        << "        <scaleOperator scaleFactor=\"0.75\" weight=\"0.1\">" << endl
-        << "            <parameter idref=\"TVMef.at\"/>" << endl
-        << "        </scaleOperator>" << endl
-        << "        <scaleOperator scaleFactor=\"0.75\" weight=\"0.1\">" << endl
-        << "            <parameter idref=\"TVMef.cg\"/>" << endl
-        << "        </scaleOperator>" << endl
-        << "        <scaleOperator scaleFactor=\"0.75\" weight=\"0.1\">" << endl
-        << "            <parameter idref=\"TVMef.gt\"/>" << endl
-        << "        </scaleOperator>" << endl;
-    } else if (partitionSubstitutionModel == "TVM") {
-        BEAST_xml_code
-        << "        <scaleOperator scaleFactor=\"0.75\" weight=\"0.1\">" << endl
-        << "            <parameter idref=\"TVM.ac\"/>" << endl
-        << "        </scaleOperator>" << endl
-        << "        <scaleOperator scaleFactor=\"0.75\" weight=\"0.1\">" << endl
-        << "            <parameter idref=\"TVM.at\"/>" << endl
-        << "        </scaleOperator>" << endl
-        << "        <scaleOperator scaleFactor=\"0.75\" weight=\"0.1\">" << endl
-        << "            <parameter idref=\"TVM.cg\"/>" << endl
-        << "        </scaleOperator>" << endl
-        << "        <scaleOperator scaleFactor=\"0.75\" weight=\"0.1\">" << endl
-        << "            <parameter idref=\"TVM.gt\"/>" << endl
-        << "        </scaleOperator>" << endl
-        << "        <deltaExchange delta=\"0.01\" weight=\"0.1\">" << endl
-        << "            <parameter idref=\"TVM.frequencies\"/>" << endl
-        << "        </deltaExchange>" << endl;
-    } else if (partitionSubstitutionModel == "SYM") {
-        BEAST_xml_code
-        << "        <scaleOperator scaleFactor=\"0.75\" weight=\"0.1\">" << endl
-        << "            <parameter idref=\"SYM.ac\"/>" << endl
-        << "        </scaleOperator>" << endl
-        << "        <scaleOperator scaleFactor=\"0.75\" weight=\"0.1\">" << endl
-        << "            <parameter idref=\"SYM.ag\"/>" << endl
-        << "        </scaleOperator>" << endl
-        << "        <scaleOperator scaleFactor=\"0.75\" weight=\"0.1\">" << endl
-        << "            <parameter idref=\"SYM.at\"/>" << endl
-        << "        </scaleOperator>" << endl
-        << "        <scaleOperator scaleFactor=\"0.75\" weight=\"0.1\">" << endl
-        << "            <parameter idref=\"SYM.cg\"/>" << endl
-        << "        </scaleOperator>" << endl
-        << "        <scaleOperator scaleFactor=\"0.75\" weight=\"0.1\">" << endl
-        << "            <parameter idref=\"SYM.gt\"/>" << endl
-        << "        </scaleOperator>" << endl;;
-    } else if (partitionSubstitutionModel == "GTR") {
-        BEAST_xml_code
-        << "        <scaleOperator scaleFactor=\"0.75\" weight=\"0.1\">" << endl
-        << "            <parameter idref=\"GTR.ac\"/>" << endl
-        << "        </scaleOperator>" << endl
-        << "        <scaleOperator scaleFactor=\"0.75\" weight=\"0.1\">" << endl
-        << "            <parameter idref=\"GTR.ag\"/>" << endl
-        << "        </scaleOperator>" << endl
-        << "        <scaleOperator scaleFactor=\"0.75\" weight=\"0.1\">" << endl
-        << "            <parameter idref=\"GTR.at\"/>" << endl
-        << "        </scaleOperator>" << endl
-        << "        <scaleOperator scaleFactor=\"0.75\" weight=\"0.1\">" << endl
-        << "            <parameter idref=\"GTR.cg\"/>" << endl
-        << "        </scaleOperator>" << endl
-        << "        <scaleOperator scaleFactor=\"0.75\" weight=\"0.1\">" << endl
-        << "            <parameter idref=\"GTR.gt\"/>" << endl
-        << "        </scaleOperator>" << endl
-        << "        <deltaExchange delta=\"0.01\" weight=\"0.1\">" << endl
-        << "            <parameter idref=\"GTR.frequencies\"/>" << endl
-        << "        </deltaExchange>" << endl;
+    for (int p = 0; p < (int)partitionSubstitutionModels.size(); p++) {
+        SubstitutionModel const& subModel = *findSubstitutionModel(partitionSubstitutionModels[p]);
+        string const& prefix = partitionPrefixes[p];
+        for (int i = 0; i < subModel.numParameters; i++) {
+            if (checkEstimatedParameter(subModel.parameters[i])) {
+                string parameterName = prefix + subModel.id + "." + subModel.parameters[i].name;
+                BEAST_xml_code
+                << "        <scaleOperator scaleFactor=\"" << getOperatorTuning("scale", parameterName, "0.75")
+                << "\" weight=\"" << getOperatorWeight("scale", parameterName, "0.1") << "\">" << endl
+                << "            <parameter idref=\"" << parameterName << "\"/>" << endl
+                << "        </scaleOperator>" << endl;
+            }
+        }
+        if (subModel.frequencyWeight && !fixFrequencies) {
+            string parameterName = prefix + subModel.id + ".frequencies";
+            BEAST_xml_code
+            << "        <deltaExchange delta=\"" << getOperatorTuning("deltaexchange", parameterName, "0.01")
+            << "\" weight=\"" << getOperatorWeight("deltaexchange", parameterName, subModel.frequencyWeight) << "\">" << endl
+            << "            <parameter idref=\"" << parameterName << "\"/>" << endl
+            << "        </deltaExchange>" << endl;
+        }
+        if (partitionSiteModels[p] == "IG" || partitionSiteModels[p] == "G")
+        {
+            string parameterName = prefix + "alpha";
+            BEAST_xml_code
+            << "        <scaleOperator scaleFactor=\"" << getOperatorTuning("scale", parameterName, "0.75") << "\" weight=\"" << getOperatorWeight("scale", parameterName, "0.1") << "\">" << endl
+            << "            <parameter idref=\"" << parameterName << "\"/>" << endl
+            << "        </scaleOperator>" << endl;
+        }
+        if (partitionSiteModels[p] == "IG" || partitionSiteModels[p] == "I")
+        {
+            string parameterName = prefix + "pInv";
+            BEAST_xml_code
+            << "        <scaleOperator scaleFactor=\"" << getOperatorTuning("scale", parameterName, "0.75") << "\" weight=\"" << getOperatorWeight("scale", parameterName, "0.1") << "\">" << endl
+            << "            <parameter idref=\"" << parameterName << "\"/>" << endl
+            << "        </scaleOperator>" << endl;
+        }
     }
-    if (partitionSiteModel == "IG" || partitionSiteModel == "G")
-    {
+// relative rates of partitions move together, keeping their mean (weighted by number of sites) at 1
+    if (partitionPrefixes.size() > 1) {
         BEAST_xml_code
-        << "        <scaleOperator scaleFactor=\"0.75\" weight=\"0.1\">" << endl
-        << "            <parameter idref=\"alpha\"/>" << endl
-        << "        </scaleOperator>" << endl;
-    }
-    if (partitionSiteModel == "IG" || partitionSiteModel == "I")
-    {
+        << "        <deltaExchange delta=\"" << getOperatorTuning("deltaexchange", "allMus", "0.75") << "\" parameterWeights=\"";
+        for (int p = 0; p < (int)partitionNumSites.size(); p++) {
+            BEAST_xml_code << (p ? " " : "") << partitionNumSites[p];
+        }
+        BEAST_xml_code << "\" weight=\"" << getOperatorWeight("deltaexchange", "allMus", "3") << "\">" << endl
+        << "            <compoundParameter id=\"allMus\">" << endl;
+        for (int p = 0; p < (int)partitionPrefixes.size(); p++) {
+            BEAST_xml_code
+            << "                <parameter idref=\"" << partitionPrefixes[p] << "mu\"/>" << endl;
+        }
         BEAST_xml_code
-        << "        <scaleOperator scaleFactor=\"0.75\" weight=\"0.1\">" << endl
-        << "            <parameter idref=\"pInv\"/>" << endl
-        << "        </scaleOperator>" << endl;
+        << "            </compoundParameter>" << endl
+        << "        </deltaExchange>" << endl;
     }
     BEAST_xml_code << endl;
     
@@ -1630,22 +1209,22 @@ void BEASTXML::writeOperators (ofstream & BEAST_xml_code, string const& treePrio
     
     if (clockFlavour == "ucln") {
         BEAST_xml_code
-        << "        <scaleOperator scaleFactor=\"0.75\" weight=\"5\">" << endl
+        << "        <scaleOperator scaleFactor=\"" << getOperatorTuning("scale", "ucld.mean", "0.75") << "\" weight=\"" << getOperatorWeight("scale", "ucld.mean", "5") << "\">" << endl
         << "            <parameter idref=\"ucld.mean\"/>" << endl
         << "        </scaleOperator>" << endl
-        << "        <scaleOperator scaleFactor=\"0.75\" weight=\"5\">" << endl
+        << "        <scaleOperator scaleFactor=\"" << getOperatorTuning("scale", "ucld.stdev", "0.75") << "\" weight=\"" << getOperatorWeight("scale", "ucld.stdev", "5") << "\">" << endl
         << "            <parameter idref=\"ucld.stdev\"/>" << endl
         << "        </scaleOperator>" << endl
-        << "        <swapOperator size=\"1\" weight=\"" << numTaxa << "\" autoOptimize=\"false\">" << endl
+        << "        <swapOperator size=\"1\" weight=\"" << getOperatorWeight("swap", "branchRates.categories", convertIntToString(numTaxa)) << "\" autoOptimize=\"false\">" << endl
         << "            <parameter idref=\"branchRates.categories\"/>" << endl
         << "        </swapOperator>" << endl
 //         << "        <randomWalkIntegerOperator windowSize=\"1\" weight=\"10\">" << endl
 //         << "            <parameter idref=\"branchRates.categories\"/>" << endl
 //         << "        </randomWalkIntegerOperator>" << endl
-        << "        <uniformIntegerOperator weight=\"10\">" << endl
+        << "        <uniformIntegerOperator weight=\"" << getOperatorWeight("uniforminteger", "branchRates.categories", "10") << "\">" << endl
         << "            <parameter idref=\"branchRates.categories\"/>" << endl
         << "        </uniformIntegerOperator>" << endl
-        << "        <upDownOperator scaleFactor=\"0.75\" weight=\"5\">" << endl
+        << "        <upDownOperator scaleFactor=\"" << getOperatorTuning("up:", "ucld.mean", "0.75") << "\" weight=\"" << getOperatorWeight("up:", "ucld.mean", "5") << "\">" << endl
         << "            <up>" << endl
         << "                <compoundParameter idref=\"ucld.mean\"/>" << endl
          << "            </up>" << endl
@@ -1655,19 +1234,19 @@ void BEASTXML::writeOperators (ofstream & BEAST_xml_code, string const& treePrio
         << "        </upDownOperator>" << endl << endl;
     } else if (clockFlavour == "uced") {
         BEAST_xml_code
-        << "        <scaleOperator scaleFactor=\"0.75\" weight=\"5\">" << endl
+        << "        <scaleOperator scaleFactor=\"" << getOperatorTuning("scale", "uced.mean", "0.75") << "\" weight=\"" << getOperatorWeight("scale", "uced.mean", "5") << "\">" << endl
         << "            <parameter idref=\"uced.mean\"/>" << endl
         << "        </scaleOperator>" << endl
-        << "        <swapOperator size=\"1\" weight=\"" << numTaxa << "\" autoOptimize=\"false\">" << endl
+        << "        <swapOperator size=\"1\" weight=\"" << getOperatorWeight("swap", "branchRates.categories", convertIntToString(numTaxa)) << "\" autoOptimize=\"false\">" << endl
         << "            <parameter idref=\"branchRates.categories\"/>" << endl
         << "        </swapOperator>" << endl
 //         << "        <randomWalkIntegerOperator windowSize=\"1\" weight=\"10\">" << endl
 //         << "            <parameter idref=\"branchRates.categories\"/>" << endl
 //         << "        </randomWalkIntegerOperator>" << endl
-        << "        <uniformIntegerOperator weight=\"10\">" << endl
+        << "        <uniformIntegerOperator weight=\"" << getOperatorWeight("uniforminteger", "branchRates.categories", "10") << "\">" << endl
         << "            <parameter idref=\"branchRates.categories\"/>" << endl
         << "        </uniformIntegerOperator>" << endl
-        << "        <upDownOperator scaleFactor=\"0.75\" weight=\"5\">" << endl
+        << "        <upDownOperator scaleFactor=\"" << getOperatorTuning("up:", "uced.mean", "0.75") << "\" weight=\"" << getOperatorWeight("up:", "uced.mean", "5") << "\">" << endl
         << "            <up>" << endl
         << "                <parameter idref=\"uced.mean\"/>" << endl
         << "            </up>" << endl
@@ -1677,16 +1256,16 @@ void BEASTXML::writeOperators (ofstream & BEAST_xml_code, string const& treePrio
         << "        </upDownOperator>" << endl << endl;
     } else if (clockFlavour == "randlocal") {
         BEAST_xml_code
-        << "        <scaleOperator scaleFactor=\"0.75\" weight=\"5\">" << endl
+        << "        <scaleOperator scaleFactor=\"" << getOperatorTuning("scale", "clock.rate", "0.75") << "\" weight=\"" << getOperatorWeight("scale", "clock.rate", "5") << "\">" << endl
         << "            <parameter idref=\"clock.rate\"/>" << endl
         << "        </scaleOperator>" << endl
-        << "        <scaleOperator scaleFactor=\"0.75\" weight=\"15\">" << endl
+        << "        <scaleOperator scaleFactor=\"" << getOperatorTuning("scale", "localClock.relativeRates", "0.75") << "\" weight=\"" << getOperatorWeight("scale", "localClock.relativeRates", "15") << "\">" << endl
         << "            <parameter idref=\"localClock.relativeRates\"/>" << endl
         << "        </scaleOperator>" << endl
-        << "        <bitFlipOperator weight=\"15\">" << endl
+        << "        <bitFlipOperator weight=\"" << getOperatorWeight("bitflip", "localClock.changes", "15") << "\">" << endl
         << "            <parameter idref=\"localClock.changes\"/>" << endl
         << "        </bitFlipOperator>" << endl
-        << "        <upDownOperator scaleFactor=\"0.75\" weight=\"5\">" << endl
+        << "        <upDownOperator scaleFactor=\"" << getOperatorTuning("up:", "clock.rate", "0.75") << "\" weight=\"" << getOperatorWeight("up:", "clock.rate", "5") << "\">" << endl
         << "            <up>" << endl
         << "                <parameter idref=\"clock.rate\"/>" << endl
         << "            </up>" << endl
@@ -1698,71 +1277,71 @@ void BEASTXML::writeOperators (ofstream & BEAST_xml_code, string const& treePrio
     
     if (treePrior == "bd") {
         BEAST_xml_code
-        << "        <scaleOperator scaleFactor=\"0.75\" weight=\"3\">" << endl
+        << "        <scaleOperator scaleFactor=\"" << getOperatorTuning("scale", "birthDeath.BminusDRate", "0.75") << "\" weight=\"" << getOperatorWeight("scale", "birthDeath.BminusDRate", "3") << "\">" << endl
         << "            <parameter idref=\"birthDeath.BminusDRate\"/>" << endl
         << "        </scaleOperator>" << endl
-        << "        <scaleOperator scaleFactor=\"0.75\" weight=\"3\">" << endl
+        << "        <scaleOperator scaleFactor=\"" << getOperatorTuning("scale", "birthDeath.DoverB", "0.75") << "\" weight=\"" << getOperatorWeight("scale", "birthDeath.DoverB", "3") << "\">" << endl
         << "            <parameter idref=\"birthDeath.DoverB\"/>" << endl
         << "        </scaleOperator>" << endl << endl;
     } else if (treePrior == "yule") {
         BEAST_xml_code
-        << "        <scaleOperator scaleFactor=\"0.75\" weight=\"3\">" << endl
+        << "        <scaleOperator scaleFactor=\"" << getOperatorTuning("scale", "yule.birthRate", "0.75") << "\" weight=\"" << getOperatorWeight("scale", "yule.birthRate", "3") << "\">" << endl
         << "            <parameter idref=\"yule.birthRate\"/>" << endl
         << "        </scaleOperator>" << endl;
     } else if (treePrior == "concoal") {
         BEAST_xml_code
-        << "        <scaleOperator scaleFactor=\"0.75\" weight=\"3\">" << endl
+        << "        <scaleOperator scaleFactor=\"" << getOperatorTuning("scale", "constant.popSize", "0.75") << "\" weight=\"" << getOperatorWeight("scale", "constant.popSize", "3") << "\">" << endl
         << "            <parameter idref=\"constant.popSize\"/>" << endl
         << "        </scaleOperator>" << endl;
     } else if (treePrior == "expcoal") {
         BEAST_xml_code
-        << "        <scaleOperator scaleFactor=\"0.75\" weight=\"3\">" << endl
+        << "        <scaleOperator scaleFactor=\"" << getOperatorTuning("scale", "exponential.popSize", "0.75") << "\" weight=\"" << getOperatorWeight("scale", "exponential.popSize", "3") << "\">" << endl
         << "            <parameter idref=\"exponential.popSize\"/>" << endl
         << "        </scaleOperator>" << endl
-        << "        <randomWalkOperator windowSize=\"1.0\" weight=\"3\">" << endl
+        << "        <randomWalkOperator windowSize=\"" << getOperatorTuning("randomwalk", "exponential.growthRate", "1.0") << "\" weight=\"" << getOperatorWeight("randomwalk", "exponential.growthRate", "3") << "\">" << endl
         << "            <parameter idref=\"exponential.growthRate\"/>" << endl
         << "        </randomWalkOperator>" << endl
-        << "        <randomWalkOperator windowSize=\"1.0\" weight=\"3\" boundaryCondition=\"absorbing\">" << endl
+        << "        <randomWalkOperator windowSize=\"" << getOperatorTuning("randomwalk", "exponential.growthRate", "1.0") << "\" weight=\"" << getOperatorWeight("randomwalk", "exponential.growthRate", "3") << "\" boundaryCondition=\"absorbing\">" << endl
         << "            <parameter idref=\"exponential.growthRate\"/>" << endl
         << "        </randomWalkOperator>" << endl;
     } else if (treePrior == "logcoal") {
         BEAST_xml_code
-        << "        <scaleOperator scaleFactor=\"0.75\" weight=\"3\">" << endl
+        << "        <scaleOperator scaleFactor=\"" << getOperatorTuning("scale", "logistic.popSize", "0.75") << "\" weight=\"" << getOperatorWeight("scale", "logistic.popSize", "3") << "\">" << endl
         << "            <parameter idref=\"logistic.popSize\"/>" << endl
         << "        </scaleOperator>" << endl
-        << "        <randomWalkOperator windowSize=\"1.0\" weight=\"3\">" << endl
+        << "        <randomWalkOperator windowSize=\"" << getOperatorTuning("randomwalk", "logistic.growthRate", "1.0") << "\" weight=\"" << getOperatorWeight("randomwalk", "logistic.growthRate", "3") << "\">" << endl
         << "            <parameter idref=\"logistic.growthRate\"/>" << endl
         << "        </randomWalkOperator>" << endl
-        << "        <randomWalkOperator windowSize=\"1.0\" weight=\"3\" boundaryCondition=\"absorbing\">" << endl
+        << "        <randomWalkOperator windowSize=\"" << getOperatorTuning("randomwalk", "logistic.growthRate", "1.0") << "\" weight=\"" << getOperatorWeight("randomwalk", "logistic.growthRate", "3") << "\" boundaryCondition=\"absorbing\">" << endl
         << "            <parameter idref=\"logistic.growthRate\"/>" << endl
         << "        </randomWalkOperator>" << endl
-        << "        <scaleOperator scaleFactor=\"0.75\" weight=\"3\">" << endl
+        << "        <scaleOperator scaleFactor=\"" << getOperatorTuning("scale", "logistic.t50", "0.75") << "\" weight=\"" << getOperatorWeight("scale", "logistic.t50", "3") << "\">" << endl
         << "            <parameter idref=\"logistic.t50\"/>" << endl
         << "        </scaleOperator>" << endl;
     }
     
     BEAST_xml_code
-    << "        <scaleOperator scaleFactor=\"0.75\" weight=\"5\">" << endl
+    << "        <scaleOperator scaleFactor=\"" << getOperatorTuning("scale", "treeModel.rootHeight", "0.75") << "\" weight=\"" << getOperatorWeight("scale", "treeModel.rootHeight", "5") << "\">" << endl
     << "            <parameter idref=\"treeModel.rootHeight\"/>" << endl
     << "        </scaleOperator>" << endl
     
-    << "        <uniformOperator weight=\"30\">" << endl
+    << "        <uniformOperator weight=\"" << getOperatorWeight("uniform", "treeModel.internalNodeHeights", "30") << "\">" << endl
     << "            <parameter idref=\"treeModel.internalNodeHeights\"/>" << endl
     << "        </uniformOperator>" << endl << endl;
     
     if (manipulateTreeTopology) {
         BEAST_xml_code
         << "<!-- *** TOPOLOGY MANIPULATION OPERATORS *** -->" << endl
-        << "        <subtreeSlide size=\"0.02\" gaussian=\"true\" weight=\"15\">" << endl
+        << "        <subtreeSlide size=\"" << getOperatorTuning("subtreeslide", "treeModel", "0.02") << "\" gaussian=\"true\" weight=\"" << getOperatorWeight("subtreeslide", "treeModel", "15") << "\">" << endl
         << "            <treeModel idref=\"treeModel\"/>" << endl
         << "        </subtreeSlide>" << endl
-        << "        <narrowExchange weight=\"15\">" << endl
+        << "        <narrowExchange weight=\"" << getOperatorWeight("narrow", "treeModel", "15") << "\">" << endl
         << "            <treeModel idref=\"treeModel\"/>" << endl
         << "        </narrowExchange>" << endl
-        << "        <wideExchange weight=\"3\">" << endl
+        << "        <wideExchange weight=\"" << getOperatorWeight("wide", "treeModel", "3") << "\">" << endl
         << "            <treeModel idref=\"treeModel\"/>" << endl
         << "        </wideExchange>" << endl
-        << "        <wilsonBalding weight=\"3\">" << endl
+        << "        <wilsonBalding weight=\"" << getOperatorWeight("wilson", "treeModel", "3") << "\">" << endl
         << "            <treeModel idref=\"treeModel\"/>" << endl
         << "        </wilsonBalding>" << endl;
     } else if (!manipulateTreeTopology) {
@@ -1789,368 +1368,50 @@ void BEASTXML::writeOperators (ofstream & BEAST_xml_code, string const& treePrio
     << "    </operators>" << endl << endl;
 }
 
-// not used at the moment
-/*
-void BEASTXML::writeOperators (ofstream & BEAST_xml_code, string const& treePrior, bool const& manipulateTreeTopology,
-    vector <string> const& partitionSubstitutionModels, vector <string> const& partitionSiteModels,
-    string const& clockFlavour, int const& numTaxa)
+void BEASTXML::writeMCMCParameters (ostream & BEAST_xml_code, long long const& mcmcLength, string const& clockFlavour, 
+    vector <string> const& partitionSubstitutionModels, vector <string> const& rootPrior, string const& treePrior)
 {
-    int counter = 0;
+    ScopedTimer timer("emit.mcmc");
     BEAST_xml_code << endl
-    << "<!-- *** DEFINE OPERATORS *** -->" << endl
-    <<     "    <operators id=\"operators\">" << endl;
-    for (vector<string>::const_iterator iter = partitionSubstitutionModels.begin(); iter != partitionSubstitutionModels.end(); iter++) {
-        if (partitionSubstitutionModels[counter] == "K80") {
-            BEAST_xml_code    
-            << "        <scaleOperator scaleFactor=\"0.75\" weight=\"0.1\">" << endl
-            << "            <parameter idref=\"K80.kappa\"/>" << endl
-            << "        </scaleOperator>" << endl;
-        } else if (partitionSubstitutionModels[counter] == "HKY") {
-            BEAST_xml_code    
-            << "        <scaleOperator scaleFactor=\"0.75\" weight=\"0.1\">" << endl
-            << "            <parameter idref=\"HKY.kappa\"/>" << endl
-            << "        </scaleOperator>" << endl
-            << "        <deltaExchange delta=\"0.01\" weight=\"0.1\">" << endl
-            << "            <parameter idref=\"HKY.frequencies\"/>" << endl
-            << "        </deltaExchange>" << endl;
-        } else if (partitionSubstitutionModels[counter] == "TrNef") {
-            BEAST_xml_code
-            << "        <scaleOperator scaleFactor=\"0.75\" weight=\"0.1\">" << endl
-            << "            <parameter idref=\"TrNef.transversion\"/>" << endl
-            << "        </scaleOperator>" << endl
-            << "        <scaleOperator scaleFactor=\"0.75\" weight=\"0.1\">" << endl
-            << "            <parameter idref=\"TrNef.ag\"/>" << endl
-            << "        </scaleOperator>" << endl;
-        } else if (partitionSubstitutionModels[counter] == "TrN") {
-            BEAST_xml_code
-            << "        <scaleOperator scaleFactor=\"0.75\" weight=\"0.1\">" << endl
-            << "            <parameter idref=\"TrN.transversion\"/>" << endl
-            << "        </scaleOperator>" << endl
-            << "        <scaleOperator scaleFactor=\"0.75\" weight=\"0.1\">" << endl
-            << "            <parameter idref=\"TrN.ag\"/>" << endl
-            << "        </scaleOperator>" << endl
-            << "        <deltaExchange delta=\"0.01\" weight=\"1\">" << endl
-            << "            <parameter idref=\"TrN.frequencies\"/>" << endl
-            << "        </deltaExchange>" << endl;
-        } else if (partitionSubstitutionModels[counter] == "K3P") {
-            BEAST_xml_code
-            << "        <scaleOperator scaleFactor=\"0.75\" weight=\"0.1\">" << endl
-            << "            <parameter idref=\"K3P.purine2pyrimidine\"/>" << endl
-            << "        </scaleOperator>" << endl
-            << "        <scaleOperator scaleFactor=\"0.75\" weight=\"0.1\">" << endl
-            << "            <parameter idref=\"K3P.pyrimidine2purine\"/>" << endl
-            << "        </scaleOperator>" << endl;
-        } else if (partitionSubstitutionModels[counter] == "K3Puf") {
-            BEAST_xml_code
-            << "        <scaleOperator scaleFactor=\"0.75\" weight=\"0.1\">" << endl
-            << "            <parameter idref=\"K3Puf.purine2pyrimidine\"/>" << endl
-            << "        </scaleOperator>" << endl
-            << "        <scaleOperator scaleFactor=\"0.75\" weight=\"0.1\">" << endl
-            << "            <parameter idref=\"K3Puf.pyrimidine2purine\"/>" << endl
-            << "        </scaleOperator>" << endl
-            << "        <deltaExchange delta=\"0.01\" weight=\"0.1\">" << endl
-            << "            <parameter idref=\"K3Puf.frequencies\"/>" << endl
-            << "        </deltaExchange>" << endl;
-        } else if (partitionSubstitutionModels[counter] == "TIMef") {
-            BEAST_xml_code
-            << "        <scaleOperator scaleFactor=\"0.75\" weight=\"0.1\">" << endl
-            << "            <parameter idref=\"TIMef.purine2pyrimidine\"/>" << endl
-            << "        </scaleOperator>" << endl
-            << "        <scaleOperator scaleFactor=\"0.75\" weight=\"0.1\">" << endl
-            << "            <parameter idref=\"TIMef.ag\"/>" << endl
-            << "        </scaleOperator>" << endl
-            << "        <scaleOperator scaleFactor=\"0.75\" weight=\"0.1\">" << endl
-            << "            <parameter idref=\"TIMef.pyrimidine2purine\"/>" << endl
-            << "        </scaleOperator>" << endl;
-        } else if (partitionSubstitutionModels[counter] == "TIM") {
-            BEAST_xml_code
-            << "        <scaleOperator scaleFactor=\"0.75\" weight=\"0.1\">" << endl
-            << "            <parameter idref=\"TIM.purine2pyrimidine\"/>" << endl
-            << "        </scaleOperator>" << endl
-            << "        <scaleOperator scaleFactor=\"0.75\" weight=\"0.1\">" << endl
-            << "            <parameter idref=\"TIM.ag\"/>" << endl
-            << "        </scaleOperator>" << endl
-            << "        <scaleOperator scaleFactor=\"0.75\" weight=\"0.1\">" << endl
-            << "            <parameter idref=\"TIM.pyrimidine2purine\"/>" << endl
-            << "        </scaleOperator>" << endl
-            << "        <deltaExchange delta=\"0.01\" weight=\"0.1\">" << endl
-            << "            <parameter idref=\"TIM.frequencies\"/>" << endl
-            << "        </deltaExchange>" << endl;
-        } else if (partitionSubstitutionModels[counter] == "TVMef") {
-            BEAST_xml_code
-            << "        <scaleOperator scaleFactor=\"0.75\" weight=\"0.1\">" << endl
-            << "            <parameter idref=\"TVMef.ac\"/>" << endl
-            << "        </scaleOperator>" << endl
-            << "        <scaleOperator scaleFactor=\"0.75\" weight=\"0.1\">" << endl
-            << "            <parameter idref=\"TVMef.at\"/>" << endl
-            << "        </scaleOperator>" << endl
-            << "        <scaleOperator scaleFactor=\"0.75\" weight=\"0.1\">" << endl
-            << "            <parameter idref=\"TVMef.cg\"/>" << endl
-            << "        </scaleOperator>" << endl
-            << "        <scaleOperator scaleFactor=\"0.75\" weight=\"0.1\">" << endl
-            << "            <parameter idref=\"TVMef.gt\"/>" << endl
-            << "        </scaleOperator>" << endl;
-        } else if (partitionSubstitutionModels[counter] == "TVM") {
-            BEAST_xml_code
-            << "        <scaleOperator scaleFactor=\"0.75\" weight=\"0.1\">" << endl
-            << "            <parameter idref=\"TVM.ac\"/>" << endl
-            << "        </scaleOperator>" << endl
-            << "        <scaleOperator scaleFactor=\"0.75\" weight=\"0.1\">" << endl
-            << "            <parameter idref=\"TVM.at\"/>" << endl
-            << "        </scaleOperator>" << endl
-            << "        <scaleOperator scaleFactor=\"0.75\" weight=\"0.1\">" << endl
-            << "            <parameter idref=\"TVM.cg\"/>" << endl
-            << "        </scaleOperator>" << endl
-            << "        <scaleOperator scaleFactor=\"0.75\" weight=\"0.1\">" << endl
-            << "            <parameter idref=\"TVM.gt\"/>" << endl
-            << "        </scaleOperator>" << endl
-            << "        <deltaExchange delta=\"0.01\" weight=\"0.1\">" << endl
-            << "            <parameter idref=\"TVM.frequencies\"/>" << endl
-            << "        </deltaExchange>" << endl;
-        } else if (partitionSubstitutionModels[counter] == "SYM") {
-            BEAST_xml_code
-            << "        <scaleOperator scaleFactor=\"0.75\" weight=\"0.1\">" << endl
-            << "            <parameter idref=\"SYM.ac\"/>" << endl
-            << "        </scaleOperator>" << endl
-            << "        <scaleOperator scaleFactor=\"0.75\" weight=\"0.1\">" << endl
-            << "            <parameter idref=\"SYM.ag\"/>" << endl
-            << "        </scaleOperator>" << endl
-            << "        <scaleOperator scaleFactor=\"0.75\" weight=\"0.1\">" << endl
-            << "            <parameter idref=\"SYM.at\"/>" << endl
-            << "        </scaleOperator>" << endl
-            << "        <scaleOperator scaleFactor=\"0.75\" weight=\"0.1\">" << endl
-            << "            <parameter idref=\"SYM.cg\"/>" << endl
-            << "        </scaleOperator>" << endl
-            << "        <scaleOperator scaleFactor=\"0.75\" weight=\"0.1\">" << endl
-            << "            <parameter idref=\"SYM.gt\"/>" << endl
-            << "        </scaleOperator>" << endl;;
-        } else if (partitionSubstitutionModels[counter] == "GTR") {
-            BEAST_xml_code
-            << "        <scaleOperator scaleFactor=\"0.75\" weight=\"0.1\">" << endl
-            << "            <parameter idref=\"GTR.ac\"/>" << endl
-            << "        </scaleOperator>" << endl
-            << "        <scaleOperator scaleFactor=\"0.75\" weight=\"0.1\">" << endl
-            << "            <parameter idref=\"GTR.ag\"/>" << endl
-            << "        </scaleOperator>" << endl
-            << "        <scaleOperator scaleFactor=\"0.75\" weight=\"0.1\">" << endl
-            << "            <parameter idref=\"GTR.at\"/>" << endl
-            << "        </scaleOperator>" << endl
-            << "        <scaleOperator scaleFactor=\"0.75\" weight=\"0.1\">" << endl
-            << "            <parameter idref=\"GTR.cg\"/>" << endl
-            << "        </scaleOperator>" << endl
-            << "        <scaleOperator scaleFactor=\"0.75\" weight=\"0.1\">" << endl
-            << "            <parameter idref=\"GTR.gt\"/>" << endl
-            << "        </scaleOperator>" << endl
-            << "        <deltaExchange delta=\"0.01\" weight=\"0.1\">" << endl
-            << "            <parameter idref=\"GTR.frequencies\"/>" << endl
-            << "        </deltaExchange>" << endl;
-        }
-        if (partitionSiteModels[counter] == "IG" || partitionSiteModels[counter] == "G")
-        {
-            BEAST_xml_code
-            << "        <scaleOperator scaleFactor=\"0.75\" weight=\"0.1\">" << endl
-            << "            <parameter idref=\"alpha\"/>" << endl
-            << "        </scaleOperator>" << endl;
-        }
-        if (partitionSiteModels[counter] == "IG" || partitionSiteModels[counter] == "I")
-        {
-            BEAST_xml_code
-            << "        <scaleOperator scaleFactor=\"0.75\" weight=\"0.1\">" << endl
-            << "            <parameter idref=\"pInv\"/>" << endl
-            << "        </scaleOperator>" << endl;
-        }
-        BEAST_xml_code << endl;
-        counter++;
-    }
-    
-    BEAST_xml_code
-    << "<!-- *** CLOCK OPERATORS *** -->" << endl;
-    
-    if (clockFlavour == "ucln") {
-        BEAST_xml_code
-        << "        <scaleOperator scaleFactor=\"0.75\" weight=\"5\">" << endl
-        << "            <parameter idref=\"ucld.mean\"/>" << endl
-        << "        </scaleOperator>" << endl
-        << "        <scaleOperator scaleFactor=\"0.75\" weight=\"5\">" << endl
-        << "            <parameter idref=\"ucld.stdev\"/>" << endl
-        << "        </scaleOperator>" << endl
-        << "        <swapOperator size=\"1\" weight=\"" << numTaxa << "\" autoOptimize=\"false\">" << endl
-        << "            <parameter idref=\"branchRates.categories\"/>" << endl
-        << "        </swapOperator>" << endl
-        << "        <randomWalkIntegerOperator windowSize=\"1\" weight=\"10\">" << endl
-        << "            <parameter idref=\"branchRates.categories\"/>" << endl
-        << "        </randomWalkIntegerOperator>" << endl
-        << "        <uniformIntegerOperator weight=\"10\">" << endl
-        << "            <parameter idref=\"branchRates.categories\"/>" << endl
-        << "        </uniformIntegerOperator>" << endl
-        << "        <upDownOperator scaleFactor=\"0.75\" weight=\"5\" autoOptimize=\"true\">" << endl
-        << "            <up>" << endl
-        << "                <compoundParameter idref=\"ucld.mean\"/>" << endl
-         << "            </up>" << endl
-        << "            <down>" << endl
-        << "                <parameter idref=\"treeModel.allInternalNodeHeights\"/>" << endl
-        << "            </down>" << endl
-        << "        </upDownOperator>" << endl << endl;
-    } else if (clockFlavour == "uced") {
-        BEAST_xml_code
-        << "        <scaleOperator scaleFactor=\"0.75\" weight=\"3\">" << endl
-        << "            <parameter idref=\"uced.mean\"/>" << endl
-        << "        </scaleOperator>" << endl
-        << "        <swapOperator size=\"1\" weight=\"10\" autoOptimize=\"false\">" << endl
-        << "            <parameter idref=\"branchRates.categories\"/>" << endl
-        << "        </swapOperator>" << endl
-        << "        <randomWalkIntegerOperator windowSize=\"1\" weight=\"10\">" << endl
-        << "            <parameter idref=\"branchRates.categories\"/>" << endl
-        << "        </randomWalkIntegerOperator>" << endl
-        << "        <uniformIntegerOperator weight=\"10\">" << endl
-        << "            <parameter idref=\"branchRates.categories\"/>" << endl
-        << "        </uniformIntegerOperator>" << endl
-        << "        <upDownOperator scaleFactor=\"0.75\" weight=\"3\">" << endl
-        << "            <up>" << endl
-        << "                <parameter idref=\"uced.mean\"/>" << endl
-        << "            </up>" << endl
-        << "            <down>" << endl
-        << "                <parameter idref=\"treeModel.allInternalNodeHeights\"/>" << endl
-        << "            </down>" << endl
-        << "        </upDownOperator>" << endl << endl;
-    }
+    << "<!-- *** MCMC PARAMETERS *** -->" << endl
+    << "    <mcmc id=\"mcmc\" chainLength=\"" << mcmcLength << "\" autoOptimize=\"true\" operatorAnalysis=\""
+    << getRootName(XMLOutFileName) << ".ops\">" << endl
+    << "        <posterior id=\"posterior\">" << endl
+    << "            <prior id=\"prior\">" << endl;
     
+// set tree priors. currently uses improper clock priors
     if (treePrior == "bd") {
         BEAST_xml_code
-        << "        <scaleOperator scaleFactor=\"0.75\" weight=\"3\">" << endl
-        << "            <parameter idref=\"birthDeath.BminusDRate\"/>" << endl
-        << "        </scaleOperator>" << endl
-        << "        <scaleOperator scaleFactor=\"0.75\" weight=\"3\">" << endl
-        << "            <parameter idref=\"birthDeath.DoverB\"/>" << endl
-        << "        </scaleOperator>" << endl << endl;
+        << "            <!-- Improper uniform clock prior -->" << endl
+        << "                <uniformPrior lower=\"0.0\" upper=\"100000.0\">" << endl
+        << "                    <parameter idref=\"birthDeath.BminusDRate\"/>" << endl
+        << "                </uniformPrior>" << endl
+        << "                <uniformPrior lower=\"0.0\" upper=\"1.0\">" << endl
+        << "                    <parameter idref=\"birthDeath.DoverB\"/>" << endl
+        << "                </uniformPrior>" << endl
+        << "                <speciationLikelihood idref=\"speciation\"/>" << endl << endl;
     } else if (treePrior == "yule") {
         BEAST_xml_code
-        << "        <scaleOperator scaleFactor=\"0.75\" weight=\"3\">" << endl
-        << "            <parameter idref=\"yule.birthRate\"/>" << endl
-        << "        </scaleOperator>" << endl;
+        << "            <!-- Improper uniform clock prior -->" << endl
+        << "                <uniformPrior lower=\"0.0\" upper=\"1.0E100\">" << endl
+        << "                    <parameter idref=\"yule.birthRate\"/>" << endl
+        << "                </uniformPrior>" << endl
+        << "                <speciationLikelihood idref=\"speciation\"/>" << endl << endl;
     } else if (treePrior == "concoal") {
         BEAST_xml_code
-        << "        <scaleOperator scaleFactor=\"0.75\" weight=\"3\">" << endl
-        << "            <parameter idref=\"constant.popSize\"/>" << endl
-        << "        </scaleOperator>" << endl;
+        << "                <oneOnXPrior>" << endl
+        << "                    <parameter idref=\"constant.popSize\"/>" << endl
+        << "                </oneOnXPrior>" << endl
+        << "                <coalescentLikelihood idref=\"coalescent\"/>" << endl << endl;
     } else if (treePrior == "expcoal") {
         BEAST_xml_code
-        << "        <scaleOperator scaleFactor=\"0.75\" weight=\"3\">" << endl
-        << "            <parameter idref=\"exponential.popSize\"/>" << endl
-        << "        </scaleOperator>" << endl
-        << "        <randomWalkOperator windowSize=\"1.0\" weight=\"3\">" << endl
-        << "            <parameter idref=\"exponential.growthRate\"/>" << endl
-        << "        </randomWalkOperator>" << endl
-        << "        <randomWalkOperator windowSize=\"1.0\" weight=\"3\" boundaryCondition=\"absorbing\">" << endl
-        << "            <parameter idref=\"exponential.growthRate\"/>" << endl
-        << "        </randomWalkOperator>" << endl;
-    } else if (treePrior == "logcoal") {
-        BEAST_xml_code
-        << "        <scaleOperator scaleFactor=\"0.75\" weight=\"3\">" << endl
-        << "            <parameter idref=\"logistic.popSize\"/>" << endl
-        << "        </scaleOperator>" << endl
-        << "        <randomWalkOperator windowSize=\"1.0\" weight=\"3\">" << endl
-        << "            <parameter idref=\"logistic.growthRate\"/>" << endl
-        << "        </randomWalkOperator>" << endl
-        << "        <randomWalkOperator windowSize=\"1.0\" weight=\"3\" boundaryCondition=\"absorbing\">" << endl
-        << "            <parameter idref=\"logistic.growthRate\"/>" << endl
-        << "        </randomWalkOperator>" << endl
-        << "        <scaleOperator scaleFactor=\"0.75\" weight=\"3\">" << endl
-        << "            <parameter idref=\"logistic.t50\"/>" << endl
-        << "        </scaleOperator>" << endl;
-    }
-    
-    BEAST_xml_code
-    << "        <scaleOperator scaleFactor=\"0.75\" weight=\"5\">" << endl
-    << "            <parameter idref=\"treeModel.rootHeight\"/>" << endl
-    << "        </scaleOperator>" << endl
-    
-    << "        <uniformOperator weight=\"30\">" << endl
-    << "            <parameter idref=\"treeModel.internalNodeHeights\"/>" << endl
-    << "        </uniformOperator>" << endl << endl;
-    
-    if (manipulateTreeTopology) {
-        BEAST_xml_code
-        << "<!-- *** TOPOLOGY MANIPULATION OPERATORS *** -->" << endl
-        << "        <subtreeSlide size=\"0.02\" gaussian=\"true\" weight=\"15\">" << endl
-        << "            <treeModel idref=\"treeModel\"/>" << endl
-        << "        </subtreeSlide>" << endl
-        << "        <narrowExchange weight=\"15\">" << endl
-        << "            <treeModel idref=\"treeModel\"/>" << endl
-        << "        </narrowExchange>" << endl
-        << "        <wideExchange weight=\"3\">" << endl
-        << "            <treeModel idref=\"treeModel\"/>" << endl
-        << "        </wideExchange>" << endl
-        << "        <wilsonBalding weight=\"3\">" << endl
-        << "            <treeModel idref=\"treeModel\"/>" << endl
-        << "        </wilsonBalding>" << endl;
-    } else if (!manipulateTreeTopology) {
-        BEAST_xml_code << endl
-        << "<!-- *** TOPOLOGY MANIPULATION OPERATORS *** -->" << endl
-        << "<!-- *** Commented out for current analysis *** -->" << endl
-        << "<!--" << endl
-        << "        <subtreeSlide size=\"0.02\" gaussian=\"true\" weight=\"15\">" << endl
-        << "            <treeModel idref=\"treeModel\"/>" << endl
-        << "        </subtreeSlide>" << endl
-        << "        <narrowExchange weight=\"150\">" << endl
-        << "            <treeModel idref=\"treeModel\"/>" << endl
-        << "        </narrowExchange>" << endl
-        << "        <wideExchange weight=\"30\">" << endl
-        << "            <treeModel idref=\"treeModel\"/>" << endl
-        << "        </wideExchange>" << endl
-        << "        <wilsonBalding weight=\"30\">" << endl
-        << "            <treeModel idref=\"treeModel\"/>" << endl
-        << "        </wilsonBalding>" << endl
-        << "-->" << endl;
-    }
-    
-    BEAST_xml_code
-    << "    </operators>" << endl << endl;
-}
-*/
-
-void BEASTXML::writeMCMCParameters (ofstream & BEAST_xml_code, int const& mcmcLength, string const& clockFlavour, 
-    string const& partitionSubstitutionModel, vector <string> const& rootPrior, string const& treePrior)
-{
-    BEAST_xml_code << endl
-    << "<!-- *** MCMC PARAMETERS *** -->" << endl
-    << "    <mcmc id=\"mcmc\" chainLength=\"" << mcmcLength << "\" autoOptimize=\"true\">" << endl
-    << "        <posterior id=\"posterior\">" << endl
-    << "            <prior id=\"prior\">" << endl;
-    
-// set tree priors. currently uses improper clock priors
-    if (treePrior == "bd") {
-        BEAST_xml_code
-        << "            <!-- Improper uniform clock prior -->" << endl
-        << "                <uniformPrior lower=\"0.0\" upper=\"100000.0\">" << endl
-        << "                    <parameter idref=\"birthDeath.BminusDRate\"/>" << endl
-        << "                </uniformPrior>" << endl
-        << "                <uniformPrior lower=\"0.0\" upper=\"1.0\">" << endl
-        << "                    <parameter idref=\"birthDeath.DoverB\"/>" << endl
-        << "                </uniformPrior>" << endl
-        << "                <speciationLikelihood idref=\"speciation\"/>" << endl << endl;
-    } else if (treePrior == "yule") {
-        BEAST_xml_code
-        << "            <!-- Improper uniform clock prior -->" << endl
-        << "                <uniformPrior lower=\"0.0\" upper=\"1.0E100\">" << endl
-        << "                    <parameter idref=\"yule.birthRate\"/>" << endl
-        << "                </uniformPrior>" << endl
-        << "                <speciationLikelihood idref=\"speciation\"/>" << endl << endl;
-    } else if (treePrior == "concoal") {
-        BEAST_xml_code
-        << "                <oneOnXPrior>" << endl
-        << "                    <parameter idref=\"constant.popSize\"/>" << endl
-        << "                </oneOnXPrior>" << endl
-        << "                <coalescentLikelihood idref=\"coalescent\"/>" << endl << endl;
-    } else if (treePrior == "expcoal") {
-        BEAST_xml_code
-        << "                <oneOnXPrior>" << endl
-        << "                    <parameter idref=\"exponential.popSize\"/>" << endl
-        << "                </oneOnXPrior>" << endl
-        << "                <laplacePrior mean=\"0.0\" scale=\"30.701134573253945\">" << endl
-        << "                    <parameter idref=\"exponential.growthRate\"/>" << endl
-        << "                </laplacePrior>" << endl
-        << "                <coalescentLikelihood idref=\"coalescent\"/>" << endl << endl;
+        << "                <oneOnXPrior>" << endl
+        << "                    <parameter idref=\"exponential.popSize\"/>" << endl
+        << "                </oneOnXPrior>" << endl
+        << "                <laplacePrior mean=\"0.0\" scale=\"30.701134573253945\">" << endl
+        << "                    <parameter idref=\"exponential.growthRate\"/>" << endl
+        << "                </laplacePrior>" << endl
+        << "                <coalescentLikelihood idref=\"coalescent\"/>" << endl << endl;
     } else if (treePrior == "logcoal") {
         BEAST_xml_code
         << "                <oneOnXPrior>" << endl
@@ -2195,403 +1456,69 @@ void BEASTXML::writeMCMCParameters (ofstream & BEAST_xml_code, int const& mcmcLe
             << "                    <parameter idref=\"treeModel.rootHeight\"/>" << endl
             << "                </normalPrior>" << endl << endl;
         } else {
-            cout << "Shit. Fucked up somewhere..." << endl;
-            exit(1);
+            throw BEASTifierError("option", "root prior flavour '" + rootPrior[0] + "' not recognized");
         }
     }
     
 // set substitution model priors
-    if (partitionSubstitutionModel == "K80") {
-        BEAST_xml_code
-        << "                <logNormalPrior mean=\"1.0\" stdev=\"1.25\" offset=\"0.0\" meanInRealSpace=\"false\">" << endl
-        << "                    <parameter idref=\"k80.kappa\"/>" << endl
-        << "                </logNormalPrior>" << endl;
-    } else if (partitionSubstitutionModel == "HKY") {
-// Updated prior here to logNormal
-        BEAST_xml_code
-        << "                <logNormalPrior mean=\"1.0\" stdev=\"1.25\" offset=\"0.0\" meanInRealSpace=\"false\">" << endl
-        << "                    <parameter idref=\"HKY.kappa\"/>" << endl
-        << "                </logNormalPrior>" << endl;
-    } else if (partitionSubstitutionModel == "TrNef") {
-        BEAST_xml_code
-        << "                <gammaPrior shape=\"0.05\" scale=\"10.0\" offset=\"0.0\">" << endl
-        << "                    <parameter idref=\"TrNef.transversion\"/>" << endl
-        << "                </gammaPrior>" << endl
-        << "                <gammaPrior shape=\"0.05\" scale=\"10.0\" offset=\"0.0\">" << endl
-        << "                    <parameter idref=\"TrNef.ag\"/>" << endl
-        << "                </gammaPrior>" << endl;
-    } else if (partitionSubstitutionModel == "TrN") {
-        BEAST_xml_code
-        << "                <gammaPrior shape=\"0.05\" scale=\"10.0\" offset=\"0.0\">" << endl
-        << "                    <parameter idref=\"TrN.transversion\"/>" << endl
-        << "                </gammaPrior>" << endl
-        << "                <gammaPrior shape=\"0.05\" scale=\"10.0\" offset=\"0.0\">" << endl
-        << "                    <parameter idref=\"TrN.ag\"/>" << endl
-        << "                </gammaPrior>" << endl;
-    } else if (partitionSubstitutionModel == "K3P") {
-        BEAST_xml_code
-        << "                <gammaPrior shape=\"0.05\" scale=\"10.0\" offset=\"0.0\">" << endl
-        << "                    <parameter idref=\"K3P.purine2pyrimidine\"/>" << endl
-        << "                </gammaPrior>" << endl
-        << "                <gammaPrior shape=\"0.05\" scale=\"10.0\" offset=\"0.0\">" << endl
-        << "                    <parameter idref=\"K3P.pyrimidine2purine\"/>" << endl
-        << "                </gammaPrior>" << endl;
-    } else if (partitionSubstitutionModel == "K3Puf") {
-        BEAST_xml_code
-        << "                <gammaPrior shape=\"0.05\" scale=\"10.0\" offset=\"0.0\">" << endl
-        << "                    <parameter idref=\"K3Puf.purine2pyrimidine\"/>" << endl
-        << "                </gammaPrior>" << endl
-        << "                <gammaPrior shape=\"0.05\" scale=\"10.0\" offset=\"0.0\">" << endl
-        << "                    <parameter idref=\"K3Puf.pyrimidine2purine\"/>" << endl
-        << "                </gammaPrior>" << endl;
-    } else if (partitionSubstitutionModel == "TIMef") {
-        BEAST_xml_code
-        << "                <gammaPrior shape=\"0.05\" scale=\"10.0\" offset=\"0.0\">" << endl
-        << "                    <parameter idref=\"TIMef.purine2pyrimidine\"/>" << endl
-        << "                </gammaPrior>" << endl
-        << "                <gammaPrior shape=\"0.05\" scale=\"10.0\" offset=\"0.0\">" << endl
-        << "                    <parameter idref=\"TIMef.ag\"/>" << endl
-        << "                </gammaPrior>" << endl
-        << "                <gammaPrior shape=\"0.05\" scale=\"10.0\" offset=\"0.0\">" << endl
-        << "                    <parameter idref=\"TIMef.pyrimidine2purine\"/>" << endl
-        << "                </gammaPrior>" << endl;
-    } else if (partitionSubstitutionModel == "TIM") {
-        BEAST_xml_code
-        << "                <gammaPrior shape=\"0.05\" scale=\"10.0\" offset=\"0.0\">" << endl
-        << "                    <parameter idref=\"TIM.purine2pyrimidine\"/>" << endl
-        << "                </gammaPrior>" << endl
-        << "                <gammaPrior shape=\"0.05\" scale=\"10.0\" offset=\"0.0\">" << endl
-        << "                    <parameter idref=\"TIM.ag\"/>" << endl
-        << "                </gammaPrior>" << endl
-        << "                <gammaPrior shape=\"0.05\" scale=\"10.0\" offset=\"0.0\">" << endl
-        << "                    <parameter idref=\"TIM.pyrimidine2purine\"/>" << endl
-        << "                </gammaPrior>" << endl;
-    } else if (partitionSubstitutionModel == "TVMef") {
-        BEAST_xml_code
-        << "                <gammaPrior shape=\"0.05\" scale=\"10.0\" offset=\"0.0\">" << endl
-        << "                    <parameter idref=\"TVMef.ac\"/>" << endl
-        << "                </gammaPrior>" << endl
-        << "                <gammaPrior shape=\"0.05\" scale=\"10.0\" offset=\"0.0\">" << endl
-        << "                    <parameter idref=\"TVMef.at\"/>" << endl
-        << "                </gammaPrior>" << endl
-        << "                <gammaPrior shape=\"0.05\" scale=\"10.0\" offset=\"0.0\">" << endl
-        << "                    <parameter idref=\"TVMef.cg\"/>" << endl
-        << "                </gammaPrior>" << endl
-        << "                <gammaPrior shape=\"0.05\" scale=\"10.0\" offset=\"0.0\">" << endl
-        << "                    <parameter idref=\"TVMef.gt\"/>" << endl
-        << "                </gammaPrior>" << endl;
-    } else if (partitionSubstitutionModel == "TVM") {
-        BEAST_xml_code
-        << "                <gammaPrior shape=\"0.05\" scale=\"10.0\" offset=\"0.0\">" << endl
-        << "                    <parameter idref=\"TVM.ac\"/>" << endl
-        << "                </gammaPrior>" << endl
-        << "                <gammaPrior shape=\"0.05\" scale=\"10.0\" offset=\"0.0\">" << endl
-        << "                    <parameter idref=\"TVM.at\"/>" << endl
-        << "                </gammaPrior>" << endl
-        << "                <gammaPrior shape=\"0.05\" scale=\"10.0\" offset=\"0.0\">" << endl
-        << "                    <parameter idref=\"TVM.cg\"/>" << endl
-        << "                </gammaPrior>" << endl
-        << "                <gammaPrior shape=\"0.05\" scale=\"10.0\" offset=\"0.0\">" << endl
-        << "                    <parameter idref=\"TVM.gt\"/>" << endl
-        << "                </gammaPrior>" << endl;
-    } else if (partitionSubstitutionModel == "SYM") {
-        BEAST_xml_code
-        << "                <gammaPrior shape=\"0.05\" scale=\"10.0\" offset=\"0.0\">" << endl
-        << "                    <parameter idref=\"SYM.ac\"/>" << endl
-        << "                </gammaPrior>" << endl
-        << "                <gammaPrior shape=\"0.05\" scale=\"10.0\" offset=\"0.0\">" << endl
-        << "                    <parameter idref=\"SYM.ag\"/>" << endl
-        << "                </gammaPrior>" << endl
-        << "                <gammaPrior shape=\"0.05\" scale=\"10.0\" offset=\"0.0\">" << endl
-        << "                    <parameter idref=\"SYM.at\"/>" << endl
-        << "                </gammaPrior>" << endl
-        << "                <gammaPrior shape=\"0.05\" scale=\"10.0\" offset=\"0.0\">" << endl
-        << "                    <parameter idref=\"SYM.cg\"/>" << endl
-        << "                </gammaPrior>" << endl
-        << "                <gammaPrior shape=\"0.05\" scale=\"10.0\" offset=\"0.0\">" << endl
-        << "                    <parameter idref=\"SYM.gt\"/>" << endl
-        << "                </gammaPrior>" << endl;
-    } else if (partitionSubstitutionModel == "GTR") {
-        BEAST_xml_code
-        << "                <gammaPrior shape=\"0.05\" scale=\"10.0\" offset=\"0.0\">" << endl
-        << "                    <parameter idref=\"GTR.ac\"/>" << endl
-        << "                </gammaPrior>" << endl
-        << "                <gammaPrior shape=\"0.05\" scale=\"10.0\" offset=\"0.0\">" << endl
-        << "                    <parameter idref=\"GTR.ag\"/>" << endl
-        << "                </gammaPrior>" << endl
-        << "                <gammaPrior shape=\"0.05\" scale=\"10.0\" offset=\"0.0\">" << endl
-        << "                    <parameter idref=\"GTR.at\"/>" << endl
-        << "                </gammaPrior>" << endl
-        << "                <gammaPrior shape=\"0.05\" scale=\"10.0\" offset=\"0.0\">" << endl
-        << "                    <parameter idref=\"GTR.cg\"/>" << endl
-        << "                </gammaPrior>" << endl
-        << "                <gammaPrior shape=\"0.05\" scale=\"10.0\" offset=\"0.0\">" << endl
-        << "                    <parameter idref=\"GTR.gt\"/>" << endl
-        << "                </gammaPrior>" << endl;
+    for (int p = 0; p < (int)partitionSubstitutionModels.size(); p++) {
+        SubstitutionModel const& subModel = *findSubstitutionModel(partitionSubstitutionModels[p]);
+        for (int i = 0; i < subModel.numParameters; i++) {
+            ModelParameter const& parameter = subModel.parameters[i];
+            if (!checkEstimatedParameter(parameter)) {
+                continue;
+            }
+            if (parameter.prior == logNormalKappaPrior) {
+                BEAST_xml_code
+                << "                <logNormalPrior mean=\"1.0\" stdev=\"1.25\" offset=\"0.0\" meanInRealSpace=\"false\">" << endl
+                << "                    <parameter idref=\"" << partitionPrefixes[p] << subModel.id << "." << parameter.name << "\"/>" << endl
+                << "                </logNormalPrior>" << endl;
+            } else if (parameter.prior == gammaRatePrior) {
+                BEAST_xml_code
+                << "                <gammaPrior shape=\"0.05\" scale=\"10.0\" offset=\"0.0\">" << endl
+                << "                    <parameter idref=\"" << partitionPrefixes[p] << subModel.id << "." << parameter.name << "\"/>" << endl
+                << "                </gammaPrior>" << endl;
+            }
+        }
     }
     
     BEAST_xml_code
     << "            </prior>" << endl;
     
     BEAST_xml_code
-    << "            <likelihood id=\"likelihood\">" << endl
-    << "                <treeLikelihood idref=\"treeLikelihood\"/>" << endl
-    << "            </likelihood>" << endl
-    << "        </posterior>" << endl
-    << "        <operators idref=\"operators\"/>" << endl;
-}
-
-// not used at the moment
-/*
-void BEASTXML::writeMCMCParameters (ofstream & BEAST_xml_code, int const& mcmcLength, string const& clockFlavour, 
-    vector <string> const& partitionSubstitutionModels, vector <string> const& rootPrior, string const& treePrior)
-{
-    BEAST_xml_code << endl
-    << "<!-- *** MCMC PARAMETERS *** -->" << endl
-    << "    <mcmc id=\"mcmc\" chainLength=\"" << mcmcLength << "\" autoOptimize=\"true\">" << endl
-    << "        <posterior id=\"posterior\">" << endl
-    << "            <prior id=\"prior\">" << endl;
-    
-    if (treePrior == "bd" || treePrior == "yule") {
+    << "            <likelihood id=\"likelihood\">" << endl;
+    for (int p = 0; p < (int)partitionPrefixes.size(); p++) {
         BEAST_xml_code
-        << "                <speciationLikelihood idref=\"speciation\"/>" << endl << endl;
-    } else if (treePrior == "concoal") {
-        BEAST_xml_code
-        << "                <oneOnXPrior>" << endl
-        << "                    <parameter idref=\"constant.popSize\"/>" << endl
-        << "                </oneOnXPrior>" << endl
-        << "                <coalescentLikelihood idref=\"coalescent\"/>" << endl << endl;
-    } else if (treePrior == "expcoal") {
-        BEAST_xml_code
-        << "                <oneOnXPrior>" << endl
-        << "                    <parameter idref=\"exponential.popSize\"/>" << endl
-        << "                </oneOnXPrior>" << endl
-        << "                <laplacePrior mean=\"0.0\" scale=\"30.701134573253945\">" << endl
-        << "                    <parameter idref=\"exponential.growthRate\"/>" << endl
-        << "                </laplacePrior>" << endl
-        << "                <coalescentLikelihood idref=\"coalescent\"/>" << endl << endl;
-    } else if (treePrior == "logcoal") {
-        BEAST_xml_code
-        << "                <oneOnXPrior>" << endl
-        << "                    <parameter idref=\"logistic.popSize\"/>" << endl
-        << "                </oneOnXPrior>" << endl
-        << "                <laplacePrior mean=\"0.0\" scale=\"23.025850929940457\">" << endl
-        << "                    <parameter idref=\"logistic.growthRate\"/>" << endl
-        << "                </laplacePrior>" << endl
-        << "                <gammaPrior shape=\"0.0010\" scale=\"1000.0\" offset=\"0.0\">" << endl
-        << "                    <parameter idref=\"logistic.t50\"/>" << endl
-        << "                </gammaPrior>" << endl
-        << "                <coalescentLikelihood idref=\"coalescent\"/>" << endl << endl;
-    }
-    
-    if (clockFlavour == "ucln") {
-        BEAST_xml_code
-        << "                <exponentialPrior mean=\"0.3333333333333333\" offset=\"0.0\">" << endl
-        << "                    <parameter idref=\"ucld.stdev\"/>" << endl
-        << "                </exponentialPrior>" << endl << endl;
+        << "                <treeLikelihood idref=\"" << partitionPrefixes[p] << "treeLikelihood\"/>" << endl;
     }
-    if (!rootPrior.empty()) {
-        if (rootPrior[0] == "unif") {
-            BEAST_xml_code
-            << "                <uniformPrior lower=\"" << rootPrior[1] << "\" upper=\"" << rootPrior[2] << "\">" << endl
-            << "                    <parameter idref=\"treeModel.rootHeight\"/>" << endl
-            << "                </uniformPrior>" << endl << endl;
-        } else if (rootPrior[0] == "norm") {
-            BEAST_xml_code
-            << "                <normalPrior mean=\"" << rootPrior[1] << "\" stdev=\"" << rootPrior[2] << "\">" << endl
-            << "                    <parameter idref=\"treeModel.rootHeight\"/>" << endl
-            << "                </normalPrior>" << endl << endl;
-        } else {
-            cout << "Shit. Fucked up somewhere..." << endl;
-            exit(1);
-        }
-    }
-    
-    int counter = 0;
-    for (vector<string>::const_iterator iter = partitionSubstitutionModels.begin(); iter != partitionSubstitutionModels.end(); iter++) {
-        if (partitionSubstitutionModels[counter] == "K80") {
-            BEAST_xml_code
-            << "                <logNormalPrior mean=\"1.0\" stdev=\"1.25\" offset=\"0.0\" meanInRealSpace=\"false\">" << endl
-            << "                    <parameter idref=\"k80.kappa\"/>" << endl
-            << "                </logNormalPrior>" << endl;
-        } else if (partitionSubstitutionModels[counter] == "HKY") {
-// Updated prior here to logNormal
-            BEAST_xml_code
-            << "                <logNormalPrior mean=\"1.0\" stdev=\"1.25\" offset=\"0.0\" meanInRealSpace=\"false\">" << endl
-            << "                    <parameter idref=\"HKY.kappa\"/>" << endl
-            << "                </logNormalPrior>" << endl;
-        } else if (partitionSubstitutionModels[counter] == "TrNef") {
-            BEAST_xml_code
-            << "                <gammaPrior shape=\"0.05\" scale=\"10.0\" offset=\"0.0\">" << endl
-            << "                    <parameter idref=\"TrNef.transversion\"/>" << endl
-            << "                </gammaPrior>" << endl
-            << "                <gammaPrior shape=\"0.05\" scale=\"10.0\" offset=\"0.0\">" << endl
-            << "                    <parameter idref=\"TrNef.ag\"/>" << endl
-            << "                </gammaPrior>" << endl;
-        } else if (partitionSubstitutionModels[counter] == "TrN") {
-            BEAST_xml_code
-            << "                <gammaPrior shape=\"0.05\" scale=\"10.0\" offset=\"0.0\">" << endl
-            << "                    <parameter idref=\"TrN.transversion\"/>" << endl
-            << "                </gammaPrior>" << endl
-            << "                <gammaPrior shape=\"0.05\" scale=\"10.0\" offset=\"0.0\">" << endl
-            << "                    <parameter idref=\"TrN.ag\"/>" << endl
-            << "                </gammaPrior>" << endl;
-        } else if (partitionSubstitutionModels[counter] == "K3P") {
-            BEAST_xml_code
-            << "                <gammaPrior shape=\"0.05\" scale=\"10.0\" offset=\"0.0\">" << endl
-            << "                    <parameter idref=\"K3P.purine2pyrimidine\"/>" << endl
-            << "                </gammaPrior>" << endl
-            << "                <gammaPrior shape=\"0.05\" scale=\"10.0\" offset=\"0.0\">" << endl
-            << "                    <parameter idref=\"K3P.pyrimidine2purine\"/>" << endl
-            << "                </gammaPrior>" << endl;
-        } else if (partitionSubstitutionModels[counter] == "K3Puf") {
-            BEAST_xml_code
-            << "                <gammaPrior shape=\"0.05\" scale=\"10.0\" offset=\"0.0\">" << endl
-            << "                    <parameter idref=\"K3Puf.purine2pyrimidine\"/>" << endl
-            << "                </gammaPrior>" << endl
-            << "                <gammaPrior shape=\"0.05\" scale=\"10.0\" offset=\"0.0\">" << endl
-            << "                    <parameter idref=\"K3Puf.pyrimidine2purine\"/>" << endl
-            << "                </gammaPrior>" << endl;
-        } else if (partitionSubstitutionModels[counter] == "TIMef") {
-            BEAST_xml_code
-            << "                <gammaPrior shape=\"0.05\" scale=\"10.0\" offset=\"0.0\">" << endl
-            << "                    <parameter idref=\"TIMef.purine2pyrimidine\"/>" << endl
-            << "                </gammaPrior>" << endl
-            << "                <gammaPrior shape=\"0.05\" scale=\"10.0\" offset=\"0.0\">" << endl
-            << "                    <parameter idref=\"TIMef.ag\"/>" << endl
-            << "                </gammaPrior>" << endl
-            << "                <gammaPrior shape=\"0.05\" scale=\"10.0\" offset=\"0.0\">" << endl
-            << "                    <parameter idref=\"TIMef.pyrimidine2purine\"/>" << endl
-            << "                </gammaPrior>" << endl;
-        } else if (partitionSubstitutionModels[counter] == "TIM") {
-            BEAST_xml_code
-            << "                <gammaPrior shape=\"0.05\" scale=\"10.0\" offset=\"0.0\">" << endl
-            << "                    <parameter idref=\"TIM.purine2pyrimidine\"/>" << endl
-            << "                </gammaPrior>" << endl
-            << "                <gammaPrior shape=\"0.05\" scale=\"10.0\" offset=\"0.0\">" << endl
-            << "                    <parameter idref=\"TIM.ag\"/>" << endl
-            << "                </gammaPrior>" << endl
-            << "                <gammaPrior shape=\"0.05\" scale=\"10.0\" offset=\"0.0\">" << endl
-            << "                    <parameter idref=\"TIM.pyrimidine2purine\"/>" << endl
-            << "                </gammaPrior>" << endl;
-        } else if (partitionSubstitutionModels[counter] == "TVMef") {
-            BEAST_xml_code
-            << "                <gammaPrior shape=\"0.05\" scale=\"10.0\" offset=\"0.0\">" << endl
-            << "                    <parameter idref=\"TVMef.ac\"/>" << endl
-            << "                </gammaPrior>" << endl
-            << "                <gammaPrior shape=\"0.05\" scale=\"10.0\" offset=\"0.0\">" << endl
-            << "                    <parameter idref=\"TVMef.at\"/>" << endl
-            << "                </gammaPrior>" << endl
-            << "                <gammaPrior shape=\"0.05\" scale=\"10.0\" offset=\"0.0\">" << endl
-            << "                    <parameter idref=\"TVMef.cg\"/>" << endl
-            << "                </gammaPrior>" << endl
-            << "                <gammaPrior shape=\"0.05\" scale=\"10.0\" offset=\"0.0\">" << endl
-            << "                    <parameter idref=\"TVMef.gt\"/>" << endl
-            << "                </gammaPrior>" << endl;
-        } else if (partitionSubstitutionModels[counter] == "TVM") {
-            BEAST_xml_code
-            << "                <gammaPrior shape=\"0.05\" scale=\"10.0\" offset=\"0.0\">" << endl
-            << "                    <parameter idref=\"TVM.ac\"/>" << endl
-            << "                </gammaPrior>" << endl
-            << "                <gammaPrior shape=\"0.05\" scale=\"10.0\" offset=\"0.0\">" << endl
-            << "                    <parameter idref=\"TVM.at\"/>" << endl
-            << "                </gammaPrior>" << endl
-            << "                <gammaPrior shape=\"0.05\" scale=\"10.0\" offset=\"0.0\">" << endl
-            << "                    <parameter idref=\"TVM.cg\"/>" << endl
-            << "                </gammaPrior>" << endl
-            << "                <gammaPrior shape=\"0.05\" scale=\"10.0\" offset=\"0.0\">" << endl
-            << "                    <parameter idref=\"TVM.gt\"/>" << endl
-            << "                </gammaPrior>" << endl;
-        } else if (partitionSubstitutionModels[counter] == "SYM") {
-            BEAST_xml_code
-            << "                <gammaPrior shape=\"0.05\" scale=\"10.0\" offset=\"0.0\">" << endl
-            << "                    <parameter idref=\"SYM.ac\"/>" << endl
-            << "                </gammaPrior>" << endl
-            << "                <gammaPrior shape=\"0.05\" scale=\"10.0\" offset=\"0.0\">" << endl
-            << "                    <parameter idref=\"SYM.ag\"/>" << endl
-            << "                </gammaPrior>" << endl
-            << "                <gammaPrior shape=\"0.05\" scale=\"10.0\" offset=\"0.0\">" << endl
-            << "                    <parameter idref=\"SYM.at\"/>" << endl
-            << "                </gammaPrior>" << endl
-            << "                <gammaPrior shape=\"0.05\" scale=\"10.0\" offset=\"0.0\">" << endl
-            << "                    <parameter idref=\"SYM.cg\"/>" << endl
-            << "                </gammaPrior>" << endl
-            << "                <gammaPrior shape=\"0.05\" scale=\"10.0\" offset=\"0.0\">" << endl
-            << "                    <parameter idref=\"SYM.gt\"/>" << endl
-            << "                </gammaPrior>" << endl;
-        } else if (partitionSubstitutionModels[counter] == "GTR") {
-            BEAST_xml_code
-            << "                <gammaPrior shape=\"0.05\" scale=\"10.0\" offset=\"0.0\">" << endl
-            << "                    <parameter idref=\"GTR.ac\"/>" << endl
-            << "                </gammaPrior>" << endl
-            << "                <gammaPrior shape=\"0.05\" scale=\"10.0\" offset=\"0.0\">" << endl
-            << "                    <parameter idref=\"GTR.ag\"/>" << endl
-            << "                </gammaPrior>" << endl
-            << "                <gammaPrior shape=\"0.05\" scale=\"10.0\" offset=\"0.0\">" << endl
-            << "                    <parameter idref=\"GTR.at\"/>" << endl
-            << "                </gammaPrior>" << endl
-            << "                <gammaPrior shape=\"0.05\" scale=\"10.0\" offset=\"0.0\">" << endl
-            << "                    <parameter idref=\"GTR.cg\"/>" << endl
-            << "                </gammaPrior>" << endl
-            << "                <gammaPrior shape=\"0.05\" scale=\"10.0\" offset=\"0.0\">" << endl
-            << "                    <parameter idref=\"GTR.gt\"/>" << endl
-            << "                </gammaPrior>" << endl;
-        }
-        counter++;
-    }
-    BEAST_xml_code
-    << "            </prior>" << endl;
-    
     BEAST_xml_code
-    << "            <likelihood id=\"likelihood\">" << endl
-    << "                <treeLikelihood idref=\"treeLikelihood\"/>" << endl
     << "            </likelihood>" << endl
     << "        </posterior>" << endl
     << "        <operators idref=\"operators\"/>" << endl;
 }
-*/
 
-void BEASTXML::writeScreenLog (ofstream & BEAST_xml_code, int const& screenSampling, string const& clockFlavour) {
-    BEAST_xml_code << endl
-    << "<!-- *** PRINT PARAMETERS TO SCREEN *** -->" << endl
-    << "        <log id=\"screenLog\" logEvery=\"" << screenSampling << "\">" << endl
-    << "            <column label=\"Posterior\" dp=\"4\" width=\"12\">" << endl
-    << "                <posterior idref=\"posterior\"/>" << endl
-    << "            </column>" << endl
-    << "            <column label=\"Prior\" dp=\"4\" width=\"12\">" << endl
-    << "                <prior idref=\"prior\"/>" << endl
-    << "            </column>" << endl
-    << "            <column label=\"Likelihood\" dp=\"4\" width=\"12\">" << endl
-    << "                <likelihood idref=\"likelihood\"/>" << endl
-    << "            </column>" << endl
-    << "            <column label=\"Root Height\" sf=\"6\" width=\"12\">" << endl
-    << "                <parameter idref=\"treeModel.rootHeight\"/>" << endl
-    << "            </column>" << endl;
+void BEASTXML::writeScreenLog (ostream & BEAST_xml_code, long long const& screenSampling, string const& clockFlavour) {
+    ScopedTimer timer("emit.screenLog");
+    ostringstream sampling;
+    sampling << screenSampling;
     
+    map <string, string> values;
+    values["screenSampling"] = sampling.str();
     if (clockFlavour == "ucln") {
-        BEAST_xml_code
-        << "            <column label=\"Rate\" sf=\"6\" width=\"12\">" << endl
-        << "                <parameter idref=\"ucld.mean\"/>" << endl
-        << "            </column>" << endl;
+        values["rateParameter"] = "ucld.mean";
     } else if (clockFlavour == "uced") {
-        BEAST_xml_code
-        << "            <column label=\"Rate\" sf=\"6\" width=\"12\">" << endl
-        << "                <parameter idref=\"uced.mean\"/>" << endl
-        << "            </column>" << endl;
-    } else if (clockFlavour == "strict" || clockFlavour == "randlocal") {
-        BEAST_xml_code
-        << "            <column label=\"Rate\" sf=\"6\" width=\"12\">" << endl
-        << "                <parameter idref=\"clock.rate\"/>" << endl
-        << "            </column>" << endl;
+        values["rateParameter"] = "uced.mean";
+    } else {
+        values["rateParameter"] = "clock.rate";
     }
-    BEAST_xml_code
-    << "        </log>" << endl << endl;
+    renderXMLTemplate(BEAST_xml_code, "screenLog", values);
 }
 
-void BEASTXML::writeParameterLog (ofstream & BEAST_xml_code, int const& parameterSampling,
-    string const& treePrior, string & clockFlavour, string const& partitionSubstitutionModel,
-    string const& partitionSiteModel)
+void BEASTXML::writeParameterLog (ostream & BEAST_xml_code, long long const& parameterSampling,
+    string const& treePrior, string & clockFlavour, vector <string> const& partitionSubstitutionModels,
+    vector <string> const& partitionSiteModels)
 {
+    ScopedTimer timer("emit.parameterLog");
     string prunedFileName = getRootName(XMLOutFileName);
     BEAST_xml_code
     << "<!-- *** PRINT PARAMETERS TO FILE *** -->" << endl
@@ -2622,84 +1549,31 @@ void BEASTXML::writeParameterLog (ofstream & BEAST_xml_code, int const& paramete
         << "            <parameter idref=\"logistic.t50\"/>" << endl << endl;
     }
     
-    if (partitionSubstitutionModel == "K80") {
-        BEAST_xml_code
-        << "            <parameter idref=\"K80.kappa\"/>" << endl
-        << "            <parameter idref=\"K80.frequencies\"/>" << endl;
-    } else if (partitionSubstitutionModel == "HKY") {
-        BEAST_xml_code
-        << "            <parameter idref=\"HKY.kappa\"/>" << endl
-        << "            <parameter idref=\"HKY.frequencies\"/>" << endl;
-    } else if (partitionSubstitutionModel == "TrNef") {
-        BEAST_xml_code
-        << "            <parameter idref=\"TrNef.transversion\"/>" << endl
-        << "            <parameter idref=\"TrNef.ag\"/>" << endl
-        << "            <parameter idref=\"TrNef.frequencies\"/>" << endl;
-    } else if (partitionSubstitutionModel == "TrN") {
-        BEAST_xml_code
-        << "            <parameter idref=\"TrN.transversion\"/>" << endl
-        << "            <parameter idref=\"TrN.ag\"/>" << endl
-        << "            <parameter idref=\"TrN.frequencies\"/>" << endl;
-    } else if (partitionSubstitutionModel == "K3P") {
-        BEAST_xml_code
-        << "            <parameter idref=\"K3P.purine2pyrimidine\"/>" << endl
-        << "            <parameter idref=\"K3P.pyrimidine2purine\"/>" << endl
-        << "            <parameter idref=\"K3P.frequencies\"/>" << endl;
-    } else if (partitionSubstitutionModel == "K3Puf") {
-        BEAST_xml_code
-        << "            <parameter idref=\"K3Puf.purine2pyrimidine\"/>" << endl
-        << "            <parameter idref=\"K3Puf.pyrimidine2purine\"/>" << endl
-        << "            <parameter idref=\"K3Puf.frequencies\"/>" << endl;
-    } else if (partitionSubstitutionModel == "TIMef") {
-        BEAST_xml_code
-        << "            <parameter idref=\"TIMef.purine2pyrimidine\"/>" << endl
-        << "            <parameter idref=\"TIMef.ag\"/>" << endl
-        << "            <parameter idref=\"TIMef.pyrimidine2purine\"/>" << endl
-        << "            <parameter idref=\"TIMef.frequencies\"/>" << endl;
-    } else if (partitionSubstitutionModel == "TIM") {
-        BEAST_xml_code
-        << "            <parameter idref=\"TIM.purine2pyrimidine\"/>" << endl
-        << "            <parameter idref=\"TIM.ag\"/>" << endl
-        << "            <parameter idref=\"TIM.pyrimidine2purine\"/>" << endl
-        << "            <parameter idref=\"TIM.frequencies\"/>" << endl;
-    } else if (partitionSubstitutionModel == "TVMef") {
-        BEAST_xml_code
-        << "            <parameter idref=\"TVMef.ac\"/>" << endl
-        << "            <parameter idref=\"TVMef.at\"/>" << endl
-        << "            <parameter idref=\"TVMef.cg\"/>" << endl
-        << "            <parameter idref=\"TVMef.gt\"/>" << endl
-        << "            <parameter idref=\"TVMef.frequencies\"/>" << endl;
-    } else if (partitionSubstitutionModel == "TVM") {
-        BEAST_xml_code
-        << "            <parameter idref=\"TVM.ac\"/>" << endl
-        << "            <parameter idref=\"TVM.at\"/>" << endl
-        << "            <parameter idref=\"TVM.cg\"/>" << endl
-        << "            <parameter idref=\"TVM.gt\"/>" << endl
-        << "            <parameter idref=\"TVM.frequencies\"/>" << endl;
-    } else if (partitionSubstitutionModel == "SYM") {
-        BEAST_xml_code
-        << "            <parameter idref=\"SYM.ac\"/>" << endl
-        << "            <parameter idref=\"SYM.ag\"/>" << endl
-        << "            <parameter idref=\"SYM.at\"/>" << endl
-        << "            <parameter idref=\"SYM.cg\"/>" << endl
-        << "            <parameter idref=\"SYM.gt\"/>" << endl
-        << "            <parameter idref=\"SYM.frequencies\"/>" << endl;
-    } else if (partitionSubstitutionModel == "GTR") {
-        BEAST_xml_code
-        << "            <parameter idref=\"GTR.ac\"/>" << endl
-        << "            <parameter idref=\"GTR.ag\"/>" << endl
-        << "            <parameter idref=\"GTR.at\"/>" << endl
-        << "            <parameter idref=\"GTR.cg\"/>" << endl
-        << "            <parameter idref=\"GTR.gt\"/>" << endl
-        << "            <parameter idref=\"GTR.frequencies\"/>" << endl;
-    }
-    if (partitionSiteModel == "IG" || partitionSiteModel == "G") {
-        BEAST_xml_code
-        << "            <parameter idref=\"alpha\"/>" << endl;
-    }
-    if (partitionSiteModel == "IG" || partitionSiteModel == "I") {
-        BEAST_xml_code
-        << "            <parameter idref=\"pInv\"/>" << endl;
+    for (int p = 0; p < (int)partitionSubstitutionModels.size(); p++) {
+        SubstitutionModel const& subModel = *findSubstitutionModel(partitionSubstitutionModels[p]);
+        string const& prefix = partitionPrefixes[p];
+        for (int i = 0; i < subModel.numParameters; i++) {
+            if (checkEstimatedParameter(subModel.parameters[i])) {
+                BEAST_xml_code
+                << "            <parameter idref=\"" << prefix << subModel.id << "." << subModel.parameters[i].name << "\"/>" << endl;
+            }
+        }
+        if (subModel.logFrequencies) {
+            BEAST_xml_code
+            << "            <parameter idref=\"" << prefix << subModel.id << ".frequencies\"/>" << endl;
+        }
+        if (partitionSiteModels[p] == "IG" || partitionSiteModels[p] == "G") {
+            BEAST_xml_code
+            << "            <parameter idref=\"" << prefix << "alpha\"/>" << endl;
+        }
+        if (partitionSiteModels[p] == "IG" || partitionSiteModels[p] == "I") {
+            BEAST_xml_code
+            << "            <parameter idref=\"" << prefix << "pInv\"/>" << endl;
+        }
+        if (partitionPrefixes.size() > 1) {
+            BEAST_xml_code
+            << "            <parameter idref=\"" << prefix << "mu\"/>" << endl;
+        }
     }
     
     if (clockFlavour == "ucln") {
@@ -2727,8 +1601,10 @@ void BEASTXML::writeParameterLog (ofstream & BEAST_xml_code, int const& paramete
         << "            <rateCovarianceStatistic idref=\"covariance\"/>" << endl << endl;
     }
     
-    BEAST_xml_code
-    << "            <treeLikelihood idref=\"treeLikelihood\"/>" << endl;
+    for (int p = 0; p < (int)partitionPrefixes.size(); p++) {
+        BEAST_xml_code
+        << "            <treeLikelihood idref=\"" << partitionPrefixes[p] << "treeLikelihood\"/>" << endl;
+    }
     
     if (treePrior == "bd" || treePrior == "yule") {
         BEAST_xml_code
@@ -2754,223 +1630,68 @@ void BEASTXML::writeParameterLog (ofstream & BEAST_xml_code, int const& paramete
     << "        </log>" << endl << endl;
 }
 
-// not used at the moment
-/*
-void BEASTXML::writeParameterLog (ofstream & BEAST_xml_code, int const& parameterSampling,
-    string const& treePrior, string & clockFlavour, vector <string> const& partitionSubstitutionModels,
-    vector <string> const& partitionSiteModels)
+void BEASTXML::writeTreeLogs (ostream & BEAST_xml_code, string const& clockFlavour,
+    bool const& logPhylograms, long long const& treeSampling)
 {
-    int counter = 0;
-    string prunedFileName = getRootName(XMLOutFileName);
-    BEAST_xml_code
-    << "<!-- *** PRINT PARAMETERS TO FILE *** -->" << endl
-    << "        <log id=\"fileLog\" logEvery=\"" << parameterSampling << "\" fileName=\"" << prunedFileName << ".log\">" << endl
-    << "            <posterior idref=\"posterior\"/>" << endl
-    << "            <prior idref=\"prior\"/>" << endl
-    << "            <likelihood idref=\"likelihood\"/>" << endl
-    << "            <parameter idref=\"treeModel.rootHeight\"/>" << endl;
-    
-    if (treePrior == "bd") {
-        BEAST_xml_code
-        << "            <parameter idref=\"birthDeath.BminusDRate\"/>" << endl
-        << "            <parameter idref=\"birthDeath.DoverB\"/>" << endl << endl;
-    } else if (treePrior == "yule") {
-        BEAST_xml_code
-        << "            <parameter idref=\"yule.birthRate\"/>" << endl << endl;
-    } else if (treePrior == "concoal") {
-        BEAST_xml_code
-        << "            <parameter idref=\"constant.popSize\"/>" << endl << endl;
-    } else if (treePrior == "expcoal") {
-        BEAST_xml_code
-        << "            <parameter idref=\"exponential.popSize\"/>" << endl
-        << "            <parameter idref=\"exponential.growthRate\"/>" << endl << endl;
-    } else if (treePrior == "logcoal") {
-        BEAST_xml_code
-        << "            <parameter idref=\"logistic.popSize\"/>" << endl
-        << "            <parameter idref=\"logistic.growthRate\"/>" << endl
-        << "            <parameter idref=\"logistic.t50\"/>" << endl << endl;
-    }
-    
-    for (vector<string>::const_iterator iter = partitionSubstitutionModels.begin(); iter != partitionSubstitutionModels.end(); iter++) {
-        if (partitionSubstitutionModels[counter] == "K80") {
-            BEAST_xml_code
-            << "            <parameter idref=\"K80.kappa\"/>" << endl
-            << "            <parameter idref=\"K80.frequencies\"/>" << endl;
-        } else if (partitionSubstitutionModels[counter] == "HKY") {
-            BEAST_xml_code
-            << "            <parameter idref=\"HKY.kappa\"/>" << endl
-            << "            <parameter idref=\"HKY.frequencies\"/>" << endl;
-        } else if (partitionSubstitutionModels[counter] == "TrNef") {
-            BEAST_xml_code
-            << "            <parameter idref=\"TrNef.transversion\"/>" << endl
-            << "            <parameter idref=\"TrNef.ag\"/>" << endl
-            << "            <parameter idref=\"TrNef.frequencies\"/>" << endl;
-        } else if (partitionSubstitutionModels[counter] == "TrN") {
-            BEAST_xml_code
-            << "            <parameter idref=\"TrN.transversion\"/>" << endl
-            << "            <parameter idref=\"TrN.ag\"/>" << endl
-            << "            <parameter idref=\"TrN.frequencies\"/>" << endl;
-        } else if (partitionSubstitutionModels[counter] == "K3P") {
-            BEAST_xml_code
-            << "            <parameter idref=\"K3P.purine2pyrimidine\"/>" << endl
-            << "            <parameter idref=\"K3P.pyrimidine2purine\"/>" << endl
-            << "            <parameter idref=\"K3P.frequencies\"/>" << endl;
-        } else if (partitionSubstitutionModels[counter] == "K3Puf") {
-            BEAST_xml_code
-            << "            <parameter idref=\"K3Puf.purine2pyrimidine\"/>" << endl
-            << "            <parameter idref=\"K3Puf.pyrimidine2purine\"/>" << endl
-            << "            <parameter idref=\"K3Puf.frequencies\"/>" << endl;
-        } else if (partitionSubstitutionModels[counter] == "TIMef") {
-            BEAST_xml_code
-            << "            <parameter idref=\"TIMef.purine2pyrimidine\"/>" << endl
-            << "            <parameter idref=\"TIMef.ag\"/>" << endl
-            << "            <parameter idref=\"TIMef.pyrimidine2purine\"/>" << endl
-            << "            <parameter idref=\"TIMef.frequencies\"/>" << endl;
-        } else if (partitionSubstitutionModels[counter] == "TIM") {
-            BEAST_xml_code
-            << "            <parameter idref=\"TIM.purine2pyrimidine\"/>" << endl
-            << "            <parameter idref=\"TIM.ag\"/>" << endl
-            << "            <parameter idref=\"TIM.pyrimidine2purine\"/>" << endl
-            << "            <parameter idref=\"TIM.frequencies\"/>" << endl;
-        } else if (partitionSubstitutionModels[counter] == "TVMef") {
-            BEAST_xml_code
-            << "            <parameter idref=\"TVMef.ac\"/>" << endl
-            << "            <parameter idref=\"TVMef.at\"/>" << endl
-            << "            <parameter idref=\"TVMef.cg\"/>" << endl
-            << "            <parameter idref=\"TVMef.gt\"/>" << endl
-            << "            <parameter idref=\"TVMef.frequencies\"/>" << endl;
-        } else if (partitionSubstitutionModels[counter] == "TVM") {
-            BEAST_xml_code
-            << "            <parameter idref=\"TVM.ac\"/>" << endl
-            << "            <parameter idref=\"TVM.at\"/>" << endl
-            << "            <parameter idref=\"TVM.cg\"/>" << endl
-            << "            <parameter idref=\"TVM.gt\"/>" << endl
-            << "            <parameter idref=\"TVM.frequencies\"/>" << endl;
-        } else if (partitionSubstitutionModels[counter] == "SYM") {
-            BEAST_xml_code
-            << "            <parameter idref=\"SYM.ac\"/>" << endl
-            << "            <parameter idref=\"SYM.ag\"/>" << endl
-            << "            <parameter idref=\"SYM.at\"/>" << endl
-            << "            <parameter idref=\"SYM.cg\"/>" << endl
-            << "            <parameter idref=\"SYM.gt\"/>" << endl
-            << "            <parameter idref=\"SYM.frequencies\"/>" << endl;
-        } else if (partitionSubstitutionModels[counter] == "GTR") {
-            BEAST_xml_code
-            << "            <parameter idref=\"GTR.ac\"/>" << endl
-            << "            <parameter idref=\"GTR.ag\"/>" << endl
-            << "            <parameter idref=\"GTR.at\"/>" << endl
-            << "            <parameter idref=\"GTR.cg\"/>" << endl
-            << "            <parameter idref=\"GTR.gt\"/>" << endl
-            << "            <parameter idref=\"GTR.frequencies\"/>" << endl;
-        }
-        if (partitionSiteModels[counter] == "IG" || partitionSiteModels[counter] == "G") {
-            BEAST_xml_code
-            << "            <parameter idref=\"alpha\"/>" << endl;
-        }
-        if (partitionSiteModels[counter] == "IG" || partitionSiteModels[counter] == "I") {
-            BEAST_xml_code
-            << "            <parameter idref=\"pInv\"/>" << endl;
+    ScopedTimer timer("emit.treeLogs");
+    ostringstream sampling;
+    sampling << treeSampling;
+    
+    map <string, string> values;
+    values["treeSampling"] = sampling.str();
+    values["fileRoot"] = getRootName(XMLOutFileName);
+    values["branchRatesElement"] = getBranchRatesElement(clockFlavour);
+    
+    renderXMLTemplate(BEAST_xml_code, "treeLog", values);
+    if (logPhylograms) {
+// relaxed-clock phylograms also carry the posterior
+        if (clockFlavour == "ucln" || clockFlavour == "uced") {
+            renderXMLTemplate(BEAST_xml_code, "phylogramLog.relaxed", values);
+        } else {
+            renderXMLTemplate(BEAST_xml_code, "phylogramLog", values);
         }
-        counter++;
-    }
-    
-    if (clockFlavour == "ucln") {
-        BEAST_xml_code << endl
-        << "            <parameter idref=\"ucld.mean\"/>" << endl
-        << "            <parameter idref=\"ucld.stdev\"/>" << endl
-        << "            <rateStatistic idref=\"meanRate\"/>" << endl
-        << "            <rateStatistic idref=\"coefficientOfVariation\"/>" << endl
-        << "            <rateCovarianceStatistic idref=\"covariance\"/>" << endl << endl;
-    } else if (clockFlavour == "uced") {
-        BEAST_xml_code << endl
-        << "            <parameter idref=\"uced.mean\"/>" << endl
-        << "            <rateStatistic idref=\"meanRate\"/>" << endl
-        << "            <rateStatistic idref=\"coefficientOfVariation\"/>" << endl
-        << "            <rateCovarianceStatistic idref=\"covariance\"/>" << endl << endl;
-    } else if (clockFlavour == "strict") {
-        BEAST_xml_code << endl
-        << "            <parameter idref=\"clock.rate\"/>" << endl << endl;
-    }
-    
-    BEAST_xml_code
-    << "            <treeLikelihood idref=\"treeLikelihood\"/>" << endl;
-    
-    if (treePrior == "bd" || treePrior == "yule") {
-        BEAST_xml_code
-        << "            <speciationLikelihood idref=\"speciation\"/>" << endl;
-    } else if (treePrior == "concoal") {
-        BEAST_xml_code
-        << "            <parameter idref=\"constant.popSize\"/>" << endl
-        << "            <coalescentLikelihood idref=\"coalescent\"/>" << endl;
-    } else if (treePrior == "expcoal") {
-        BEAST_xml_code
-        << "            <parameter idref=\"exponential.popSize\"/>" << endl
-        << "            <parameter idref=\"exponential.growthRate\"/>" << endl
-        << "            <coalescentLikelihood idref=\"coalescent\"/>" << endl;
-    } else if (treePrior == "logcoal") {
-        BEAST_xml_code
-        << "            <parameter idref=\"logistic.popSize\"/>" << endl
-        << "            <parameter idref=\"logistic.growthRate\"/>" << endl
-        << "            <parameter idref=\"logistic.t50\"/>" << endl
-        << "            <coalescentLikelihood idref=\"coalescent\"/>" << endl;
     }
-    
     BEAST_xml_code
-    << "        </log>" << endl << endl;
+    << "    </mcmc>" << endl;
 }
-*/
 
-void BEASTXML::writeTreeLogs (ofstream & BEAST_xml_code, string const& clockFlavour,
-    bool const& logPhylograms, int const& treeSampling)
+void BEASTXML::writeMarginalLikelihoodEstimator (ostream & BEAST_xml_code, int const& mleSteps,
+    long long const& mleChainLength)
 {
+    ScopedTimer timer("emit.marginalLikelihood");
+// Power posteriors run after the main chain, from the posterior (theta = 1) down to the prior,
+// each step starting from the state the previous one ended in.
     string prunedFileName = getRootName(XMLOutFileName);
-    if (clockFlavour == "ucln" || clockFlavour == "uced") {
-        BEAST_xml_code
-        << "<!-- *** TREE LOG FILES *** -->" << endl
-        << "        <logTree id=\"treeFileLog\" logEvery=\"" << treeSampling << "\" nexusFormat=\"true\" fileName=\"" << prunedFileName << ".time.trees\" sortTranslationTable=\"true\">" << endl
-        << "            <treeModel idref=\"treeModel\"/>" << endl
-        << "            <discretizedBranchRates idref=\"branchRates\"/>" << endl
-        << "            <posterior idref=\"posterior\"/>" << endl
-        << "        </logTree>" << endl;
-        if (logPhylograms) {
-            BEAST_xml_code
-            << "        <logTree id=\"substTreeFileLog\" logEvery=\"" << treeSampling << "\" nexusFormat=\"true\" fileName=\"" << prunedFileName << ".subst.trees\" branchLengths=\"substitutions\">" << endl
-            << "            <treeModel idref=\"treeModel\"/>" << endl
-            << "            <discretizedBranchRates idref=\"branchRates\"/>" << endl
-            << "            <posterior idref=\"posterior\"/>" << endl
-            << "        </logTree>" << endl;
-        }
-    } else if (clockFlavour == "strict") {
-        BEAST_xml_code
-        << "<!-- *** TREE LOG FILES *** -->" << endl
-        << "        <logTree id=\"treeFileLog\" logEvery=\"" << treeSampling << "\" nexusFormat=\"true\" fileName=\"" << prunedFileName << ".time.trees\" sortTranslationTable=\"true\">" << endl
-        << "            <treeModel idref=\"treeModel\"/>" << endl
-        << "            <strictClockBranchRates idref=\"branchRates\"/>" << endl
-        << "            <posterior idref=\"posterior\"/>" << endl
-        << "        </logTree>" << endl;
-        if (logPhylograms) {
-            BEAST_xml_code
-            << "        <logTree id=\"substTreeFileLog\" logEvery=\"" << treeSampling << "\" nexusFormat=\"true\" fileName=\"" << prunedFileName << ".subst.trees\" branchLengths=\"substitutions\">" << endl
-            << "            <treeModel idref=\"treeModel\"/>" << endl
-            << "            <strictClockBranchRates idref=\"branchRates\"/>" << endl
-            << "        </logTree>" << endl;
-        }
-    } else if (clockFlavour == "randlocal") {
-        BEAST_xml_code
-        << "<!-- *** TREE LOG FILES *** -->" << endl
-        << "        <logTree id=\"treeFileLog\" logEvery=\"" << treeSampling << "\" nexusFormat=\"true\" fileName=\"" << prunedFileName << ".time.trees\" sortTranslationTable=\"true\">" << endl
-        << "            <treeModel idref=\"treeModel\"/>" << endl
-        << "            <randomLocalClockModel idref=\"branchRates\"/>" << endl
-        << "            <posterior idref=\"posterior\"/>" << endl
-        << "        </logTree>" << endl;
-        if (logPhylograms) {
-            BEAST_xml_code
-            << "        <logTree id=\"substTreeFileLog\" logEvery=\"" << treeSampling << "\" nexusFormat=\"true\" fileName=\"" << prunedFileName << ".subst.trees\" branchLengths=\"substitutions\">" << endl
-            << "            <treeModel idref=\"treeModel\"/>" << endl
-            << "            <randomLocalClockModel idref=\"branchRates\"/>" << endl
-            << "        </logTree>" << endl;
-        }
+    long long mleSampling = parameterSampling;
+    if (mleSampling > mleChainLength / 10 && mleChainLength >= 10) {
+        mleSampling = mleChainLength / 10;
     }
-    BEAST_xml_code
-    << "    </mcmc>" << endl;
+    
+    BEAST_xml_code << endl
+    << "<!-- *** MARGINAL LIKELIHOOD ESTIMATION *** -->" << endl
+    << "    <marginalLikelihoodEstimator chainLength=\"" << mleChainLength << "\" pathSteps=\"" << mleSteps
+        << "\" pathScheme=\"betaquantile\" alpha=\"0.3\">" << endl
+    << "        <samplers>" << endl
+    << "            <mcmc idref=\"mcmc\"/>" << endl
+    << "        </samplers>" << endl
+    << "        <pathLikelihood id=\"pathLikelihood\">" << endl
+    << "            <source>" << endl
+    << "                <posterior idref=\"posterior\"/>" << endl
+    << "            </source>" << endl
+    << "            <destination>" << endl
+    << "                <prior idref=\"prior\"/>" << endl
+    << "            </destination>" << endl
+    << "        </pathLikelihood>" << endl
+    << "        <log id=\"MLE\" logEvery=\"" << mleSampling << "\" fileName=\"" << prunedFileName << ".mle.log\">" << endl
+    << "            <pathLikelihood idref=\"pathLikelihood\"/>" << endl
+    << "        </log>" << endl
+    << "    </marginalLikelihoodEstimator>" << endl << endl
+    << "    <pathSamplingAnalysis fileName=\"" << prunedFileName << ".mle.log\" resultsFileName=\"" << prunedFileName << ".ps.result.log\">" << endl
+    << "        <likelihoodColumn name=\"pathLikelihood.delta\"/>" << endl
+    << "        <thetaColumn name=\"pathLikelihood.theta\"/>" << endl
+    << "    </pathSamplingAnalysis>" << endl << endl
+    << "    <steppingStoneSamplingAnalysis fileName=\"" << prunedFileName << ".mle.log\" resultsFileName=\"" << prunedFileName << ".ss.result.log\">" << endl
+    << "        <likelihoodColumn name=\"pathLikelihood.delta\"/>" << endl
+    << "        <thetaColumn name=\"pathLikelihood.theta\"/>" << endl
+    << "    </steppingStoneSamplingAnalysis>" << endl;
 }
@@ -3,80 +3,143 @@
 
 class BEASTXML {
     
-    ofstream BEAST_xml_code;
-    string root, analyzeModel, clockFlavour, treePrior, XMLOutFileName, starterTree,
-        partitionSubstitutionModel, partitionSiteModel;
-    int numTaxa, numChar, mcmcLength, screenSampling, parameterSampling, treeSampling;
-    bool manipulateTreeTopology, overwrite, logPhylograms, starterTreePresent;
+    ostringstream BEAST_xml_code;
+    string root, alignmentFileName, analyzeModel, clockFlavour, treePrior, XMLOutFileName, starterTree,
+        partitionSubstitutionModel, partitionSiteModel, partitionScheme, outputFormat, gridLabel;
+    long long numTaxa, numChar, mcmcLength, screenSampling, parameterSampling, treeSampling, mleChainLength, targetSamples;
+    int mleSteps, maxThreads, beagleThreads;
+    double outputByteBudget;
+    bool manipulateTreeTopology, overwrite, logPhylograms, starterTreePresent, triageRuns, fileWritten,
+        estimateMarginalLikelihood, fixFrequencies, useAmbiguities, sitePatternsCounted;
+    double triageESS, burninFraction, startingRootHeight, startingClockRate;
+    SubstitutionModel const* subModel;
     vector <string> rootPrior;
+    vector <double> empiricalFrequencies;
+    vector <OperatorStatistics> tunedOperators;
+    double medianTimePerOperation;
+    vector <string> writtenFileNames;
+    vector <string> manifestEntries;
+    vector <string> planEntries;        // '-plan': one per file that would be written
+    double plannedXMLBytes, plannedOutputBytes, plannedCPUHours;
+    vector <string> nameFieldValues; // fields of the alignment file name, for the manifest
+    vector <string> outputFormats;
+    vector <Partition> partitions;
     vector <string> partitionSubstitutionModels;
     vector <string> partitionSiteModels;
-    vector < vector <string> > taxaAlignment;
+    vector <string> partitionPrefixes;
+    vector < vector <double> > partitionFrequencies;
+    vector <long long> partitionNumSites;
+    vector <long long> partitionNumPatterns;
+    vector <int> partitionInstanceCounts;
+    string beagleResource, beagleScaling;
     
 public:
     
+    string composeXMLOutFileName ();
     string setXMLOutFileName (bool const& overwrite);
     string getXMLOutFileName ();
+    bool getFileWritten ();
+    int getNumFilesWritten ();
+    
+// sampling-interval planning and job reporting
+    double estimateTreeSampleBytes ();
+    double estimateLogSampleBytes ();
+    double estimateOutputBytes ();
+    void planSamplingIntervals ();
+    string composeManifestEntry ();
+    void writeManifestEntries (ofstream & manifest);
+    
+// batch planning ('-plan'): estimates without data
+    double estimateXMLBytes ();
+    double estimateCPUHours ();
+    void planPartitions (string const& scheme);
+    string composePlanEntry ();
+    void writePlanEntries (ostream & planTable);
+    int getNumPlannedFiles ();
+    double getPlannedXMLBytes ();
+    double getPlannedOutputBytes ();
+    double getPlannedCPUHours ();
+    
+// BEAGLE settings and launch command
+    int getRateCategoryCount (string const& siteModel);
+    void setBeagleSettings ();
+    string getLaunchCommand (string const& fileName);
+    void writeLaunchCommands (ofstream & runScript);
+    void writeLaunchComment (ostream & BEAST_xml_code);
+    bool triageRun ();
+    void setStartingValues (SimData & data);
+    string getStartingClockRate (string const& clockFlavour);
+    string getFrequencyValues (SubstitutionModel const& subModel, vector <double> const& frequencies);
+    
+// operator tuning from previous runs
+    void poolOperatorAnalyses (vector <OperatorAnalysis> const& operatorAnalyses);
+    OperatorStatistics const* findOperatorStatistics (string const& operatorKeyword, string const& parameter);
+    string getOperatorWeight (string const& operatorKeyword, string const& parameter, string const& defaultWeight);
+    string getOperatorTuning (string const& operatorKeyword, string const& parameter, string const& defaultTuning);
     void setDNASubModel (string const& analyzeModel, string & partitionSubstitutionModel,
         string & partitionSiteModel);
     void setDNAModel (string const& analyzeModel, vector <string> & partitionSubstitutionModels,
         vector <string> & partitionSiteModels);
+    void setAnalysisSettings (int const& modelIndex, int const& clockIndex, int const& treePriorIndex,
+        AnalysisSettings & ASet);
+    void setPartitions (SimData & data, string const& scheme);
     
-    void writeFile ();
+    bool writeFiles (SimData & data);
+    void writeFile (SimData & data, string const& serializedAlignment);
+    string const& getSerializedAlignment (SimData & data, string const& format);
     
     // Writing functions
+    void writeSections (string const& serializedAlignment);
     void writeXMLHeader ();
     void writeXMLTail ();
-    void writeTaxonList (ofstream & BEAST_xml_code, int const& numTaxa,
+    void writeTaxonList (ostream & BEAST_xml_code, long long const& numTaxa,
         vector < vector <string> > const& taxaAlignment);
-    void writeAlignment (ofstream & BEAST_xml_code, int const& numTaxa, int const& numChar,
+    void writeAlignment (ostream & BEAST_xml_code, long long const& numTaxa, long long const& numChar,
         vector < vector <string> > const& taxaAlignment);
-    void writePartitionInformation (ofstream & BEAST_xml_code);
-    void writeTreePrior (ofstream & BEAST_xml_code, string const& treePrior,
+    void writePartitionInformation (ostream & BEAST_xml_code);
+    void writeTreePrior (ostream & BEAST_xml_code, string const& treePrior,
         bool const& starterTreePresent, string const& starterTree);
-    void writeTreeModel (ofstream & BEAST_xml_code, string const& treePrior);
-    void writeClockModel (ofstream & BEAST_xml_code, int const& numTaxa, string const& clockFlavour);
+    void writeTreeModel (ostream & BEAST_xml_code, string const& treePrior);
+    void writeClockModel (ostream & BEAST_xml_code, long long const& numTaxa, string const& clockFlavour);
     
-    void writeSubstitutionModel (ofstream & BEAST_xml_code, string const& partitionSubstitutionModel);
+    void writeSubstitutionModel (ostream & BEAST_xml_code, SubstitutionModel const& subModel,
+        string const& prefix, vector <double> const& frequencies);
+    void writeSubstitutionModels (ostream & BEAST_xml_code, vector <string> const& partitionSubstitutionModels);
     
-//    void writeSubstitutionModels (ofstream & BEAST_xml_code, vector <string> const& partitionSubstitutionModels);
+    void writeSiteModel (ostream & BEAST_xml_code, SubstitutionModel const& subModel,
+        string const& partitionSiteModel, string const& prefix);
+    void writeSiteModels (ostream & BEAST_xml_code, vector <string> const& partitionSubstitutionModels,
+        vector <string> const& partitionSiteModels);
     
-    void writeSiteModel (ofstream & BEAST_xml_code, string const& partitionSubstitutionModel,
-        string const& partitionSiteModel);
-
-//     void writeSiteModels (ofstream & BEAST_xml_code, vector <string> const& partitionSubstitutionModels,
-//         vector <string> const& partitionSiteModels);
-    
-    void writeTreeLikelihoods (ofstream & BEAST_xml_code, string const& clockFlavour);
-    
-    void writeOperators (ofstream & BEAST_xml_code, string const& treePrior, bool const& manipulateTreeTopology,
-        string const& partitionSubstitutionModel, string const& partitionSiteModel,
-        string const& clockFlavour, int const& numTaxa);
+    string getBranchRatesElement (string const& clockFlavour);
+    void writeTreeLikelihoods (ostream & BEAST_xml_code, string const& clockFlavour);
     
-//     void writeOperators (ofstream & BEAST_xml_code, string const& treePrior,
-//         bool const& manipulateTreeTopology, vector <string> const& partitionSubstitutionModels,
-//         vector <string> const& partitionSiteModels, string const& clockFlavour, int const& numTaxa);
+    void writeOperators (ostream & BEAST_xml_code, string const& treePrior,
+        bool const& manipulateTreeTopology, vector <string> const& partitionSubstitutionModels,
+        vector <string> const& partitionSiteModels, string const& clockFlavour, long long const& numTaxa);
     
-    void writeMCMCParameters (ofstream & BEAST_xml_code, int const& mcmcLength, string const& clockFlavour, 
-        string const& partitionSubstitutionModel, vector <string> const& rootPrior, string const& treePrior);
+    void writeMCMCParameters (ostream & BEAST_xml_code, long long const& mcmcLength, string const& clockFlavour, 
+        vector <string> const& partitionSubstitutionModels, vector <string> const& rootPrior, string const& treePrior);
     
-//     void writeMCMCParameters (ofstream & BEAST_xml_code, int const& mcmcLength, string const& clockFlavour, 
-//         vector <string> const& partitionSubstitutionModels, vector <string> const& rootPrior, string const& treePrior);
+    void writeScreenLog (ostream & BEAST_xml_code, long long const& screenSampling, string const& clockFlavour);
     
-    void writeScreenLog (ofstream & BEAST_xml_code, int const& screenSampling, string const& clockFlavour);
+    void writeParameterLog (ostream & BEAST_xml_code, long long const& parameterSampling,
+        string const& treePrior, string & clockFlavour, vector <string> const& partitionSubstitutionModels,
+        vector <string> const& partitionSiteModels);
     
-    void writeParameterLog (ofstream & BEAST_xml_code, int const& parameterSampling,
-        string const& treePrior, string & clockFlavour, string const& partitionSubstitutionModel,
-        string const& partitionSiteModel);
+    void writeTreeLogs (ostream & BEAST_xml_code, string const& clockFlavour,
+        bool const& logPhylograms, long long const& treeSampling);
     
-//     void writeParameterLog (ofstream & BEAST_xml_code, int const& parameterSampling,
-//         string const& treePrior, string & clockFlavour, vector <string> const& partitionSubstitutionModels,
-//         vector <string> const& partitionSiteModels);
-    
-    void writeTreeLogs (ofstream & BEAST_xml_code, string const& clockFlavour,
-        bool const& logPhylograms, int const& treeSampling);
+    void writeMarginalLikelihoodEstimator (ostream & BEAST_xml_code, int const& mleSteps,
+        long long const& mleChainLength);
 
+    // the BEAST 2 backend writes the same analysis from these settings
+    friend class BEAST2XML;
+    
     BEASTXML (SimData & data, int const& modelIndex, int const& clockIndex, int const& treePriorIndex, AnalysisSettings ASet);
+    BEASTXML (string const& fileName, string const& fileRoot, long long const& fileNumTaxa,
+        long long const& fileNumChar, int const& modelIndex, int const& clockIndex, int const& treePriorIndex,
+        AnalysisSettings & ASet);
     ~BEASTXML () {};
 };
 
@@ -0,0 +1,158 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <vector>
+#include <map>
+
+using namespace std;
+
+#include "General.h"
+#include "Log_Analysis.h"
+#include "File_Name_Pattern.h"
+#include "Analysis_Settings.h"
+#include "Settings_Grid.h"
+#include "Newick_Tree.h"
+#include "Partitions.h"
+#include "Alignment_Reader.h"
+#include "SimData.h"
+#include "Substitution_Models.h"
+#include "BEAST_XML.h"
+#include "Batch_Plan.h"
+
+extern bool DEBUG;
+
+static const size_t headerChunkSize = 1 << 16;
+static const int maxReportedFailures = 10;
+
+BatchPlan::BatchPlan (string const& planFileName)
+: numAlignments(0), numFailed(0)
+{
+    PlanTotals empty = {0, 0, 0.0, 0.0, 0.0};
+    batchTotals = empty;
+    if (!planFileName.empty()) {
+        planTable.open(planFileName.c_str());
+        if (!planTable.is_open()) {
+            throw BEASTifierError("output", "unable to write plan table '" + planFileName + "'");
+        }
+        planTable << "xml_file\talignment\tmodel\tclock\ttree_prior\tntax\tnchar\tchain_length"
+            << "\ttree_sampling\tparameter_sampling\test_xml_bytes\test_output_bytes\test_cpu_hours" << endl;
+    }
+}
+
+void BatchPlan::addTotals (PlanTotals & totals, BEASTXML & BXML) {
+    totals.numFiles += BXML.getNumPlannedFiles();
+    totals.xmlBytes += BXML.getPlannedXMLBytes();
+    totals.outputBytes += BXML.getPlannedOutputBytes();
+    totals.cpuHours += BXML.getPlannedCPUHours();
+}
+
+void BatchPlan::planAlignment (string const& fileName, map <string, string> const& fileVariables,
+    AnalysisSettings & ASet, SettingsGrid const& grid, long long const& numCombinations, long long & numSelected)
+{
+// the combinations selected exactly as in a real run; an alignment whose header cannot be read
+// (or whose name does not match) would fail there too, and is counted as such
+    numAlignments++;
+    long long combination = grid.findNextCombination(0, fileVariables, ASet, numSelected);
+    if (combination == numCombinations) {
+        return;
+    }
+    string errorMessage;
+    long long numTaxa = 0;
+    long long numChar = 0;
+    AlignmentReader reader(fileName, headerChunkSize);
+    bool readable = reader.readDimensions(numTaxa, numChar, errorMessage);
+    if (readable && fileVariables.find("root") == fileVariables.end()) {
+        readable = false;
+        errorMessage = "file name does not match the name pattern '" + ASet.getNamePattern().getPattern() + "'";
+    }
+    if (!readable) {
+        numFailed++;
+        if ((int)failures.size() < maxReportedFailures) {
+            failures.push_back(fileName + ": " + errorMessage);
+        }
+        while (combination < numCombinations) {
+            combination = grid.findNextCombination(combination + 1, fileVariables, ASet, numSelected);
+        }
+        return;
+    }
+    string::size_type slash = fileName.rfind('/');
+    string root = fileName.substr(0, slash + 1) + ASet.getOutputPattern().expand(fileVariables);
+    
+    AnalysisSettings settings = ASet;
+    long long currentSettingIndex = -1;
+    for ( ; combination < numCombinations;
+        combination = grid.findNextCombination(combination + 1, fileVariables, ASet, numSelected))
+    {
+        long long settingIndex = 0;
+        int j = 0;
+        int k = 0;
+        int l = 0;
+        grid.decodeCombination(combination, settingIndex, j, k, l);
+        if (settingIndex != currentSettingIndex) {
+            settings = ASet;
+            grid.applySettings(settingIndex, settings);
+            currentSettingIndex = settingIndex;
+        }
+        BEASTXML BXML(fileName, root, numTaxa, numChar, j, k, l, settings);
+        
+        string key = settings.getSubModel(j) + "\t" + settings.getClockFlavour(k) + "\t" + settings.getTreePrior(l)
+            + "\t" + settings.getGridLabel();
+        map <string, PlanTotals>::iterator found = combinationTotals.find(key);
+        if (found == combinationTotals.end()) {
+            PlanTotals empty = {0, 0, 0.0, 0.0, 0.0};
+            found = combinationTotals.insert(make_pair(key, empty)).first;
+            combinationOrder.push_back(key);
+        }
+        found->second.numAlignments++;
+        addTotals(found->second, BXML);
+        addTotals(batchTotals, BXML);
+        if (planTable.is_open()) {
+            BXML.writePlanEntries(planTable);
+        }
+    }
+}
+
+static string formatBytes (double bytes) {
+    char const* units[] = {"B", "kB", "MB", "GB", "TB", "PB"};
+    int unit = 0;
+    while (bytes >= 1000.0 && unit < 5) {
+        bytes /= 1000.0;
+        unit++;
+    }
+    ostringstream formatted;
+    formatted << fixed << setprecision(unit == 0 ? 0 : 1) << bytes << " " << units[unit];
+    return formatted.str();
+}
+
+void BatchPlan::report () {
+    cout << endl << "Plan for " << numAlignments << " alignments (nothing written):" << endl << endl
+        << "   " << setw(12) << left << "model" << setw(12) << "clock" << setw(12) << "tree prior"
+        << right << setw(12) << "alignments" << setw(10) << "files" << setw(12) << "xml"
+        << setw(12) << "logs+trees" << setw(14) << "CPU hours" << "   options" << endl;
+    for (int i = 0; i < (int)combinationOrder.size(); i++) {
+        PlanTotals const& totals = combinationTotals[combinationOrder[i]];
+        vector <string> names = tokenizeString(combinationOrder[i]); // model, clock, tree prior[, options]
+        string options = (names.size() > 3) ? names[3] : "";
+        cout << "   " << setw(12) << left << names[0] << setw(12) << names[1] << setw(12) << names[2] << right
+            << setw(12) << totals.numAlignments << setw(10) << totals.numFiles
+            << setw(12) << formatBytes(totals.xmlBytes) << setw(12) << formatBytes(totals.outputBytes)
+            << setw(14) << fixed << setprecision(1) << totals.cpuHours << "   " << options << endl;
+    }
+    cout << endl << "Total: " << batchTotals.numFiles << " xml files, " << formatBytes(batchTotals.xmlBytes)
+        << " of xml, " << formatBytes(batchTotals.outputBytes) << " of logs and trees, "
+        << fixed << setprecision(1) << batchTotals.cpuHours << " CPU hours." << endl;
+    if (numFailed > 0) {
+        cout << numFailed << " alignments would fail:" << endl;
+        for (int i = 0; i < (int)failures.size(); i++) {
+            cout << "   " << failures[i] << endl;
+        }
+        if (numFailed > (long long)failures.size()) {
+            cout << "   ..." << endl;
+        }
+    }
+}
+
+long long BatchPlan::getNumFailed () {
+    return numFailed;
+}
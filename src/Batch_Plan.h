@@ -0,0 +1,39 @@
+#ifndef _BATCH_PLAN_H_
+#define _BATCH_PLAN_H_
+
+// Dry run ('-plan'): what a batch would produce, without writing anything. Only the header of
+// each alignment is read (ntax and nchar; see AlignmentReader::readDimensions), and each selected
+// combination of settings is planned by BEASTXML from those alone: number of xml files, their
+// estimated size, the estimated size of the logs and trees of the runs, and the estimated CPU
+// time. Totals are reported per combination of model, clock, tree prior and grid options, and for
+// the batch; the xml files themselves can be listed in a table. Estimates use the sites in place
+// of the site patterns, so sizes and costs are upper bounds for the likelihood work.
+
+struct PlanTotals {
+    long long numAlignments, numFiles;
+    double xmlBytes, outputBytes, cpuHours;
+};
+
+class BatchPlan {
+    
+    map <string, PlanTotals> combinationTotals; // keyed by model, clock, tree prior and grid options
+    vector <string> combinationOrder;
+    PlanTotals batchTotals;
+    long long numAlignments, numFailed;
+    vector <string> failures;               // the first few, for the report
+    ofstream planTable;
+    
+    void addTotals (PlanTotals & totals, BEASTXML & BXML);
+    
+public:
+    
+    void planAlignment (string const& fileName, map <string, string> const& fileVariables, AnalysisSettings & ASet,
+        SettingsGrid const& grid, long long const& numCombinations, long long & numSelected);
+    void report ();
+    long long getNumFailed ();
+    
+    BatchPlan (string const& planFileName);
+    ~BatchPlan () {};
+};
+
+#endif /* _BATCH_PLAN_H_ */
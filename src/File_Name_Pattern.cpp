@@ -0,0 +1,126 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <map>
+
+using namespace std;
+
+#include "General.h"
+#include "File_Name_Pattern.h"
+
+extern bool DEBUG;
+
+FileNamePattern::FileNamePattern () {
+    compile("{root}");
+}
+
+FileNamePattern::FileNamePattern (string const& patternString) {
+    compile(patternString);
+}
+
+void FileNamePattern::compile (string const& patternString) {
+    pattern = patternString;
+    literals.assign(1, "");
+    fields.clear();
+    string::size_type position = 0;
+    while (position < pattern.size()) {
+        string::size_type open = pattern.find('{', position);
+        if (open == string::npos) {
+            literals.back() += pattern.substr(position);
+            break;
+        }
+        string::size_type close = pattern.find('}', open);
+        string name = (close == string::npos) ? "" : pattern.substr(open + 1, close - open - 1);
+        if (name.empty() || name.find_first_of("{/") != string::npos) {
+            throw BEASTifierError("option", "file name pattern '" + pattern + "' has an unterminated or empty {field}");
+        }
+        literals.back() += pattern.substr(position, open - position);
+        if (!fields.empty() && literals.back().empty()) {
+            throw BEASTifierError("option", "fields of file name pattern '" + pattern + "' must be separated by text");
+        }
+        fields.push_back(name);
+        literals.push_back("");
+        position = close + 1;
+    }
+    if (DEBUG) {cout << "File name pattern '" << pattern << "': " << fields.size() << " fields" << endl;}
+}
+
+string const& FileNamePattern::getPattern () const {
+    return pattern;
+}
+
+vector <string> const& FileNamePattern::getFieldNames () const {
+    return fields;
+}
+
+bool FileNamePattern::match (string const& fileName, map <string, string> & values) const {
+// fileName without its directory; fields are added to 'values'
+    string const& first = literals[0];
+    string const& last = literals.back();
+    if (fileName.compare(0, first.size(), first) != 0) {
+        return false;
+    }
+    if (fields.empty()) {
+        return fileName == first;
+    }
+    if (fileName.size() < first.size() + last.size()
+        || fileName.compare(fileName.size() - last.size(), last.size(), last) != 0)
+    {
+        return false;
+    }
+    string::size_type position = first.size();
+    string::size_type end = fileName.size() - last.size();
+    for (int i = 0; i < (int)fields.size(); i++) {
+        string::size_type fieldEnd = end;
+        if (i + 1 < (int)fields.size()) {
+            fieldEnd = fileName.find(literals[i + 1], position + 1);
+            if (fieldEnd == string::npos || fieldEnd + literals[i + 1].size() > end) {
+                return false;
+            }
+        }
+        if (fieldEnd <= position) {
+            return false;
+        }
+        values[fields[i]] = fileName.substr(position, fieldEnd - position);
+        position = fieldEnd + ((i + 1 < (int)fields.size()) ? literals[i + 1].size() : 0);
+    }
+    return true;
+}
+
+bool FileNamePattern::matchPath (string const& path, map <string, string> & values) const {
+// the file name of 'path' (its directory is dropped); also sets '{root}'
+    string name = path.substr(path.rfind('/') + 1);
+    if (!match(name, values)) {
+        return false;
+    }
+    values["root"] = name.substr(0, name.rfind('.'));
+    return true;
+}
+
+string FileNamePattern::expand (map <string, string> const& values) const {
+    string expanded = literals[0];
+    for (int i = 0; i < (int)fields.size(); i++) {
+        map <string, string>::const_iterator found = values.find(fields[i]);
+        if (found != values.end()) {
+            expanded += found->second;
+        }
+        expanded += literals[i + 1];
+    }
+    return expanded;
+}
+
+bool FileNamePattern::checkFieldsDefined (FileNamePattern const& source, string & undefinedField) const {
+// every field used here must be set by matching 'source' (or be '{root}')
+    for (int i = 0; i < (int)fields.size(); i++) {
+        bool defined = (fields[i] == "root");
+        for (int j = 0; j < (int)source.fields.size() && !defined; j++) {
+            defined = (fields[i] == source.fields[j]);
+        }
+        if (!defined) {
+            undefinedField = fields[i];
+            return false;
+        }
+    }
+    return true;
+}
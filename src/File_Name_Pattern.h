@@ -0,0 +1,33 @@
+#ifndef _FILE_NAME_PATTERN_H_
+#define _FILE_NAME_PATTERN_H_
+
+// A file name pattern such as 'b_{b}_d_{d}_a_{a}_n_{n}_sim_{model}_rep_{rep}.{ext}': literal text
+// and named {fields}. It is compiled once into alternating literals and fields; a name is then
+// matched in a single left-to-right pass, each field taking the shortest non-empty text up to the
+// literal that follows it (a field that ends the pattern takes the rest of the name, and the
+// pattern's final literal must end the name). The fields of a matched name fill in other patterns,
+// e.g. the starting tree file or the output file root. Patterns apply to the file name only; the
+// directory is kept as is. '{root}', the file name without its last extension, is always set.
+
+class FileNamePattern {
+    
+    string pattern;
+    vector <string> literals;           // literals[i] comes before fields[i]; the last ends the pattern
+    vector <string> fields;
+    
+public:
+    
+    void compile (string const& patternString);
+    string const& getPattern () const;
+    vector <string> const& getFieldNames () const;
+    bool match (string const& fileName, map <string, string> & values) const;
+    bool matchPath (string const& path, map <string, string> & values) const;
+    string expand (map <string, string> const& values) const;
+    bool checkFieldsDefined (FileNamePattern const& source, string & undefinedField) const;
+    
+    FileNamePattern ();
+    FileNamePattern (string const& patternString);
+    ~FileNamePattern () {};
+};
+
+#endif /* _FILE_NAME_PATTERN_H_ */
@@ -2,14 +2,88 @@
 #include <fstream>
 #include <sstream>
 #include <vector>
+#include <map>
 #include <math.h>
 #include <cstdlib>
+#include <climits>
 
 using namespace std;
 
 #include "General.h"
+#include "Run_Statistics.h"
 
 extern bool DEBUG;
+extern RunStatistics runStatistics;
+
+BEASTifierError::BEASTifierError (string const& errorCategory, string const& errorMessage)
+:category(errorCategory), message(errorMessage)
+{
+}
+
+BEASTifierError::BEASTifierError (string const& errorCategory, string const& errorMessage,
+    vector <string> const& errorDetails)
+:category(errorCategory), message(errorMessage), details(errorDetails)
+{
+}
+
+string const& BEASTifierError::getCategory () const {
+    return category;
+}
+
+string const& BEASTifierError::what () const {
+    return message;
+}
+
+vector <string> const& BEASTifierError::getDetails () const {
+    return details;
+}
+
+string BEASTifierError::composeMessage (string const& separator, int const& maxDetails) const {
+// message, then at most maxDetails of the details (all if maxDetails < 0), each after 'separator'
+    string composed = message + (details.empty() ? "" : ":");
+    for (int i = 0; i < (int)details.size(); i++) {
+        if (maxDetails >= 0 && i >= maxDetails) {
+            composed += separator + "... and " + convertIntToString(details.size() - maxDetails) + " more";
+            break;
+        }
+        composed += separator + details[i];
+    }
+    return composed;
+}
+
+void reportFatalError (BEASTifierError const& error) {
+// full list of details goes to the error file; the screen gets the first few
+    int maxScreenDetails = 10;
+    ofstream errorReport("Error.BEASTifier.txt");
+    errorReport << "BEASTifier failed." << endl << "Error: " << error.composeMessage("\n   ", -1) << "." << endl;
+    errorReport.close();
+    cerr << endl << "BEASTifier failed." << endl << "Error: " << error.composeMessage("\n   ", maxScreenDetails) << "."
+        << endl << "Exiting." << endl << endl;
+}
+
+void reportFileError (ofstream & errorLog, string const& errorLogFileName, string const& fileName,
+    BEASTifierError const& error)
+{
+// One tab-separated line per failed file: alignment, category, message (details joined by '; ').
+// The log is only created once a file fails.
+    int maxScreenDetails = 10;
+    cerr << "Error: " << error.composeMessage("\n   ", maxScreenDetails) << "." << endl
+        << "Skipping '" << fileName << "'." << endl;
+    if (!errorLog.is_open()) {
+        errorLog.open(errorLogFileName.c_str());
+        errorLog << "alignment\tcategory\tmessage" << endl;
+    }
+    string message = error.what();
+    for (int i = 0; i < (int)error.getDetails().size(); i++) {
+        message += (i ? "; " : ": ") + error.getDetails()[i];
+    }
+    for (string::size_type i = 0; i < message.size(); i++) {
+        if (message[i] == '\t' || message[i] == '\n' || message[i] == '\r') {
+            message[i] = ' ';
+        }
+    }
+    errorLog << fileName << "\t" << error.getCategory() << "\t" << message << endl;
+}
 
 // general processing and error-checking functions
 
@@ -21,8 +95,7 @@ bool checkValidFloat (string stringToCheck) {
     tempStream >> tempFloat;
     
     if (tempStream.fail()) {
-        cout << endl << "Invalid input! Looking for a float argument. Exiting." << endl << endl;
-        exit(1);
+        throw BEASTifierError("option", "invalid input '" + stringToCheck + "'; looking for a float argument");
     }
     return validInput;
 }
@@ -59,14 +132,9 @@ bool checkValidInputFile (string fileName) {
     ifstream tempStream;
     
     tempStream.open(fileName.c_str());
+    runStatistics.countOpen();
     if (tempStream.fail()) {
-        ofstream errorReport("Error.BEASTifier.txt");
-        errorReport << "BEASTifier  failed." << endl << "Error: unable to open file '";
-        errorReport << fileName << "'" << endl;
-        errorReport.close();
-        cerr << endl << "BEASTifier failed." << endl << "Error: unable to open file '";
-        cerr << fileName << "'. You fucked up, yo. Exiting." <<  endl << endl;
-        exit(1);
+        throw BEASTifierError("input", "unable to open file '" + fileName + "'");
     } else {
         if (DEBUG) {cout << "Successfully opened file '" << fileName << "'." <<  endl;}
         tempStream.close();
@@ -79,11 +147,13 @@ bool checkValidOutputFile (string & outputFileName, bool const& overwrite) {
     bool testOutBool = true;
     bool fileNameAcceptable = false;
     bool keepFileName = false;
+    ScopedTimer timer("filesystem");
     
 // First, check if file already exists, so overwriting can be prevented
     fstream testIn;
     while (!fileNameAcceptable) {
         testIn.open(outputFileName.c_str());
+        runStatistics.countOpen();
         if (!testIn) {
             testIn.close();
             fileNameAcceptable = true;
@@ -109,17 +179,11 @@ bool checkValidOutputFile (string & outputFileName, bool const& overwrite) {
     
     ofstream outFile;
     outFile.open(outputFileName.c_str());
+    runStatistics.countOpen();
     
     if (outFile.fail()) {
-        ofstream errorReport("Error.BEASTifier.txt");
-        errorReport << "BEASTifier analysis failed." << endl << "Error: unable to open file '";
-        errorReport << outputFileName << "'" << endl;
-        errorReport.close();
-
-        cerr << endl << "BEASTifier analysis failed." << endl << "Error: unable to open file '";
-        cerr << outputFileName << "'" <<  endl;
         testOutBool = false;
-        exit(1);
+        throw BEASTifierError("output", "unable to open file '" + outputFileName + "'");
     } else {
         outFile.close();
         outFile.clear();
@@ -187,15 +251,65 @@ bool checkCommentLineNexus (string stringToParse) {
     return commentLine;
 }
 
-int convertStringtoInt (string stringToConvert) {
-    int tempInt = 0;
-    istringstream tempStream(stringToConvert);
-    tempStream >> tempInt;
+bool parseCount (string const& stringToParse, long long & count) {
+// A whole, non-negative number within range of a long long, as plain digits ('5000000000') or in
+// exponent form ('5e9', '2.5E9'). Signs, fractions, trailing text and overflow are rejected.
+    string mantissa = stringToParse;
+    int exponent = 0;
+    string::size_type exponentPosition = stringToParse.find_first_of("eE");
+    if (exponentPosition != string::npos) {
+        mantissa = stringToParse.substr(0, exponentPosition);
+        string exponentString = stringToParse.substr(exponentPosition + 1);
+        if (exponentString.empty() || exponentString.size() > 2 || exponentString.find_first_not_of("0123456789") != string::npos) {
+            return false;
+        }
+        exponent = atoi(exponentString.c_str());
+    }
+    string digits = mantissa;
+    string::size_type pointPosition = mantissa.find('.');
+    if (pointPosition != string::npos) {
+        digits = mantissa.substr(0, pointPosition) + mantissa.substr(pointPosition + 1);
+        exponent -= mantissa.size() - pointPosition - 1;
+    }
+    if (digits.empty() || digits.find_first_not_of("0123456789") != string::npos) {
+        return false;
+    }
+    while (exponent < 0 && digits.size() > 1 && digits[digits.size() - 1] == '0') {
+        digits.erase(digits.size() - 1);
+        exponent++;
+    }
+    if (exponent < 0) {
+        return false;
+    }
     
-    return tempInt;
+    long long value = 0;
+    for (string::size_type i = 0; i < digits.size(); i++) {
+        int digit = digits[i] - '0';
+        if (value > (LLONG_MAX - digit) / 10) {
+            return false;
+        }
+        value = value * 10 + digit;
+    }
+    for (int i = 0; i < exponent && value > 0; i++) {
+        if (value > LLONG_MAX / 10) {
+            return false;
+        }
+        value *= 10;
+    }
+    count = value;
+    return true;
+}
+
+long long convertStringtoCount (string const& stringToConvert, string const& description, long long const& maximum) {
+    long long count = 0;
+    if (!parseCount(stringToConvert, count) || count > maximum) {
+        throw BEASTifierError("option", description + " '" + stringToConvert + "' is not a whole number from 0 to "
+            + convertIntToString(maximum));
+    }
+    return count;
 }
 
-string convertIntToString (int intToConvert) {
+string convertIntToString (long long intToConvert) {
     string tempString;
     stringstream tempStream;
     tempStream << intToConvert;
@@ -1,6 +1,30 @@
 #ifndef _GENERAL_H_
 #define _GENERAL_H_
 
+// Thrown for anything that stops the run, or, inside the loop over alignments, stops one file.
+// The category is a short tag for the error log ('input', 'alignment', 'tree', 'option', ...);
+// details are itemized problems (e.g. one per inconsistent taxon) that follow the message.
+class BEASTifierError {
+    
+    string category, message;
+    vector <string> details;
+    
+public:
+    
+    string const& getCategory () const;
+    string const& what () const;
+    vector <string> const& getDetails () const;
+    string composeMessage (string const& separator, int const& maxDetails) const;
+    
+    BEASTifierError (string const& errorCategory, string const& errorMessage);
+    BEASTifierError (string const& errorCategory, string const& errorMessage, vector <string> const& errorDetails);
+    ~BEASTifierError () {};
+};
+
+void reportFatalError (BEASTifierError const& error);
+void reportFileError (ofstream & errorLog, string const& errorLogFileName, string const& fileName,
+    BEASTifierError const& error);
+
 // General use functions
 bool checkValidFloat (string stringToCheck);
 bool checkValidBoolInput (string queryString);
@@ -11,8 +35,9 @@ bool checkStringValue (string stringToParse, string stringToMatch, int stringPos
 bool checkCharValue (char const& charInput, char const& charToMatch);
 bool checkWhiteSpaceOnly (string stringToParse);
 bool checkCommentLineNexus (string stringToParse);
-int convertStringtoInt (string stringToConvert);
-string convertIntToString (int intToConvert);
+bool parseCount (string const& stringToParse, long long & count);
+long long convertStringtoCount (string const& stringToConvert, string const& description, long long const& maximum);
+string convertIntToString (long long intToConvert);
 string removeStringSuffix (string stringToParse, char suffixToRemove, bool & suffixEncountered);
 string removeStringPrefix (string stringToParse, char characterToRemove);
 string getLongestName (vector<string> const& elements);
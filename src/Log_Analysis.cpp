@@ -0,0 +1,313 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <map>
+#include <math.h>
+#include <cstdlib>
+
+using namespace std;
+
+#include "General.h"
+#include "Log_Analysis.h"
+
+extern bool DEBUG;
+
+// functions for reading BEAST parameter logs (i.e. the 'fileLog' written by writeParameterLog)
+
+bool readBEASTLog (string const& fileName, vector <string> & columnLabels,
+    vector < vector <double> > & columnValues)
+{
+// Log format: '#' comment lines, then a tab-delimited header ('state posterior prior ...'),
+// then one row per sample. Returns false if the file cannot be read or has no header.
+    ifstream logInput;
+    logInput.open(fileName.c_str());
+    if (logInput.fail()) {
+        return false;
+    }
+
+    string line;
+    bool headerEncountered = false;
+
+    columnLabels.clear();
+    columnValues.clear();
+
+    while (getline(logInput, line)) {
+        if (line.empty() || line[0] == '#' || checkWhiteSpaceOnly(line)) {
+            continue;
+        }
+        vector <string> tokens = tokenizeString(line);
+        if (!headerEncountered) {
+            columnLabels = tokens;
+            columnValues.resize(columnLabels.size());
+            headerEncountered = true;
+            continue;
+        }
+// Last row may be incomplete if BEAST is still running (or was killed); ignore it
+        if (tokens.size() != columnLabels.size()) {
+            continue;
+        }
+        for (int i = 0; i < (int)tokens.size(); i++) {
+            double tempDouble = 0.0;
+            istringstream tempStream(tokens[i]);
+            tempStream >> tempDouble;
+            columnValues[i].push_back(tempDouble);
+        }
+    }
+    logInput.close();
+    return headerEncountered;
+}
+
+double calculateESS (vector <double> const& values, int const& burnin) {
+// Effective sample size, computed as in Tracer: autocovariance is summed over pairs of
+// successive lags until the pair sum becomes non-positive.
+    int maxLagLimit = 2000;
+    int numSamples = (int)values.size() - burnin;
+    if (numSamples < 2) {
+        return 0.0;
+    }
+
+    double mean = 0.0;
+    bool constantValues = true;
+    for (int i = burnin; i < (int)values.size(); i++) {
+        mean += values[i];
+        if (values[i] != values[burnin]) {
+            constantValues = false;
+        }
+    }
+    mean /= numSamples;
+
+// Constant column (e.g. a fixed parameter); ESS is meaningless, so treat as converged
+    if (constantValues) {
+        return -1.0;
+    }
+
+    int maxLag = numSamples - 1;
+    if (maxLag > maxLagLimit) {
+        maxLag = maxLagLimit;
+    }
+
+    vector <double> gammaStat(maxLag + 1, 0.0);
+    double varStat = 0.0;
+
+    for (int lag = 0; lag <= maxLag; lag++) {
+        for (int j = 0; j < numSamples - lag; j++) {
+            double del1 = values[burnin + j] - mean;
+            double del2 = values[burnin + j + lag] - mean;
+            gammaStat[lag] += del1 * del2;
+        }
+        gammaStat[lag] /= (double)(numSamples - lag);
+
+        if (lag == 0) {
+            varStat = gammaStat[0];
+        } else if (lag % 2 == 0) {
+            if (gammaStat[lag - 1] + gammaStat[lag] > 0) {
+                varStat += 2.0 * (gammaStat[lag - 1] + gammaStat[lag]);
+            } else {
+                maxLag = lag;
+            }
+        }
+    }
+
+    if (gammaStat[0] == 0.0 || varStat <= 0.0) {
+        return -1.0;
+    }
+    return numSamples * gammaStat[0] / varStat;
+}
+
+double calculateMinESS (string const& fileName, double const& burninFraction,
+    string & worstParameter, long long & lastState, int & numSamples)
+{
+// Returns the smallest ESS across all logged columns (except 'state'), or 0 if the log
+// is unreadable/empty. Also reports which column was worst, the last state logged and the
+// number of samples.
+    vector <string> columnLabels;
+    vector < vector <double> > columnValues;
+    double minESS = -1.0;
+
+    worstParameter = "";
+    lastState = 0;
+    numSamples = 0;
+
+    if (!readBEASTLog(fileName, columnLabels, columnValues) || columnValues.empty() || columnValues[0].empty()) {
+        return 0.0;
+    }
+
+    numSamples = columnValues[0].size();
+    lastState = (long long)columnValues[0][numSamples - 1];
+    int burnin = (int)(burninFraction * numSamples);
+
+    for (int i = 1; i < (int)columnLabels.size(); i++) {
+        double ess = calculateESS(columnValues[i], burnin);
+        if (ess < 0.0) {
+            continue;
+        }
+        if (DEBUG) {cout << "ESS(" << columnLabels[i] << ") = " << ess << endl;}
+        if (minESS < 0.0 || ess < minESS) {
+            minESS = ess;
+            worstParameter = columnLabels[i];
+        }
+    }
+    if (minESS < 0.0) {
+        minESS = 0.0;
+    }
+    return minESS;
+}
+
+long long readXMLChainLength (string const& xmlFileName) {
+// chain length of the main mcmc ('<mcmc ...>' or '<run ...>', the first chainLength in the file);
+// 0 if the xml cannot be read
+    ifstream xmlInput;
+    xmlInput.open(xmlFileName.c_str());
+    string line;
+    while (!xmlInput.fail() && getline(xmlInput, line)) {
+        string::size_type position = line.find("chainLength=\"");
+        if (position != string::npos) {
+            return atoll(line.c_str() + position + 13);
+        }
+    }
+    return 0;
+}
+
+bool mergeMarginalLikelihoodLogs (vector <string> const& fileNames, double & logPathSampling,
+    double & logSteppingStone, int & numPowers)
+{
+// Pool the power-posterior samples of one or more '.mle.log' files by power (theta), then compute
+// the path sampling (trapezoid rule) and stepping-stone log marginal likelihood estimates.
+    map < double, vector <double> > samplesByPower;
+    
+    for (int i = 0; i < (int)fileNames.size(); i++) {
+        vector <string> columnLabels;
+        vector < vector <double> > columnValues;
+        int thetaColumn = -1;
+        int deltaColumn = -1;
+        
+        if (!readBEASTLog(fileNames[i], columnLabels, columnValues)) {
+            cerr << "Error: unable to read marginal likelihood log '" << fileNames[i] << "'." << endl;
+            return false;
+        }
+        for (int j = 0; j < (int)columnLabels.size(); j++) {
+            if (columnLabels[j] == "pathLikelihood.theta") {
+                thetaColumn = j;
+            } else if (columnLabels[j] == "pathLikelihood.delta") {
+                deltaColumn = j;
+            }
+        }
+        if (thetaColumn < 0 || deltaColumn < 0) {
+            cerr << "Error: '" << fileNames[i] << "' has no pathLikelihood.theta/pathLikelihood.delta columns." << endl;
+            return false;
+        }
+        for (int j = 0; j < (int)columnValues[thetaColumn].size(); j++) {
+            samplesByPower[columnValues[thetaColumn][j]].push_back(columnValues[deltaColumn][j]);
+        }
+    }
+    
+    numPowers = samplesByPower.size();
+    if (numPowers < 2) {
+        cerr << "Error: need samples from at least two powers to estimate a marginal likelihood." << endl;
+        return false;
+    }
+    
+    logPathSampling = 0.0;
+    logSteppingStone = 0.0;
+    
+    map < double, vector <double> >::const_iterator previous = samplesByPower.begin();
+    map < double, vector <double> >::const_iterator current = previous;
+    double previousMean = 0.0;
+    for (int j = 0; j < (int)previous->second.size(); j++) {
+        previousMean += previous->second[j];
+    }
+    previousMean /= previous->second.size();
+    
+    for (current++; current != samplesByPower.end(); previous++, current++) {
+        double currentMean = 0.0;
+        for (int j = 0; j < (int)current->second.size(); j++) {
+            currentMean += current->second[j];
+        }
+        currentMean /= current->second.size();
+        
+        double deltaPower = current->first - previous->first;
+        logPathSampling += deltaPower * (previousMean + currentMean) / 2.0;
+        
+// stepping-stone ratio uses samples from the *lower* power; factor out the max for stability
+        double maxLogLik = previous->second[0];
+        for (int j = 1; j < (int)previous->second.size(); j++) {
+            if (previous->second[j] > maxLogLik) {
+                maxLogLik = previous->second[j];
+            }
+        }
+        double sumRatio = 0.0;
+        for (int j = 0; j < (int)previous->second.size(); j++) {
+            sumRatio += exp(deltaPower * (previous->second[j] - maxLogLik));
+        }
+        logSteppingStone += deltaPower * maxLogLik + log(sumRatio / previous->second.size());
+        
+        previousMean = currentMean;
+    }
+    return true;
+}
+
+static bool checkOperatorNumber (string const& token, double & value) {
+    char * end = 0;
+    value = strtod(token.c_str(), &end);
+    return (!token.empty() && *end == '\0');
+}
+
+bool readOperatorAnalysis (string const& fileName, OperatorAnalysis & analysis) {
+// Row format: 'name  tuning  count  time  time/op  Pr(accept)  [advice]'. The name may contain
+// spaces (e.g. 'Narrow Exchange(treeModel)') and the tuning column is '-' for untunable
+// operators, so each row is split at the first run of five numeric columns.
+    ifstream opsInput;
+    opsInput.open(fileName.c_str());
+    if (opsInput.fail()) {
+        return false;
+    }
+    
+    analysis.fileName = fileName;
+    analysis.numTaxa = 0;
+    analysis.operators.clear();
+    
+    string line;
+    while (getline(opsInput, line)) {
+        vector <string> tokens = tokenizeString(line);
+        for (int i = 1; i + 4 < (int)tokens.size(); i++) {
+            double values[5];
+            bool numeric = true;
+            for (int j = 0; j < 5 && numeric; j++) {
+                if (j == 0 && tokens[i] == "-") {
+                    values[0] = -1.0;
+                } else {
+                    numeric = checkOperatorNumber(tokens[i + j], values[j]);
+                }
+            }
+            if (!numeric) {
+                continue;
+            }
+            OperatorStatistics stats;
+            stats.name = tokens[0];
+            for (int j = 1; j < i; j++) {
+                stats.name += " " + tokens[j];
+            }
+            stats.tuning = values[0];
+            stats.count = values[1];
+            stats.timePerOperation = values[3];
+            stats.acceptance = values[4];
+            analysis.operators.push_back(stats);
+            break;
+        }
+    }
+    opsInput.close();
+    
+// size of the run comes from the numTaxa comment in the xml file that produced it
+    string xmlFileName = getRootName(fileName) + ".xml";
+    ifstream xmlInput;
+    xmlInput.open(xmlFileName.c_str());
+    while (!xmlInput.fail() && getline(xmlInput, line)) {
+        string::size_type position = line.find("<!-- numTaxa = ");
+        if (position != string::npos) {
+            analysis.numTaxa = atoll(line.c_str() + position + 15);
+            break;
+        }
+    }
+    return !analysis.operators.empty();
+}
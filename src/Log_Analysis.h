@@ -0,0 +1,30 @@
+#ifndef _LOG_ANALYSIS_H_
+#define _LOG_ANALYSIS_H_
+
+// Rows of a BEAST operator analysis table ('operatorAnalysis' file written at the end of a run)
+struct OperatorStatistics {
+    string name;              // as printed by BEAST, e.g. 'scale(ucld.mean)'
+    double tuning;            // final (auto-optimized) size/scale factor; -1 if not tunable
+    double count;
+    double timePerOperation;  // ms
+    double acceptance;
+};
+
+struct OperatorAnalysis {
+    string fileName;
+    long long numTaxa;        // from the xml file of the same run; 0 if unknown
+    vector <OperatorStatistics> operators;
+};
+
+// Functions for summarizing BEAST parameter logs from previous runs
+bool readBEASTLog (string const& fileName, vector <string> & columnLabels,
+    vector < vector <double> > & columnValues);
+double calculateESS (vector <double> const& values, int const& burnin);
+double calculateMinESS (string const& fileName, double const& burninFraction,
+    string & worstParameter, long long & lastState, int & numSamples);
+long long readXMLChainLength (string const& xmlFileName);
+bool mergeMarginalLikelihoodLogs (vector <string> const& fileNames, double & logPathSampling,
+    double & logSteppingStone, int & numPowers);
+bool readOperatorAnalysis (string const& fileName, OperatorAnalysis & analysis);
+
+#endif /* _LOG_ANALYSIS_H_ */
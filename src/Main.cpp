@@ -41,7 +41,10 @@ where:
 #include <iostream>
 #include <sstream>
 #include <vector>
+#include <map>
 #include <fstream>
+#include <new>
+#include <cstdio>
 
 #ifdef _OPENMP
     #include <omp.h>
@@ -52,10 +55,21 @@ where:
 using namespace std;
 
 #include "General.h"
+#include "Log_Analysis.h"
+#include "File_Name_Pattern.h"
 #include "Analysis_Settings.h"
+#include "Settings_Grid.h"
 #include "User_Interface.h"
+#include "Newick_Tree.h"
+#include "Partitions.h"
+#include "Alignment_Reader.h"
 #include "SimData.h"
+#include "Substitution_Models.h"
 #include "BEAST_XML.h"
+#include "Batch_Plan.h"
+#include "Run_Statistics.h"
+#include "Run_Trace.h"
+#include "XML_Templates.h"
 
 // version information
 double version = 0.41;
@@ -63,44 +77,165 @@ string month = "May";
 int year = 2013;
 
 bool DEBUG = false;
+RunStatistics runStatistics;
+RunTrace runTrace;
 
 int main (int argc, char *argv[]) {
 
     vector <string> listFileNames;
      int fileCounter = 0;
+    int skippedCounter = 0;
+    int failedCounter = 0;
     
 // default options are now in a AnalysisSettings object.
     AnalysisSettings ASet;
+    SettingsGrid grid;
+    long long numCombinations = 0;
     
     printProgramInfo();
-    processCommandLineArguments(argc, argv, listFileNames, ASet);
+// settings errors stop the run before any file is touched
+    try {
+        processCommandLineArguments(argc, argv, listFileNames, ASet, grid);
+        initializeXMLTemplates(ASet.getTemplateDirectory());
+        numCombinations = grid.countCombinations(ASet);
+    } catch (BEASTifierError const& error) {
+        reportFatalError(error);
+        return 1;
+    }
+    
+    if (grid.checkActive()) {
+        cout << "Settings grid: " << numCombinations << " combinations per alignment." << endl;
+    }
+    
+// dry run: only the alignment headers are read, and nothing is written
+    if (ASet.getPlanRun()) {
+        try {
+            BatchPlan plan(ASet.getPlanFileName());
+            long long numSelected = 0;
+            for (int i = 0; i < int(listFileNames.size()); i++) {
+                map <string, string> fileVariables;
+                ASet.getNamePattern().matchPath(listFileNames[i], fileVariables);
+                fileVariables["file"] = listFileNames[i];
+                plan.planAlignment(listFileNames[i], fileVariables, ASet, grid, numCombinations, numSelected);
+            }
+            plan.report();
+            return (plan.getNumFailed() > 0) ? 1 : 0;
+        } catch (BEASTifierError const& error) {
+            reportFatalError(error);
+            return 1;
+        }
+    }
+    
+// a file that fails is logged (alignment, category, message) and the batch carries on
+    string errorLogFileName = "Error.BEASTifier.tsv";
+    ofstream errorLog;
+    remove(errorLogFileName.c_str());
+    
+// optional jobs manifest: one line per xml file, including the sampling intervals used
+    ofstream manifest;
+    if (!ASet.getManifestFileName().empty()) {
+        manifest.open(ASet.getManifestFileName().c_str());
+        manifest << "xml_file\talignment\tmodel\tclock\ttree_prior\tntax\tnchar\tchain_length"
+            << "\ttree_sampling\tparameter_sampling\tscreen_sampling\test_output_bytes";
+        vector <string> const& nameFieldNames = ASet.getNamePattern().getFieldNames();
+        for (int i = 0; i < (int)nameFieldNames.size(); i++) {
+            manifest << "\t" << nameFieldNames[i];
+        }
+        manifest << endl;
+    }
+    
+// optional run script: the suggested BEAST launch command of every xml file
+    ofstream runScript;
+    if (!ASet.getRunScriptFileName().empty()) {
+        runScript.open(ASet.getRunScriptFileName().c_str());
+        runScript << "#!/bin/sh" << endl;
+    }
     
 //     cout << "listFileNames.size() = " << listFileNames.size() << endl;
     
+// combinations are visited in order and only those selected by the filters and shard are built;
+// numSelected counts the selected ones over the whole batch (see Settings_Grid.h)
+    long long numSelected = 0;
     for (int i = 0; i < int(listFileNames.size()); i++) { // loop over file names
-    
-// File-specific parameters are now stored in SimData object
-        SimData Data(listFileNames[i]);
+        
+        map <string, string> fileVariables;
+        ASet.getNamePattern().matchPath(listFileNames[i], fileVariables);
+        fileVariables["file"] = listFileNames[i];
+        long long combination = grid.findNextCombination(0, fileVariables, ASet, numSelected);
+        if (combination == numCombinations) {
+            continue; // nothing selected: the alignment is not read
+        }
         
          cout << endl << "Processing alignment '" << listFileNames[i] << "'..." << endl;
+        runStatistics.beginFile(listFileNames[i]);
+        runTrace.beginFile(listFileNames[i]);
         
-        for (int j = 0; j < ASet.getNumSubModels(); j++) { // loop over model flavours
-            for (int k = 0; k < ASet.getNumClockFlavours(); k++) { // loop over clock flavours
-                for (int l = 0; l < ASet.getNumTreePriors(); l++) { // loop over tree priors
-                    BEASTXML BXML(Data, j, k, l, ASet);
-            
-                    cout << "    - creating BEAST file using substitution model '" << ASet.getSubModel(j)
-                        << "', clock flavour '" << ASet.getClockFlavour(k)
-                        << "' and tree prior '" << ASet.getTreePrior(l) << "'." << endl;
+        try {
+// File-specific parameters are now stored in SimData object
+            SimData Data(listFileNames[i], ASet);
+            Data.checkUltrametricity(ASet.getUltrametricTolerance());
+            Data.setPartitions(ASet.getPartitionScheme());
             
-                    fileCounter++;
-                    if (DEBUG) {cout << "Successfully created file '" << BXML.getXMLOutFileName() << "'." << endl;}
+            AnalysisSettings settings = ASet;
+            long long currentSettingIndex = -1;
+            for ( ; combination < numCombinations;
+                combination = grid.findNextCombination(combination + 1, fileVariables, ASet, numSelected))
+            {
+                long long settingIndex = 0;
+                int j = 0; // model
+                int k = 0; // clock flavour
+                int l = 0; // tree prior
+                grid.decodeCombination(combination, settingIndex, j, k, l);
+                if (settingIndex != currentSettingIndex) {
+                    settings = ASet;
+                    grid.applySettings(settingIndex, settings);
+                    currentSettingIndex = settingIndex;
                 }
-             }
+                BEASTXML BXML(Data, j, k, l, settings);
+                
+                if (!BXML.getFileWritten()) {
+                    skippedCounter++;
+                    continue;
+                }
+                
+                cout << "    - creating BEAST file using substitution model '" << settings.getSubModel(j)
+                    << "', clock flavour '" << settings.getClockFlavour(k)
+                    << "' and tree prior '" << settings.getTreePrior(l) << "'." << endl;
+                
+                fileCounter += BXML.getNumFilesWritten();
+                if (manifest.is_open()) {
+                    BXML.writeManifestEntries(manifest);
+                }
+                if (runScript.is_open()) {
+                    BXML.writeLaunchCommands(runScript);
+                }
+                if (DEBUG) {cout << "Successfully created file '" << BXML.getXMLOutFileName() << "'." << endl;}
+            }
+        } catch (BEASTifierError const& error) {
+            failedCounter++;
+            reportFileError(errorLog, errorLogFileName, listFileNames[i], error);
+        } catch (bad_alloc const&) {
+            failedCounter++;
+            reportFileError(errorLog, errorLogFileName, listFileNames[i], BEASTifierError("memory", "out of memory (try '-stream')"));
         }
+// the rest of a failed alignment still counts towards the shards
+        while (combination < numCombinations) {
+            combination = grid.findNextCombination(combination + 1, fileVariables, ASet, numSelected);
+        }
+        runStatistics.endFile();
+        runTrace.endFile();
     }
     
     cout << endl << endl << "Successfully created " << fileCounter << " BEAST input files. Hazzah!" << endl;
+    if (skippedCounter > 0) {
+        cout << "Left " << skippedCounter << " converged or pending runs alone." << endl;
+    }
+    if (failedCounter > 0) {
+        cout << "Failed on " << failedCounter << " of " << listFileNames.size() << " alignments; see '"
+            << errorLogFileName << "'." << endl;
+    }
+    runStatistics.writeReport();
+    runTrace.writeTrace();
     cout << endl << "Fin." << endl;
-    return 0;
+    return (failedCounter > 0) ? 1 : 0;
 }
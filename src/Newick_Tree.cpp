@@ -0,0 +1,377 @@
+#include <iostream>
+#include <sstream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <cstdlib>
+
+using namespace std;
+
+#include "Newick_Tree.h"
+
+extern bool DEBUG;
+
+// single-pass newick parser and accessors for the array-based tree
+
+static bool checkNewickDelimiter (char const& c) {
+    switch (c) {
+        case '(': case ')': case ',': case ':': case ';': case '[':
+        case ' ': case '\t': case '\n': case '\r':
+            return true;
+    }
+    return false;
+}
+
+NewickTree::NewickTree ()
+: numBranchLengths(0)
+{
+}
+
+void NewickTree::clear () {
+    parent.clear();
+    firstChild.clear();
+    nextSibling.clear();
+    tipIndex.clear();
+    branchLength.clear();
+    tipNames.clear();
+    numBranchLengths = 0;
+}
+
+int NewickTree::addNode (int const& parentNode) {
+    int node = parent.size();
+    parent.push_back(parentNode);
+    firstChild.push_back(-1);
+    nextSibling.push_back(-1);
+    tipIndex.push_back(-1);
+    branchLength.push_back(0.0);
+    
+    if (parentNode >= 0) {
+// new child goes to the front of the list; lists are reversed once the parse is done
+        nextSibling[node] = firstChild[parentNode];
+        firstChild[parentNode] = node;
+    }
+    return node;
+}
+
+bool NewickTree::parseNewick (string const& newick, string & errorMessage) {
+// Reads '(A:0.1,(B:0.2,C:0.2):0.3)root;'. Labels may be quoted ('...', with '' for a quote);
+// [comments] are skipped; internal node labels are read but not kept. Whitespace outside
+// quotes is ignored. Returns false, with a message, on malformed input.
+    clear();
+    
+// an upper bound on the number of nodes, so the parse never reallocates
+    int maxNodes = 1;
+    for (string::size_type i = 0; i < newick.size(); i++) {
+        if (newick[i] == '(' || newick[i] == ',') {
+            maxNodes++;
+        }
+    }
+    parent.reserve(maxNodes);
+    firstChild.reserve(maxNodes);
+    nextSibling.reserve(maxNodes);
+    tipIndex.reserve(maxNodes);
+    branchLength.reserve(maxNodes);
+    tipNames.reserve(maxNodes / 2 + 1);
+    
+    const char * text = newick.c_str();
+    string::size_type length = newick.size();
+    string::size_type pos = 0;
+    int current = addNode(-1);
+    int depth = 0;
+    bool terminated = false;
+    bool labelRead = false;   // one label and one branch length per node
+    bool lengthRead = false;
+    bool cladeClosed = false; // ')' read for the current node, so it can have no more children
+    
+    while (pos < length && !terminated) {
+        char c = text[pos];
+        switch (c) {
+            case '(':
+                if (labelRead || lengthRead || cladeClosed) {
+                    errorMessage = "'(' after a label or branch length";
+                    return false;
+                }
+                current = addNode(current);
+                depth++;
+                labelRead = lengthRead = false;
+                pos++;
+                break;
+            case ',':
+                if (parent[current] < 0) {
+                    errorMessage = "',' outside of any parentheses";
+                    return false;
+                }
+                current = addNode(parent[current]);
+                labelRead = lengthRead = cladeClosed = false;
+                pos++;
+                break;
+            case ')':
+                if (depth == 0) {
+                    errorMessage = "unbalanced ')'";
+                    return false;
+                }
+                current = parent[current];
+                depth--;
+                labelRead = lengthRead = false;
+                cladeClosed = true;
+                pos++;
+                break;
+            case ';':
+                terminated = true;
+                pos++;
+                break;
+            case '[': {
+                string::size_type close = newick.find(']', pos);
+                if (close == string::npos) {
+                    errorMessage = "unterminated '[' comment";
+                    return false;
+                }
+                pos = close + 1;
+                break;
+            }
+            case ':': {
+                if (lengthRead) {
+                    errorMessage = "more than one branch length on a node";
+                    return false;
+                }
+                char * end = 0;
+                double value = strtod(text + pos + 1, &end);
+                if (end == text + pos + 1) {
+                    errorMessage = "missing branch length after ':'";
+                    return false;
+                }
+                branchLength[current] = value;
+                if (parent[current] >= 0) {
+                    numBranchLengths++;
+                }
+                lengthRead = true;
+                pos = end - text;
+                break;
+            }
+            case ' ': case '\t': case '\n': case '\r':
+                pos++;
+                break;
+            default: {
+                if (labelRead || lengthRead) {
+                    errorMessage = "unexpected character '" + string(1, c) + "'";
+                    return false;
+                }
+                string label;
+                if (c == '\'') {
+                    pos++;
+                    while (true) {
+                        if (pos >= length) {
+                            errorMessage = "unterminated quoted label";
+                            return false;
+                        }
+                        if (text[pos] == '\'') {
+                            if (pos + 1 < length && text[pos + 1] == '\'') {
+                                label += '\'';
+                                pos += 2;
+                                continue;
+                            }
+                            pos++;
+                            break;
+                        }
+                        label += text[pos++];
+                    }
+                } else {
+                    string::size_type start = pos;
+                    while (pos < length && !checkNewickDelimiter(text[pos])) {
+                        pos++;
+                    }
+                    label.assign(text + start, pos - start);
+                }
+// labels on internal nodes (support values, names) are not needed
+                if (firstChild[current] < 0) {
+                    tipIndex[current] = tipNames.size();
+                    tipNames.push_back(label);
+                }
+                labelRead = true;
+                break;
+            }
+        }
+    }
+    
+    if (!terminated) {
+        errorMessage = "missing terminating ';'";
+        return false;
+    }
+    if (depth != 0) {
+        errorMessage = "unbalanced '('";
+        return false;
+    }
+    for (int node = 0; node < (int)parent.size(); node++) {
+        if (firstChild[node] < 0 && tipIndex[node] < 0) {
+            errorMessage = "unnamed tip";
+            return false;
+        }
+    }
+    
+// restore the left-to-right order of each child list
+    for (int node = 0; node < (int)parent.size(); node++) {
+        int previous = -1;
+        int child = firstChild[node];
+        while (child >= 0) {
+            int next = nextSibling[child];
+            nextSibling[child] = previous;
+            previous = child;
+            child = next;
+        }
+        firstChild[node] = previous;
+    }
+    
+    if (DEBUG) {cout << "Parsed newick tree with " << tipNames.size() << " tips and "
+        << parent.size() << " nodes." << endl;}
+    return true;
+}
+
+int NewickTree::getNumNodes () const {
+    return parent.size();
+}
+
+int NewickTree::getNumTips () const {
+    return tipNames.size();
+}
+
+int NewickTree::getParent (int const& node) const {
+    return parent[node];
+}
+
+int NewickTree::getFirstChild (int const& node) const {
+    return firstChild[node];
+}
+
+int NewickTree::getNextSibling (int const& node) const {
+    return nextSibling[node];
+}
+
+bool NewickTree::isTip (int const& node) const {
+    return (firstChild[node] < 0);
+}
+
+int NewickTree::getTipIndex (int const& node) const {
+    return tipIndex[node];
+}
+
+string const& NewickTree::getTipName (int const& tip) const {
+    return tipNames[tip];
+}
+
+double NewickTree::getBranchLength (int const& node) const {
+    return branchLength[node];
+}
+
+bool NewickTree::hasBranchLengths () const {
+// every branch must have a length for node heights to mean anything
+    return (numBranchLengths > 0 && numBranchLengths == (int)parent.size() - 1);
+}
+
+void NewickTree::getRootToTipDistances (vector <double> & distances) const {
+// distances[tip] for each tip index. A forward sweep reaches every parent before its children.
+    vector <double> depth(parent.size(), 0.0);
+    distances.assign(tipNames.size(), 0.0);
+    for (int node = 1; node < (int)parent.size(); node++) {
+        depth[node] = depth[parent[node]] + branchLength[node];
+        if (tipIndex[node] >= 0) {
+            distances[tipIndex[node]] = depth[node];
+        }
+    }
+}
+
+double NewickTree::getUltrametricDeviation (double & treeHeight) const {
+// spread of root-to-tip distances (0 for a perfectly ultrametric tree); treeHeight = the longest
+    vector <double> distances;
+    getRootToTipDistances(distances);
+    if (distances.empty()) {
+        treeHeight = 0.0;
+        return 0.0;
+    }
+    double shortest = distances[0];
+    treeHeight = distances[0];
+    for (int i = 1; i < (int)distances.size(); i++) {
+        if (distances[i] < shortest) {
+            shortest = distances[i];
+        } else if (distances[i] > treeHeight) {
+            treeHeight = distances[i];
+        }
+    }
+    return treeHeight - shortest;
+}
+
+void NewickTree::makeUltrametric () {
+// extend each terminal branch so that every tip sits at the height of the deepest one
+    vector <double> distances;
+    double treeHeight = 0.0;
+    getUltrametricDeviation(treeHeight);
+    getRootToTipDistances(distances);
+    for (int node = 1; node < (int)parent.size(); node++) {
+        if (tipIndex[node] >= 0) {
+            branchLength[node] += treeHeight - distances[tipIndex[node]];
+        }
+    }
+}
+
+double NewickTree::getTreeHeight () const {
+    double treeHeight = 0.0;
+    getUltrametricDeviation(treeHeight);
+    return treeHeight;
+}
+
+void NewickTree::scaleToHeight (double const& height) {
+    double treeHeight = getTreeHeight();
+    if (treeHeight <= 0.0) {
+        return;
+    }
+    double scale = height / treeHeight;
+    for (int node = 0; node < (int)parent.size(); node++) {
+        branchLength[node] *= scale;
+    }
+}
+
+string NewickTree::writeNewick () const {
+// iterative pre-order walk; children are closed off by climbing back up the parent links
+    ostringstream newick;
+    newick << setprecision(15);
+    
+    if (parent.empty()) {
+        return ";";
+    }
+    int node = 0;
+    while (true) {
+        if (firstChild[node] >= 0) {
+            newick << "(";
+            node = firstChild[node];
+            continue;
+        }
+        string const& name = tipNames[tipIndex[node]];
+        if (name.find_first_of("(),:;[]' \t") != string::npos) {
+            newick << "'";
+            for (string::size_type i = 0; i < name.size(); i++) {
+                newick << name[i];
+                if (name[i] == '\'') {
+                    newick << "'";
+                }
+            }
+            newick << "'";
+        } else {
+            newick << name;
+        }
+        while (true) {
+            if (parent[node] < 0) {
+                newick << ";";
+                return newick.str();
+            }
+            if (numBranchLengths > 0) {
+                newick << ":" << branchLength[node];
+            }
+            if (nextSibling[node] >= 0) {
+                newick << ",";
+                node = nextSibling[node];
+                break;
+            }
+            newick << ")";
+            node = parent[node];
+        }
+    }
+}
@@ -0,0 +1,50 @@
+#ifndef _NEWICK_TREE_H_
+#define _NEWICK_TREE_H_
+
+// Array-based rooted tree parsed from a newick string. Nodes are numbered in the order they are
+// opened during the parse, so every node's parent has a smaller index than the node itself:
+// a forward sweep over the arrays visits nodes in pre-order, a backward sweep in post-order.
+// Children are kept as first-child / next-sibling links. Tip names are stored once, in
+// parse order, and tips refer to them by index.
+
+class NewickTree {
+    
+    vector <int> parent;        // -1 for the root
+    vector <int> firstChild;    // -1 for tips
+    vector <int> nextSibling;   // -1 for the last child
+    vector <int> tipIndex;      // index into tipNames; -1 for internal nodes
+    vector <double> branchLength;
+    vector <string> tipNames;
+    int numBranchLengths;       // number of nodes (excluding the root) given a ':length'
+    
+    int addNode (int const& parentNode);
+    
+public:
+    
+    bool parseNewick (string const& newick, string & errorMessage);
+    void clear ();
+    
+    int getNumNodes () const;
+    int getNumTips () const;
+    int getParent (int const& node) const;
+    int getFirstChild (int const& node) const;
+    int getNextSibling (int const& node) const;
+    bool isTip (int const& node) const;
+    int getTipIndex (int const& node) const;
+    string const& getTipName (int const& tip) const;
+    double getBranchLength (int const& node) const;
+    bool hasBranchLengths () const;
+    
+// ultrametricity
+    void getRootToTipDistances (vector <double> & distances) const;
+    double getUltrametricDeviation (double & treeHeight) const;
+    void makeUltrametric ();
+    double getTreeHeight () const;
+    void scaleToHeight (double const& height);
+    string writeNewick () const;
+    
+    NewickTree ();
+    ~NewickTree () {};
+};
+
+#endif /* _NEWICK_TREE_H_ */
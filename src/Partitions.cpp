@@ -0,0 +1,210 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <cstdlib>
+#include <cctype>
+
+using namespace std;
+
+#include "General.h"
+#include "Partitions.h"
+
+extern bool DEBUG;
+
+// functions for defining data partitions (codon positions or NEXUS charsets)
+
+bool checkPartitionScheme (string const& scheme) {
+    return (scheme == "codon" || scheme == "codon12+3" || scheme == "charsets");
+}
+
+bool makeCodonPartitions (string const& scheme, vector <Partition> & partitions) {
+// 'codon': one partition per codon position; 'codon12+3': first and second positions together
+    partitions.clear();
+    if (scheme != "codon" && scheme != "codon12+3") {
+        return false;
+    }
+    for (int position = 1; position <= 3; position++) {
+        CharacterRange range = {position, 0, 3};
+        if (scheme == "codon12+3" && position == 2) {
+            partitions.back().name = "pos12";
+            partitions.back().ranges.push_back(range);
+            continue;
+        }
+        Partition partition;
+        partition.name = "pos" + convertIntToString(position);
+        partition.ranges.push_back(range);
+        partitions.push_back(partition);
+    }
+    return true;
+}
+
+static string compactCharsetRanges (string const& text) {
+// drop whitespace next to '-' and '\' so that '1 - 300 \ 3' tokenizes as '1-300\3'
+    string compact;
+    for (string::size_type i = 0; i < text.size(); i++) {
+        if (!isspace(text[i])) {
+            compact += text[i];
+            continue;
+        }
+        string::size_type next = text.find_first_not_of(" \t\r\n", i);
+        bool beforeOperator = (next != string::npos && (text[next] == '-' || text[next] == '\\'));
+        bool afterOperator = (!compact.empty() && (compact[compact.size() - 1] == '-' || compact[compact.size() - 1] == '\\'));
+        if (!beforeOperator && !afterOperator) {
+            compact += ' ';
+        }
+    }
+    return compact;
+}
+
+static bool parseCharacterRange (string const& token, CharacterRange & range) {
+// 'a', 'a-b', 'a-.', each optionally followed by '\stride'
+    string::size_type dash = token.find('-');
+    string::size_type slash = token.find('\\');
+    string fromString = token.substr(0, (dash != string::npos) ? dash : slash);
+    string toString = fromString;
+    if (dash != string::npos) {
+        toString = token.substr(dash + 1, (slash != string::npos) ? slash - dash - 1 : string::npos);
+    }
+    string everyString = (slash != string::npos) ? token.substr(slash + 1) : "1";
+
+    if (fromString.empty() || fromString.find_first_not_of("0123456789") != string::npos
+        || everyString.empty() || everyString.find_first_not_of("0123456789") != string::npos
+        || (toString != "." && (toString.empty() || toString.find_first_not_of("0123456789") != string::npos)))
+    {
+        return false;
+    }
+    range.to = 0;
+    if (!parseCount(fromString, range.from) || !parseCount(everyString, range.every)
+        || (toString != "." && !parseCount(toString, range.to)))
+    {
+        return false;
+    }
+    return (range.from > 0 && range.every > 0 && (range.to == 0 || range.to >= range.from));
+}
+
+static bool parseCharsetStatement (string const& statement, vector <string> const& tokens,
+    vector <Partition> & partitions, string & errorMessage)
+{
+// 'charset name = ranges', without its ';'
+    string::size_type equals = statement.find('=');
+    if (equals == string::npos) {
+        errorMessage = "charset statement '" + statement + "' has no '='";
+        return false;
+    }
+    string::size_type nameStart = statement.find(tokens[0]) + tokens[0].size();
+    vector <string> nameTokens = tokenizeString(statement.substr(nameStart, equals - nameStart));
+    if (nameTokens.size() != 1) {
+        errorMessage = "charset statement '" + statement + "' needs a single name before '='";
+        return false;
+    }
+    Partition partition;
+    partition.name = nameTokens[0];
+    if (partition.name.size() > 1 && (partition.name[0] == '\'' || partition.name[0] == '"')) {
+        partition.name = partition.name.substr(1, partition.name.size() - 2);
+    }
+
+    vector <string> rangeTokens = tokenizeString(compactCharsetRanges(statement.substr(equals + 1)));
+    for (int i = 0; i < (int)rangeTokens.size(); i++) {
+        CharacterRange range;
+        if (parseCharacterRange(rangeTokens[i], range)) {
+            partition.ranges.push_back(range);
+            continue;
+        }
+        bool foundCharset = false;
+        for (int j = 0; j < (int)partitions.size() && !foundCharset; j++) {
+            if (partitions[j].name == rangeTokens[i]) {
+                partition.ranges.insert(partition.ranges.end(), partitions[j].ranges.begin(), partitions[j].ranges.end());
+                foundCharset = true;
+            }
+        }
+        if (!foundCharset) {
+            errorMessage = "charset '" + partition.name + "' has invalid range '" + rangeTokens[i] + "'";
+            return false;
+        }
+    }
+    if (partition.ranges.empty()) {
+        errorMessage = "charset '" + partition.name + "' is empty";
+        return false;
+    }
+    if (DEBUG) {cout << "Read charset '" << partition.name << "' (" << partition.ranges.size() << " ranges)" << endl;}
+    partitions.push_back(partition);
+    return true;
+}
+
+bool readCharsets (string const& fileName, vector <Partition> & partitions, string & errorMessage) {
+// Collects 'charset name = ranges;' statements from the SETS and ASSUMPTIONS blocks of a NEXUS
+// file. A charset may also list earlier charsets by name (e.g. 'charset coding = gene1 gene2;').
+// The file is scanned line by line; outside those blocks only the start of each statement is
+// kept, enough to find the next 'begin', so the matrix is never copied.
+    partitions.clear();
+    ifstream nexusInput;
+    nexusInput.open(fileName.c_str());
+    if (nexusInput.fail()) {
+        errorMessage = "unable to open '" + fileName + "'";
+        return false;
+    }
+
+// strip [comments]; statements end at ';'
+    string::size_type maxSkippedStatement = 64;
+    string statement;
+    string line;
+    int commentDepth = 0;
+    bool inSetsBlock = false;
+    while (getline(nexusInput, line)) {
+        for (string::size_type i = 0; i <= line.size(); i++) {
+            char c = (i < line.size()) ? line[i] : ' ';
+            if (c == '[') {
+                commentDepth++;
+                continue;
+            } else if (c == ']' && commentDepth > 0) {
+                commentDepth--;
+                continue;
+            } else if (commentDepth > 0) {
+                continue;
+            } else if (c != ';') {
+                if ((inSetsBlock || statement.size() < maxSkippedStatement)
+                    && !(statement.empty() && isspace((unsigned char)c)))
+                {
+                    statement += c;
+                }
+                continue;
+            }
+
+            vector <string> tokens = tokenizeString(statement);
+            string keyword = tokens.empty() ? "" : tokens[0];
+            for (string::size_type j = 0; j < keyword.size(); j++) {
+                keyword[j] = tolower(keyword[j]);
+            }
+            if (keyword == "begin" && tokens.size() > 1) {
+                string block = tokens[1];
+                for (string::size_type j = 0; j < block.size(); j++) {
+                    block[j] = tolower(block[j]);
+                }
+                inSetsBlock = (block == "sets" || block == "assumptions");
+            } else if (keyword == "end" || keyword == "endblock") {
+                inSetsBlock = false;
+            } else if (inSetsBlock && keyword == "charset"
+                && !parseCharsetStatement(statement, tokens, partitions, errorMessage))
+            {
+                return false;
+            }
+            statement.clear();
+        }
+    }
+    nexusInput.close();
+    return true;
+}
+
+vector <long long> getPartitionColumns (Partition const& partition, long long const& numChar) {
+// 0-based columns of the partition, in range order; columns beyond numChar are dropped
+    vector <long long> columns;
+    for (int i = 0; i < (int)partition.ranges.size(); i++) {
+        CharacterRange const& range = partition.ranges[i];
+        long long to = (range.to == 0 || range.to > numChar) ? numChar : range.to;
+        for (long long column = range.from; column <= to; column += range.every) {
+            columns.push_back(column - 1);
+        }
+    }
+    return columns;
+}
@@ -0,0 +1,24 @@
+#ifndef _PARTITIONS_H_
+#define _PARTITIONS_H_
+
+// Data partitions: sets of alignment columns, each analysed under its own substitution model,
+// site model and tree likelihood. Columns are given as in NEXUS 'charset' statements: 1-based,
+// inclusive ranges with an optional stride (e.g. '2-600\3'); a 'to' of 0 means the last column.
+
+struct CharacterRange {
+    long long from;
+    long long to;
+    long long every;
+};
+
+struct Partition {
+    string name;                       // used as id prefix, e.g. 'pos1' -> 'pos1.siteModel'
+    vector <CharacterRange> ranges;
+};
+
+bool checkPartitionScheme (string const& scheme);
+bool makeCodonPartitions (string const& scheme, vector <Partition> & partitions);
+bool readCharsets (string const& fileName, vector <Partition> & partitions, string & errorMessage);
+vector <long long> getPartitionColumns (Partition const& partition, long long const& numChar);
+
+#endif /* _PARTITIONS_H_ */
@@ -0,0 +1,191 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <vector>
+#include <map>
+#include <cstdio>
+#include <time.h>
+
+using namespace std;
+
+#include "General.h"
+#include "Run_Statistics.h"
+#include "Run_Trace.h"
+
+extern bool DEBUG;
+extern RunStatistics runStatistics;
+extern RunTrace runTrace;
+
+RunStatistics::RunStatistics ()
+: enabled(false), startTime(0.0), fileStartTime(0.0)
+{
+    IOStatistics empty = {0, 0, 0, 0, 0, 0};
+    batch.alignment = "";
+    batch.seconds = 0.0;
+    batch.io = empty;
+    current = &batch;
+}
+
+double RunStatistics::getTime () {
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec * 1e-9;
+}
+
+void RunStatistics::enable (string const& fileName) {
+    enabled = true;
+    reportFileName = fileName;
+    startTime = getTime();
+}
+
+bool RunStatistics::getEnabled () const {
+    return enabled;
+}
+
+void RunStatistics::beginFile (string const& alignment) {
+    if (!enabled) {
+        return;
+    }
+    FileStatistics statistics;
+    IOStatistics empty = {0, 0, 0, 0, 0, 0};
+    statistics.alignment = alignment;
+    statistics.seconds = 0.0;
+    statistics.io = empty;
+    files.push_back(statistics);
+    current = &files.back();
+    fileStartTime = getTime();
+}
+
+void RunStatistics::endFile () {
+    if (!enabled || current == &batch) {
+        return;
+    }
+    current->seconds = getTime() - fileStartTime;
+    current = &batch;
+}
+
+void RunStatistics::addStageTime (char const* stage, double const& seconds) {
+    StageStatistics & statistics = current->stages[stage];
+    statistics.seconds += seconds;
+    statistics.calls++;
+}
+
+void RunStatistics::countRead (long long const& bytes) {
+    if (enabled) {
+        current->io.bytesRead += bytes;
+        current->io.readCalls++;
+    }
+}
+
+void RunStatistics::countWrite (long long const& bytes) {
+    if (enabled) {
+        current->io.bytesWritten += bytes;
+        current->io.writeCalls++;
+    }
+}
+
+void RunStatistics::countOpen () {
+    if (enabled) {
+        current->io.openCalls++;
+    }
+}
+
+void RunStatistics::countFileWritten () {
+    if (enabled) {
+        current->io.filesWritten++;
+    }
+}
+
+string escapeJSON (string const& text) {
+    string escaped;
+    for (string::size_type i = 0; i < text.size(); i++) {
+        unsigned char character = text[i];
+        if (character == '"' || character == '\\') {
+            escaped += '\\';
+            escaped += character;
+        } else if (character < 0x20) {
+            char code[8];
+            snprintf(code, sizeof(code), "\\u%04x", character);
+            escaped += code;
+        } else {
+            escaped += character;
+        }
+    }
+    return escaped;
+}
+
+void RunStatistics::writeFileStatistics (ostream & report, FileStatistics const& statistics, string const& indent) {
+    report << indent << "\"seconds\": " << statistics.seconds << "," << endl
+        << indent << "\"bytes_read\": " << statistics.io.bytesRead << ", \"read_calls\": " << statistics.io.readCalls
+        << ", \"bytes_written\": " << statistics.io.bytesWritten << ", \"write_calls\": " << statistics.io.writeCalls
+        << ", \"open_calls\": " << statistics.io.openCalls << ", \"xml_files\": " << statistics.io.filesWritten << "," << endl
+        << indent << "\"stages\": {";
+    for (map <string, StageStatistics>::const_iterator stage = statistics.stages.begin();
+        stage != statistics.stages.end(); stage++)
+    {
+        report << ((stage == statistics.stages.begin()) ? "" : ",") << endl << indent << "    \""
+            << escapeJSON(stage->first) << "\": {\"seconds\": " << stage->second.seconds << ", \"calls\": "
+            << stage->second.calls << "}";
+    }
+    report << endl << indent << "}" << endl;
+}
+
+void RunStatistics::writeReport () {
+// the batch totals are the sums over the alignments plus the work outside them
+    if (!enabled) {
+        return;
+    }
+    endFile();
+    FileStatistics total = batch;
+    total.seconds = getTime() - startTime;
+    for (int i = 0; i < (int)files.size(); i++) {
+        for (map <string, StageStatistics>::const_iterator stage = files[i].stages.begin();
+            stage != files[i].stages.end(); stage++)
+        {
+            StageStatistics & sum = total.stages[stage->first];
+            sum.seconds += stage->second.seconds;
+            sum.calls += stage->second.calls;
+        }
+        total.io.bytesRead += files[i].io.bytesRead;
+        total.io.readCalls += files[i].io.readCalls;
+        total.io.bytesWritten += files[i].io.bytesWritten;
+        total.io.writeCalls += files[i].io.writeCalls;
+        total.io.openCalls += files[i].io.openCalls;
+        total.io.filesWritten += files[i].io.filesWritten;
+    }
+    
+    ofstream report(reportFileName.c_str());
+    if (!report.is_open()) {
+        cout << "Warning: unable to write statistics to '" << reportFileName << "'." << endl;
+        return;
+    }
+    report << setprecision(9) << "{" << endl << "  \"alignments\": " << files.size() << "," << endl
+        << "  \"total\": {" << endl;
+    writeFileStatistics(report, total, "    ");
+    report << "  }," << endl << "  \"files\": [";
+    for (int i = 0; i < (int)files.size(); i++) {
+        report << ((i == 0) ? "" : ",") << endl << "    {" << endl
+            << "      \"alignment\": \"" << escapeJSON(files[i].alignment) << "\"," << endl;
+        writeFileStatistics(report, files[i], "      ");
+        report << "    }";
+    }
+    report << endl << "  ]" << endl << "}" << endl;
+    cout << "Run statistics written to '" << reportFileName << "'." << endl;
+}
+
+ScopedTimer::ScopedTimer (char const* stageName)
+: stage(stageName), startTime(0.0)
+{
+    if (runStatistics.getEnabled()) {
+        startTime = RunStatistics::getTime();
+    }
+    runTrace.begin(stage);
+}
+
+ScopedTimer::~ScopedTimer () {
+    if (runStatistics.getEnabled() && startTime > 0.0) {
+        runStatistics.addStageTime(stage, RunStatistics::getTime() - startTime);
+    }
+    runTrace.end(stage);
+}
@@ -0,0 +1,72 @@
+#ifndef _RUN_STATISTICS_H_
+#define _RUN_STATISTICS_H_
+
+// Where the time of a batch goes ('-stats out.json'). A ScopedTimer adds the time until the end of
+// its scope to a named stage: 'parse' (SimData, with 'parse.alignment', 'parse.cache',
+// 'parse.patterns' and 'parse.tree'), 'xml' (a BEASTXML object, which holds 'triage', 'emit'
+// (composing an xml file, with one 'emit.<section>' per section), 'output' (handing the file to
+// the OS) and 'filesystem' (output file checks)), plus 'discovery' for -adir. Stages nest, so a stage's time includes that of the
+// stages within it. Counters follow the I/O: bytes and calls for reads and writes, file opens and
+// xml files written. Figures are kept per alignment and summed for the batch, and written as json
+// at the end of the run. Off by default: timers and counters then only test a flag. Timers
+// also mark the timeline of '-trace' (see Run_Trace.h).
+
+struct StageStatistics {
+    double seconds;
+    long long calls;
+};
+
+struct IOStatistics {
+    long long bytesRead, readCalls, bytesWritten, writeCalls, openCalls, filesWritten;
+};
+
+struct FileStatistics {
+    string alignment;
+    double seconds;
+    map <string, StageStatistics> stages;
+    IOStatistics io;
+};
+
+class RunStatistics {
+    
+    bool enabled;
+    string reportFileName;
+    double startTime, fileStartTime;
+    vector <FileStatistics> files;
+    FileStatistics batch;               // outside any alignment (e.g. discovery)
+    FileStatistics * current;           // the alignment being processed, or the batch
+    
+    void writeFileStatistics (ostream & report, FileStatistics const& statistics, string const& indent);
+    
+public:
+    
+    static double getTime ();
+    void enable (string const& fileName);
+    bool getEnabled () const;
+    void beginFile (string const& alignment);
+    void endFile ();
+    void addStageTime (char const* stage, double const& seconds);
+    void countRead (long long const& bytes);
+    void countWrite (long long const& bytes);
+    void countOpen ();
+    void countFileWritten ();
+    void writeReport ();
+    
+    RunStatistics ();
+    ~RunStatistics () {};
+};
+
+string escapeJSON (string const& text);
+
+class ScopedTimer {
+    
+    char const* stage;
+    double startTime;
+    
+public:
+    
+    ScopedTimer (char const* stageName);
+    ~ScopedTimer ();
+};
+
+#endif /* _RUN_STATISTICS_H_ */
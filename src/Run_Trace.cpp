@@ -0,0 +1,130 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <vector>
+#include <map>
+#include <unistd.h>
+
+#ifdef _OPENMP
+    #include <omp.h>
+#else
+    #define omp_get_thread_num() 0
+    #define omp_get_max_threads() 1
+#endif
+
+using namespace std;
+
+#include "General.h"
+#include "Run_Statistics.h"
+#include "Run_Trace.h"
+
+extern bool DEBUG;
+extern RunTrace runTrace;
+
+RunTrace::RunTrace ()
+: enabled(false), startTime(0.0)
+{
+}
+
+void RunTrace::enable (string const& fileName) {
+// the buffers are laid out here, before any parallel region, and never resized by another thread
+    enabled = true;
+    traceFileName = fileName;
+    startTime = RunStatistics::getTime();
+    int numThreads = omp_get_max_threads();
+    threadEvents.assign(numThreads, vector <TraceEvent>());
+    threadFiles.assign(numThreads, vector <string>());
+    currentFiles.assign(numThreads, -1);
+    for (int i = 0; i < numThreads; i++) {
+        threadEvents[i].reserve(1 << 12);
+    }
+}
+
+bool RunTrace::getEnabled () const {
+    return enabled;
+}
+
+void RunTrace::beginFile (string const& alignment) {
+    int thread = omp_get_thread_num();
+    if (!enabled || thread >= (int)threadEvents.size()) {
+        return;
+    }
+    threadFiles[thread].push_back(alignment);
+    currentFiles[thread] = threadFiles[thread].size() - 1;
+}
+
+void RunTrace::endFile () {
+    int thread = omp_get_thread_num();
+    if (enabled && thread < (int)threadEvents.size()) {
+        currentFiles[thread] = -1;
+    }
+}
+
+void RunTrace::addEvent (char const* name, char const& phase) {
+    int thread = omp_get_thread_num();
+    if (thread >= (int)threadEvents.size()) {
+        return; // a thread beyond those counted at the start (e.g. nested parallelism)
+    }
+    TraceEvent event = {name, phase, RunStatistics::getTime() - startTime, currentFiles[thread]};
+    threadEvents[thread].push_back(event);
+}
+
+void RunTrace::begin (char const* name) {
+    if (enabled) {
+        addEvent(name, 'B');
+    }
+}
+
+void RunTrace::end (char const* name) {
+    if (enabled) {
+        addEvent(name, 'E');
+    }
+}
+
+void RunTrace::writeTrace () {
+// timestamps are in microseconds, as the format expects
+    if (!enabled) {
+        return;
+    }
+    ofstream trace(traceFileName.c_str());
+    if (!trace.is_open()) {
+        cout << "Warning: unable to write trace to '" << traceFileName << "'." << endl;
+        return;
+    }
+    int processId = getpid();
+    long long numEvents = 0;
+    trace << fixed << setprecision(3) << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [" << endl
+        << "{\"name\": \"process_name\", \"ph\": \"M\", \"pid\": " << processId
+        << ", \"tid\": 0, \"args\": {\"name\": \"BEASTifier\"}}";
+    for (int thread = 0; thread < (int)threadEvents.size(); thread++) {
+        vector <TraceEvent> const& events = threadEvents[thread];
+        if (events.empty()) {
+            continue;
+        }
+        trace << "," << endl << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": " << processId
+            << ", \"tid\": " << thread << ", \"args\": {\"name\": \"thread " << thread << "\"}}";
+        for (int i = 0; i < (int)events.size(); i++) {
+            trace << "," << endl << "{\"name\": \"" << escapeJSON(events[i].name) << "\", \"cat\": \"BEASTifier\", \"ph\": \""
+                << events[i].phase << "\", \"ts\": " << events[i].time * 1e6 << ", \"pid\": " << processId
+                << ", \"tid\": " << thread;
+            if (events[i].phase == 'B' && events[i].fileIndex >= 0) {
+                trace << ", \"args\": {\"file\": \"" << escapeJSON(threadFiles[thread][events[i].fileIndex]) << "\"}";
+            }
+            trace << "}";
+        }
+        numEvents += events.size();
+    }
+    trace << endl << "]}" << endl;
+    cout << "Trace of " << numEvents << " events written to '" << traceFileName << "'." << endl;
+}
+
+TraceScope::TraceScope (char const* eventName)
+: name(eventName)
+{
+    runTrace.begin(name);
+}
+
+TraceScope::~TraceScope () {
+    runTrace.end(name);
+}
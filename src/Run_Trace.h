@@ -0,0 +1,53 @@
+#ifndef _RUN_TRACE_H_
+#define _RUN_TRACE_H_
+
+// Timeline of a batch ('-trace out.json') in the Chrome trace-event format, for chrome://tracing
+// or Perfetto. Every stage timed by a ScopedTimer (see Run_Statistics.h) becomes a begin/end pair
+// of events: 'parse' is the loading of a SimData object, 'xml' the construction of a BEASTXML
+// object, 'output' the writing of one file, and so on. Events are tagged with the thread and with
+// the alignment being processed. Each thread appends to its own buffer, so recording takes no
+// lock; the buffers are only read when the trace is written at the end of the run.
+
+struct TraceEvent {
+    char const* name;
+    char phase;                         // 'B' or 'E'
+    double time;                        // seconds since tracing began
+    int fileIndex;                      // into the thread's files, or -1
+};
+
+class RunTrace {
+    
+    bool enabled;
+    string traceFileName;
+    double startTime;
+    vector < vector <TraceEvent> > threadEvents;    // one buffer per thread
+    vector < vector <string> > threadFiles;         // the alignments each thread has worked on
+    vector <int> currentFiles;
+    
+    void addEvent (char const* name, char const& phase);
+    
+public:
+    
+    void enable (string const& fileName);
+    bool getEnabled () const;
+    void beginFile (string const& alignment);
+    void endFile ();
+    void begin (char const* name);
+    void end (char const* name);
+    void writeTrace ();
+    
+    RunTrace ();
+    ~RunTrace () {};
+};
+
+class TraceScope {
+    
+    char const* name;
+    
+public:
+    
+    TraceScope (char const* eventName);
+    ~TraceScope ();
+};
+
+#endif /* _RUN_TRACE_H_ */
@@ -0,0 +1,407 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <map>
+#include <cstdlib>
+#include <climits>
+#include <algorithm>
+
+using namespace std;
+
+#include "General.h"
+#include "Log_Analysis.h"
+#include "File_Name_Pattern.h"
+#include "Analysis_Settings.h"
+#include "Settings_Grid.h"
+
+extern bool DEBUG;
+
+SettingsGrid::SettingsGrid ()
+:
+    shardIndex(0), numShards(1), numSettings(1), numCombinations(0), numModels(0), numClocks(0),
+    numTreePriors(0)
+{}
+
+static bool checkFilterComparison (string const& token) {
+    return token == "==" || token == "!=" || token == "<" || token == "<=" || token == ">" || token == ">=";
+}
+
+static bool checkFilterOperator (string const& token) {
+    return checkFilterComparison(token) || token == "(" || token == ")" || token == "!" || token == "&&"
+        || token == "||";
+}
+
+static bool parseFilterNumber (string const& value, double & number) {
+    if (value.empty()) {
+        return false;
+    }
+    char * end = NULL;
+    number = strtod(value.c_str(), &end);
+    return *end == '\0';
+}
+
+static vector <string> tokenizeFilter (string const& expression) {
+// operators, names and values; a quoted value keeps its opening quote so that it is never
+// taken for an operator (e.g. clock=="||")
+    vector <string> tokens;
+    string::size_type position = 0;
+    while (position < expression.size()) {
+        char current = expression[position];
+        if (current == ' ' || current == '\t' || current == '\r') {
+            position++;
+        } else if (current == '"' || current == '\'') {
+            string::size_type close = expression.find(current, position + 1);
+            if (close == string::npos) {
+                throw BEASTifierError("option", "unterminated quote in filter '" + expression + "'");
+            }
+            tokens.push_back(expression.substr(position, close - position));
+            position = close + 1;
+        } else if (string("()!=<>&|").find(current) != string::npos) {
+            string twoCharacters = expression.substr(position, 2);
+            if (checkFilterOperator(twoCharacters)) {
+                tokens.push_back(twoCharacters);
+                position += 2;
+            } else if (current != '=' && current != '&' && current != '|') {
+                tokens.push_back(string(1, current));
+                position++;
+            } else {
+                throw BEASTifierError("option", "unknown operator '" + twoCharacters + "' in filter '"
+                    + expression + "' (use ==, &&, ||)");
+            }
+        } else {
+            string::size_type end = expression.find_first_of(" \t\r()!=<>&|\"'", position);
+            if (end == string::npos) {
+                end = expression.size();
+            }
+            tokens.push_back(expression.substr(position, end - position));
+            position = end;
+        }
+    }
+    return tokens;
+}
+
+void SettingsGrid::compileFilter (vector <string> const& tokens, int & position, vector <FilterStep> & steps,
+    int level)
+{
+// recursive descent into reverse Polish; level 0 is '||', level 1 '&&', level 2 a negation, a
+// parenthesized expression or a comparison
+    if (level < 2) {
+        string logicalOperator = (level == 0) ? "||" : "&&";
+        compileFilter(tokens, position, steps, level + 1);
+        while (position < (int)tokens.size() && tokens[position] == logicalOperator) {
+            position++;
+            compileFilter(tokens, position, steps, level + 1);
+            FilterStep step;
+            step.type = (level == 0) ? filterOr : filterAnd;
+            steps.push_back(step);
+        }
+        return;
+    }
+    if (position >= (int)tokens.size()) {
+        throw BEASTifierError("option", "filter ends where a comparison was expected");
+    }
+    if (tokens[position] == "!") {
+        position++;
+        compileFilter(tokens, position, steps, 2);
+        FilterStep step;
+        step.type = filterNot;
+        steps.push_back(step);
+    } else if (tokens[position] == "(") {
+        position++;
+        compileFilter(tokens, position, steps, 0);
+        if (position >= (int)tokens.size() || tokens[position] != ")") {
+            throw BEASTifierError("option", "filter is missing a ')'");
+        }
+        position++;
+    } else {
+        if (position + 2 >= (int)tokens.size()) {
+            throw BEASTifierError("option", "incomplete comparison in filter, starting at '" + tokens[position] + "'");
+        }
+        FilterStep step;
+        step.type = filterComparison;
+        step.variable = tokens[position];
+        step.comparison = tokens[position + 1];
+        step.value = tokens[position + 2];
+        if (checkFilterOperator(step.variable) || step.variable[0] == '"' || step.variable[0] == '\'') {
+            throw BEASTifierError("option", "expected a variable name in filter, found '" + step.variable + "'");
+        }
+        if (!checkFilterComparison(step.comparison)) {
+            throw BEASTifierError("option", "expected ==, !=, <, <=, > or >= after '" + step.variable
+                + "' in filter, found '" + step.comparison + "'");
+        }
+        if (checkFilterOperator(step.value)) {
+            throw BEASTifierError("option", "expected a value after '" + step.variable + step.comparison
+                + "' in filter, found '" + step.value + "'");
+        }
+        if (step.value[0] == '"' || step.value[0] == '\'') {
+            step.value.erase(0, 1);
+        }
+        steps.push_back(step);
+        position += 3;
+    }
+}
+
+void SettingsGrid::addFilter (string const& expression) {
+    vector <string> tokens = tokenizeFilter(expression);
+    if (tokens.empty()) {
+        throw BEASTifierError("option", "-filter expects an expression, e.g. '-filter clock!=randlocal || n<=100'");
+    }
+    vector <FilterStep> steps;
+    int position = 0;
+    compileFilter(tokens, position, steps, 0);
+    if (position < (int)tokens.size()) {
+        throw BEASTifierError("option", "unexpected '" + tokens[position] + "' in filter '" + expression + "'");
+    }
+// several filters must all hold
+    bool combine = !filter.empty();
+    filter.insert(filter.end(), steps.begin(), steps.end());
+    if (combine) {
+        FilterStep step;
+        step.type = filterAnd;
+        filter.push_back(step);
+    }
+    if (DEBUG) {cout << "Filter '" << expression << "': " << steps.size() << " steps" << endl;}
+}
+
+bool SettingsGrid::evaluateFilter (map <string, string> const& variables) const {
+    vector <bool> stack;
+    for (int i = 0; i < (int)filter.size(); i++) {
+        FilterStep const& step = filter[i];
+        if (step.type == filterNot) {
+            stack.back() = !stack.back();
+            continue;
+        }
+        if (step.type != filterComparison) {
+            bool second = stack.back();
+            stack.pop_back();
+            stack.back() = (step.type == filterAnd) ? (stack.back() && second) : (stack.back() || second);
+            continue;
+        }
+        map <string, string>::const_iterator found = variables.find(step.variable);
+        string value = (found == variables.end()) ? "" : found->second;
+        double first = 0.0;
+        double second = 0.0;
+        int order = 0;
+        if (parseFilterNumber(value, first) && parseFilterNumber(step.value, second)) {
+            order = (first < second) ? -1 : ((first > second) ? 1 : 0);
+        } else {
+            order = value.compare(step.value);
+        }
+        bool result = false;
+        if (step.comparison == "==") {
+            result = (order == 0);
+        } else if (step.comparison == "!=") {
+            result = (order != 0);
+        } else if (step.comparison == "<") {
+            result = (order < 0);
+        } else if (step.comparison == "<=") {
+            result = (order <= 0);
+        } else if (step.comparison == ">") {
+            result = (order > 0);
+        } else {
+            result = (order >= 0);
+        }
+        stack.push_back(result);
+    }
+    return stack.empty() || stack.back();
+}
+
+void SettingsGrid::addDimension (vector <string> const& tokens, AnalysisSettings const& ASet) {
+// '-option a b | c | d' -> alternatives '-option a b', '-option c' and '-option d'
+    string const& option = tokens[0];
+    char const* fixedOptions[] = {"-alist", "-adir", "-aglob", "-aregex", "-filter", "-shard", "-manifest",
+        "-runscript", "-templates", "-namepattern", "-treepattern", "-outpattern", "-cache", "-stream",
+        "-partition", "-ultrametric", "-plan", "-mods", "-clock", "-tprior"};
+    for (int i = 0; i < (int)(sizeof(fixedOptions) / sizeof(fixedOptions[0])); i++) {
+        if (option == fixedOptions[i]) {
+            string reason = (option == "-mods" || option == "-clock" || option == "-tprior")
+                ? "; it already loops over its values, so list them without '|'"
+                : "; it applies to the whole batch or to reading the alignments";
+            throw BEASTifierError("option", "'" + option + "' cannot take alternatives" + reason);
+        }
+    }
+    for (int i = 0; i < (int)optionNames.size(); i++) {
+        if ("-" + optionNames[i] == option) {
+            throw BEASTifierError("option", "alternatives for '" + option + "' are given more than once");
+        }
+    }
+    vector < vector <string> > optionAlternatives(1, vector <string>(1, option));
+    for (int i = 1; i < (int)tokens.size(); i++) {
+        if (tokens[i] == "|") {
+            optionAlternatives.push_back(vector <string>(1, option));
+        } else {
+            optionAlternatives.back().push_back(tokens[i]);
+        }
+    }
+    for (int i = 0; i < (int)optionAlternatives.size(); i++) {
+        if (optionAlternatives[i].size() < 2) {
+            throw BEASTifierError("option", "empty alternative for '" + option + "' (flags take 'on' or 'off')");
+        }
+// each alternative must be a valid setting on its own
+        AnalysisSettings scratch = ASet;
+        if (!scratch.applyOption(optionAlternatives[i])) {
+            throw BEASTifierError("option", "unknown configuration file argument '" + option + "'");
+        }
+    }
+    optionNames.push_back(option.substr(1));
+    alternatives.push_back(optionAlternatives);
+    if (DEBUG) {cout << "Settings grid: " << optionAlternatives.size() << " alternatives for '" << option << "'" << endl;}
+}
+
+void SettingsGrid::setShard (string const& val) {
+// 'i/n': the i-th of n shards, counting from 1
+    string::size_type slash = val.find('/');
+    if (slash == string::npos) {
+        throw BEASTifierError("option", "-shard expects 'i/n' (e.g. '-shard 2/8'), found '" + val + "'");
+    }
+    numShards = (int)convertStringtoCount(val.substr(slash + 1), "number of shards", INT_MAX);
+    long long shard = convertStringtoCount(val.substr(0, slash), "shard", INT_MAX);
+    if (numShards < 1 || shard < 1 || shard > numShards) {
+        throw BEASTifierError("option", "-shard '" + val + "' is not one of 1/n to n/n");
+    }
+    shardIndex = (int)shard - 1;
+}
+
+bool SettingsGrid::checkActive () {
+    return !optionNames.empty() || !filter.empty() || numShards > 1;
+}
+
+long long SettingsGrid::countCombinations (AnalysisSettings & ASet) {
+    numModels = ASet.getNumSubModels();
+    numClocks = ASet.getNumClockFlavours();
+    numTreePriors = ASet.getNumTreePriors();
+    vector <long long> sizes;
+    sizes.push_back(numModels);
+    sizes.push_back(numClocks);
+    sizes.push_back(numTreePriors);
+    numSettings = 1;
+    for (int i = 0; i < (int)alternatives.size(); i++) {
+        sizes.push_back(alternatives[i].size());
+        if (numSettings > LLONG_MAX / (long long)alternatives[i].size()) {
+            throw BEASTifierError("option", "the settings grid has more than " + convertIntToString(LLONG_MAX)
+                + " combinations");
+        }
+        numSettings *= alternatives[i].size();
+    }
+    numCombinations = 1;
+    for (int i = 0; i < (int)sizes.size(); i++) {
+        if (sizes[i] > 0 && numCombinations > LLONG_MAX / sizes[i]) {
+            throw BEASTifierError("option", "the settings grid has more than " + convertIntToString(LLONG_MAX)
+                + " combinations");
+        }
+        numCombinations *= sizes[i];
+    }
+    return numCombinations;
+}
+
+void SettingsGrid::checkFilterVariables (AnalysisSettings & ASet) {
+// catches misspelt names, which would otherwise quietly compare as empty text
+    vector <string> known;
+    known.push_back("model");
+    known.push_back("clock");
+    known.push_back("tprior");
+    known.push_back("file");
+    known.insert(known.end(), optionNames.begin(), optionNames.end());
+    vector <string> fieldNames = ASet.getNamePattern().getFieldNames();
+    fieldNames.push_back("root");
+    for (int i = 0; i < (int)fieldNames.size(); i++) {
+        if (find(known.begin(), known.end(), fieldNames[i]) == known.end()) {
+            known.push_back(fieldNames[i]);
+        }
+    }
+    for (int i = 0; i < (int)filter.size(); i++) {
+        if (filter[i].type != filterComparison) {
+            continue;
+        }
+        bool found = false;
+        for (int j = 0; j < (int)known.size() && !found; j++) {
+            found = (filter[i].variable == known[j]);
+        }
+        if (!found) {
+            string names;
+            for (int j = 0; j < (int)known.size(); j++) {
+                names += (j == 0 ? "" : ", ") + known[j];
+            }
+            throw BEASTifierError("option", "unknown filter variable '" + filter[i].variable + "' (known: " + names + ")");
+        }
+    }
+}
+
+void SettingsGrid::decodeCombination (long long const& combination, long long & settingIndex, int & modelIndex,
+    int & clockIndex, int & treePriorIndex) const
+{
+// tree priors vary fastest, then clocks, models and the grid options, so that a batch without
+// alternatives is written in the same order as ever
+    long long remainder = combination;
+    treePriorIndex = (int)(remainder % numTreePriors);
+    remainder /= numTreePriors;
+    clockIndex = (int)(remainder % numClocks);
+    remainder /= numClocks;
+    modelIndex = (int)(remainder % numModels);
+    settingIndex = remainder / numModels;
+}
+
+void SettingsGrid::applySettings (long long const& settingIndex, AnalysisSettings & settings) const {
+// the alternative of every option (the last option varies fastest) and the label that keeps the
+// xml file names apart
+    vector <int> alternativeIndices(alternatives.size());
+    long long remainder = settingIndex;
+    for (int i = (int)alternatives.size() - 1; i >= 0; i--) {
+        alternativeIndices[i] = (int)(remainder % (long long)alternatives[i].size());
+        remainder /= alternatives[i].size();
+    }
+    string label;
+    for (int i = 0; i < (int)alternatives.size(); i++) {
+        vector <string> const& alternative = alternatives[i][alternativeIndices[i]];
+        settings.applyOption(alternative);
+        label += "_" + optionNames[i];
+        for (int j = 1; j < (int)alternative.size(); j++) {
+            label += "-" + alternative[j];
+        }
+    }
+    for (int i = 0; i < (int)label.size(); i++) {
+        if (string("/\\ \t\"'*?").find(label[i]) != string::npos) {
+            label[i] = '_';
+        }
+    }
+    settings.setGridLabel(label);
+}
+
+long long SettingsGrid::findNextCombination (long long combination, map <string, string> const& fileVariables,
+    AnalysisSettings & ASet, long long & numSelected) const
+{
+// The first combination from 'combination' on that passes the filters and falls in this shard
+// (numCombinations if there is none). numSelected counts the combinations passing the filters
+// over the whole batch, which is what the shards are cut from.
+    map <string, string> variables = fileVariables;
+    for ( ; combination < numCombinations; combination++) {
+        if (!filter.empty()) {
+            long long settingIndex = 0;
+            int modelIndex = 0;
+            int clockIndex = 0;
+            int treePriorIndex = 0;
+            decodeCombination(combination, settingIndex, modelIndex, clockIndex, treePriorIndex);
+            variables["model"] = ASet.getSubModel(modelIndex);
+            variables["clock"] = ASet.getClockFlavour(clockIndex);
+            variables["tprior"] = ASet.getTreePrior(treePriorIndex);
+            for (int i = (int)alternatives.size() - 1; i >= 0; i--) {
+                vector <string> const& alternative = alternatives[i][settingIndex % (long long)alternatives[i].size()];
+                settingIndex /= alternatives[i].size();
+                string value = alternative[1];
+                for (int j = 2; j < (int)alternative.size(); j++) {
+                    value += " " + alternative[j];
+                }
+                variables[optionNames[i]] = value;
+            }
+            if (!evaluateFilter(variables)) {
+                continue;
+            }
+        }
+        numSelected++;
+        if ((numSelected - 1) % numShards == shardIndex) {
+            return combination;
+        }
+    }
+    return numCombinations;
+}
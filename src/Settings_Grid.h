@@ -0,0 +1,57 @@
+#ifndef _SETTINGS_GRID_H_
+#define _SETTINGS_GRID_H_
+
+// The analyses of a batch as a product: alignments x substitution models x clock flavours x
+// tree priors x every configuration line listing alternatives separated by '|' (e.g.
+// '-mcmc 1e7 | 5e7', '-logphy on | off'). Each such line is one dimension of the grid; its
+// alternatives are applied on top of the other settings. Combinations are never stored: a
+// combination index is decoded into one value per dimension when it is visited, so the size of
+// the grid costs nothing until files are written.
+// Combinations can be filtered ('-filter clock!=randlocal || n<=100') and split into shards
+// ('-shard 2/8'). A filter compares a variable with a value using == != < <= > >= (as numbers
+// when both sides are numbers, otherwise as text) and combines comparisons with && || ! and
+// parentheses; several filters must all hold. Variables are 'model', 'clock', 'tprior', 'file',
+// the fields of the name pattern (shadowed by the former), and the options of the grid without
+// their '-'. Only the file name is needed to decide which combinations of an alignment are
+// selected, so alignments with none are never read. Shards take every n-th selected combination
+// across the batch, so they stay balanced whatever the filter removes.
+
+enum FilterStepType {filterComparison, filterAnd, filterOr, filterNot};
+
+struct FilterStep {
+    FilterStepType type;
+    string variable, comparison, value;
+};
+
+class SettingsGrid {
+    
+    vector <string> optionNames;        // without the '-'
+    vector < vector < vector <string> > > alternatives;
+    vector <FilterStep> filter;         // reverse Polish; empty when there is no filter
+    int shardIndex, numShards;          // shardIndex counts from 0
+    long long numSettings, numCombinations, numModels, numClocks, numTreePriors;
+    
+    void compileFilter (vector <string> const& tokens, int & position, vector <FilterStep> & steps, int level);
+    bool evaluateFilter (map <string, string> const& variables) const;
+    
+public:
+    
+    void addDimension (vector <string> const& tokens, AnalysisSettings const& ASet);
+    void addFilter (string const& expression);
+    void setShard (string const& val);
+    bool checkActive ();
+    long long countCombinations (AnalysisSettings & ASet);
+    void checkFilterVariables (AnalysisSettings & ASet);
+    
+// visiting the combinations of one alignment
+    long long findNextCombination (long long combination, map <string, string> const& fileVariables,
+        AnalysisSettings & ASet, long long & numSelected) const;
+    void decodeCombination (long long const& combination, long long & settingIndex, int & modelIndex,
+        int & clockIndex, int & treePriorIndex) const;
+    void applySettings (long long const& settingIndex, AnalysisSettings & settings) const;
+    
+    SettingsGrid ();
+    ~SettingsGrid () {};
+};
+
+#endif /* _SETTINGS_GRID_H_ */
@@ -1,289 +1,603 @@
 #include <iostream>
 #include <sstream>
 #include <vector>
+#include <map>
 #include <fstream>
+#include <math.h>
+#include <cstdlib>
+#include <unordered_map>
+#include <unordered_set>
+#include <iomanip>
+#include <fcntl.h>
+#include <unistd.h>
 
 using namespace std;
 
 #include "General.h"
+#include "Log_Analysis.h"
+#include "File_Name_Pattern.h"
+#include "Analysis_Settings.h"
+#include "Alignment_Reader.h"
+#include "Alignment_Cache.h"
+#include "Newick_Tree.h"
+#include "Partitions.h"
 #include "SimData.h"
+#include "Run_Statistics.h"
 
 extern bool DEBUG;
+extern RunStatistics runStatistics;
 
-SimData::SimData (string const& fileName)
-: numTaxa(0), numChar(0), interleavedData(false), starterTreePresent(false)
+SimData::SimData (string const& fileName, AnalysisSettings & ASet)
+: numTaxa(0), numChar(0), numPatterns(0), meanPairwiseDistance(0.0), interleavedData(false),
+    starterTreePresent(false), streamSequences(ASet.getStreamSequences())
 {
+    ScopedTimer timer("parse");
+    bool useAlignmentCache = ASet.getUseAlignmentCache();
     seqFileName = fileName;
     checkValidInputFile(fileName);
-    setNumTaxaChar(seqFileName, numTaxa, numChar, interleavedData);
-    taxaAlignment = collectTaxaAlignment(seqFileName, numTaxa, numChar, interleavedData);
-    
-    root = setRootName(seqFileName);
-    simModel = getStringElement(seqFileName, '_', 10);
-    treeFileName = getTreeName(root);
-    starterTree = collectStartingTreePhylip(treeFileName, starterTreePresent);
+    parseFileName(ASet.getNamePattern(), ASet.getTreePattern(), ASet.getOutputPattern());
+    if (streamSequences) {
+        readAlignment();
+    } else if (!useAlignmentCache || !readAlignmentCache(seqFileName, taxaAlignment, numTaxa, numChar, interleavedData,
+        sitePatterns, numPatterns))
+    {
+        readAlignment();
+        buildSitePatterns();
+        if (useAlignmentCache && !writeAlignmentCache(seqFileName, taxaAlignment, numTaxa, numChar, interleavedData,
+            sitePatterns, numPatterns))
+        {
+            cout << "Note: unable to write alignment cache '" << getAlignmentCacheName(seqFileName) << "'." << endl;
+        }
+    }
     
+    {
+        ScopedTimer timer("parse.tree");
+        starterTree = collectStartingTreePhylip(treeFileName, starterTreePresent);
+        if (starterTreePresent) {
+            parseStartingTree();
+        }
+    }
+    checkTaxonConsistency();
+    meanPairwiseDistance = calculateMeanPairwiseDistance();
+    checkComposition();
+    if (DEBUG) {cout << numPatterns << " unique site patterns" << endl;}
 }
 
-void SimData::setNumTaxaChar (string & seqFileName, int & numTaxa, int & numChar,
-    bool & interleavedData)
+void SimData::readAlignment () {
+// NEXUS, FASTA or relaxed PHYLIP, sequential or interleaved; see Alignment_Reader.h
+    ScopedTimer timer("parse.alignment");
+    string errorMessage;
+    AlignmentReader reader(seqFileName);
+    bool success = streamSequences
+        ? reader.readAlignmentRanges(taxaAlignment, sequenceRanges, numTaxa, numChar, interleavedData, errorMessage)
+        : reader.readAlignment(taxaAlignment, numTaxa, numChar, interleavedData, errorMessage);
+    if (!success) {
+        throw BEASTifierError("alignment", "alignment '" + seqFileName + "' could not be read (" + errorMessage + ")");
+    }
+    if (DEBUG) {cout << "NTax = " << numTaxa << ", NChar = " << numChar << " (" << reader.getFormat() << ")" << endl;}
+    if (streamSequences) {
+// site patterns need whole columns; the number of sites stands in for them
+        numPatterns = numChar;
+        cout << "Streaming " << numTaxa << " sequences of " << numChar << " characters from '" << seqFileName << "'." << endl;
+    }
+}
+
+void SimData::parseFileName (FileNamePattern const& namePattern, FileNamePattern const& treePattern,
+    FileNamePattern const& outputPattern)
 {
-    ifstream inputUserFile;
+// Fields of the alignment's name (e.g. b_1_d_0.5_a_0.9_n_100_sim_JC_rep_4.NEX) give the starting
+// tree file and the root of the output names, both in the alignment's directory
+    string::size_type slash = seqFileName.rfind('/');
+    string directory = (slash == string::npos) ? "" : seqFileName.substr(0, slash + 1);
+    string name = seqFileName.substr(directory.size());
+    nameFields.clear();
+    if (!namePattern.matchPath(seqFileName, nameFields)) {
+        throw BEASTifierError("name", "file name '" + name + "' does not match the name pattern '"
+            + namePattern.getPattern() + "'");
+    }
+    treeFileName = directory + treePattern.expand(nameFields);
+    root = directory + outputPattern.expand(nameFields);
+    if (DEBUG) {cout << "Starting tree file '" << treeFileName << "', output root '" << root << "'" << endl;}
+}
+
+string SimData::collectStartingTreePhylip (string & fileName, bool & starterTreePresent) {
+// Rudimentary. if a valid line is found in a file, assume it is a phylip tree.
+    string treeString;
     bool commentLine = false;
     bool whiteSpaceOnly = false;
-    bool numTaxaEncountered = false;
-    bool numCharEncountered = false;
-    bool equalSignEncountered = false;
-    bool semicolonEncountered = false;
-    bool matrixEncountered = false; // know to stop looking
     
-    inputUserFile.open(seqFileName.c_str());
+    checkValidInputFile(fileName);
+    ifstream treeInput;
+    treeInput.open(fileName.c_str());
     string line;
     
-// Looking for pattern like 'dimensions ntax=53 nchar=16620;'
-//     - can be in either order, but must be stated on same line (for now)
-//     - no spaces allowed next to equal sign (for now)
-
-// Looking for pattern like 'Format datatype=dna [gap=-] [missing=?] {[interleave=yes] or [interleave]};'
-//     - no spaces allowed next to equal sign (for now)
-
-    while (getline(inputUserFile,line) && !matrixEncountered) {
-        int stringPosition = 0;
+// Read in every non-empty (or non-whitespace), non-commented-out line
+    while (getline(treeInput,line)) {
         commentLine = checkCommentLineNexus(line);
         whiteSpaceOnly = checkWhiteSpaceOnly(line);
         if (line.empty() || commentLine || whiteSpaceOnly) {
             continue;
         } else {
-            if (checkStringValue(line, "matrix", stringPosition)) {    // Done - won't find the information further down; really only used for 'interleave'
-                matrixEncountered = true;
-                continue;
-            } else if (checkStringValue(line, "dimensions", stringPosition)) {
-                stringPosition = 0;
-                while (!numTaxaEncountered || !numCharEncountered) {
-                    stringPosition++;
-                    string tempString = removeStringSuffix(parseString(line,stringPosition), '=', equalSignEncountered);
-                    if (checkStringValue(tempString, "ntax", 0)) {
-                        tempString = removeStringPrefix(parseString(line,stringPosition), '=');
-                        tempString = removeStringSuffix(tempString, ';', numTaxaEncountered);
-                        numTaxa = convertStringtoInt(tempString);
-                        if (DEBUG) {cout << "NTax = " << numTaxa << endl;}
-                        numTaxaEncountered = true;
-                    }
-                    if (checkStringValue(tempString, "nchar", 0)) {
-                        tempString = removeStringPrefix(parseString(line,stringPosition), '=');
-                        tempString = removeStringSuffix(tempString, ';', numCharEncountered);
-                        numChar = convertStringtoInt(tempString);
-                        if (DEBUG) {cout << "NChar = " << numChar << endl;}
-                        numCharEncountered = true;
-                    }
-                }
-            } else if (checkStringValue(line, "format", stringPosition)) {
-                stringPosition = 0;
-                while (!semicolonEncountered) {
-                    stringPosition++;
-                    
-                    string tempString = removeStringSuffix(parseString(line,stringPosition), '=', equalSignEncountered); // where '=' is used i.e. 'interleave=yes;'
-                    if (checkStringValue(tempString, "interleave", 0)) {
-                        tempString = removeStringPrefix(parseString(line,stringPosition), '=');
-                        tempString = removeStringSuffix(tempString, ';', semicolonEncountered);
-                        if (checkStringValue(tempString, "yes", 0)) {
-                            interleavedData = true;
-                            semicolonEncountered = true;
-                            cout << "Data are in interleaved format." << endl;
-                            continue;
-                        } else if (checkStringValue(tempString, "no", 0)) {
-                            interleavedData = false;
-                            semicolonEncountered = true;
-                            cout << "Data are not in interleaved format." << endl;
-                            continue;
-                        }
-                    }
-                    tempString = removeStringSuffix(parseString(line,stringPosition), ';', semicolonEncountered); // where '=' is NOT used i.e. 'interleave;'
-                    if (checkStringValue(tempString, "interleave", 0)) {                                          // OR a space follows interleave declaration i.e. 'interleave [=];'
-                        interleavedData = true;
-                        semicolonEncountered = true;
-                        cout << "Data are in interleaved format." << endl;
-                        continue;
-                    }
-                }
+            treeString = line;
+            starterTreePresent = true;
+        }
+    }
+    return treeString;
+}
+
+void SimData::parseStartingTree () {
+    string errorMessage;
+    if (!starterTreeStructure.parseNewick(starterTree, errorMessage)) {
+        throw BEASTifierError("tree", "starting tree in '" + treeFileName + "' is not valid newick (" + errorMessage + ")");
+    }
+    if (DEBUG) {cout << "Starting tree has " << starterTreeStructure.getNumTips() << " tips." << endl;}
+}
+
+void SimData::checkUltrametricity (double const& repairTolerance) {
+// Deviation is the spread of root-to-tip distances relative to the tree height. Below
+// 'ultrametricEpsilon' it is floating-point noise; otherwise it is reported, and repaired
+// (terminal branches extended) if within repairTolerance.
+    double ultrametricEpsilon = 1e-12;
+    if (!starterTreePresent) {
+        return;
+    }
+    if (!starterTreeStructure.hasBranchLengths()) {
+        cout << "Note: starting tree in '" << treeFileName << "' lacks branch lengths; ultrametricity not checked." << endl;
+        return;
+    }
+    double treeHeight = 0.0;
+    double deviation = starterTreeStructure.getUltrametricDeviation(treeHeight);
+    double relativeDeviation = (treeHeight > 0.0) ? deviation / treeHeight : 0.0;
+    if (DEBUG) {cout << "Starting tree height = " << treeHeight << "; max tip deviation = " << deviation << endl;}
+    
+    if (relativeDeviation <= ultrametricEpsilon) {
+        return;
+    }
+    if (repairTolerance > 0.0 && relativeDeviation <= repairTolerance) {
+        starterTreeStructure.makeUltrametric();
+        starterTree = starterTreeStructure.writeNewick();
+        cout << "Starting tree in '" << treeFileName << "' made ultrametric (max tip deviation "
+            << deviation << ", " << relativeDeviation << " of tree height)." << endl;
+    } else if (repairTolerance > 0.0) {
+        ostringstream message;
+        message << "starting tree in '" << treeFileName << "' is not ultrametric (max tip deviation " << deviation
+            << ", " << relativeDeviation << " of tree height; tolerance " << repairTolerance << ")";
+        throw BEASTifierError("tree", message.str());
+    } else {
+        cout << "Warning: starting tree in '" << treeFileName << "' is not ultrametric (max tip deviation "
+            << deviation << ", " << relativeDeviation << " of tree height). Use '-ultrametric' to repair." << endl;
+    }
+}
+
+void SimData::checkTaxonConsistency () {
+// Names from the alignment and the starting tree are interned into one hash index, counting
+// occurrences in each source; a single pass over the index then finds duplicates, taxa missing
+// from the tree, and tips absent from the alignment. Any of these would make BEAST fail at startup.
+    unordered_map <string, int> taxonIndex;
+    vector <string> taxonNames;
+    vector <int> alignmentCount;
+    vector <int> treeCount;
+    int numTips = starterTreePresent ? starterTreeStructure.getNumTips() : 0;
+    
+    taxonIndex.reserve(numTaxa + numTips);
+    taxonNames.reserve(numTaxa + numTips);
+    
+    for (int i = 0; i < (int)taxaAlignment.size() + numTips; i++) {
+        bool fromAlignment = (i < (int)taxaAlignment.size());
+        string const& name = fromAlignment ? taxaAlignment[i][0] : starterTreeStructure.getTipName(i - taxaAlignment.size());
+        pair <unordered_map <string, int>::iterator, bool> inserted = taxonIndex.insert(make_pair(name, (int)taxonNames.size()));
+        if (inserted.second) {
+            taxonNames.push_back(name);
+            alignmentCount.push_back(0);
+            treeCount.push_back(0);
+        }
+        if (fromAlignment) {
+            alignmentCount[inserted.first->second]++;
+        } else {
+            treeCount[inserted.first->second]++;
+        }
+    }
+    
+    vector <string> problems;
+    for (int i = 0; i < (int)taxonNames.size(); i++) {
+        if (alignmentCount[i] > 1) {
+            problems.push_back("taxon '" + taxonNames[i] + "' occurs " + convertIntToString(alignmentCount[i]) + " times in the alignment");
+        }
+        if (!starterTreePresent) {
+            continue;
+        }
+        if (treeCount[i] > 1) {
+            problems.push_back("tip '" + taxonNames[i] + "' occurs " + convertIntToString(treeCount[i]) + " times in the starting tree");
+        }
+        if (alignmentCount[i] == 0) {
+            problems.push_back("tip '" + taxonNames[i] + "' of the starting tree is not in the alignment");
+        } else if (treeCount[i] == 0) {
+            problems.push_back("taxon '" + taxonNames[i] + "' is missing from the starting tree");
+        }
+    }
+    if (problems.empty()) {
+        return;
+    }
+    
+    string message = "taxa of '" + seqFileName + "'";
+    if (starterTreePresent) {
+        message += " and starting tree '" + treeFileName + "'";
+    }
+    throw BEASTifierError("taxa", message + " are inconsistent", problems);
+}
+
+double SimData::calculateMeanPairwiseDistance () {
+// Mean Jukes-Cantor distance between sequences, over sites where both have an unambiguous base.
+// All pairs for small alignments; otherwise a fixed, evenly spread sample of pairs, over the first
+// 'maxSampleSites' sites whether or not the sequences are streamed, since this only seeds
+// starting values.
+    int maxPairs = 2000;
+    long long maxSampleSites = 100000;
+    int numSequences = taxaAlignment.size();
+    if (numSequences < 2) {
+        return 0.0;
+    }
+    int sourceDescriptor = streamSequences ? open(seqFileName.c_str(), O_RDONLY) : -1;
+    if (streamSequences) {
+        runStatistics.countOpen();
+    }
+    string sample1;
+    string sample2;
+    
+    signed char baseCode[256];
+    for (int i = 0; i < 256; i++) {
+        baseCode[i] = -1;
+    }
+    baseCode[(unsigned char)'A'] = baseCode[(unsigned char)'a'] = 0;
+    baseCode[(unsigned char)'C'] = baseCode[(unsigned char)'c'] = 1;
+    baseCode[(unsigned char)'G'] = baseCode[(unsigned char)'g'] = 2;
+    baseCode[(unsigned char)'T'] = baseCode[(unsigned char)'t'] = 3;
+    baseCode[(unsigned char)'U'] = baseCode[(unsigned char)'u'] = 3;
+    
+    double totalNumPairs = 0.5 * numSequences * (numSequences - 1.0);
+    int numPairs = (totalNumPairs <= maxPairs) ? (int)totalNumPairs : maxPairs;
+    double sumDistance = 0.0;
+    int numUsed = 0;
+    int first = 0;
+    int second = 1;
+    
+    for (int pair = 0; pair < numPairs; pair++) {
+        if (totalNumPairs > maxPairs) {
+            first = pair % numSequences;
+            second = (first + 1 + (int)(((long long)pair * 7919) % (numSequences - 1))) % numSequences;
+        }
+        string const& seq1 = getSequenceSample(first, sourceDescriptor, maxSampleSites, sample1);
+        string const& seq2 = getSequenceSample(second, sourceDescriptor, maxSampleSites, sample2);
+        long long length = (seq1.size() < seq2.size()) ? seq1.size() : seq2.size();
+        if (length > maxSampleSites) {
+            length = maxSampleSites;
+        }
+        long long compared = 0;
+        long long differences = 0;
+        for (long long site = 0; site < length; site++) {
+            int base1 = baseCode[(unsigned char)seq1[site]];
+            int base2 = baseCode[(unsigned char)seq2[site]];
+            if (base1 >= 0 && base2 >= 0) {
+                compared++;
+                differences += (base1 != base2);
+            }
+        }
+        if (compared > 0) {
+            double pDistance = (double)differences / compared;
+            if (pDistance > 0.74) {
+                pDistance = 0.74; // saturated; keep the correction finite
+            }
+            sumDistance += -0.75 * log(1.0 - pDistance / 0.75);
+            numUsed++;
+        }
+        if (totalNumPairs <= maxPairs) {
+            second++;
+            if (second == numSequences) {
+                first++;
+                second = first + 1;
             }
         }
     }
-    //cout << endl;
-    inputUserFile.close();
+    if (sourceDescriptor >= 0) {
+        close(sourceDescriptor);
+    }
+    if (DEBUG) {cout << "Mean pairwise distance (" << numUsed << " pairs) = " << sumDistance / (numUsed ? numUsed : 1) << endl;}
+    return (numUsed > 0) ? sumDistance / numUsed : 0.0;
 }
 
-vector < vector <string> > SimData::collectTaxaAlignment (string & seqFileName, int const& numTaxa,
-    int const& numChar, bool const& interleavedData)
+string const& SimData::getSequenceSample (int const& taxon, int const& sourceDescriptor,
+    long long const& maxSampleSites, string & sample)
 {
-// PLEASE NOTE: search strategy below uses very strict format assumptions - that which is exported by PAUP*
-//     - do not be surprised if this fucks up - it is probably a simple rearrangement of terms
+// The whole sequence (callers read only its first 'maxSampleSites' states), or when streaming
+// those states read from the file
+    if (!streamSequences) {
+        return taxaAlignment[taxon][1];
+    }
+    readSequenceRanges(sourceDescriptor, sequenceRanges[taxon], 0, maxSampleSites, sample);
+    return sample;
+}
 
-    vector < vector <string> > taxaAlignment;
-    ifstream inputAlignment;
-    vector <string> tempStringVector;
-    bool commentLine = false;
-    bool whiteSpaceOnly = false;
-    bool matrixEncountered = false;
-    bool allCharacterRead = false;
-    int numCharRead = 0;
+void SimData::countComposition (string const& sequence, long long counts[6]) {
+// counts[] = A, C, G, T, gap, ambiguous. Characters are classified through a lookup table and
+// tallied into four independent sets of counters, so consecutive characters never wait on the
+// same counter; the loop is branch-free and runs at memory speed.
+    static unsigned char stateClass[256];
+    static bool tableBuilt = false;
+    if (!tableBuilt) {
+        for (int i = 0; i < 256; i++) {
+            stateClass[i] = 5;
+        }
+        stateClass[(unsigned char)'A'] = stateClass[(unsigned char)'a'] = 0;
+        stateClass[(unsigned char)'C'] = stateClass[(unsigned char)'c'] = 1;
+        stateClass[(unsigned char)'G'] = stateClass[(unsigned char)'g'] = 2;
+        stateClass[(unsigned char)'T'] = stateClass[(unsigned char)'t'] = 3;
+        stateClass[(unsigned char)'U'] = stateClass[(unsigned char)'u'] = 3;
+        stateClass[(unsigned char)'-'] = 4;
+        tableBuilt = true;
+    }
     
-    inputAlignment.open(seqFileName.c_str());
-    string line;
+    long long lanes[4][6] = {{0}};
+    const unsigned char * text = (const unsigned char *)sequence.data();
+    size_t length = sequence.size();
+    size_t site = 0;
+    for (; site + 4 <= length; site += 4) {
+        lanes[0][stateClass[text[site]]]++;
+        lanes[1][stateClass[text[site + 1]]]++;
+        lanes[2][stateClass[text[site + 2]]]++;
+        lanes[3][stateClass[text[site + 3]]]++;
+    }
+    for (; site < length; site++) {
+        lanes[0][stateClass[text[site]]]++;
+    }
+    for (int i = 0; i < 6; i++) {
+        counts[i] = lanes[0][i] + lanes[1][i] + lanes[2][i] + lanes[3][i];
+    }
+}
+
+void SimData::countTaxonComposition (int const& taxon, int const& sourceDescriptor, long long counts[6]) {
+// when streaming, the taxon's states are read back a block at a time
+    long long blockSize = 1 << 20;
+    if (!streamSequences) {
+        countComposition(taxaAlignment[taxon][1], counts);
+        return;
+    }
+    for (int i = 0; i < 6; i++) {
+        counts[i] = 0;
+    }
+    string block;
+    for (long long from = 0; readSequenceRanges(sourceDescriptor, sequenceRanges[taxon], from, blockSize, block) > 0; from += blockSize) {
+        long long blockCounts[6];
+        countComposition(block, blockCounts);
+        for (int i = 0; i < 6; i++) {
+            counts[i] += blockCounts[i];
+        }
+    }
+}
+
+void SimData::checkComposition () {
+// Empirical base frequencies over all taxa, and a chi-square test (3 df, p < 0.05) of each
+// taxon's base counts against them. With millions of sites any difference is significant, so a
+// taxon is only reported as a compositional outlier when the difference is also not negligible:
+// its effect size w = sqrt(chi2 / bases) (Cohen's w) must reach 0.1, a 'small' effect (e.g. GC
+// content 5 points off an even composition).
+    double chiSquareCritical = 7.815;
+    double minEffectSize = 0.1;
+    int maxReported = 10;
+    vector < vector <long long> > taxonCounts(taxaAlignment.size(), vector <long long>(6, 0));
+    double totalCounts[6] = {0.0, 0.0, 0.0, 0.0, 0.0, 0.0};
+    int sourceDescriptor = streamSequences ? open(seqFileName.c_str(), O_RDONLY) : -1;
+    if (streamSequences) {
+        runStatistics.countOpen();
+    }
     
-    if (!interleavedData) {
-        while (!matrixEncountered) { // Ignore lines until 'matrix' is encountered
-            getline(inputAlignment,line);
-            commentLine = checkCommentLineNexus(line);
-            whiteSpaceOnly = checkWhiteSpaceOnly(line);
-            
-            if (line.empty() || commentLine || whiteSpaceOnly) {
-                continue;
-            } else if (checkStringValue(line, "matrix", 0)) {
-                matrixEncountered = true;
-            } else {
-                continue;
-            }
+    for (int i = 0; i < (int)taxaAlignment.size(); i++) {
+        long long counts[6];
+        countTaxonComposition(i, sourceDescriptor, counts);
+        for (int j = 0; j < 6; j++) {
+            taxonCounts[i][j] = counts[j];
+            totalCounts[j] += counts[j];
         }
-        numCharRead = 0;
-// Read in every non-empty (or non-whitespace), non-commented-out line
-        for (int taxonIter = 0; taxonIter < numTaxa; taxonIter++) {
-            getline(inputAlignment,line);
-            commentLine = checkCommentLineNexus(line);
-            whiteSpaceOnly = checkWhiteSpaceOnly(line);
-            
-            if (line.empty() || commentLine || whiteSpaceOnly) {
-                taxonIter--;
-                continue;
-            } else {
-// First string is taxon name, second is sequence
-                if (DEBUG) {cout << "Reading in taxon '" << parseString(line, 0) << "'..." << endl;}
-                tempStringVector.push_back(parseString(line, 0));
-                tempStringVector.push_back(parseString(line, 1));
-                
-                taxaAlignment.push_back(tempStringVector);
-                
-                tempStringVector.clear();
-                
-// Count sites encountered - for error-checking; only checking first sequence (for now)
-                if (taxonIter == 0) {
-                    int charCounter = 0;
-                    for (string::size_type iterCharacters = 0; iterCharacters < parseString(line, 1).size(); iterCharacters++) {
-                        charCounter++;
-                    }
-                    numCharRead += charCounter;
-                }
+    }
+    if (sourceDescriptor >= 0) {
+        close(sourceDescriptor);
+    }
+    
+    double numBases = totalCounts[0] + totalCounts[1] + totalCounts[2] + totalCounts[3];
+    double numCharacters = numBases + totalCounts[4] + totalCounts[5];
+    empiricalFrequencies.assign(4, 0.25);
+    if (numBases > 0.0) {
+        for (int j = 0; j < 4; j++) {
+            empiricalFrequencies[j] = totalCounts[j] / numBases;
+        }
+    }
+    cout << "Base frequencies: A = " << fixed << setprecision(4) << empiricalFrequencies[0]
+        << ", C = " << empiricalFrequencies[1] << ", G = " << empiricalFrequencies[2]
+        << ", T = " << empiricalFrequencies[3];
+    if (numCharacters > 0.0) {
+        cout << " (gaps " << setprecision(2) << 100.0 * totalCounts[4] / numCharacters << "%, ambiguous "
+            << 100.0 * totalCounts[5] / numCharacters << "%)";
+    }
+    cout.unsetf(ios::floatfield);
+    cout << setprecision(6) << endl;
+    
+    vector <string> outliers;
+    for (int i = 0; i < (int)taxaAlignment.size(); i++) {
+        double taxonBases = taxonCounts[i][0] + taxonCounts[i][1] + taxonCounts[i][2] + taxonCounts[i][3];
+        double chiSquare = 0.0;
+        for (int j = 0; j < 4; j++) {
+            double expected = taxonBases * empiricalFrequencies[j];
+            if (expected > 0.0) {
+                chiSquare += (taxonCounts[i][j] - expected) * (taxonCounts[i][j] - expected) / expected;
             }
         }
-        if (numCharRead == numChar) {
-            allCharacterRead = true;
-            if (DEBUG) {cout << "numCharRead (" << numCharRead << ") == numChar (" << numChar << ") declared in Nexus file. Woo-hoo!" << endl;}
+        if (DEBUG) {cout << taxaAlignment[i][0] << ": A " << taxonCounts[i][0] << " C " << taxonCounts[i][1]
+            << " G " << taxonCounts[i][2] << " T " << taxonCounts[i][3] << " gap " << taxonCounts[i][4]
+            << " ambiguous " << taxonCounts[i][5] << " chi2 = " << chiSquare << endl;}
+        if (chiSquare > chiSquareCritical && chiSquare >= minEffectSize * minEffectSize * taxonBases) {
+            outliers.push_back(taxaAlignment[i][0]);
+        }
+    }
+    if (!outliers.empty()) {
+        cout << "Warning: " << outliers.size() << " of " << taxaAlignment.size()
+            << " taxa fail the composition chi-square test (p < 0.05, effect size w >= " << minEffectSize << "):";
+        for (int i = 0; i < (int)outliers.size() && i < maxReported; i++) {
+            cout << " " << outliers[i];
+        }
+        if ((int)outliers.size() > maxReported) {
+            cout << " ...";
+        }
+        cout << endl;
+    }
+}
+
+void SimData::setPartitions (string const& partitionScheme) {
+// Codon positions, or the charsets of the alignment's own NEXUS file. Ranges must lie within
+// the alignment; columns in no partition are left out of the analysis, and columns in several
+// partitions are counted once per partition, so both are reported. Each partition gets its
+// own empirical base frequencies.
+    partitions.clear();
+    partitionFrequencies.clear();
+    partitionNumSites.clear();
+    partitionNumPatterns.clear();
+    if (partitionScheme.empty()) {
+        return;
+    }
+    
+    string errorMessage;
+    if (partitionScheme == "charsets") {
+        if (!readCharsets(seqFileName, partitions, errorMessage)) {
+            throw BEASTifierError("partition", "charsets of '" + seqFileName + "' are not valid (" + errorMessage + ")");
+        }
+        if (partitions.empty()) {
+            cout << "Warning: no charsets found in '" << seqFileName << "'; analysing it unpartitioned." << endl;
+            return;
         }
-    } else if (interleavedData) {
-// Ignore lines until 'matrix' is encountered
-        while (!matrixEncountered) {
-            getline(inputAlignment,line);
-            commentLine = checkCommentLineNexus(line);
-            whiteSpaceOnly = checkWhiteSpaceOnly(line);
-            
-            if (line.empty() || commentLine || whiteSpaceOnly) {
-                continue;
-            } else if (checkStringValue(line, "matrix", 0)) {
-                matrixEncountered = true;
-            } else {
-                continue;
+    } else {
+        makeCodonPartitions(partitionScheme, partitions);
+    }
+    
+    vector <int> coverage(numChar, 0);
+    for (int i = 0; i < (int)partitions.size(); i++) {
+        for (int j = 0; j < (int)partitions[i].ranges.size(); j++) {
+            CharacterRange const& range = partitions[i].ranges[j];
+            if (range.from > numChar || range.to > numChar) {
+                throw BEASTifierError("partition", "partition '" + partitions[i].name + "' extends beyond the " + convertIntToString(numChar)
+                    + " characters of '" + seqFileName + "'");
             }
         }
-        bool firstPass = true;
-        numCharRead = 0;
-        while (!allCharacterRead) {
-// Read in every non-empty (or non-whitespace), non-commented-out line
-            for (int taxonIter = 0; taxonIter < numTaxa; taxonIter++) {
-                getline(inputAlignment,line);
-                commentLine = checkCommentLineNexus(line);
-                whiteSpaceOnly = checkWhiteSpaceOnly(line);
-                
-                if (line.empty() || commentLine || whiteSpaceOnly) {
-                    taxonIter--;
-                    continue;
-                } else {
-// First string is taxon name, second is sequence
-                    string taxonName = (parseString(line, 0));
-                    string taxonSequence = (parseString(line, 1));
-                    
-                    if (firstPass) {
-                        if (DEBUG) {cout << "Reading in taxon '" << parseString(line, 0) << "'..." << endl;}
-                        tempStringVector.push_back(taxonName);        // Taxon name
-                        tempStringVector.push_back(taxonSequence);    // sequence
-                        taxaAlignment.push_back(tempStringVector);
-                    }
-                    if (!firstPass) {
-                        taxaAlignment[taxonIter][1] += taxonSequence;
-                    }
-                    
-// Count sites encountered - for error-checking; only checking first sequence (for now)
-                    if (taxonIter == 0) {
-                        int charCounter = 0;
-                        for (string::size_type iterCharacters = 0; iterCharacters < taxonSequence.size(); iterCharacters++) {
-                            charCounter++;
-                        }
-                        numCharRead += charCounter;
-                    }
-                    tempStringVector.clear();
-                }
+        
+        vector <long long> columns = getPartitionColumns(partitions[i], numChar);
+        double totalCounts[4] = {0.0, 0.0, 0.0, 0.0};
+        string partitionSequence(columns.size(), '-');
+        for (int j = 0; j < (int)taxaAlignment.size() && !streamSequences; j++) {
+            string const& sequence = taxaAlignment[j][1];
+            for (size_t k = 0; k < columns.size(); k++) {
+                partitionSequence[k] = (columns[k] < (long long)sequence.size()) ? sequence[columns[k]] : '-';
+            }
+            long long counts[6];
+            countComposition(partitionSequence, counts);
+            for (int k = 0; k < 4; k++) {
+                totalCounts[k] += counts[k];
             }
-            firstPass = false;
-            if (numCharRead == numChar) {
-                allCharacterRead = true;
-                if (DEBUG) {cout << "numCharRead (" << numCharRead << ") == numChar (" << numChar << ") declared in Nexus file. Woo-hoo!" << endl;}
+        }
+        for (size_t k = 0; k < columns.size(); k++) {
+            coverage[columns[k]]++;
+        }
+        
+        double numBases = totalCounts[0] + totalCounts[1] + totalCounts[2] + totalCounts[3];
+        vector <double> frequencies(4, 0.25);
+        if (streamSequences) {
+            frequencies = empiricalFrequencies; // columns are not held in memory
+        } else if (numBases > 0.0) {
+            for (int k = 0; k < 4; k++) {
+                frequencies[k] = totalCounts[k] / numBases;
             }
         }
+        partitionFrequencies.push_back(frequencies);
+        partitionNumSites.push_back(columns.size());
+        partitionNumPatterns.push_back(countSitePatterns(columns));
+        if (DEBUG) {cout << "Partition '" << partitions[i].name << "': " << columns.size() << " sites, "
+            << partitionNumPatterns.back() << " patterns" << endl;}
+    }
+    
+    long long numExcluded = 0;
+    long long numShared = 0;
+    for (long long i = 0; i < numChar; i++) {
+        numExcluded += (coverage[i] == 0);
+        numShared += (coverage[i] > 1);
+    }
+    cout << "Partitioned into " << partitions.size() << " partitions (" << partitionScheme << ")." << endl;
+    if (numExcluded > 0) {
+        cout << "Warning: " << numExcluded << " of " << numChar << " characters are in no partition and will not be analysed." << endl;
+    }
+    if (numShared > 0) {
+        cout << "Warning: " << numShared << " characters are in more than one partition." << endl;
     }
-    return taxaAlignment;
 }
 
-string SimData::setRootName (string const& stringToBreak) {
-// form: b_1_d_0.5_a_0.9_n_100_sim_JC_rep_4.NEX - 12 root elements
-    string desired = stringToBreak;
-    bool done = false;
-    desired = removeStringSuffix(desired, '.', done); // removes last instance of '.'
-    return desired;
+static char getColumnState (string const& sequence, long long const& column) {
+    return (column < (long long)sequence.size()) ? toupper(sequence[column]) : '-';
 }
 
-string SimData::getTreeName(string const& rootName) {
-// form: b_1_d_0.5_a_0.9_n_100_sim_JC_rep_4 - 12 elements
-    bool done = false;
-    string treeName = rootName;
-    string repNumber = getStringElement(rootName, '_', 12);
-    for (int i = 12; i > 8; i--) {
-        treeName = removeStringSuffix(treeName, '_', done);
-    }
-    treeName = treeName + "_rep_" + repNumber + ".phy";
-    
-    return treeName;
+bool SimData::checkSameColumns (long long const& first, long long const& second) {
+    for (int j = 0; j < (int)taxaAlignment.size(); j++) {
+        if (getColumnState(taxaAlignment[j][1], first) != getColumnState(taxaAlignment[j][1], second)) {
+            return false;
+        }
+    }
+    return true;
 }
 
-string SimData::collectStartingTreePhylip (string & fileName, bool & starterTreePresent) {
-// Rudimentary. if a valid line is found in a file, assume it is a phylip tree.
-    string treeString;
-    bool commentLine = false;
-    bool whiteSpaceOnly = false;
-    
-    checkValidInputFile(fileName);
-    ifstream treeInput;
-    treeInput.open(fileName.c_str());
-    string line;
+void SimData::buildSitePatterns () {
+// Index of each column's pattern (case-insensitive), numbered in order of first appearance; built
+// once per alignment (or read from its cache), after which any set of columns is counted by
+// its distinct indices. Columns are never copied out: a 64-bit hash of every column is built in
+// one pass along the rows, and each hash maps to the first column seen with it. A column whose
+// hash is taken by a different column (a collision, checked state by state) moves on to a
+// derived hash.
+    ScopedTimer timer("parse.patterns");
+    vector <unsigned long long> columnHashes(numChar, 14695981039346656037ULL);
+    for (int j = 0; j < (int)taxaAlignment.size(); j++) {
+        string const& sequence = taxaAlignment[j][1];
+        for (long long i = 0; i < numChar; i++) {
+            columnHashes[i] = (columnHashes[i] ^ (unsigned char)getColumnState(sequence, i)) * 1099511628211ULL;
+        }
+    }
     
-// Read in every non-empty (or non-whitespace), non-commented-out line
-    while (getline(treeInput,line)) {
-        commentLine = checkCommentLineNexus(line);
-        whiteSpaceOnly = checkWhiteSpaceOnly(line);
-        if (line.empty() || commentLine || whiteSpaceOnly) {
-            continue;
-        } else {
-            treeString = line;
-            starterTreePresent = true;
+    unordered_map <unsigned long long, long long> representatives; // hash -> first column
+    representatives.reserve(numChar < (1 << 20) ? numChar : (1 << 20));
+    sitePatterns.assign(numChar, 0);
+    numPatterns = 0;
+    for (long long i = 0; i < numChar; i++) {
+        unsigned long long hash = columnHashes[i];
+        while (true) {
+            pair <unordered_map <unsigned long long, long long>::iterator, bool> found
+                = representatives.insert(make_pair(hash, i));
+            if (found.second) {
+                sitePatterns[i] = numPatterns++;
+                break;
+            }
+            if (checkSameColumns(found.first->second, i)) {
+                sitePatterns[i] = sitePatterns[found.first->second];
+                break;
+            }
+            hash = hash * 6364136223846793005ULL + 1442695040888963407ULL;
         }
     }
-    return treeString;
+}
+
+long long SimData::countSitePatterns (vector <long long> const& columns) {
+// Number of distinct patterns among the given columns; this, not the number of sites, is what
+// a tree likelihood computes over. Streamed alignments have no pattern index; every site counts.
+    if (sitePatterns.empty()) {
+        return columns.size();
+    }
+    vector <char> seen(numPatterns, 0);
+    long long count = 0;
+    for (size_t i = 0; i < columns.size(); i++) {
+        long long index = sitePatterns[columns[i]];
+        count += !seen[index];
+        seen[index] = 1;
+    }
+    return count;
 }
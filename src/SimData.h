@@ -3,22 +3,45 @@
 
 class SimData {
     
-    int numTaxa, numChar;
+    long long numTaxa, numChar, numPatterns;
+    double meanPairwiseDistance;
+    vector <double> empiricalFrequencies;
     vector < vector <string> > taxaAlignment;
-    string seqFileName, root, simModel, treeFileName, starterTree;
-    bool interleavedData, starterTreePresent;
+    vector <long long> sitePatterns; // pattern index of each column
+    vector < vector <SequenceRange> > sequenceRanges; // -stream: where each taxon's states lie in seqFileName
+    string seqFileName, root, treeFileName, starterTree;
+    map <string, string> nameFields; // from the file name pattern
+    bool interleavedData, starterTreePresent, streamSequences;
+    NewickTree starterTreeStructure;
+    vector <Partition> partitions;
+    vector < vector <double> > partitionFrequencies;
+    vector <long long> partitionNumSites;
+    vector <long long> partitionNumPatterns;
+    map <string, string> serializedAlignments; // taxa + alignment xml, per output format
     
 public:
-    void setNumTaxaChar (string&, int&, int&, bool&);
-    vector < vector <string> > collectTaxaAlignment (string&, int const&, int const&, bool const&);
-    string setRootName (string const&);
-    string getTreeName (string const&);
+    void readAlignment ();
+    void buildSitePatterns ();
+    bool checkSameColumns (long long const& first, long long const& second);
+    void parseFileName (FileNamePattern const& namePattern, FileNamePattern const& treePattern,
+        FileNamePattern const& outputPattern);
     string collectStartingTreePhylip (string&, bool &);
+    void parseStartingTree ();
+    void checkUltrametricity (double const& repairTolerance);
+    void checkTaxonConsistency ();
+    double calculateMeanPairwiseDistance ();
+    string const& getSequenceSample (int const& taxon, int const& sourceDescriptor,
+        long long const& maxSampleSites, string & sample);
+    void countComposition (string const& sequence, long long counts[6]);
+    void countTaxonComposition (int const& taxon, int const& sourceDescriptor, long long counts[6]);
+    void checkComposition ();
+    void setPartitions (string const& partitionScheme);
+    long long countSitePatterns (vector <long long> const& columns);
     
     // allow easy access to data
     friend class BEASTXML;
     
-    SimData (string const& fileName);
+    SimData (string const& fileName, AnalysisSettings & ASet);
     ~SimData () {};
 };
 
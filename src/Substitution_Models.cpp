@@ -0,0 +1,98 @@
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+#include "Substitution_Models.h"
+
+// Rates are listed in the order BEAST expects them within the model block (AC, AG, AT, CG, GT);
+// operators, priors and log columns follow the same order.
+
+static const SubstitutionModel substitutionModels[] = {
+    {"JC", "JC69", "gtrModel", "The JC69 substitution model (Jukes & Cantor, 1969)", 0, false, 5,
+        {{"rateAC", "ac", false, noPrior},
+         {"rateAG", "ag", false, noPrior},
+         {"rateAT", "at", false, noPrior},
+         {"rateCG", "cg", false, noPrior},
+         {"rateGT", "gt", false, noPrior}}},
+    {"K80", "K80", "hkyModel", "The K80 substitution model (Hasegawa, Kishino & Yano, 1985)", 0, true, 1,
+        {{"kappa", "kappa", false, logNormalKappaPrior}}},
+    {"HKY", "HKY", "hkyModel", "The HKY substitution model (Hasegawa, Kishino & Yano, 1985)", "0.1", true, 1,
+        {{"kappa", "kappa", false, logNormalKappaPrior}}},
+    {"TrNef", "TrNef", "gtrModel", "The Tamura-Nei 1993 (TrNef) substitution model ", 0, true, 5,
+        {{"rateAC", "transversion", false, gammaRatePrior},
+         {"rateAG", "ag", false, gammaRatePrior},
+         {"rateAT", "transversion", true, noPrior},
+         {"rateCG", "transversion", true, noPrior},
+         {"rateGT", "transversion", true, noPrior}}},
+    {"TrN", "TrN", "gtrModel", "The Tamura-Nei 1993 (TrN) substitution model ", "1", true, 5,
+        {{"rateAC", "transversion", false, gammaRatePrior},
+         {"rateAG", "ag", false, gammaRatePrior},
+         {"rateAT", "transversion", true, noPrior},
+         {"rateCG", "transversion", true, noPrior},
+         {"rateGT", "transversion", true, noPrior}}},
+    {"K3P", "K3P", "gtrModel", "The Kimura 1981 3-parameter (K3P) substitution model", 0, true, 5,
+        {{"rateAC", "purine2pyrimidine", false, gammaRatePrior},
+         {"rateAG", "ag", false, noPrior},
+         {"rateAT", "pyrimidine2purine", false, gammaRatePrior},
+         {"rateCG", "pyrimidine2purine", true, noPrior},
+         {"rateGT", "purine2pyrimidine", true, noPrior}}},
+    {"K3Puf", "K3Puf", "gtrModel", "The Kimura 1981 3-parameter (K3Puf) substitution model", "0.1", true, 5,
+        {{"rateAC", "purine2pyrimidine", false, gammaRatePrior},
+         {"rateAG", "ag", false, noPrior},
+         {"rateAT", "pyrimidine2purine", false, gammaRatePrior},
+         {"rateCG", "pyrimidine2purine", true, noPrior},
+         {"rateGT", "purine2pyrimidine", true, noPrior}}},
+    {"TIMef", "TIMef", "gtrModel", "The transitional (TIMef) substitution model", 0, true, 5,
+        {{"rateAC", "purine2pyrimidine", false, gammaRatePrior},
+         {"rateAG", "ag", false, gammaRatePrior},
+         {"rateAT", "pyrimidine2purine", false, gammaRatePrior},
+         {"rateCG", "pyrimidine2purine", true, noPrior},
+         {"rateGT", "purine2pyrimidine", true, noPrior}}},
+    {"TIM", "TIM", "gtrModel", "The transitional (TIM) substitution model", "0.1", true, 5,
+        {{"rateAC", "purine2pyrimidine", false, gammaRatePrior},
+         {"rateAG", "ag", false, gammaRatePrior},
+         {"rateAT", "pyrimidine2purine", false, gammaRatePrior},
+         {"rateCG", "pyrimidine2purine", true, noPrior},
+         {"rateGT", "purine2pyrimidine", true, noPrior}}},
+    {"TVMef", "TVMef", "gtrModel", "The transversional (TVMef) substitution model", 0, true, 5,
+        {{"rateAC", "ac", false, gammaRatePrior},
+         {"rateAG", "ag", false, noPrior},
+         {"rateAT", "at", false, gammaRatePrior},
+         {"rateCG", "cg", false, gammaRatePrior},
+         {"rateGT", "gt", false, gammaRatePrior}}},
+    {"TVM", "TVM", "gtrModel", "The transversional (TVM) substitution model ", "0.1", true, 5,
+        {{"rateAC", "ac", false, gammaRatePrior},
+         {"rateAG", "ag", false, noPrior},
+         {"rateAT", "at", false, gammaRatePrior},
+         {"rateCG", "cg", false, gammaRatePrior},
+         {"rateGT", "gt", false, gammaRatePrior}}},
+    {"SYM", "SYM", "gtrModel", "The symmetric (SYM) substitution model", 0, true, 5,
+        {{"rateAC", "ac", false, gammaRatePrior},
+         {"rateAG", "ag", false, gammaRatePrior},
+         {"rateAT", "at", false, gammaRatePrior},
+         {"rateCG", "cg", false, gammaRatePrior},
+         {"rateGT", "gt", false, gammaRatePrior}}},
+    {"GTR", "GTR", "gtrModel", "The general time reversible (GTR) substitution model", "0.1", true, 5,
+        {{"rateAC", "ac", false, gammaRatePrior},
+         {"rateAG", "ag", false, gammaRatePrior},
+         {"rateAT", "at", false, gammaRatePrior},
+         {"rateCG", "cg", false, gammaRatePrior},
+         {"rateGT", "gt", false, gammaRatePrior}}}
+};
+
+static const int numSubstitutionModels = sizeof(substitutionModels) / sizeof(SubstitutionModel);
+
+SubstitutionModel const* findSubstitutionModel (string const& name) {
+// returns 0 if the model is not supported
+    for (int i = 0; i < numSubstitutionModels; i++) {
+        if (name == substitutionModels[i].name) {
+            return &substitutionModels[i];
+        }
+    }
+    return 0;
+}
+
+bool checkEstimatedParameter (ModelParameter const& parameter) {
+    return (!parameter.reference && parameter.prior != noPrior);
+}
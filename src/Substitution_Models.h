@@ -0,0 +1,31 @@
+#ifndef _SUBSTITUTION_MODELS_H_
+#define _SUBSTITUTION_MODELS_H_
+
+// Table of supported nucleotide substitution models. The BEASTXML writers (model block, site
+// model, operators, priors, parameter log) all walk the entry of the model being analysed, so
+// adding a model means adding one entry to the table in Substitution_Models.cpp.
+
+enum ParameterPrior {noPrior, logNormalKappaPrior, gammaRatePrior};
+
+struct ModelParameter {
+    const char * element;      // element wrapping the parameter in the model block, e.g. 'rateAC'
+    const char * name;         // parameter id suffix, e.g. 'ac' -> 'GTR.ac'
+    bool reference;            // idref to a parameter defined earlier in the same model
+    ParameterPrior prior;      // noPrior: fixed at 1.0; otherwise bounded, scaled, and given this prior
+};
+
+struct SubstitutionModel {
+    const char * name;             // as given in '-mods', e.g. 'JC'
+    const char * id;               // BEAST id, e.g. 'JC69'
+    const char * element;          // 'gtrModel' or 'hkyModel'
+    const char * description;
+    const char * frequencyWeight;  // deltaExchange weight on (estimated) frequencies; 0 if equal frequencies
+    bool logFrequencies;
+    int numParameters;
+    ModelParameter parameters[5];
+};
+
+SubstitutionModel const* findSubstitutionModel (string const& name);
+bool checkEstimatedParameter (ModelParameter const& parameter);
+
+#endif /* _SUBSTITUTION_MODELS_H_ */
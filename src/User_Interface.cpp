@@ -1,20 +1,30 @@
 #include <iostream>
 #include <fstream>
 #include <vector>
+#include <map>
 #include <sstream>
 #include <cstdlib>
 #include <iomanip>
+#include <algorithm>
 
 using namespace std;
 
 #include "General.h"
+#include "Alignment_Discovery.h"
+#include "Log_Analysis.h"
+#include "File_Name_Pattern.h"
 #include "Analysis_Settings.h"
+#include "Settings_Grid.h"
 #include "User_Interface.h"
+#include "Run_Statistics.h"
+#include "Run_Trace.h"
 
 extern bool DEBUG;
 extern double version;
 extern string month;
 extern int year;
+extern RunStatistics runStatistics;
+extern RunTrace runTrace;
 
 void printProgramInfo () {
     cout << endl << 
@@ -31,7 +41,7 @@ void printProgramInfo () {
 // *** add option to process config file instead - DONE
 // need to error-check: parameters (maybe conflicting) in config vs. commandline - low priority
 void processCommandLineArguments (int argc, char *argv[], vector <string> & listFileNames,
-    AnalysisSettings & ASet)
+    AnalysisSettings & ASet, SettingsGrid & grid)
 {
     if (argc == 1) {
         cout << "No arguments given." << endl << endl;
@@ -50,10 +60,39 @@ void processCommandLineArguments (int argc, char *argv[], vector <string> & list
                 << "   make" << endl << endl;
                 usage();
                 exit(0);
+            } else if (temp == "-mlemerge") {
+                vector <string> mleLogs;
+                for (i++; i < argc; i++) {
+                    mleLogs.push_back(argv[i]);
+                }
+                mergeMarginalLikelihood(mleLogs);
+                exit(0);
+            } else if (temp == "-plan") {
+                string planFileName;
+                if (i + 1 < argc && argv[i + 1][0] != '-') {
+                    i++;
+                    planFileName = argv[i];
+                }
+                ASet.setPlanRun(planFileName);
+                continue;
+            } else if (temp == "-stats") {
+                if (i + 1 >= argc) {
+                    throw BEASTifierError("settings", "'-stats' needs the name of the statistics file");
+                }
+                i++;
+                runStatistics.enable(argv[i]);
+                continue;
+            } else if (temp == "-trace") {
+                if (i + 1 >= argc) {
+                    throw BEASTifierError("settings", "'-trace' needs the name of the trace file");
+                }
+                i++;
+                runTrace.enable(argv[i]);
+                continue;
             } else if (temp == "-config") {
                 i++;
                 string temp = argv[i];
-                readConfigFile (temp, ASet, listFileNames);
+                readConfigFile (temp, ASet, listFileNames, grid);
                 continue;
             } else {
                 cout
@@ -82,7 +121,37 @@ void usage() {
     << "   -alist: filename" << endl
     << "      - name of text file listing alignment filenames." << endl
     << "      - one alignment filename per line." << endl
-    << "      - Required; all other arguments are optional." << endl
+    << "      - alignments may be NEXUS, FASTA or relaxed PHYLIP." << endl
+    << "      - alignments that fail are skipped and logged in 'Error.BEASTifier.tsv'." << endl
+    << "      - Required (or -adir); all other arguments are optional." << endl
+    << "   -adir: directory [directory ...]" << endl
+    << "      - use the alignments found in these directories and their subdirectories." << endl
+    << "      - largest files first; added after any -alist files." << endl
+    << "   -aglob: pattern [pattern ...]" << endl
+    << "      - file name patterns for -adir (case-insensitive)." << endl
+    << "      - default: -aglob *.nex *.nexus *.fasta *.fas *.fa" << endl
+    << "   -aregex: expression" << endl
+    << "      - only use -adir files whose path matches this extended regular expression." << endl
+    << "      - e.g. -aregex sim_(GTR|HKY)_rep_[0-9]+" << endl
+    << "   -namepattern: pattern" << endl
+    << "      - names of the alignment files: literal text and named {fields}." << endl
+    << "      - each field takes the shortest text up to the literal that follows it." << endl
+    << "      - default: -namepattern b_{b}_d_{d}_a_{a}_n_{n}_sim_{model}_rep_{rep}.{ext}" << endl
+    << "   -treepattern: pattern" << endl
+    << "      - name of each alignment's starting tree file, from the fields of its name." << endl
+    << "      - default: -treepattern b_{b}_d_{d}_a_{a}_n_{n}_rep_{rep}.phy" << endl
+    << "   -outpattern: pattern" << endl
+    << "      - root of the xml file names, from the fields of the alignment name." << endl
+    << "      - {root} is the alignment file name without its extension." << endl
+    << "      - default: -outpattern {root}" << endl
+    << "   -cache: keep a binary copy of each parsed alignment next to it ('<alignment>.bcache')." << endl
+    << "      - later runs read the copy instead of parsing the text, unless the alignment has changed." << endl
+    << "   -stream: for alignments too large to hold in memory." << endl
+    << "      - only taxon names and the file positions of each sequence are kept; sequences are" << endl
+    << "        copied from the alignment file into each xml file as it is written." << endl
+    << "      - base frequencies are counted in a pass over the file; pairwise distances use the" << endl
+    << "        first 100000 sites; site patterns are not counted (each site counts as one)." << endl
+    << "      - partitions get the frequencies of the whole alignment; -cache is not used." << endl
     << "   -mods: list substitution model(s) to analyze data" << endl
     << "      - supported models: JC, K80, HKY, TrNef, TrN, K3P, K3Puf, TIMef, TIM, TVMef, TVM, SYM, GTR." << endl
     << "      - if more than one model, separate by spaces." << endl
@@ -94,12 +163,55 @@ void usage() {
     << "      - default = -clock ucln" << endl
     << "   -mcmc: the number of mcmc generations to run analysis." << endl
     << "      - default: -mcmc 20000000" << endl
+    << "      - counts (here and for -tsamp, -psamp, -ssamp, -mle) may exceed 2^31 and may be written as e.g. 5e9." << endl
     << "   -tsamp: the interval (in generations) for sampling trees." << endl
     << "      - default: -tamps 5000" << endl
     << "   -psamp: the interval (in generations) for sampling parameter values." << endl
     << "      - default: -psamp 1000" << endl
     << "   -ssamp: the interval (in generations) for printing results to standard output." << endl
     << "      - default: -ssamp 500" << endl
+    << "   -samples: target number of tree and parameter samples per file." << endl
+    << "      - sets -tsamp and -psamp per file to chain length / target." << endl
+    << "      - default = use -tsamp and -psamp as given." << endl
+    << "   -iobudget: output byte budget per file for tree and parameter logs (e.g. 500M)." << endl
+    << "      - bytes per tree sample are estimated from the number of taxa and clock model;" << endl
+    << "        the tree sampling interval is coarsened until the estimate fits the budget;" << endl
+    << "        the parameter log, which ESS is computed from, keeps its interval." << endl
+    << "      - default = no budget." << endl
+    << "   -manifest: filename" << endl
+    << "      - write a tab-delimited jobs manifest listing every xml file created," << endl
+    << "        its settings and the sampling intervals chosen." << endl
+    << "      - the fields of the alignment name (-namepattern) are added as the last columns." << endl
+    << "   -maxthreads: most threads a single BEAST run should use." << endl
+    << "      - BEAGLE instances per partition, resource (SSE/CPU), scaling and thread count are" << endl
+    << "        chosen per file from its site patterns, rate categories and partitions, written into" << endl
+    << "        the tree likelihoods, and suggested as a launch command at the top of the file." << endl
+    << "      - default: -maxthreads 8" << endl
+    << "   -runscript: filename" << endl
+    << "      - write a shell script with the suggested launch command of every xml file created." << endl
+    << "   -format: list of output format(s)." << endl
+    << "      - supported: 'beast1', 'beast2' (BEAST 2.6 xml, files named '_beast2')." << endl
+    << "      - each alignment is read once and written in every format listed; BEAST 2 files" << endl
+    << "        analyse the same models, clocks and tree priors, except 'logcoal' (not in BEAST 2)," << endl
+    << "        and carry no marginal likelihood estimator." << endl
+    << "      - default: -format beast1" << endl
+    << "   -ambiguities: let BEAST 2 tree likelihoods use ambiguity codes (useAmbiguities)." << endl
+    << "      - default = ambiguity codes are treated as missing data." << endl
+    << "   -ultrametric: tolerance for repairing a non-ultrametric starting tree." << endl
+    << "      - if tip distances from the root differ by at most this fraction of the tree height," << endl
+    << "        terminal branches are extended so all tips line up (e.g. rounding from write.tree)." << endl
+    << "      - larger deviations are an error." << endl
+    << "      - default = report deviations only." << endl
+    << "   -partition: analyse the data as partitions, each with its own model and tree likelihood." << endl
+    << "      - supported: 'codon' (codon positions 1, 2, 3), 'codon12+3' (positions 1+2, 3), or" << endl
+    << "        'charsets' (the 'charset' statements in the SETS or ASSUMPTIONS block of each NEXUS file)." << endl
+    << "      - every partition gets an unlinked copy of the substitution and site model, its own" << endl
+    << "        base frequencies, and a relative rate; files are named '_<scheme>-part'." << endl
+    << "      - default = unpartitioned." << endl
+    << "   -templates: directory of xml templates overriding the built-in sections." << endl
+    << "      - a file '<name>.xml' replaces the template of that name (e.g. 'treeLog.xml');" << endl
+    << "        slots such as '{{treeSampling}}' are filled in per file." << endl
+    << "      - default = built-in templates only." << endl
     << "   -logphy: turn on logging of phylograms (in addition to chronograms)." << endl
     << "      -  default: don't log." << endl
     << "   -tprior: list of tree prior(s)" << endl
@@ -107,24 +219,88 @@ void usage() {
     << "      - default = -tprior bd" << endl
     << "   -fixtree: turn off topology manipulation operators (i.e. fix to input topology)." << endl
     << "      - default = estimate topology." << endl
+    << "   -tuneops: filename" << endl
+    << "      - list of operator analysis files ('.ops') from previous runs, one per line." << endl
+    << "      - runs within a factor of two in number of taxa are pooled; operator scale factors" << endl
+    << "        start at their tuned values, and weights are lowered for operators that are" << endl
+    << "        rarely accepted or slower than the median operator." << endl
+    << "      - default = fixed weights and scale factors." << endl
+    << "   -fixfreqs: fix base frequencies at their empirical values (no frequency operator)." << endl
+    << "      - applies to models with unequal frequencies; files are named '_fix-freq'." << endl
+    << "      - default = estimate frequencies, starting from their empirical values." << endl
     << "   -rprior: specify prior for root age." << endl
     << "      - supported: 'unif'' or 'norm'." << endl
     << "      - if 'unif', expecting '-rprior unif min_value max_value'." << endl
     << "      - if 'norm', expecting '-rprior norm mean_value stdev_value'." << endl
+    << "      - the root starts at the prior midpoint (unif) or mean (norm); a starting tree is" << endl
+    << "        rescaled to that height, and the clock rate starts at (mean pairwise distance / 2) / root height." << endl
+    << "      - without a root prior, the root starts at the starting tree height, or at half the mean pairwise distance." << endl
     << "   -overwrite: overwrite existing files." << endl
     << "      - default = don't overwrite; warn instead." << endl
+    << "   -triage: minimum ESS for convergence triage of previous runs." << endl
+    << "      - reads each combination's existing parameter log and only regenerates" << endl
+    << "        files whose smallest ESS is below this value, with a longer chain." << endl
+    << "      - converged runs, runs with an xml file but no log yet, and runs whose log has not" << endl
+    << "        reached the chain length of their xml, are left alone." << endl
+    << "      - default = no triage; write every combination." << endl
+    << "   -burnin: fraction of logged samples discarded before computing ESS." << endl
+    << "      - default: -burnin 0.1" << endl
+    << "   -mle: append a power-posterior marginal likelihood estimator to each file." << endl
+    << "      - expecting '-mle path_steps chain_length_per_step'." << endl
+    << "      - path sampling and stepping-stone estimates are written at the end of the run." << endl
+    << "      - default = don't estimate." << endl
+    << "      - the '.mle.log' files of replicate runs of one file can be pooled with:" << endl
+    << "         ./BEASTifier -mlemerge run1.mle.log run2.mle.log ..." << endl
+    << endl
+    << "Settings grid:" << endl
+    << endl
+    << "   Any other setting may list alternatives separated by '|', e.g. '-mcmc 1e7 | 5e7' or" << endl
+    << "   '-logphy on | off'. Every combination of alternatives (times models, clocks and tree" << endl
+    << "   priors) is written for every alignment; file names gain e.g. '_mcmc-1e7'." << endl
+    << "      - -mods, -clock and -tprior already loop over their values; list them without '|'." << endl
+    << "      - settings of the whole batch (-alist, -manifest, -cache, -partition, ...) take one value." << endl
+    << "   -filter: expression" << endl
+    << "      - only write combinations for which it holds, e.g. '-filter clock!=randlocal || n<=100'." << endl
+    << "      - compare with == != < <= > >= (as numbers when both sides are); combine with && || ! ( )." << endl
+    << "      - variables: model, clock, tprior, file, the fields of -namepattern, and the grid" << endl
+    << "        options without their '-' (e.g. mcmc)." << endl
+    << "      - several filters must all hold." << endl
+    << "   -shard: i/n" << endl
+    << "      - write only every n-th selected combination of the batch, starting with the i-th (1 to n)." << endl
+    << "      - running all n shards writes every combination exactly once." << endl
+    << endl
+    << "Planning a batch:" << endl
+    << endl
+    << "   ./BEASTifier -config config_filename -plan [plan_filename]" << endl
+    << "      - reads only the alignment headers and writes no xml." << endl
+    << "      - reports files, xml size, log and tree size and CPU hours per combination and in total." << endl
+    << "      - with a file name, also lists every planned xml file with its estimates." << endl
+    << endl
+    << "Timing a batch:" << endl
+    << endl
+    << "   ./BEASTifier -config config_filename -stats stats_filename" << endl
+    << "      - (or '-stats stats_filename' in the config file.)" << endl
+    << "      - writes the time spent parsing, emitting each xml section and writing, with bytes" << endl
+    << "        read and written, I/O calls and files, per alignment and for the batch (json)." << endl
+    << "   ./BEASTifier -config config_filename -trace trace_filename" << endl
+    << "      - (or '-trace trace_filename' in the config file.)" << endl
+    << "      - writes a timeline of the same stages, per thread and alignment, in the Chrome" << endl
+    << "        trace-event format (open in chrome://tracing or ui.perfetto.dev)." << endl
     << endl
     << "Consult 'config.example' as a, well, example." << endl << endl;
 }
 
 void readConfigFile (string const& fileName, AnalysisSettings & ASet,
-    vector <string> & listFileNames)
+    vector <string> & listFileNames, SettingsGrid & grid)
 {
     ifstream configInput;
     configInput.open(fileName.c_str());
     
     vector <string> tempVect;
     string line;
+    vector <string> alignmentDirectories;
+    vector <string> alignmentGlobs;
+    string alignmentExpression;
     
     while (getline(configInput, line)) {
         if (!checkWhiteSpaceOnly(line)) {
@@ -135,42 +311,41 @@ void readConfigFile (string const& fileName, AnalysisSettings & ASet,
                     checkValidInputFile(fileName);
                     listFileNames = readFileList(fileName);
                     continue;
-                } else if (tempVect[0] == "-mods") {
-                    tempVect.erase(tempVect.begin());
-                    ASet.setSubModels(tempVect);
+                } else if (tempVect[0] == "-adir") {
+                    alignmentDirectories.insert(alignmentDirectories.end(), tempVect.begin() + 1, tempVect.end());
                     continue;
-                } else if (tempVect[0] == "-mcmc") {
-                    ASet.setMcmcLength(tempVect[1]);
+                } else if (tempVect[0] == "-aglob") {
+                    alignmentGlobs.insert(alignmentGlobs.end(), tempVect.begin() + 1, tempVect.end());
                     continue;
-                } else if (tempVect[0] == "-tsamp") {
-                    ASet.setTreeSampling(tempVect[1]);
+                } else if (tempVect[0] == "-aregex") {
+                    alignmentExpression = line.substr(line.find("-aregex") + 7);
+                    alignmentExpression.erase(0, alignmentExpression.find_first_not_of(" \t"));
+                    alignmentExpression.erase(alignmentExpression.find_last_not_of(" \t\r") + 1);
                     continue;
-                } else if (tempVect[0] == "-psamp") {
-                    ASet.setParameterSampling(tempVect[1]);
+                } else if (tempVect[0] == "-filter") {
+                    string expression = line.substr(line.find("-filter") + 7);
+                    expression.erase(0, expression.find_first_not_of(" \t"));
+                    grid.addFilter(expression);
                     continue;
-                } else if (tempVect[0] == "-ssamp") {
-                    ASet.setScreenSampling(tempVect[1]);
+                } else if (tempVect[0] == "-shard") {
+                    grid.setShard(tempVect[1]);
                     continue;
-                } else if (tempVect[0] == "-logphy") {
-                    ASet.setLogPhylogramsTrue();
+                } else if (tempVect[0] == "-stats") {
+                    if (tempVect.size() < 2) {
+                        throw BEASTifierError("settings", "'-stats' needs the name of the statistics file");
+                    }
+                    runStatistics.enable(tempVect[1]);
                     continue;
-                } else if (tempVect[0] == "-tprior") {
-                    tempVect.erase(tempVect.begin());
-                    ASet.setTreePriors(tempVect);
+                } else if (tempVect[0] == "-trace") {
+                    if (tempVect.size() < 2) {
+                        throw BEASTifierError("settings", "'-trace' needs the name of the trace file");
+                    }
+                    runTrace.enable(tempVect[1]);
                     continue;
-                } else if (tempVect[0] == "-fixtree") {
-                    ASet.setTreeManipulationFalse();
+                } else if (find(tempVect.begin(), tempVect.end(), "|") != tempVect.end()) {
+                    grid.addDimension(tempVect, ASet);
                     continue;
-                } else if (tempVect[0] == "-clock") {
-                    tempVect.erase(tempVect.begin());
-                    ASet.setClockFlavours(tempVect);
-                    continue;
-                } else if (tempVect[0] == "-rprior") {
-                    tempVect.erase(tempVect.begin());
-                    ASet.setRootPrior(tempVect);
-                    continue;
-                } else if (tempVect[0] == "-overwrite") {
-                    ASet.setOverwriteTrue();
+                } else if (ASet.applyOption(tempVect)) {
                     continue;
                 } else {
                     cout << endl
@@ -183,6 +358,32 @@ void readConfigFile (string const& fileName, AnalysisSettings & ASet,
             tempVect.clear();
         }
     }
+    ASet.checkFileNamePatterns();
+    grid.checkFilterVariables(ASet);
+    
+// directories are walked once all settings are read, so filters may come after '-adir'
+    if (!alignmentDirectories.empty()) {
+        vector <string> discovered = discoverAlignmentFiles(alignmentDirectories,
+            alignmentGlobs.empty() ? getDefaultAlignmentGlobs() : alignmentGlobs, alignmentExpression);
+        listFileNames.insert(listFileNames.end(), discovered.begin(), discovered.end());
+    }
+}
+
+void mergeMarginalLikelihood (vector <string> const& mleLogs) {
+    double logPathSampling = 0.0;
+    double logSteppingStone = 0.0;
+    int numPowers = 0;
+    
+    if (mleLogs.empty()) {
+        cout << "No marginal likelihood logs given to merge." << endl << endl;
+        exit(1);
+    }
+    if (!mergeMarginalLikelihoodLogs(mleLogs, logPathSampling, logSteppingStone, numPowers)) {
+        exit(1);
+    }
+    cout << "Merged " << mleLogs.size() << " marginal likelihood log(s) across " << numPowers << " powers." << endl
+        << "   log marginal likelihood (path sampling)   = " << setprecision(10) << logPathSampling << endl
+        << "   log marginal likelihood (stepping stone)  = " << setprecision(10) << logSteppingStone << endl << endl;
 }
 
 bool checkComment (string const& val) {
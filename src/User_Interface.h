@@ -3,10 +3,11 @@
 
 void printProgramInfo();
 void processCommandLineArguments (int argc, char *argv[], vector <string> & listFileNames,
-    AnalysisSettings & ASet);
+    AnalysisSettings & ASet, SettingsGrid & grid);
 void usage ();
 void readConfigFile (string const& fileName, AnalysisSettings & ASet,
-    vector <string> & listFileNames);
+    vector <string> & listFileNames, SettingsGrid & grid);
+void mergeMarginalLikelihood (vector <string> const& mleLogs);
 bool checkComment (string const& val);
 
 #endif /* _USER_INTERFACE_H_ */
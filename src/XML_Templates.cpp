@@ -0,0 +1,544 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <map>
+#include <cstdlib>
+
+using namespace std;
+
+#include "General.h"
+#include "XML_Templates.h"
+
+extern bool DEBUG;
+
+// Built-in templates: name, text. Section text is exactly what the writers used to stream.
+static const char * builtinTemplates[][2] = {
+    {"header",
+        "<?xml version=\"1.0\" standalone=\"yes\"?>\n"
+        "\n"
+        " <!-- Generated by BEASTifier version {{version}} -->\n"
+        " <!--           Joseph W. Brown           -->\n"
+        " <!--        University of Michigan       -->\n"
+        " <!--          josephwb@umich.edu         -->\n"
+        " <!--            {{month}}, {{year}}            -->\n"
+        "\n"
+        "<beast>\n"
+        "\n"},
+    {"treePrior.bd",
+        "<!-- *** PRIOR ON NODE AGES *** -->\n"
+        "    <!-- A prior on the distribution node heights defined given a birth-death speciation process -->\n"
+        "    <birthDeathModel id=\"birthDeath\" units=\"substitutions\">\n"
+        "        <birthMinusDeathRate>\n"
+        "            <parameter id=\"birthDeath.BminusDRate\" value=\"1.0\" lower=\"0.0\" upper=\"Infinity\"/>\n"
+        "        </birthMinusDeathRate>\n"
+        "        <relativeDeathRate>\n"
+        "            <parameter id=\"birthDeath.DoverB\" value=\"0.5\" lower=\"0.0\" upper=\"1.0\"/>\n"
+        "        </relativeDeathRate>\n"
+        "    </birthDeathModel>\n"
+        "\n"
+        "\n"},
+    {"treePrior.yule",
+        "<!-- *** PRIOR ON NODE AGES *** -->\n"
+        "    <!-- A prior on the distribution node heights defined given a Yule speciation process (a pure birth process) -->\n"
+        "    <yuleModel id=\"yule\" units=\"substitutions\">\n"
+        "        <birthRate>\n"
+        "            <parameter id=\"yule.birthRate\" value=\"1.0\" lower=\"0.0\" upper=\"Infinity\"/>\n"
+        "        </birthRate>\n"
+        "    </yuleModel>\n"
+        "\n"
+        "\n"},
+    {"treePrior.concoal",
+        "<!-- *** PRIOR ON NODE AGES *** -->\n"
+        "    <!-- A prior on the distribution node heights defined given a constant-size coalescent process -->\n"
+        "    <constantSize id=\"constant\" units=\"substitutions\">\n"
+        "    <populationSize>\n"
+        "        <parameter id=\"constant.popSize\" value=\"0.3\" lower=\"0.0\" upper=\"Infinity\"/>\n"
+        "    </populationSize>\n"
+        "    </constantSize>\n"
+        "\n"
+        "\n"},
+    {"treePrior.expcoal",
+        "<!-- *** PRIOR ON NODE AGES *** -->\n"
+        "    <!-- A prior on the distribution node heights defined given a exponential-growth coalescent process -->\n"
+        "    <exponentialGrowth id=\"exponential\" units=\"substitutions\">\n"
+        "    <populationSize>\n"
+        "        <parameter id=\"exponential.popSize\" value=\"0.3\" lower=\"0.0\" upper=\"Infinity\"/>\n"
+        "    </populationSize>\n"
+        "    <growthRate>\n"
+        "        <parameter id=\"exponential.growthRate\" value=\"3.0E-4\" lower=\"-Infinity\" upper=\"Infinity\"/>\n"
+        "    </growthRate>\n"
+        "    </exponentialGrowth>\n"
+        "\n"
+        "\n"},
+    {"treePrior.logcoal",
+        "<!-- *** PRIOR ON NODE AGES *** -->\n"
+        "    <!-- A prior on the distribution node heights defined given a logistic-growth coalescent process -->\n"
+        "    <logisticGrowth id=\"logistic\" units=\"substitutions\">\n"
+        "    <populationSize>\n"
+        "        <parameter id=\"logistic.popSize\" value=\"0.3\" lower=\"0.0\" upper=\"Infinity\"/>\n"
+        "    </populationSize>\n"
+        "    <growthRate>\n"
+        "        <parameter id=\"logistic.growthRate\" value=\"3.0E-4\" lower=\"-Infinity\" upper=\"Infinity\"/>\n"
+        "    </growthRate>\n"
+        "    <t50>\n"
+        "        <parameter id=\"logistic.t50\" value=\"1.0\" lower=\"0.0\" upper=\"Infinity\"/>\n"
+        "    </t50>\n"
+        "    </logisticGrowth>\n"
+        "\n"
+        "\n"},
+    {"startingTree.bd",
+        "    <!-- This is a simple constant population size coalescent model  -->\n"
+        "    <!-- that is used to generate an initial tree for the chain. -->\n"
+        "    <constantSize id=\"initialDemo\" units=\"substitutions\">\n"
+        "        <populationSize>\n"
+        "            <parameter id=\"initialDemo.popSize\" value=\"100.0\"/>\n"
+        "        </populationSize>\n"
+        "    </constantSize>\n"
+        "\n"
+        "    <!-- Generate a random starting tree under the coalescent process -->\n"
+        "    <coalescentTree id=\"startingTree\" rootHeight=\"{{rootHeight}}\">\n"
+        "        <taxa idref=\"taxa\"/>\n"
+        "        <constantSize idref=\"initialDemo\"/>\n"
+        "    </coalescentTree>\n"
+        "\n"
+        "\n"},
+    {"startingTree.yule",
+        "    <!-- This is a simple constant population size coalescent model  -->\n"
+        "    <!-- that is used to generate an initial tree for the chain. -->\n"
+        "    <constantSize id=\"initialDemo\" units=\"substitutions\">\n"
+        "        <populationSize>\n"
+        "            <parameter id=\"initialDemo.popSize\" value=\"100.0\"/>\n"
+        "        </populationSize>\n"
+        "    </constantSize>\n"
+        "\n"
+        "    <!-- Generate a random starting tree under the coalescent process -->\n"
+        "    <coalescentTree id=\"startingTree\" rootHeight=\"{{rootHeight}}\">\n"
+        "        <taxa idref=\"taxa\"/>\n"
+        "        <constantSize idref=\"initialDemo\"/>\n"
+        "    </coalescentTree>\n"
+        "\n"
+        "\n"},
+    {"startingTree.concoal",
+        "    <!-- Generate a random starting tree under the coalescent process            -->\n"
+        "    <coalescentTree id=\"startingTree\" rootHeight=\"{{rootHeight}}\">\n"
+        "        <taxa idref=\"taxa\"/>\n"
+        "        <constantSize idref=\"constant\"/>\n"
+        "    </coalescentTree>\n"
+        "\n"
+        "\n"},
+    {"startingTree.expcoal",
+        "    <!-- Generate a random starting tree under the coalescent process            -->\n"
+        "    <coalescentTree id=\"startingTree\" rootHeight=\"{{rootHeight}}\">\n"
+        "        <taxa idref=\"taxa\"/>\n"
+        "        <constantSize idref=\"exponential\"/>\n"
+        "    </coalescentTree>\n"
+        "\n"
+        "\n"},
+    {"startingTree.logcoal",
+        "    <constantSize id=\"initialDemo\" units=\"substitutions\">\n"
+        "    <populationSize>\n"
+        "        <parameter idref=\"logistic.popSize\"/>\n"
+        "    </populationSize>\n"
+        "    </constantSize>\n"
+        "\n"
+        "    <!-- Generate a random starting tree under the coalescent process -->\n"
+        "    <coalescentTree id=\"startingTree\" rootHeight=\"{{rootHeight}}\">\n"
+        "        <taxa idref=\"taxa\"/>\n"
+        "        <constantSize idref=\"initialDemo\"/>\n"
+        "    </coalescentTree>\n"
+        "\n"
+        "\n"},
+    {"startingTree.newick",
+        "<!-- *** STARTING TREE - MUST BE COMPATIBLE WITH MONOPHYLY/TEMPORAL CONSTRAINTS OR OR INITIAL STATE OF MODEL WILL HAVE ZERO PROBABILITY *** -->\n"
+        "<newick id=\"startingTree\" units=\"years\">\n"
+        "{{starterTree}}\n"
+        "</newick>\n"
+        "\n"},
+    {"partitions",
+        "\n"
+        "<!-- *** DEFINE PARTITIONS *** -->\n"
+        "    <patterns id=\"patterns\" from=\"1\">\n"
+        "        <alignment idref=\"alignment\"/>\n"
+        "    </patterns>\n"
+        "\n"},
+    {"treeModel",
+        "<!-- *** CONSTRUCT TREE MODEL *** -->\n"
+        "    <treeModel id=\"treeModel\">\n"
+        "        <tree idref=\"startingTree\"/>\n"
+        "        <rootHeight>\n"
+        "            <parameter id=\"treeModel.rootHeight\"/>\n"
+        "        </rootHeight>\n"
+        "        <nodeHeights internalNodes=\"true\">\n"
+        "            <parameter id=\"treeModel.internalNodeHeights\"/>\n"
+        "        </nodeHeights>\n"
+        "        <nodeHeights internalNodes=\"true\" rootNode=\"true\">\n"
+        "            <parameter id=\"treeModel.allInternalNodeHeights\"/>\n"
+        "        </nodeHeights>\n"
+        "    </treeModel>\n"
+        "\n"},
+    {"treeModel.bd",
+        "    <speciationLikelihood id=\"speciation\">\n"
+        "        <model>\n"
+        "            <birthDeathModel idref=\"birthDeath\"/>\n"
+        "        </model>\n"
+        "        <speciesTree>\n"
+        "            <treeModel idref=\"treeModel\"/>\n"
+        "        </speciesTree>\n"
+        "    </speciationLikelihood>\n"
+        "\n"
+        "\n"},
+    {"treeModel.yule",
+        "    <speciationLikelihood id=\"speciation\">\n"
+        "        <model>\n"
+        "            <yuleModel idref=\"yule\"/>\n"
+        "        </model>\n"
+        "        <speciesTree>\n"
+        "            <treeModel idref=\"treeModel\"/>\n"
+        "        </speciesTree>\n"
+        "    </speciationLikelihood>\n"
+        "\n"
+        "\n"},
+    {"treeModel.concoal",
+        "    <!-- Generate a coalescent likelihood -->\n"
+        "    <coalescentLikelihood id=\"coalescent\">\n"
+        "        <model>\n"
+        "            <constantSize idref=\"constant\"/>\n"
+        "        </model>\n"
+        "        <populationTree>\n"
+        "            <treeModel idref=\"treeModel\"/>\n"
+        "        </populationTree>\n"
+        "    </coalescentLikelihood>\n"
+        "\n"
+        "\n"},
+    {"treeModel.expcoal",
+        "    <!-- Generate a coalescent likelihood -->\n"
+        "    <coalescentLikelihood id=\"coalescent\">\n"
+        "        <model>\n"
+        "            <exponentialGrowth idref=\"exponential\"/>\n"
+        "        </model>\n"
+        "        <populationTree>\n"
+        "            <treeModel idref=\"treeModel\"/>\n"
+        "        </populationTree>\n"
+        "    </coalescentLikelihood>\n"
+        "\n"
+        "\n"},
+    {"treeModel.logcoal",
+        "    <!-- Generate a coalescent likelihood -->\n"
+        "    <coalescentLikelihood id=\"coalescent\">\n"
+        "        <model>\n"
+        "            <logisticGrowth idref=\"logistic\"/>\n"
+        "        </model>\n"
+        "        <populationTree>\n"
+        "            <treeModel idref=\"treeModel\"/>\n"
+        "        </populationTree>\n"
+        "    </coalescentLikelihood>\n"
+        "\n"
+        "\n"},
+    {"clockModel.ucln",
+        "<!-- *** DEFINE CLOCK MODEL *** -->\n"
+        "    <!-- The uncorrelated relaxed clock (Drummond, Ho, Phillips & Rambaut, 2006) -->\n"
+        "    <discretizedBranchRates id=\"branchRates\">\n"
+        "        <treeModel idref=\"treeModel\"/>\n"
+        "        <distribution>\n"
+        "            <logNormalDistributionModel meanInRealSpace=\"true\">\n"
+        "                <mean>\n"
+        "                    <parameter id=\"ucld.mean\" value=\"{{clockRate}}\" lower=\"0.0\" upper=\"10.0\"/>\n"
+        "                </mean>\n"
+        "                <stdev>\n"
+        "                    <parameter id=\"ucld.stdev\" value=\"0.1\" lower=\"0.0\" upper=\"10.0\"/>\n"
+        "                </stdev>\n"
+        "            </logNormalDistributionModel>\n"
+        "        </distribution>\n"
+        "        <rateCategories>\n"
+        "            <parameter id=\"branchRates.categories\" dimension=\"{{numBranches}}\"/>\n"
+        "        </rateCategories>\n"
+        "    </discretizedBranchRates>\n"
+        "\n"
+        "    <rateStatistic id=\"meanRate\" name=\"meanRate\" mode=\"mean\" internal=\"true\" external=\"true\">\n"
+        "        <treeModel idref=\"treeModel\"/>\n"
+        "        <discretizedBranchRates idref=\"branchRates\"/>\n"
+        "    </rateStatistic>\n"
+        "\n"
+        "    <rateStatistic id=\"coefficientOfVariation\" name=\"coefficientOfVariation\" mode=\"coefficientOfVariation\" internal=\"true\" external=\"true\">\n"
+        "        <treeModel idref=\"treeModel\"/>\n"
+        "        <discretizedBranchRates idref=\"branchRates\"/>\n"
+        "    </rateStatistic>\n"
+        "\n"
+        "    <rateCovarianceStatistic id=\"covariance\" name=\"covariance\">\n"
+        "        <treeModel idref=\"treeModel\"/>\n"
+        "        <discretizedBranchRates idref=\"branchRates\"/>\n"
+        "    </rateCovarianceStatistic>\n"
+        "\n"},
+    {"clockModel.uced",
+        "<!-- *** DEFINE CLOCK MODEL *** -->\n"
+        "    <!-- The uncorrelated relaxed clock (Drummond, Ho, Phillips & Rambaut, 2006) -->\n"
+        "    <discretizedBranchRates id=\"branchRates\">\n"
+        "        <treeModel idref=\"treeModel\"/>\n"
+        "        <distribution>\n"
+        "            <exponentialDistributionModel>\n"
+        "                <mean>\n"
+        "                    <parameter id=\"uced.mean\" value=\"{{clockRate}}\" lower=\"0.0\" upper=\"1000000.0\"/>\n"
+        "                </mean>\n"
+        "            </exponentialDistributionModel>\n"
+        "        </distribution>\n"
+        "        <rateCategories>\n"
+        "            <parameter id=\"branchRates.categories\" dimension=\"{{numBranches}}\"/>\n"
+        "        </rateCategories>\n"
+        "    </discretizedBranchRates>\n"
+        "    <rateStatistic id=\"meanRate\" name=\"meanRate\" mode=\"mean\" internal=\"true\" external=\"true\">\n"
+        "        <treeModel idref=\"treeModel\"/>\n"
+        "        <discretizedBranchRates idref=\"branchRates\"/>\n"
+        "    </rateStatistic>\n"
+        "    <rateStatistic id=\"coefficientOfVariation\" name=\"coefficientOfVariation\" mode=\"coefficientOfVariation\" internal=\"true\" external=\"true\">\n"
+        "        <treeModel idref=\"treeModel\"/>\n"
+        "        <discretizedBranchRates idref=\"branchRates\"/>\n"
+        "    </rateStatistic>\n"
+        "    <rateCovarianceStatistic id=\"covariance\" name=\"covariance\">\n"
+        "        <treeModel idref=\"treeModel\"/>\n"
+        "        <discretizedBranchRates idref=\"branchRates\"/>\n"
+        "    </rateCovarianceStatistic>\n"
+        "\n"},
+    {"clockModel.strict",
+        "<!-- *** DEFINE CLOCK MODEL *** -->\n"
+        "    <!-- The strict clock (Uniform rates across branches) -->\n"
+        "        <strictClockBranchRates id=\"branchRates\">\n"
+        "            <rate>\n"
+        "                <parameter id=\"clock.rate\" value=\"1.0\"/>\n"
+        "            </rate>\n"
+        "        </strictClockBranchRates>\n"
+        "\n"},
+    {"clockModel.randlocal",
+        "<!-- *** DEFINE CLOCK MODEL *** -->\n"
+        "    <!-- The random local clock model (Drummond & Suchard, 2010) -->\n"
+        "    <randomLocalClockModel id=\"branchRates\" ratesAreMultipliers=\"false\">\n"
+        "        <treeModel idref=\"treeModel\"/>\n"
+        "        <rates>\n"
+        "            <parameter id=\"localClock.relativeRates\"/>\n"
+        "        </rates>\n"
+        "        <rateIndicator>\n"
+        "            <parameter id=\"localClock.changes\"/>\n"
+        "        </rateIndicator>\n"
+        "        <clockRate>\n"
+        "            <parameter id=\"clock.rate\" value=\"{{clockRate}}\" lower=\"0.0\"/>\n"
+        "        </clockRate>\n"
+        "    </randomLocalClockModel>\n"
+        "    <sumStatistic id=\"rateChanges\" name=\"rateChangeCount\" elementwise=\"true\">\n"
+        "        <parameter idref=\"localClock.changes\"/>\n"
+        "    </sumStatistic>\n"
+        "    <rateStatistic id=\"meanRate\" name=\"meanRate\" mode=\"mean\" internal=\"true\" external=\"true\">\n"
+        "        <treeModel idref=\"treeModel\"/>\n"
+        "        <randomLocalClockModel idref=\"branchRates\"/>\n"
+        "    </rateStatistic>\n"
+        "    <rateStatistic id=\"coefficientOfVariation\" name=\"coefficientOfVariation\" mode=\"coefficientOfVariation\" internal=\"true\" external=\"true\">\n"
+        "        <treeModel idref=\"treeModel\"/>\n"
+        "        <randomLocalClockModel idref=\"branchRates\"/>\n"
+        "    </rateStatistic>\n"
+        "    <rateCovarianceStatistic id=\"covariance\" name=\"covariance\">\n"
+        "        <treeModel idref=\"treeModel\"/>\n"
+        "        <randomLocalClockModel idref=\"branchRates\"/>\n"
+        "    </rateCovarianceStatistic>\n"
+        "\n"},
+    {"treeLikelihood",
+        "\n"
+        "<!-- *** DEFINE TREE LIKELIHOOD *** -->\n"
+        "    <treeLikelihood id=\"{{idPrefix}}treeLikelihood\" instanceCount=\"{{instanceCount}}\" scalingScheme=\"{{scalingScheme}}\">\n"
+        "        <{{patternsElement}} idref=\"{{idPrefix}}patterns\"/>\n"
+        "        <treeModel idref=\"treeModel\"/>\n"
+        "        <siteModel idref=\"{{idPrefix}}siteModel\"/>\n"
+        "        <{{branchRatesElement}} idref=\"branchRates\"/>\n"
+        "    </treeLikelihood>\n"
+        "\n"},
+    {"screenLog",
+        "\n"
+        "<!-- *** PRINT PARAMETERS TO SCREEN *** -->\n"
+        "        <log id=\"screenLog\" logEvery=\"{{screenSampling}}\">\n"
+        "            <column label=\"Posterior\" dp=\"4\" width=\"12\">\n"
+        "                <posterior idref=\"posterior\"/>\n"
+        "            </column>\n"
+        "            <column label=\"Prior\" dp=\"4\" width=\"12\">\n"
+        "                <prior idref=\"prior\"/>\n"
+        "            </column>\n"
+        "            <column label=\"Likelihood\" dp=\"4\" width=\"12\">\n"
+        "                <likelihood idref=\"likelihood\"/>\n"
+        "            </column>\n"
+        "            <column label=\"Root Height\" sf=\"6\" width=\"12\">\n"
+        "                <parameter idref=\"treeModel.rootHeight\"/>\n"
+        "            </column>\n"
+        "            <column label=\"Rate\" sf=\"6\" width=\"12\">\n"
+        "                <parameter idref=\"{{rateParameter}}\"/>\n"
+        "            </column>\n"
+        "        </log>\n"
+        "\n"},
+    {"treeLog",
+        "<!-- *** TREE LOG FILES *** -->\n"
+        "        <logTree id=\"treeFileLog\" logEvery=\"{{treeSampling}}\" nexusFormat=\"true\" fileName=\"{{fileRoot}}.time.trees\" sortTranslationTable=\"true\">\n"
+        "            <treeModel idref=\"treeModel\"/>\n"
+        "            <{{branchRatesElement}} idref=\"branchRates\"/>\n"
+        "            <posterior idref=\"posterior\"/>\n"
+        "        </logTree>\n"},
+    {"phylogramLog.relaxed",
+        "        <logTree id=\"substTreeFileLog\" logEvery=\"{{treeSampling}}\" nexusFormat=\"true\" fileName=\"{{fileRoot}}.subst.trees\" branchLengths=\"substitutions\">\n"
+        "            <treeModel idref=\"treeModel\"/>\n"
+        "            <{{branchRatesElement}} idref=\"branchRates\"/>\n"
+        "            <posterior idref=\"posterior\"/>\n"
+        "        </logTree>\n"},
+    {"phylogramLog",
+        "        <logTree id=\"substTreeFileLog\" logEvery=\"{{treeSampling}}\" nexusFormat=\"true\" fileName=\"{{fileRoot}}.subst.trees\" branchLengths=\"substitutions\">\n"
+        "            <treeModel idref=\"treeModel\"/>\n"
+        "            <{{branchRatesElement}} idref=\"branchRates\"/>\n"
+        "        </logTree>\n"},
+    {"tail",
+        "\n"
+        "    <report>\n"
+        "        <property name=\"timer\">\n"
+        "            <object idref=\"mcmc\"/>\n"
+        "        </property>\n"
+        "    </report>\n"
+        "\n"
+        "</beast>\n"},
+    {"beast2.header",
+        "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"no\"?>\n"
+        "\n"
+        " <!-- Generated by BEASTifier version {{version}} -->\n"
+        " <!--           Joseph W. Brown           -->\n"
+        " <!--        University of Michigan       -->\n"
+        " <!--          josephwb@umich.edu         -->\n"
+        " <!--            {{month}}, {{year}}            -->\n"
+        "\n"
+        "<beast version=\"2.6\" namespace=\"beast.core:beast.core.util:beast.core.parameter:beast.evolution.alignment:"
+        "beast.evolution.tree:beast.evolution.tree.coalescent:beast.evolution.speciation:beast.evolution.branchratemodel:"
+        "beast.evolution.operators:beast.evolution.sitemodel:beast.evolution.substitutionmodel:beast.evolution.likelihood:"
+        "beast.math.distributions\">\n"
+        "\n"},
+    {"beast2.treePrior.bd",
+        "                <!-- A prior on the distribution node heights defined given a birth-death speciation process -->\n"
+        "                <distribution id=\"speciation\" spec=\"BirthDeathGernhard08Model\" birthDiffRate=\"@birthDeath.BminusDRate\""
+        " relativeDeathRate=\"@birthDeath.DoverB\" type=\"unscaled\" tree=\"@Tree\"/>\n"},
+    {"beast2.treePrior.yule",
+        "                <!-- A prior on the distribution node heights defined given a Yule speciation process (a pure birth process) -->\n"
+        "                <distribution id=\"speciation\" spec=\"YuleModel\" birthDiffRate=\"@yule.birthRate\" tree=\"@Tree\"/>\n"},
+    {"beast2.treePrior.concoal",
+        "                <!-- A prior on the distribution node heights defined given a constant-size coalescent process -->\n"
+        "                <distribution id=\"coalescent\" spec=\"Coalescent\">\n"
+        "                    <populationModel id=\"constant\" spec=\"ConstantPopulation\" popSize=\"@constant.popSize\"/>\n"
+        "                    <treeIntervals id=\"treeIntervals\" spec=\"TreeIntervals\" tree=\"@Tree\"/>\n"
+        "                </distribution>\n"},
+    {"beast2.treePrior.expcoal",
+        "                <!-- A prior on the distribution node heights defined given a exponential-growth coalescent process -->\n"
+        "                <distribution id=\"coalescent\" spec=\"Coalescent\">\n"
+        "                    <populationModel id=\"exponential\" spec=\"ExponentialGrowth\" popSize=\"@exponential.popSize\""
+        " growthRate=\"@exponential.growthRate\"/>\n"
+        "                    <treeIntervals id=\"treeIntervals\" spec=\"TreeIntervals\" tree=\"@Tree\"/>\n"
+        "                </distribution>\n"},
+    {"beast2.clockModel.strict",
+        "                    <!-- The strict clock (Uniform rates across branches) -->\n"
+        "                    <branchRateModel id=\"branchRates\" spec=\"StrictClockModel\">\n"
+        "                        <parameter id=\"clock.rate\" name=\"clock.rate\" estimate=\"false\">1.0</parameter>\n"
+        "                    </branchRateModel>\n"},
+    {"beast2.clockModel.ucln",
+        "                    <!-- The uncorrelated relaxed clock (Drummond, Ho, Phillips & Rambaut, 2006) -->\n"
+        "                    <branchRateModel id=\"branchRates\" spec=\"UCRelaxedClockModel\" clock.rate=\"@ucld.mean\""
+        " rateCategories=\"@branchRates.categories\" tree=\"@Tree\">\n"
+        "                        <distr id=\"ucld.distribution\" spec=\"LogNormalDistributionModel\" M=\"1.0\" S=\"@ucld.stdev\""
+        " meanInRealSpace=\"true\"/>\n"
+        "                    </branchRateModel>\n"},
+    {"beast2.clockModel.uced",
+        "                    <!-- The uncorrelated relaxed clock (Drummond, Ho, Phillips & Rambaut, 2006) -->\n"
+        "                    <branchRateModel id=\"branchRates\" spec=\"UCRelaxedClockModel\" clock.rate=\"@uced.mean\""
+        " rateCategories=\"@branchRates.categories\" tree=\"@Tree\">\n"
+        "                        <distr id=\"uced.distribution\" spec=\"Exponential\" mean=\"1.0\"/>\n"
+        "                    </branchRateModel>\n"},
+    {"beast2.clockModel.randlocal",
+        "                    <!-- The random local clock model (Drummond & Suchard, 2010) -->\n"
+        "                    <branchRateModel id=\"branchRates\" spec=\"RandomLocalClockModel\" clock.rate=\"@clock.rate\""
+        " indicators=\"@localClock.changes\" rates=\"@localClock.relativeRates\" ratesAreMultipliers=\"false\" tree=\"@Tree\"/>\n"},
+    {"beast2.treeLog",
+        "<!-- *** TREE LOG FILES *** -->\n"
+        "        <logger id=\"treeFileLog\" logEvery=\"{{treeSampling}}\" fileName=\"{{fileRoot}}.time.trees\" mode=\"tree\">\n"
+        "            <log id=\"timeTreeLog\" spec=\"TreeWithMetaDataLogger\" tree=\"@Tree\" branchratemodel=\"@branchRates\"/>\n"
+        "        </logger>\n"},
+    {"beast2.phylogramLog",
+        "        <logger id=\"substTreeFileLog\" logEvery=\"{{treeSampling}}\" fileName=\"{{fileRoot}}.subst.trees\" mode=\"tree\">\n"
+        "            <log id=\"substTreeLog\" spec=\"TreeWithMetaDataLogger\" tree=\"@Tree\" branchratemodel=\"@branchRates\" substitutions=\"true\"/>\n"
+        "        </logger>\n"},
+    {"beast2.tail",
+        "\n"
+        "</beast>\n"}
+};
+
+static const int numBuiltinTemplates = sizeof(builtinTemplates) / sizeof(builtinTemplates[0]);
+
+static map <string, XMLTemplate> compiledTemplates;
+
+XMLTemplate::XMLTemplate () {
+    segments.push_back("");
+}
+
+void XMLTemplate::compile (string const& text) {
+    segments.clear();
+    slots.clear();
+    
+    size_t start = 0;
+    while (true) {
+        size_t open = text.find("{{", start);
+        size_t close = (open == string::npos) ? string::npos : text.find("}}", open + 2);
+        if (close == string::npos) {
+            segments.push_back(text.substr(start));
+            break;
+        }
+        segments.push_back(text.substr(start, open - start));
+        slots.push_back(text.substr(open + 2, close - open - 2));
+        start = close + 2;
+    }
+}
+
+void XMLTemplate::render (ostream & out, map <string, string> const& values) const {
+// a slot with no value is written back out verbatim, so a typo shows up in the xml
+    for (int i = 0; i < (int)slots.size(); i++) {
+        out << segments[i];
+        map <string, string>::const_iterator value = values.find(slots[i]);
+        if (value != values.end()) {
+            out << value->second;
+        } else {
+            out << "{{" << slots[i] << "}}";
+        }
+    }
+    out << segments.back();
+}
+
+void initializeXMLTemplates (string const& templateDirectory) {
+    for (int i = 0; i < numBuiltinTemplates; i++) {
+        string name = builtinTemplates[i][0];
+        string text = builtinTemplates[i][1];
+        
+        if (!templateDirectory.empty()) {
+            string overrideFileName = templateDirectory + "/" + name + ".xml";
+            ifstream overrideInput(overrideFileName.c_str());
+            if (!overrideInput.fail()) {
+                ostringstream overrideText;
+                overrideText << overrideInput.rdbuf();
+                text = overrideText.str();
+                cout << "Using template '" << overrideFileName << "'." << endl;
+            }
+        }
+        compiledTemplates[name].compile(text);
+    }
+    if (DEBUG) {cout << "Compiled " << compiledTemplates.size() << " xml templates." << endl;}
+}
+
+XMLTemplate const& getXMLTemplate (string const& name) {
+    map <string, XMLTemplate>::const_iterator found = compiledTemplates.find(name);
+    if (found == compiledTemplates.end()) {
+        throw BEASTifierError("template", "no xml template named '" + name + "'");
+    }
+    return found->second;
+}
+
+void renderXMLTemplate (ostream & out, string const& name, map <string, string> const& values) {
+    getXMLTemplate(name).render(out, values);
+}
+
+void renderXMLTemplate (ostream & out, string const& name) {
+    getXMLTemplate(name).render(out, map <string, string>());
+}
@@ -0,0 +1,28 @@
+#ifndef _XML_TEMPLATES_H_
+#define _XML_TEMPLATES_H_
+
+// Fixed sections of the BEAST xml are stored as templates: literal text with '{{name}}' slots.
+// Each template is split into segments once (at startup), so writing a section is a straight run
+// of appends with no per-line formatting. A file '<name>.xml' in the '-templates' directory
+// replaces the built-in template of the same name.
+
+class XMLTemplate {
+    
+    vector <string> segments; // segments[i] precedes slots[i]; one more segment than slots
+    vector <string> slots;
+    
+public:
+    
+    void compile (string const& text);
+    void render (ostream & out, map <string, string> const& values) const;
+    
+    XMLTemplate ();
+    ~XMLTemplate () {};
+};
+
+void initializeXMLTemplates (string const& templateDirectory);
+XMLTemplate const& getXMLTemplate (string const& name);
+void renderXMLTemplate (ostream & out, string const& name, map <string, string> const& values);
+void renderXMLTemplate (ostream & out, string const& name);
+
+#endif /* _XML_TEMPLATES_H_ */
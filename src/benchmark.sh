@@ -0,0 +1,136 @@
+#!/bin/sh
+# Large-input timing of BEASTifier, optionally against a baseline build.
+#
+# Usage: ./benchmark.sh [binary] [baseline_binary]
+#
+# Writes a random alignment of NTAX taxa and NCHAR sites (default 25 x 3000000, sequential
+# PHYLIP) and a starting tree to a scratch directory, then runs each binary REPS times on it,
+# in memory and with -stream, writing one JC / strict / birth-death xml file per run. Reports
+# the median wall-clock seconds of the run and, for binaries that have '-stats', of the 'parse'
+# and 'emit' stages. With a baseline binary (e.g. built from an earlier commit) both are timed on
+# the same data, and the xml files they write are compared. Files follow the default name and
+# tree patterns, so older builds without those options can be the baseline.
+
+BINARY=${1:-./BEASTifier}
+BASELINE=$2
+NTAX=${NTAX:-25}
+NCHAR=${NCHAR:-3000000}
+REPS=${REPS:-3}
+WORKDIR=${WORKDIR:-/tmp/BEASTifier_benchmark}
+
+for program in "$BINARY" $BASELINE; do
+    if [ ! -x "$program" ]; then
+        echo "Error: '$program' is not an executable." >&2
+        exit 1
+    fi
+done
+BINARY=$(cd "$(dirname "$BINARY")" && pwd)/$(basename "$BINARY")
+if [ -n "$BASELINE" ]; then
+    BASELINE=$(cd "$(dirname "$BASELINE")" && pwd)/$(basename "$BASELINE")
+fi
+
+mkdir -p "$WORKDIR" || exit 1
+cd "$WORKDIR" || exit 1
+
+# taxa differ from a common ancestor at 5% of sites, so the data have realistic site patterns
+ALIGNMENT=b_1_d_0_a_0_n_${NTAX}_sim_JC_rep_${NCHAR}.phy
+if [ ! -f "$ALIGNMENT" ]; then
+    echo "Writing $NTAX x $NCHAR alignment '$WORKDIR/$ALIGNMENT'..."
+    awk -v ntax="$NTAX" -v nchar="$NCHAR" 'BEGIN {
+        srand(1);
+        split("A C G T", bases, " ");
+        for (i = 1; i <= nchar; i++) {
+            ancestor[i] = bases[int(rand() * 4) + 1];
+        }
+        printf("%d %d\n", ntax, nchar);
+        for (t = 1; t <= ntax; t++) {
+            printf("t%d ", t);
+            for (i = 1; i <= nchar; i++) {
+                printf("%s", (rand() < 0.05) ? bases[int(rand() * 4) + 1] : ancestor[i]);
+            }
+            printf("\n");
+        }
+    }' > "$ALIGNMENT.tmp" && mv "$ALIGNMENT.tmp" "$ALIGNMENT" || exit 1
+fi
+# an ultrametric caterpillar tree: each taxon joins the clade of the previous ones one unit higher
+awk -v ntax="$NTAX" 'BEGIN {
+    tree = "t1";
+    for (t = 2; t <= ntax; t++) {
+        tree = "(" tree ":1.0,t" t ":" (t - 1) ".0)";
+    }
+    print tree ";";
+}' > "b_1_d_0_a_0_n_${NTAX}_rep_${NCHAR}.phy"
+echo "$ALIGNMENT" > alignments.txt
+
+# seconds of 'parse' and of 'emit' for the whole batch, from a '-stats' report
+readStatistics () {
+    awk '/"total"/ {total = 1} /"files"/ {total = 0}
+        total && /"parse":/ {sub(/.*"parse": \{"seconds": /, ""); sub(/,.*/, ""); parse = $0}
+        total && /"emit":/ {sub(/.*"emit": \{"seconds": /, ""); sub(/,.*/, ""); emit = $0}
+        END {print parse, emit}' "$1"
+}
+
+median () {
+    sort -n | awk '{value[NR] = $1} END {median = value[int((NR + 1) / 2)];
+        if (median == "-") print median; else printf("%.3f\n", median)}'
+}
+
+# runs one binary in one mode REPS times; prints the median seconds and keeps the last xml
+benchmark () {
+    program=$1
+    mode=$2
+    label=$3
+    {
+        echo "-alist alignments.txt"
+        echo "-mods JC"
+        echo "-clock strict"
+        echo "-tprior bd"
+        echo "-overwrite"
+        if [ "$mode" = "stream" ]; then
+            echo "-stream"
+        fi
+    } > benchmark.cfg
+    statistics=""
+    if "$program" 2>&1 | grep -q -- "-stats"; then
+        statistics="-stats stats.json"
+    fi
+    rm -f times.txt
+    rep=1
+    while [ $rep -le "$REPS" ]; do
+        rm -f ./*.xml stats.json
+        start=$(date +%s.%N)
+        if ! "$program" -config benchmark.cfg $statistics > run.out 2>&1; then
+            echo "Error: '$program' failed; see '$WORKDIR/run.out'." >&2
+            exit 1
+        fi
+        end=$(date +%s.%N)
+        stages="- -"
+        if [ -f stats.json ]; then
+            stages=$(readStatistics stats.json)
+        fi
+        echo "$(awk -v start="$start" -v end="$end" 'BEGIN {printf("%.3f", end - start)}') $stages" >> times.txt
+        rep=$((rep + 1))
+    done
+    mv ./*.xml "$label.$mode.xml.out"
+    printf "%-10s %-8s %10s %10s %10s\n" "$label" "$mode" "$(cut -d' ' -f1 times.txt | median)" \
+        "$(cut -d' ' -f2 times.txt | median)" "$(cut -d' ' -f3 times.txt | median)"
+}
+
+echo "Median of $REPS runs on $NTAX x $NCHAR sites, in seconds:"
+printf "%-10s %-8s %10s %10s %10s\n" "binary" "mode" "total" "parse" "emit"
+for mode in memory stream; do
+    benchmark "$BINARY" $mode binary
+    if [ -n "$BASELINE" ]; then
+        benchmark "$BASELINE" $mode baseline
+    fi
+done
+
+if [ -n "$BASELINE" ]; then
+    for mode in memory stream; do
+        if cmp -s binary.$mode.xml.out baseline.$mode.xml.out; then
+            echo "xml ($mode): identical"
+        else
+            echo "xml ($mode): differs"
+        fi
+    done
+fi